@@ -32,6 +32,7 @@
 #endif
 
 #ifdef ENABLE_DATABASE
+#include "thread/WorkerPool.hxx"
 #include "db/DatabaseError.hxx"
 #include "db/Interface.hxx"
 #include "db/update/Service.hxx"
@@ -121,6 +122,7 @@ Instance::OnDatabaseModified() noexcept
 	/* propagate the change to all subsystems */
 
 	stats_invalidate();
+	database_response_cache.Clear();
 
 	for (auto &partition : partitions)
 		partition.DatabaseModified(*database);
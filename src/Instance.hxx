@@ -42,6 +42,7 @@ class NeighborGlue;
 #ifdef ENABLE_DATABASE
 #include "db/DatabaseListener.hxx"
 #include "db/Ptr.hxx"
+#include "db/ResponseCache.hxx"
 class Storage;
 class UpdateService;
 #endif
@@ -50,6 +51,7 @@ class UpdateService;
 #include <list>
 
 class ClientList;
+class WorkerPool;
 struct Partition;
 class StateFile;
 class RemoteTagCache;
@@ -121,6 +123,20 @@ struct Instance final
 	Storage *storage = nullptr;
 
 	UpdateService *update = nullptr;
+
+	/**
+	 * Cached responses of "list" and "count group"; flushed by
+	 * OnDatabaseModified().
+	 */
+	DatabaseResponseCache database_response_cache;
+
+	/**
+	 * Executes read-only database commands outside of the main
+	 * thread; only set if "client_threads" is configured.  Must
+	 * be declared before #client_list, because clients may still
+	 * have jobs in this pool.
+	 */
+	std::unique_ptr<WorkerPool> client_worker_pool;
 #endif
 
 #ifdef ENABLE_CURL
@@ -67,6 +67,7 @@
 #endif
 
 #ifdef ENABLE_DATABASE
+#include "thread/WorkerPool.hxx"
 #include "db/update/Service.hxx"
 #include "db/Configured.hxx"
 #include "db/DatabasePlugin.hxx"
@@ -122,9 +123,8 @@ static constexpr size_t MEGABYTE = 1024 * KILOBYTE;
 
 static constexpr size_t DEFAULT_BUFFER_SIZE = 4 * MEGABYTE;
 
-static constexpr
-size_t MIN_BUFFER_SIZE = std::max(CHUNK_SIZE * 32,
-				  64 * KILOBYTE);
+static constexpr size_t MIN_BUFFER_CHUNKS = 32;
+static constexpr size_t MIN_BUFFER_SIZE = 64 * KILOBYTE;
 
 #ifdef ANDROID
 Context *context;
@@ -278,28 +278,48 @@ initialize_decoder_and_player(Instance &instance,
 {
 	const ConfigParam *param;
 
+	size_t chunk_size = DEFAULT_CHUNK_SIZE;
+	param = config.GetParam(ConfigOption::AUDIO_CHUNK_SIZE);
+	if (param != nullptr) {
+		chunk_size = param->With([](const char *s){
+			size_t result = ParseSize(s, KILOBYTE);
+			if (result < DEFAULT_CHUNK_SIZE ||
+			    result > MAX_CHUNK_SIZE)
+				throw FormatRuntimeError("chunk size \"%s\" is not "
+							 "between %lu and %lu bytes",
+							 s,
+							 (unsigned long)DEFAULT_CHUNK_SIZE,
+							 (unsigned long)MAX_CHUNK_SIZE);
+
+			return result;
+		});
+	}
+
+	const size_t min_buffer_size = std::max(chunk_size * MIN_BUFFER_CHUNKS,
+						MIN_BUFFER_SIZE);
+
 	size_t buffer_size;
 	param = config.GetParam(ConfigOption::AUDIO_BUFFER_SIZE);
 	if (param != nullptr) {
-		buffer_size = param->With([](const char *s){
+		buffer_size = param->With([min_buffer_size](const char *s){
 			size_t result = ParseSize(s, KILOBYTE);
 			if (result <= 0)
 				throw FormatRuntimeError("buffer size \"%s\" is not a "
 							 "positive integer", s);
 
-			if (result < MIN_BUFFER_SIZE) {
+			if (result < min_buffer_size) {
 				FormatWarning(config_domain, "buffer size %lu is too small, using %lu bytes instead",
 					      (unsigned long)result,
-					      (unsigned long)MIN_BUFFER_SIZE);
-				result = MIN_BUFFER_SIZE;
+					      (unsigned long)min_buffer_size);
+				result = min_buffer_size;
 			}
 
 			return result;
 		});
 	} else
-		buffer_size = DEFAULT_BUFFER_SIZE;
+		buffer_size = std::max(DEFAULT_BUFFER_SIZE, min_buffer_size);
 
-	const unsigned buffered_chunks = buffer_size / CHUNK_SIZE;
+	const unsigned buffered_chunks = buffer_size / chunk_size;
 
 	if (buffered_chunks >= 1 << 15)
 		throw FormatRuntimeError("buffer size \"%lu\" is too big",
@@ -309,6 +329,10 @@ initialize_decoder_and_player(Instance &instance,
 		config.GetPositive(ConfigOption::MAX_PLAYLIST_LENGTH,
 				   DEFAULT_PLAYLIST_MAX_LENGTH);
 
+	const auto predecode_time =
+		SongTime::FromS(config.GetUnsigned(ConfigOption::PREDECODE_TIME,
+						   0U));
+
 	AudioFormat configured_audio_format = config.With(ConfigOption::AUDIO_OUTPUT_FORMAT, [](const char *s){
 		if (s == nullptr)
 			return AudioFormat::Undefined();
@@ -320,6 +344,8 @@ initialize_decoder_and_player(Instance &instance,
 					 "default",
 					 max_length,
 					 buffered_chunks,
+					 chunk_size,
+					 predecode_time,
 					 configured_audio_format,
 					 replay_gain_config);
 	auto &partition = instance.partitions.back();
@@ -402,6 +428,15 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 		raw_config.GetPositive(ConfigOption::MAX_CONN, 100);
 	instance.client_list = std::make_unique<ClientList>(max_clients);
 
+#ifdef ENABLE_DATABASE
+	const unsigned client_threads =
+		raw_config.GetUnsigned(ConfigOption::CLIENT_THREADS, 0);
+	if (client_threads > 0)
+		instance.client_worker_pool =
+			std::make_unique<WorkerPool>("client",
+						     client_threads);
+#endif
+
 	const auto *input_cache_config = raw_config.GetBlock(ConfigBlockOption::INPUT_CACHE);
 	if (input_cache_config != nullptr) {
 		const InputCacheConfig c(*input_cache_config);
@@ -537,6 +572,12 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 
 	/* cleanup */
 
+#ifdef ENABLE_DATABASE
+	/* no more database access from worker threads */
+	if (instance.client_worker_pool)
+		instance.client_worker_pool->Stop();
+#endif
+
 	instance.BeginShutdownUpdate();
 
 	ZeroconfDeinit();
@@ -18,19 +18,33 @@
  */
 
 #include "MusicBuffer.hxx"
-#include "MusicChunk.hxx"
+#include "system/Error.hxx"
 
 #include <cassert>
 
-MusicBuffer::MusicBuffer(unsigned num_chunks)
-	:buffer(num_chunks) {
+MusicBuffer::MusicBuffer(unsigned num_chunks, size_t _chunk_size)
+	:buffer(num_chunks, _chunk_size), chunk_size(_chunk_size)
+{
+	assert(chunk_size >= DEFAULT_CHUNK_SIZE);
+	assert(chunk_size <= MAX_CHUNK_SIZE);
+}
+
+void
+MusicBuffer::Lock()
+{
+	if (!buffer.Lock())
+#ifdef _WIN32
+		throw MakeLastError("VirtualLock() failed");
+#else
+		throw MakeErrno("mlock() failed");
+#endif
 }
 
 MusicChunkPtr
 MusicBuffer::Allocate() noexcept
 {
-	const std::lock_guard<Mutex> protect(mutex);
-	return MusicChunkPtr(buffer.Allocate(), MusicChunkDeleter(*this));
+	return MusicChunkPtr(buffer.Allocate(chunk_size),
+			     MusicChunkDeleter(*this));
 }
 
 void
@@ -38,14 +52,6 @@ MusicBuffer::Return(MusicChunk *chunk) noexcept
 {
 	assert(chunk != nullptr);
 
-	/* these attributes need to be cleared before locking the
-	   mutex, because they might recursively call this method,
-	   causing a deadlock */
-	chunk->next.reset();
-	chunk->other.reset();
-
-	const std::lock_guard<Mutex> protect(mutex);
-
 	assert(!chunk->other || !chunk->other->other);
 
 	buffer.Free(chunk);
@@ -20,18 +20,20 @@
 #ifndef MPD_MUSIC_BUFFER_HXX
 #define MPD_MUSIC_BUFFER_HXX
 
-#include "MusicChunkPtr.hxx"
-#include "util/SliceBuffer.hxx"
-#include "thread/Mutex.hxx"
+#include "MusicChunk.hxx"
+#include "util/LockFreeSliceBuffer.hxx"
 
 /**
- * An allocator for #MusicChunk objects.
+ * An allocator for #MusicChunk objects.  All methods are
+ * thread-safe and lock-free.
  */
 class MusicBuffer {
-	/** a mutex which protects #buffer */
-	mutable Mutex mutex;
+	LockFreeSliceBuffer<MusicChunk> buffer;
 
-	SliceBuffer<MusicChunk> buffer;
+	/**
+	 * The size of each #MusicChunk including its header.
+	 */
+	const size_t chunk_size;
 
 public:
 	/**
@@ -39,14 +41,18 @@ public:
 	 *
 	 * @param num_chunks the number of #MusicChunk reserved in
 	 * this buffer
+	 * @param _chunk_size the size of each #MusicChunk in bytes
+	 * (including its header); between #DEFAULT_CHUNK_SIZE and
+	 * #MAX_CHUNK_SIZE
 	 */
-	explicit MusicBuffer(unsigned num_chunks);
+	explicit MusicBuffer(unsigned num_chunks,
+			     size_t _chunk_size=DEFAULT_CHUNK_SIZE);
 
 #ifndef NDEBUG
 	/**
-	 * Check whether the buffer is empty.  This call is not
-	 * protected with the mutex, and may only be used while this
-	 * object is inaccessible to other threads.
+	 * Check whether the buffer is empty.  The result may be
+	 * stale, and this may only be used while this object is
+	 * inaccessible to other threads.
 	 */
 	bool IsEmptyUnsafe() const {
 		return buffer.empty();
@@ -54,7 +60,6 @@ public:
 #endif
 
 	bool IsFull() const noexcept {
-		const std::lock_guard<Mutex> protect(mutex);
 		return buffer.IsFull();
 	}
 
@@ -68,6 +73,23 @@ public:
 		return buffer.GetCapacity();
 	}
 
+	/**
+	 * Returns the number of data bytes in each chunk (see
+	 * MusicChunk::capacity).
+	 */
+	gcc_pure
+	size_t GetChunkCapacity() const noexcept {
+		return MusicChunk::GetCapacity(chunk_size);
+	}
+
+	/**
+	 * Lock the buffer in RAM, to avoid page faults while
+	 * playing.  Must be called before the buffer is used.
+	 *
+	 * Throws on error.
+	 */
+	void Lock();
+
 	/**
 	 * Allocates a chunk from the buffer.  When it is not used anymore,
 	 * call Return().
@@ -29,11 +29,22 @@
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 
-static constexpr size_t CHUNK_SIZE = 4096;
+/**
+ * The default size of a #MusicChunk (including its header) in bytes.
+ * This is also the minimum.
+ */
+static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+/**
+ * The maximum size of a #MusicChunk, limited by the type of
+ * MusicChunkInfo::length.
+ */
+static constexpr size_t MAX_CHUNK_SIZE = 65536;
 
 struct AudioFormat;
 struct Tag;
@@ -43,8 +54,12 @@ struct MusicChunk;
  * Meta information for #MusicChunk.
  */
 struct MusicChunkInfo {
-	/** the next chunk in a linked list */
-	MusicChunkPtr next;
+	/**
+	 * The next chunk in a #MusicPipe.  The pipe owns all of its
+	 * chunks; this is written by the pipe's producer and may be
+	 * read by other threads.
+	 */
+	std::atomic<MusicChunk *> next{nullptr};
 
 	/**
 	 * An optional chunk which should be mixed into this chunk.
@@ -113,10 +128,40 @@ struct MusicChunkInfo {
 /**
  * A chunk of music data.  Its format is defined by the
  * MusicPipe::Push() caller.
+ *
+ * The chunk size is configurable; #MusicBuffer allocates this struct
+ * followed by the data region, see GetData().
  */
 struct MusicChunk : MusicChunkInfo {
-	/** the data (probably PCM) */
-	uint8_t data[CHUNK_SIZE - sizeof(MusicChunkInfo)];
+	/** the number of bytes available in the data region */
+	const uint16_t capacity;
+
+	/**
+	 * @param chunk_size the size of the memory allocated for
+	 * this chunk, including the header; see GetCapacity()
+	 */
+	explicit MusicChunk(size_t chunk_size) noexcept
+		:capacity(GetCapacity(chunk_size)) {}
+
+	/**
+	 * Returns the number of data bytes in a chunk of the given
+	 * size (including the header).
+	 */
+	static constexpr size_t GetCapacity(size_t chunk_size) noexcept {
+		return chunk_size - sizeof(MusicChunk);
+	}
+
+	/**
+	 * The data (probably PCM) which follows the header.  Its
+	 * size is #capacity, and #length bytes of it are used.
+	 */
+	uint8_t *GetData() noexcept {
+		return reinterpret_cast<uint8_t *>(this + 1);
+	}
+
+	const uint8_t *GetData() const noexcept {
+		return reinterpret_cast<const uint8_t *>(this + 1);
+	}
 
 	/**
 	 * Prepares appending to the music chunk.  Returns a buffer
@@ -145,6 +190,7 @@ struct MusicChunk : MusicChunkInfo {
 	bool Expand(AudioFormat af, size_t length) noexcept;
 };
 
-static_assert(sizeof(MusicChunk) == CHUNK_SIZE, "Wrong size");
+static_assert(sizeof(MusicChunk) < DEFAULT_CHUNK_SIZE,
+	      "MusicChunk header too large");
 
 #endif
@@ -21,15 +21,15 @@
 #include "MusicChunk.hxx"
 
 #include <cassert>
+#include <thread>
 
 #ifndef NDEBUG
 
 bool
 MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 {
-	const std::lock_guard<Mutex> protect(mutex);
-
-	for (const MusicChunk *i = head.get(); i != nullptr; i = i->next.get())
+	for (const MusicChunk *i = Peek(); i != nullptr;
+	     i = i->next.load(std::memory_order_acquire))
 		if (i == chunk)
 			return true;
 
@@ -41,32 +41,38 @@ MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 MusicChunkPtr
 MusicPipe::Shift() noexcept
 {
-	const std::lock_guard<Mutex> protect(mutex);
-
-	auto chunk = std::move(head);
-	if (chunk != nullptr) {
-		assert(!chunk->IsEmpty());
+	MusicChunk *chunk = head.load(std::memory_order_acquire);
+	if (chunk == nullptr)
+		return nullptr;
 
-		head = std::move(chunk->next);
-		--size;
-
-		if (head == nullptr) {
-			assert(size == 0);
-			assert(tail_r == &chunk->next);
+	assert(!chunk->IsEmpty());
 
-			tail_r = &head;
-		} else {
-			assert(size > 0);
-			assert(tail_r != &chunk->next);
+	MusicChunk *next = chunk->next.load(std::memory_order_acquire);
+	if (next == nullptr) {
+		/* this looks like the last chunk; detach it from the
+		   tail, unless Push() has just replaced it */
+		MusicChunk *expected = chunk;
+		if (tail.compare_exchange_strong(expected, nullptr,
+						 std::memory_order_acq_rel)) {
+			/* the pipe is empty now; if Push() has already
+			   published a new head, keep it */
+			expected = chunk;
+			head.compare_exchange_strong(expected, nullptr,
+						     std::memory_order_acq_rel);
+			size.fetch_sub(1, std::memory_order_relaxed);
+			return MusicChunkPtr(chunk, deleter);
 		}
 
-#ifndef NDEBUG
-		if (size == 0)
-			audio_format.Clear();
-#endif
+		/* Push() has replaced the tail, but has not yet
+		   linked the new chunk; this is a very short window,
+		   so wait for it */
+		while ((next = chunk->next.load(std::memory_order_acquire)) == nullptr)
+			std::this_thread::yield();
 	}
 
-	return chunk;
+	head.store(next, std::memory_order_release);
+	size.fetch_sub(1, std::memory_order_relaxed);
+	return MusicChunkPtr(chunk, deleter);
 }
 
 void
@@ -81,20 +87,35 @@ MusicPipe::Push(MusicChunkPtr chunk) noexcept
 	assert(!chunk->IsEmpty());
 	assert(chunk->length == 0 || chunk->audio_format.IsValid());
 
-	const std::lock_guard<Mutex> protect(mutex);
+	if (!have_deleter) {
+		deleter = chunk.get_deleter();
+		have_deleter = true;
+	}
+
+	MusicChunk *const c = chunk.release();
+	c->next.store(nullptr, std::memory_order_relaxed);
 
-	assert(size > 0 || !audio_format.IsDefined());
-	assert(!audio_format.IsDefined() ||
-	       chunk->CheckFormat(audio_format));
+	/* count it before the consumer can see it, so Shift()
+	   never underflows the counter */
+	size.fetch_add(1, std::memory_order_relaxed);
+
+	MusicChunk *const prev = tail.exchange(c, std::memory_order_acq_rel);
 
 #ifndef NDEBUG
-	if (!audio_format.IsDefined() && chunk->length > 0)
-		audio_format = chunk->audio_format;
-#endif
+	if (prev == nullptr)
+		/* the pipe was empty */
+		audio_format.Clear();
 
-	chunk->next.reset();
-	*tail_r = std::move(chunk);
-	tail_r = &(*tail_r)->next;
+	assert(!audio_format.IsDefined() ||
+	       c->CheckFormat(audio_format));
+
+	if (!audio_format.IsDefined() && c->length > 0)
+		audio_format = c->audio_format;
+#endif
 
-	++size;
+	/* publish the new chunk */
+	if (prev != nullptr)
+		prev->next.store(c, std::memory_order_release);
+	else
+		head.store(c, std::memory_order_release);
 }
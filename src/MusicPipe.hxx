@@ -21,31 +21,60 @@
 #define MPD_PIPE_H
 
 #include "MusicChunkPtr.hxx"
-#include "thread/Mutex.hxx"
 #include "util/Compiler.h"
 
 #ifndef NDEBUG
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
+
+struct MusicChunk;
+
 /**
- * A queue of #MusicChunk objects.  One party appends chunks at the
- * tail, and the other consumes them from the head.
+ * A queue of #MusicChunk objects.  One party (the producer) appends
+ * chunks at the tail, and the other (the consumer) removes them from
+ * the head.  This is lock-free: Push() may be called by one thread
+ * concurrently with Shift() and Clear() in another thread.  Other
+ * threads may call Peek() and follow the MusicChunk::next links, as
+ * long as the consumer does not remove the chunks they are looking
+ * at.
+ *
+ * Another thread may act as the consumer (e.g. Clear() in the
+ * decoder thread while seeking) if it is synchronized with the
+ * usual consumer by other means, e.g. a mutex.
  */
 class MusicPipe {
-	/** the first chunk */
-	MusicChunkPtr head;
+	/** the first chunk; only the consumer may remove it */
+	std::atomic<MusicChunk *> head{nullptr};
+
+	/**
+	 * The last chunk; nullptr if the consumer has removed it.
+	 * Push() replaces it and then links the new chunk to the
+	 * previous one (or publishes it as #head).
+	 */
+	std::atomic<MusicChunk *> tail{nullptr};
 
-	/** a pointer to the tail of the chunk */
-	MusicChunkPtr *tail_r = &head;
+	/**
+	 * The current number of chunks.  Push() increments it before
+	 * publishing a new chunk, so this is never smaller than the
+	 * number of chunks visible to the consumer.
+	 */
+	std::atomic<unsigned> size{0};
 
-	/** the current number of chunks */
-	unsigned size = 0;
+	/**
+	 * Returns the chunks to their #MusicBuffer.  This is copied
+	 * from the first chunk passed to Push(), and never changes
+	 * afterwards.  All chunks must come from the same
+	 * #MusicBuffer.
+	 */
+	MusicChunkDeleter deleter;
 
-	/** a mutex which protects #head and #tail_r */
-	mutable Mutex mutex;
+	/** has #deleter been initialized?  Used only by Push(). */
+	bool have_deleter = false;
 
 #ifndef NDEBUG
+	/** the audio format of all chunks; used only by the producer */
 	AudioFormat audio_format = AudioFormat::Undefined();
 #endif
 
@@ -78,37 +107,40 @@ public:
 	 */
 	gcc_pure
 	const MusicChunk *Peek() const noexcept {
-		const std::lock_guard<Mutex> protect(mutex);
-		return head.get();
+		return head.load(std::memory_order_acquire);
 	}
 
 	/**
-	 * Removes the first chunk from the head, and returns it.
+	 * Removes the first chunk from the head, and returns it.  May
+	 * only be called by the consumer.
 	 */
 	MusicChunkPtr Shift() noexcept;
 
 	/**
 	 * Clears the whole pipe and returns the chunks to the buffer.
+	 * May only be called by the consumer.
 	 */
 	void Clear() noexcept;
 
 	/**
-	 * Pushes a chunk to the tail of the pipe.
+	 * Pushes a chunk to the tail of the pipe.  May only be called
+	 * by the producer.
 	 */
 	void Push(MusicChunkPtr chunk) noexcept;
 
 	/**
-	 * Returns the number of chunks currently in this pipe.
+	 * Returns the number of chunks currently in this pipe.  While
+	 * Push() is in progress, this may include the new chunk
+	 * before Peek() returns it.
 	 */
 	gcc_pure
 	unsigned GetSize() const noexcept {
-		const std::lock_guard<Mutex> protect(mutex);
-		return size;
+		return size.load(std::memory_order_relaxed);
 	}
 
 	gcc_pure
 	bool IsEmpty() const noexcept {
-		return GetSize() == 0;
+		return Peek() == nullptr;
 	}
 };
 
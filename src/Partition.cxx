@@ -35,6 +35,8 @@ Partition::Partition(Instance &_instance,
 		     const char *_name,
 		     unsigned max_length,
 		     unsigned buffer_chunks,
+		     size_t chunk_size,
+		     SongTime predecode_time,
 		     AudioFormat configured_audio_format,
 		     const ReplayGainConfig &replay_gain_config) noexcept
 	:instance(_instance),
@@ -46,7 +48,7 @@ Partition::Partition(Instance &_instance,
 	 outputs(pc, *this),
 	 pc(*this, outputs,
 	    instance.input_cache.get(),
-	    buffer_chunks,
+	    buffer_chunks, chunk_size, predecode_time,
 	    configured_audio_format, replay_gain_config)
 {
 	UpdateEffectiveReplayGainMode();
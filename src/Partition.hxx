@@ -82,6 +82,8 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 		  const char *_name,
 		  unsigned max_length,
 		  unsigned buffer_chunks,
+		  size_t chunk_size,
+		  SongTime predecode_time,
 		  AudioFormat configured_audio_format,
 		  const ReplayGainConfig &replay_gain_config) noexcept;
 
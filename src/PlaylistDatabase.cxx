@@ -19,7 +19,7 @@
 
 #include "PlaylistDatabase.hxx"
 #include "db/PlaylistVector.hxx"
-#include "fs/io/TextFile.hxx"
+#include "fs/io/LineReader.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
 #include "time/ChronoUtil.hxx"
 #include "util/StringStrip.hxx"
@@ -40,8 +40,8 @@ playlist_vector_save(BufferedOutputStream &os, const PlaylistVector &pv)
 	}
 }
 
-void
-playlist_metadata_load(TextFile &file, PlaylistVector &pv, const char *name)
+PlaylistInfo
+playlist_metadata_load(LineReader &file, const char *name)
 {
 	PlaylistInfo pm(name);
 
@@ -65,5 +65,11 @@ playlist_metadata_load(TextFile &file, PlaylistVector &pv, const char *name)
 						 line);
 	}
 
-	pv.UpdateOrInsert(std::move(pm));
+	return pm;
+}
+
+void
+playlist_metadata_load(LineReader &file, PlaylistVector &pv, const char *name)
+{
+	pv.UpdateOrInsert(playlist_metadata_load(file, name));
 }
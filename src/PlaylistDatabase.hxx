@@ -22,17 +22,24 @@
 
 #define PLAYLIST_META_BEGIN "playlist_begin: "
 
+struct PlaylistInfo;
 class PlaylistVector;
 class BufferedOutputStream;
-class TextFile;
+class LineReader;
 
 void
 playlist_vector_save(BufferedOutputStream &os, const PlaylistVector &pv);
 
+/**
+ * Throws #std::runtime_error on error.
+ */
+PlaylistInfo
+playlist_metadata_load(LineReader &file, const char *name);
+
 /**
  * Throws #std::runtime_error on error.
  */
 void
-playlist_metadata_load(TextFile &file, PlaylistVector &pv, const char *name);
+playlist_metadata_load(LineReader &file, PlaylistVector &pv, const char *name);
 
 #endif
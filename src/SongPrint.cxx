@@ -23,6 +23,8 @@
 #include "TimePrint.hxx"
 #include "TagPrint.hxx"
 #include "client/Response.hxx"
+#include "protocol/Compact.hxx"
+#include "tag/Tag.hxx"
 #include "fs/Traits.hxx"
 #include "time/ChronoUtil.hxx"
 #include "util/UriUtil.hxx"
@@ -78,11 +80,89 @@ PrintRange(Response &r, SongTime start_time, SongTime end_time) noexcept
 			 start_ms % 1000);
 }
 
+static void
+CompactUri(CompactRecord &record, const char *uri, bool base) noexcept
+{
+	std::string allocated;
+
+	if (base) {
+		uri = PathTraitsUTF8::GetBase(uri);
+	} else {
+		allocated = uri_remove_auth(uri);
+		if (!allocated.empty())
+			uri = allocated.c_str();
+	}
+
+	record.AddString(CompactField::URI, uri);
+}
+
+static void
+CompactRange(CompactRecord &record,
+	     SongTime start_time, SongTime end_time) noexcept
+{
+	const unsigned start_ms = start_time.ToMS();
+	const unsigned end_ms = end_time.ToMS();
+
+	if (start_ms > 0 || end_ms > 0)
+		record.AddNumbers(CompactField::RANGE, start_ms, end_ms);
+}
+
+static void
+CompactLastModified(CompactRecord &record,
+		    std::chrono::system_clock::time_point mtime) noexcept
+{
+	if (IsNegative(mtime))
+		return;
+
+	const auto t = std::chrono::system_clock::to_time_t(mtime);
+	if (t >= 0)
+		record.AddNumber(CompactField::LAST_MODIFIED, t);
+}
+
+static void
+CompactTags(CompactRecord &record, SignedSongTime duration,
+	    const Tag &tag, TagMask tag_mask) noexcept
+{
+	if (!duration.IsNegative())
+		record.AddNumber(CompactField::DURATION, duration.ToMS());
+
+	for (const auto &i : tag)
+		if (tag_mask.Test(i.type))
+			record.AddTag(i.type, i.value);
+}
+
+static void
+CompactSongInfo(CompactRecord &record, const LightSong &song,
+		TagMask tag_mask, bool base) noexcept
+{
+	if (!base && song.directory != nullptr)
+		record.AddPath(CompactField::URI, song.directory, song.uri);
+	else
+		CompactUri(record, song.uri, base);
+
+	CompactRange(record, song.start_time, song.end_time);
+	CompactLastModified(record, song.mtime);
+
+	if (song.audio_format.IsDefined())
+		record.AddString(CompactField::FORMAT,
+				 ToString(song.audio_format).c_str());
+
+	CompactTags(record, song.tag.duration, song.tag, tag_mask);
+}
+
 void
-song_print_info(Response &r, const LightSong &song, bool base) noexcept
+song_compact_info(CompactRecord &record, const DetachedSong &song,
+		  TagMask tag_mask, bool base) noexcept
 {
-	song_print_uri(r, song, base);
+	CompactUri(record, song.GetURI(), base);
+	CompactRange(record, song.GetStartTime(), song.GetEndTime());
+	CompactLastModified(record, song.GetLastModified());
+	CompactTags(record, song.GetDuration(), song.GetTag(), tag_mask);
+}
 
+static void
+PrintSongDetails(Response &r, const LightSong &song) noexcept
+{
 	PrintRange(r, song.start_time, song.end_time);
 
 	if (!IsNegative(song.mtime))
@@ -94,9 +174,48 @@ song_print_info(Response &r, const LightSong &song, bool base) noexcept
 	tag_print(r, song.tag);
 }
 
+void
+song_print_info(Response &r, const LightSong &song, bool base) noexcept
+{
+	if (r.IsCompact()) {
+		CompactRecord record;
+		CompactSongInfo(record, song, r.GetTagMask(), base);
+		record.Finish();
+		r.WriteBinary(record.GetData());
+		return;
+	}
+
+	song_print_uri(r, song, base);
+
+	if (song.protocol_cache == nullptr ||
+	    r.GetTagMask() != TagMask::All()) {
+		PrintSongDetails(r, song);
+		return;
+	}
+
+	auto &cache = *song.protocol_cache;
+	if (cache == nullptr) {
+		std::string buffer;
+		Response r2(buffer, TagMask::All());
+		PrintSongDetails(r2, song);
+		cache = AllocatedString<>::Duplicate(buffer.data(),
+						     buffer.size());
+	}
+
+	r.Write(cache.c_str());
+}
+
 void
 song_print_info(Response &r, const DetachedSong &song, bool base) noexcept
 {
+	if (r.IsCompact()) {
+		CompactRecord record;
+		song_compact_info(record, song, r.GetTagMask(), base);
+		record.Finish();
+		r.WriteBinary(record.GetData());
+		return;
+	}
+
 	song_print_uri(r, song, base);
 
 	PrintRange(r, song.GetStartTime(), song.GetEndTime());
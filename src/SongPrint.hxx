@@ -23,6 +23,8 @@
 struct LightSong;
 class DetachedSong;
 class Response;
+class CompactRecord;
+class TagMask;
 
 void
 song_print_info(Response &r, const DetachedSong &song,
@@ -34,6 +36,14 @@ song_print_info(Response &r, const LightSong &song, bool base=false) noexcept;
 void
 song_print_uri(Response &r, const LightSong &song, bool base=false) noexcept;
 
+/**
+ * Add the information song_print_info() would print to a record of
+ * the compact protocol mode.
+ */
+void
+song_compact_info(CompactRecord &record, const DetachedSong &song,
+		  TagMask tag_mask, bool base=false) noexcept;
+
 void
 song_print_uri(Response &r, const DetachedSong &song,
 	       bool base=false) noexcept;
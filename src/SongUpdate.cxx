@@ -21,6 +21,7 @@
 #include "song/DetachedSong.hxx"
 #include "db/plugins/simple/Song.hxx"
 #include "db/plugins/simple/Directory.hxx"
+#include "db/DatabaseLock.hxx"
 #include "storage/StorageInterface.hxx"
 #include "storage/FileInfo.hxx"
 #include "fs/AllocatedPath.hxx"
@@ -58,33 +59,43 @@ Song::LoadFile(Storage &storage, const char *path_utf8, Directory &parent)
 #ifdef ENABLE_DATABASE
 
 bool
-Song::UpdateFile(Storage &storage)
+Song::ScanFile(Storage &storage, const char *uri_utf8,
+	       TagBuilder &tag_builder, AudioFormat &audio_format,
+	       std::chrono::system_clock::time_point &mtime)
 {
-	const auto &relative_uri = GetURI();
-
-	const auto info = storage.GetInfo(relative_uri.c_str(), true);
+	const auto info = storage.GetInfo(uri_utf8, true);
 	if (!info.IsRegular())
 		return false;
 
-	TagBuilder tag_builder;
-	auto new_audio_format = AudioFormat::Undefined();
-
-	const auto path_fs = storage.MapFS(relative_uri.c_str());
+	const auto path_fs = storage.MapFS(uri_utf8);
 	if (path_fs.IsNull()) {
-		const auto absolute_uri =
-			storage.MapUTF8(relative_uri.c_str());
+		const auto absolute_uri = storage.MapUTF8(uri_utf8);
 		if (!tag_stream_scan(absolute_uri.c_str(), tag_builder,
-				     &new_audio_format))
+				     &audio_format))
 			return false;
 	} else {
 		if (!ScanFileTagsWithGeneric(path_fs, tag_builder,
-					     &new_audio_format))
+					     &audio_format))
 			return false;
 	}
 
 	mtime = info.mtime;
-	audio_format = new_audio_format;
-	tag_builder.Commit(tag);
+	return true;
+}
+
+bool
+Song::UpdateFile(Storage &storage)
+{
+	TagBuilder tag_builder;
+	auto new_audio_format = AudioFormat::Undefined();
+	std::chrono::system_clock::time_point new_mtime;
+
+	if (!ScanFile(storage, GetURI().c_str(), tag_builder,
+		      new_audio_format, new_mtime))
+		return false;
+
+	const ScopeDatabaseLock protect;
+	ApplyScan(new_mtime, new_audio_format, tag_builder);
 	return true;
 }
 
@@ -109,7 +120,7 @@ Song::UpdateFileInArchive(ArchiveFile &archive) noexcept
 {
 	assert(parent.device == DEVICE_INARCHIVE);
 
-	std::string path_utf8(filename);
+	std::string path_utf8(filename.c_str());
 
 	for (const Directory *directory = &parent;
 	     directory->parent != nullptr &&
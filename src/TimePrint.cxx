@@ -20,6 +20,7 @@
 #include "TimePrint.hxx"
 #include "client/Response.hxx"
 #include "time/ISO8601.hxx"
+#include "util/StringView.hxx"
 
 void
 time_print(Response &r, const char *name,
@@ -33,5 +34,5 @@ time_print(Response &r, const char *name,
 		return;
 	}
 
-	r.Format("%s: %s\n", name, s.c_str());
+	r.WritePair(name, s.c_str());
 }
@@ -42,6 +42,14 @@ public:
 	 * #Client's #EventLoop thread.
 	 */
 	virtual void Cancel() noexcept = 0;
+
+	/**
+	 * The client's output buffer has been flushed completely.
+	 * Commands which send their response in portions may now
+	 * generate the next one, but must not write to the client
+	 * from inside this method.
+	 */
+	virtual void OnOutputDrained() noexcept {}
 };
 
 #endif
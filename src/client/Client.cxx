@@ -121,4 +121,13 @@ Client::GetStorage() const noexcept
 	return partition->instance.storage;
 }
 
+WorkerPool *
+Client::GetWorkerPool() const noexcept
+{
+	if (!IsBackgroundAllowed())
+		return nullptr;
+
+	return partition->instance.client_worker_pool.get();
+}
+
 #endif
@@ -48,6 +48,7 @@ struct playlist;
 class Database;
 class Storage;
 class BackgroundCommand;
+class WorkerPool;
 
 class Client final
 	: FullyBufferedSocket,
@@ -67,6 +68,12 @@ class Client final
 
 	const unsigned int num;	/* client number */
 
+	/**
+	 * Is a command list being executed right now?  Commands in a
+	 * list must not be deferred to a #BackgroundCommand.
+	 */
+	bool in_command_list = false;
+
 	/** is this client waiting for an "idle" response? */
 	bool idle_waiting = false;
 
@@ -84,6 +91,13 @@ public:
 	 */
 	TagMask tag_mask = TagMask::All();
 
+	/**
+	 * Has this client enabled the "compact" protocol feature?  If
+	 * yes, then songs are sent as binary records instead of text
+	 * lines.
+	 */
+	bool compact_responses = false;
+
 private:
 	static constexpr size_t MAX_SUBSCRIPTIONS = 16;
 
@@ -182,6 +196,15 @@ public:
 	 */
 	void OnBackgroundCommandFinished() noexcept;
 
+	/**
+	 * May the current command be deferred to a
+	 * #BackgroundCommand?  This is not possible inside a command
+	 * list.
+	 */
+	bool IsBackgroundAllowed() const noexcept {
+		return !in_command_list;
+	}
+
 	enum class SubscribeResult {
 		/** success */
 		OK,
@@ -260,6 +283,15 @@ public:
 	gcc_pure
 	const Storage *GetStorage() const noexcept;
 
+	/**
+	 * Returns Instance::client_worker_pool, which may execute
+	 * the current command, or nullptr if the command must be
+	 * executed synchronously (no "client_threads" configured, or inside
+	 * a command list).
+	 */
+	gcc_pure
+	WorkerPool *GetWorkerPool() const noexcept;
+
 private:
 	CommandResult ProcessCommandList(bool list_ok,
 					 std::list<std::string> &&list) noexcept;
@@ -271,6 +303,9 @@ private:
 	void OnSocketError(std::exception_ptr ep) noexcept override;
 	void OnSocketClosed() noexcept override;
 
+	/* virtual methods from class FullyBufferedSocket */
+	void OnSocketDrained() noexcept override;
+
 	/* callback for TimerEvent */
 	void OnTimeout() noexcept;
 };
@@ -18,6 +18,7 @@
  */
 
 #include "Client.hxx"
+#include "BackgroundCommand.hxx"
 #include "Log.hxx"
 
 void
@@ -33,3 +34,10 @@ Client::OnSocketClosed() noexcept
 {
 	SetExpired();
 }
+
+void
+Client::OnSocketDrained() noexcept
+{
+	if (background_command)
+		background_command->OnOutputDrained();
+}
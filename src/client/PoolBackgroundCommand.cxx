@@ -0,0 +1,105 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "PoolBackgroundCommand.hxx"
+#include "Client.hxx"
+#include "Config.hxx"
+#include "Domain.hxx"
+#include "Response.hxx"
+#include "command/CommandError.hxx"
+#include "protocol/Result.hxx"
+#include "Log.hxx"
+
+PoolBackgroundCommand::PoolBackgroundCommand(WorkerPool &_pool,
+					     Client &_client,
+					     const char *_command) noexcept
+	:pool(_pool),
+	 defer_finish(_client.GetEventLoop(),
+		      BIND_THIS_METHOD(DeferredFinish)),
+	 client(_client), command(_command)
+{
+}
+
+void
+PoolBackgroundCommand::RunJob() noexcept
+{
+	assert(!error);
+
+	Response r(client, 0, buffer);
+	r.SetCommand(command);
+
+	try {
+		result = Run(r);
+	} catch (...) {
+		error = std::current_exception();
+	}
+}
+
+void
+PoolBackgroundCommand::FinishJob() noexcept
+{
+	defer_finish.Schedule();
+}
+
+void
+PoolBackgroundCommand::DeferredFinish() noexcept
+{
+	if (!error && result == CommandResult::OK)
+		OnFinished(buffer);
+
+	/* copy everything to the stack, because a failed
+	   Client::Write() may delete this object */
+	Client &c = client;
+	const char *const cmd = command;
+	const std::string b = std::move(buffer);
+	const auto e = std::move(error);
+	const auto res = result;
+
+	if (b.size() > client_max_output_buffer_size) {
+		LogWarning(client_domain, "Output buffer is full");
+		/* this deletes this object */
+		c.SetExpired();
+		return;
+	}
+
+	c.Write(b.data(), b.size());
+
+	if (e) {
+		Response r(c, 0);
+		r.SetCommand(cmd);
+		PrintError(r, e);
+	} else if (res == CommandResult::OK)
+		command_success(c);
+
+	if (c.IsExpired())
+		return;
+
+	/* delete this object */
+	c.OnBackgroundCommandFinished();
+}
+
+void
+PoolBackgroundCommand::Cancel() noexcept
+{
+	pool.Cancel(*this);
+
+	/* cancel the DeferEvent, just in case the job has meanwhile
+	   finished execution */
+	defer_finish.Cancel();
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_POOL_BACKGROUND_COMMAND_HXX
+#define MPD_POOL_BACKGROUND_COMMAND_HXX
+
+#include "BackgroundCommand.hxx"
+#include "thread/WorkerPool.hxx"
+#include "command/CommandResult.hxx"
+#include "event/DeferEvent.hxx"
+
+#include <exception>
+#include <string>
+
+class Client;
+class Response;
+
+/**
+ * A #BackgroundCommand which runs in a #WorkerPool.  The response is
+ * collected in a buffer and sent to the client by the main thread
+ * after Run() has finished.
+ */
+class PoolBackgroundCommand
+	: public BackgroundCommand, WorkerPool::Job {
+
+	WorkerPool &pool;
+
+	DeferEvent defer_finish;
+
+	Client &client;
+
+	/**
+	 * The name of the command; used to generate error messages.
+	 */
+	const char *const command;
+
+	/**
+	 * The response generated by Run().
+	 */
+	std::string buffer;
+
+	/**
+	 * The error thrown by Run().
+	 */
+	std::exception_ptr error;
+
+	CommandResult result = CommandResult::OK;
+
+public:
+	PoolBackgroundCommand(WorkerPool &_pool, Client &_client,
+			      const char *_command) noexcept;
+
+	void Start() noexcept {
+		pool.Submit(*this);
+	}
+
+	/* virtual methods from class BackgroundCommand */
+	void Cancel() noexcept final;
+
+private:
+	/* virtual methods from class WorkerPool::Job */
+	void RunJob() noexcept final;
+	void FinishJob() noexcept final;
+
+	void DeferredFinish() noexcept;
+
+protected:
+	/**
+	 * Generate the response.  This runs in a worker thread, and
+	 * must not access anything which is owned by the main thread
+	 * except for the database (with #db_mutex).  If this method
+	 * throws, the exception will be converted to a MPD response.
+	 */
+	virtual CommandResult Run(Response &r) = 0;
+
+	/**
+	 * Called in the main thread after Run() has succeeded, right
+	 * before the response gets sent.
+	 */
+	virtual void OnFinished(const std::string &response) noexcept {
+		(void)response;
+	}
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "Log.hxx"
 #include "util/StringAPI.hxx"
 #include "util/CharUtil.hxx"
+#include "util/ScopeExit.hxx"
 
 #define CLIENT_LIST_MODE_BEGIN "command_list_begin"
 #define CLIENT_LIST_OK_MODE_BEGIN "command_list_ok_begin"
@@ -36,6 +37,9 @@ Client::ProcessCommandList(bool list_ok,
 {
 	unsigned n = 0;
 
+	in_command_list = true;
+	AtScopeExit(this) { in_command_list = false; };
+
 	for (auto &&i : list) {
 		char *cmd = &*i.begin();
 
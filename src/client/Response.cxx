@@ -19,30 +19,81 @@
 
 #include "Response.hxx"
 #include "Client.hxx"
+#include "Config.hxx"
 #include "util/FormatString.hxx"
 #include "util/AllocatedString.hxx"
+#include "util/StringView.hxx"
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
 
 TagMask
 Response::GetTagMask() const noexcept
 {
-	return GetClient().tag_mask;
+	return client != nullptr
+		? client->tag_mask
+		: detached_tag_mask;
+}
+
+bool
+Response::IsCompact() const noexcept
+{
+	return client != nullptr && client->compact_responses;
 }
 
 bool
 Response::Write(const void *data, size_t length) noexcept
 {
-	return client.Write(data, length);
+	if (capture != nullptr)
+		capture->append((const char *)data, length);
+
+	if (buffer != nullptr) {
+		/* once the limit is exceeded, stop growing the
+		   buffer; PoolBackgroundCommand will notice and
+		   disconnect the client */
+		if (client == nullptr) {
+			/* detached: no limit */
+			buffer->append((const char *)data, length);
+			return true;
+		}
+
+		if (buffer->size() > client_max_output_buffer_size)
+			return false;
+
+		buffer->append((const char *)data, length);
+		return buffer->size() <= client_max_output_buffer_size;
+	}
+
+	return client->Write(data, length);
 }
 
 bool
 Response::Write(const char *data) noexcept
 {
-	return client.Write(data);
+	return Write(data, strlen(data));
 }
 
 bool
 Response::FormatV(const char *fmt, std::va_list args) noexcept
 {
+	/* almost all lines are short; format them on the stack and
+	   fall back to a heap allocation only if that doesn't fit */
+	char stack_buffer[1024];
+
+	std::va_list args2;
+	va_copy(args2, args);
+	const int length = vsnprintf(stack_buffer, sizeof(stack_buffer),
+				     fmt, args2);
+	va_end(args2);
+
+	if (length < 0)
+		return false;
+
+	if (size_t(length) < sizeof(stack_buffer))
+		return Write(stack_buffer, length);
+
 	return Write(FormatStringV(fmt, args).c_str());
 }
 
@@ -56,6 +107,26 @@ Response::Format(const char *fmt, ...) noexcept
 	return success;
 }
 
+bool
+Response::WritePair(StringView name, StringView value) noexcept
+{
+	char stack_buffer[1024];
+
+	if (name.size + value.size + 3 > sizeof(stack_buffer))
+		return Write(name.data, name.size) &&
+			Write(": ", 2) &&
+			Write(value.data, value.size) &&
+			Write("\n", 1);
+
+	char *p = std::copy_n(name.data, name.size, stack_buffer);
+	*p++ = ':';
+	*p++ = ' ';
+	p = std::copy_n(value.data, value.size, p);
+	*p++ = '\n';
+
+	return Write(stack_buffer, p - stack_buffer);
+}
+
 bool
 Response::WriteBinary(ConstBuffer<void> payload) noexcept
 {
@@ -21,17 +21,28 @@
 #define MPD_RESPONSE_HXX
 
 #include "protocol/Ack.hxx"
+#include "tag/Mask.hxx"
 #include "util/Compiler.h"
 
 #include <cstdarg>
 #include <cstddef>
+#include <string>
 
 template<typename T> struct ConstBuffer;
+struct StringView;
 class Client;
-class TagMask;
 
 class Response {
-	Client &client;
+	/**
+	 * The client this response is sent to; nullptr if this is a
+	 * detached response (see #buffer).
+	 */
+	Client *const client;
+
+	/**
+	 * The tag mask of a detached response.
+	 */
+	const TagMask detached_tag_mask = TagMask::All();
 
 	/**
 	 * This command's index in the command list.  Used to generate
@@ -44,9 +55,39 @@ class Response {
 	 */
 	const char *command = "";
 
+	/**
+	 * If not nullptr, then all data written to the client is
+	 * also appended to this string.  This is used to fill the
+	 * #DatabaseResponseCache.
+	 */
+	std::string *capture = nullptr;
+
+	/**
+	 * If not nullptr, then all data is appended to this string
+	 * instead of being written to the client.  This is used by
+	 * #PoolBackgroundCommand, which must not touch the client's
+	 * socket from a worker thread.
+	 */
+	std::string *const buffer = nullptr;
+
 public:
 	Response(Client &_client, unsigned _list_index) noexcept
-		:client(_client), list_index(_list_index) {}
+		:client(&_client), list_index(_list_index) {}
+
+	Response(Client &_client, unsigned _list_index,
+		 std::string &_buffer) noexcept
+		:client(&_client), list_index(_list_index),
+		 buffer(&_buffer) {}
+
+	/**
+	 * Create a response which is not attached to any #Client;
+	 * all data is appended to the given string.  This is used by
+	 * benchmarks.  GetClient() must not be called on such an
+	 * object.
+	 */
+	Response(std::string &_buffer, TagMask _tag_mask) noexcept
+		:client(nullptr), detached_tag_mask(_tag_mask),
+		 list_index(0), buffer(&_buffer) {}
 
 	Response(const Response &) = delete;
 	Response &operator=(const Response &) = delete;
@@ -58,7 +99,7 @@ public:
 	 * returned reference is "const".
 	 */
 	const Client &GetClient() const noexcept {
-		return client;
+		return *client;
 	}
 
 	/**
@@ -68,15 +109,39 @@ public:
 	gcc_pure
 	TagMask GetTagMask() const noexcept;
 
+	/**
+	 * Accessor for Client::compact_responses.  Detached responses
+	 * are always in the text format.
+	 */
+	gcc_pure
+	bool IsCompact() const noexcept;
+
+	const char *GetCommand() const noexcept {
+		return command;
+	}
+
 	void SetCommand(const char *_command) noexcept {
 		command = _command;
 	}
 
+	/**
+	 * Start or stop (with nullptr) copying all response data to
+	 * the given string.
+	 */
+	void SetCapture(std::string *_capture) noexcept {
+		capture = _capture;
+	}
+
 	bool Write(const void *data, size_t length) noexcept;
 	bool Write(const char *data) noexcept;
 	bool FormatV(const char *fmt, std::va_list args) noexcept;
 	bool Format(const char *fmt, ...) noexcept;
 
+	/**
+	 * Write a "NAME: VALUE" line.  This is cheaper than Format().
+	 */
+	bool WritePair(StringView name, StringView value) noexcept;
+
 	static constexpr size_t MAX_BINARY_SIZE = 8192;
 
 	/**
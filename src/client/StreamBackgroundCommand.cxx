@@ -0,0 +1,105 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "StreamBackgroundCommand.hxx"
+#include "Client.hxx"
+#include "Config.hxx"
+#include "Domain.hxx"
+#include "Response.hxx"
+#include "command/CommandError.hxx"
+#include "protocol/Result.hxx"
+#include "Log.hxx"
+
+#include <string>
+
+StreamBackgroundCommand::StreamBackgroundCommand(Client &_client,
+						 const char *_command) noexcept
+	:defer_step(_client.GetEventLoop(), BIND_THIS_METHOD(OnDeferredStep)),
+	 client(_client), command(_command)
+{
+}
+
+void
+StreamBackgroundCommand::OnDeferredStep() noexcept
+{
+	/* generate the portion into a buffer first, because a failed
+	   Client::Write() may delete this object */
+	std::string buffer;
+	bool more;
+	std::exception_ptr error;
+
+	{
+		Response r(client, 0, buffer);
+		r.SetCommand(command);
+
+		try {
+			more = Step(r);
+		} catch (...) {
+			more = false;
+			error = std::current_exception();
+		}
+	}
+
+	Client &c = client;
+	const char *const cmd = command;
+
+	if (buffer.size() > client_max_output_buffer_size) {
+		LogWarning(client_domain, "Output buffer is full");
+		/* this deletes this object */
+		c.SetExpired();
+		return;
+	}
+
+	if (more) {
+		if (buffer.empty())
+			/* nothing was sent, so there will be no
+			   OnOutputDrained() call */
+			defer_step.Schedule();
+		else
+			c.Write(buffer.data(), buffer.size());
+		return;
+	}
+
+	c.Write(buffer.data(), buffer.size());
+
+	if (error) {
+		Response r(c, 0);
+		r.SetCommand(cmd);
+		PrintError(r, error);
+	} else
+		command_success(c);
+
+	if (c.IsExpired())
+		return;
+
+	/* delete this object */
+	c.OnBackgroundCommandFinished();
+}
+
+void
+StreamBackgroundCommand::OnOutputDrained() noexcept
+{
+	defer_step.Schedule();
+}
+
+void
+StreamBackgroundCommand::Cancel() noexcept
+{
+	defer_step.Cancel();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_STREAM_BACKGROUND_COMMAND_HXX
+#define MPD_STREAM_BACKGROUND_COMMAND_HXX
+
+#include "BackgroundCommand.hxx"
+#include "event/DeferEvent.hxx"
+
+class Client;
+class Response;
+
+/**
+ * A #BackgroundCommand which sends a large response in portions.
+ * The next portion is only generated after the previous one has been
+ * sent to the client, which limits the size of the client's output
+ * buffer regardless of the total response size.  Everything runs in
+ * the client's #EventLoop thread.
+ */
+class StreamBackgroundCommand : public BackgroundCommand {
+	DeferEvent defer_step;
+
+	Client &client;
+
+	/**
+	 * The name of the command; used to generate error messages.
+	 */
+	const char *const command;
+
+public:
+	StreamBackgroundCommand(Client &_client,
+				const char *_command) noexcept;
+
+	void Start() noexcept {
+		defer_step.Schedule();
+	}
+
+	/* virtual methods from class BackgroundCommand */
+	void Cancel() noexcept final;
+	void OnOutputDrained() noexcept final;
+
+private:
+	void OnDeferredStep() noexcept;
+
+protected:
+	/**
+	 * Generate the next portion of the response.  If this method
+	 * throws, the exception will be converted to a MPD response
+	 * and the command is finished.
+	 *
+	 * @return true if there is more data, false if the response
+	 * is complete
+	 */
+	virtual bool Step(Response &r) = 0;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "client/Client.hxx"
 #include "client/Response.hxx"
 #include "TagPrint.hxx"
+#include "protocol/Compact.hxx"
 #include "tag/ParseName.hxx"
 #include "util/StringAPI.hxx"
 
@@ -109,3 +110,102 @@ handle_tagtypes(Client &client, Request request, Response &r)
 		return CommandResult::ERROR;
 	}
 }
+
+/**
+ * Throws if one of the given names is not a known protocol feature.
+ * Currently, there is only "compact".
+ */
+static void
+CheckProtocolFeatures(Request request)
+{
+	if (request.empty())
+		throw ProtocolError(ACK_ERROR_ARG, "Not enough arguments");
+
+	for (const char *name : request)
+		if (!StringIsEqual(name, "compact"))
+			throw ProtocolError(ACK_ERROR_ARG,
+					    "Unknown protocol feature");
+}
+
+static void
+PrintCompactCodes(Response &r) noexcept
+{
+	static constexpr struct {
+		CompactField code;
+		const char *name;
+	} fields[] = {
+		{ CompactField::URI, "file" },
+		{ CompactField::LAST_MODIFIED, "Last-Modified" },
+		{ CompactField::RANGE, "Range" },
+		{ CompactField::FORMAT, "Format" },
+		{ CompactField::DURATION, "duration" },
+		{ CompactField::POS, "Pos" },
+		{ CompactField::ID, "Id" },
+		{ CompactField::PRIO, "Prio" },
+		{ CompactField::TRUNCATED, "truncated" },
+	};
+
+	for (const auto &i : fields)
+		r.Format("code: %u %s\n", unsigned(i.code), i.name);
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; i++)
+		r.Format("code: %u %s\n",
+			 unsigned(CompactField::TAG) + i,
+			 tag_item_names[i]);
+}
+
+CommandResult
+handle_protocol(Client &client, Request request, Response &r)
+{
+	if (request.empty()) {
+		if (client.compact_responses)
+			r.Write("feature: compact\n");
+		return CommandResult::OK;
+	}
+
+	const char *cmd = request.shift();
+	if (StringIsEqual(cmd, "available")) {
+		if (!request.empty()) {
+			r.Error(ACK_ERROR_ARG, "Too many arguments");
+			return CommandResult::ERROR;
+		}
+
+		r.Write("feature: compact\n");
+		return CommandResult::OK;
+	} else if (StringIsEqual(cmd, "codes")) {
+		if (!request.empty()) {
+			r.Error(ACK_ERROR_ARG, "Too many arguments");
+			return CommandResult::ERROR;
+		}
+
+		PrintCompactCodes(r);
+		return CommandResult::OK;
+	} else if (StringIsEqual(cmd, "all")) {
+		if (!request.empty()) {
+			r.Error(ACK_ERROR_ARG, "Too many arguments");
+			return CommandResult::ERROR;
+		}
+
+		client.compact_responses = true;
+		return CommandResult::OK;
+	} else if (StringIsEqual(cmd, "clear")) {
+		if (!request.empty()) {
+			r.Error(ACK_ERROR_ARG, "Too many arguments");
+			return CommandResult::ERROR;
+		}
+
+		client.compact_responses = false;
+		return CommandResult::OK;
+	} else if (StringIsEqual(cmd, "enable")) {
+		CheckProtocolFeatures(request);
+		client.compact_responses = true;
+		return CommandResult::OK;
+	} else if (StringIsEqual(cmd, "disable")) {
+		CheckProtocolFeatures(request);
+		client.compact_responses = false;
+		return CommandResult::OK;
+	} else {
+		r.Error(ACK_ERROR_ARG, "Unknown sub command");
+		return CommandResult::ERROR;
+	}
+}
@@ -24,17 +24,27 @@
 #include "db/DatabasePrint.hxx"
 #include "db/Count.hxx"
 #include "db/Selection.hxx"
+#include "db/ResponseCache.hxx"
+#include "db/Interface.hxx"
+#include "db/DatabasePlugin.hxx"
+#include "db/update/Service.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
 #include "protocol/RangeArg.hxx"
 #include "client/Client.hxx"
+#include "client/PoolBackgroundCommand.hxx"
+#include "client/StreamBackgroundCommand.hxx"
 #include "client/Response.hxx"
 #include "tag/ParseName.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/Exception.hxx"
 #include "util/StringAPI.hxx"
 #include "util/ASCII.hxx"
+#include "util/ScopeExit.hxx"
 #include "song/Filter.hxx"
+#include "Instance.hxx"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 CommandResult
@@ -114,17 +124,244 @@ ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
 	return selection;
 }
 
+/**
+ * Returns the #DatabaseResponseCache if responses may be served from
+ * it, or nullptr if not.  Only the local database announces all
+ * modifications via Instance::OnDatabaseModified() and
+ * SimpleDatabase::GetVersion(), and only while no update is running.
+ */
+static DatabaseResponseCache *
+GetResponseCache(Client &client) noexcept
+{
+	auto &instance = client.GetInstance();
+	if (instance.update == nullptr || instance.update->GetId() != 0)
+		return nullptr;
+
+	const auto *db = dynamic_cast<const SimpleDatabase *>(instance.GetDatabase());
+	if (db == nullptr)
+		return nullptr;
+
+	auto &cache = instance.database_response_cache;
+	cache.Validate(db->GetVersion());
+	return &cache;
+}
+
+/**
+ * Returns Instance::client_worker_pool if the current command may be
+ * executed there, or nullptr if it must run in the main thread.
+ */
+static WorkerPool *
+GetWorkerPool(Client &client)
+{
+	auto *pool = client.GetWorkerPool();
+	if (pool == nullptr ||
+	    !client.GetDatabaseOrThrow().GetPlugin().IsThreadSafe())
+		return nullptr;
+
+	return pool;
+}
+
+/**
+ * A read-only database command running in
+ * Instance::client_worker_pool.  The function object receives a
+ * #Response and the client's #Partition; it must own copies of all
+ * its parameters, because the #Request is gone by the time it runs.
+ */
+template<typename F>
+class DatabaseCommand final : public PoolBackgroundCommand {
+	Client &client;
+
+	F f;
+
+	/**
+	 * If not empty, then the response will be stored in the
+	 * #DatabaseResponseCache with this key.
+	 */
+	std::string cache_key;
+
+	unsigned cache_generation;
+
+public:
+	DatabaseCommand(WorkerPool &_pool, Client &_client,
+			const char *_command, F &&_f,
+			std::string &&_cache_key={},
+			unsigned _cache_generation=0) noexcept
+		:PoolBackgroundCommand(_pool, _client, _command),
+		 client(_client), f(std::move(_f)),
+		 cache_key(std::move(_cache_key)),
+		 cache_generation(_cache_generation) {}
+
+protected:
+	CommandResult Run(Response &r) override {
+		f(r, client.GetPartition());
+		return CommandResult::OK;
+	}
+
+	void OnFinished(const std::string &response) noexcept override {
+		if (cache_key.empty())
+			return;
+
+		/* don't store the response if the database has been
+		   modified meanwhile */
+		auto *cache = GetResponseCache(client);
+		if (cache == nullptr ||
+		    cache->GetGeneration() != cache_generation)
+			return;
+
+		try {
+			cache->Put(std::move(cache_key),
+				   std::string(response));
+		} catch (...) {
+			/* out of memory - ignore, it's just a cache */
+		}
+	}
+};
+
+template<typename F>
 static CommandResult
-handle_match(Client &client, Request args, Response &r, bool fold_case)
+StartDatabaseCommand(WorkerPool &pool, Client &client, Response &r,
+		     F &&f, std::string &&cache_key={},
+		     unsigned cache_generation=0)
 {
-	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
+	auto cmd = std::make_unique<DatabaseCommand<std::decay_t<F>>>(pool, client,
+								     r.GetCommand(),
+								     std::forward<F>(f),
+								     std::move(cache_key),
+								     cache_generation);
+	cmd->Start();
+	client.SetBackgroundCommand(std::move(cmd));
+	return CommandResult::BACKGROUND;
+}
 
-	db_selection_print(r, client.GetPartition(),
-			   selection, true, false);
+/**
+ * Invoke the given function which prints the response of a read-only
+ * database command.  If "client_threads" is configured, this is done
+ * in Instance::client_worker_pool, so the main thread can serve
+ * other clients meanwhile.
+ */
+template<typename F>
+static CommandResult
+PrintDatabase(Client &client, Response &r, F &&f)
+{
+	if (auto *pool = GetWorkerPool(client))
+		return StartDatabaseCommand(*pool, client, r,
+					    std::forward<F>(f));
+
+	f(r, client.GetPartition());
+	return CommandResult::OK;
+}
+
+/**
+ * Sends a recursive directory listing ("listall", "listallinfo") in
+ * portions, so its size is not limited by the client's output
+ * buffer.
+ */
+class DatabaseTreeCommand final : public StreamBackgroundCommand {
+	/**
+	 * The number of entries printed in one portion.
+	 */
+	static constexpr unsigned PORTION = 1024;
+
+	Client &client;
+
+	DatabaseTreePrinter printer;
+
+public:
+	DatabaseTreeCommand(Client &_client, const char *_command,
+			    bool full) noexcept
+		:StreamBackgroundCommand(_client, _command),
+		 client(_client), printer(_client, full) {}
+
+	bool Open(const char *uri) {
+		return printer.Open(client.GetPartition(), uri);
+	}
+
+protected:
+	bool Step(Response &r) override {
+		return printer.Print(r, client.GetPartition(), PORTION);
+	}
+};
+
+static CommandResult
+PrintDatabaseTree(Client &client, Response &r, const char *uri, bool full)
+{
+	if (client.IsBackgroundAllowed()) {
+		auto cmd = std::make_unique<DatabaseTreeCommand>(client,
+								 r.GetCommand(),
+								 full);
+		if (cmd->Open(uri)) {
+			cmd->Start();
+			client.SetBackgroundCommand(std::move(cmd));
+			return CommandResult::BACKGROUND;
+		}
+
+		/* not a directory (probably a song): print it right
+		   away */
+	}
+
+	return PrintDatabase(client, r,
+			     [uri=std::string(uri), full](Response &r2,
+							  Partition &partition){
+				     db_selection_print(r2, partition,
+							DatabaseSelection(uri.c_str(),
+									  true),
+							full, false);
+			     });
+}
+
+/**
+ * Like PrintDatabase(), but if the same command was answered before,
+ * the cached response is sent instead; otherwise the new response is
+ * stored in the cache.
+ */
+template<typename F>
+static CommandResult
+PrintCached(Client &client, Response &r,
+	    const char *command, Request args, F &&f)
+{
+	auto *cache = GetResponseCache(client);
+	if (cache == nullptr)
+		return PrintDatabase(client, r, std::forward<F>(f));
+
+	auto key = DatabaseResponseCache::MakeKey(r.GetTagMask(), command,
+						  args);
+	if (const auto *value = cache->Get(key)) {
+		r.Write(value->data(), value->size());
+		return CommandResult::OK;
+	}
+
+	if (auto *pool = GetWorkerPool(client))
+		return StartDatabaseCommand(*pool, client, r,
+					    std::forward<F>(f),
+					    std::move(key),
+					    cache->GetGeneration());
+
+	std::string value;
+	r.SetCapture(&value);
+	AtScopeExit(&r) { r.SetCapture(nullptr); };
+
+	f(r, client.GetPartition());
+
+	cache->Put(std::move(key), std::move(value));
 	return CommandResult::OK;
 }
 
+static CommandResult
+handle_match(Client &client, Request args, Response &r, bool fold_case)
+{
+	/* the filter is allocated on the heap, because the selection
+	   points to it and both may be moved to a worker thread */
+	auto filter = std::make_unique<SongFilter>();
+	auto selection = ParseDatabaseSelection(args, fold_case, *filter);
+
+	return PrintDatabase(client, r,
+			     [filter=std::move(filter), selection](Response &r2,
+								   Partition &partition){
+				     db_selection_print(r2, partition,
+							selection, true, false);
+			     });
+}
+
 CommandResult
 handle_find(Client &client, Request args, Response &r)
 {
@@ -178,6 +415,8 @@ handle_searchaddpl(Client &client, Request args, Response &)
 CommandResult
 handle_count(Client &client, Request args, Response &r)
 {
+	const Request original_args = args;
+
 	TagType group = TAG_NUM_OF_ITEM_TYPES;
 	if (args.size >= 2 && StringIsEqual(args[args.size - 2], "group")) {
 		const char *s = args[args.size - 1];
@@ -205,8 +444,19 @@ handle_count(Client &client, Request args, Response &r)
 		filter.Optimize();
 	}
 
-	PrintSongCount(r, client.GetPartition(), "", &filter, group);
-	return CommandResult::OK;
+	if (group == TAG_NUM_OF_ITEM_TYPES) {
+		/* a plain "count" is cheap enough with the database
+		   indexes and is not worth a cache entry */
+		PrintSongCount(r, client.GetPartition(), "", &filter, group);
+		return CommandResult::OK;
+	}
+
+	return PrintCached(client, r, "count", original_args,
+			   [filter=std::move(filter), group](Response &r2,
+							     Partition &partition){
+				   PrintSongCount(r2, partition, "", &filter,
+						  group);
+			   });
 }
 
 CommandResult
@@ -215,10 +465,7 @@ handle_listall(Client &client, Request args, Response &r)
 	/* default is root directory */
 	const auto uri = args.GetOptional(0, "");
 
-	db_selection_print(r, client.GetPartition(),
-			   DatabaseSelection(uri, true),
-			   false, false);
-	return CommandResult::OK;
+	return PrintDatabaseTree(client, r, uri, false);
 }
 
 static CommandResult
@@ -238,13 +485,17 @@ handle_list_file(Client &client, Request args, Response &r)
 		filter->Optimize();
 	}
 
-	PrintSongUris(r, client.GetPartition(), filter.get());
-	return CommandResult::OK;
+	return PrintDatabase(client, r,
+			     [filter=std::move(filter)](Response &r2,
+							Partition &partition){
+				     PrintSongUris(r2, partition, filter.get());
+			     });
 }
 
 CommandResult
 handle_list(Client &client, Request args, Response &r)
 {
+	const Request original_args = args;
 	const char *tag_name = args.shift();
 	if (StringEqualsCaseASCII(tag_name, "file") ||
 	    StringEqualsCaseASCII(tag_name, "filename"))
@@ -313,10 +564,15 @@ handle_list(Client &client, Request args, Response &r)
 		filter->Optimize();
 	}
 
-	PrintUniqueTags(r, client.GetPartition(),
-			{&tag_types.front(), tag_types.size()},
-			filter.get());
-	return CommandResult::OK;
+	return PrintCached(client, r, "list", original_args,
+			   [tag_types=std::move(tag_types),
+			    filter=std::move(filter)](Response &r2,
+						      Partition &partition){
+				   PrintUniqueTags(r2, partition,
+						   {&tag_types.front(),
+						    tag_types.size()},
+						   filter.get());
+			   });
 }
 
 CommandResult
@@ -325,8 +581,5 @@ handle_listallinfo(Client &client, Request args, Response &r)
 	/* default is root directory */
 	const auto uri = args.GetOptional(0, "");
 
-	db_selection_print(r, client.GetPartition(),
-			   DatabaseSelection(uri, true),
-			   true, false);
-	return CommandResult::OK;
+	return PrintDatabaseTree(client, r, uri, true);
 }
@@ -21,6 +21,7 @@
 #include "Request.hxx"
 #include "Instance.hxx"
 #include "Partition.hxx"
+#include "MusicChunk.hxx"
 #include "IdleFlags.hxx"
 #include "output/Filtered.hxx"
 #include "client/Client.hxx"
@@ -102,6 +103,8 @@ handle_newpartition(Client &client, Request request, Response &response)
 					 // TODO: use real configuration
 					 16384,
 					 1024,
+					 DEFAULT_CHUNK_SIZE,
+					 SongTime::zero(),
 					 AudioFormat::Undefined(),
 					 ReplayGainConfig());
 	auto &partition = instance.partitions.back();
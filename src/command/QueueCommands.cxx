@@ -28,9 +28,11 @@
 #include "song/DetachedSong.hxx"
 #include "LocateUri.hxx"
 #include "queue/Playlist.hxx"
+#include "queue/QueuePrint.hxx"
 #include "PlaylistPrint.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
+#include "client/StreamBackgroundCommand.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "BulkEdit.hxx"
@@ -39,7 +41,11 @@
 #include "util/StringAPI.hxx"
 #include "util/NumberParser.hxx"
 
+#include <algorithm>
+#include <cassert>
 #include <limits>
+#include <memory>
+#include <vector>
 
 static void
 AddUri(Client &client, const LocatedUri &uri)
@@ -236,14 +242,85 @@ handle_plchangesposid(Client &client, Request args, Response &r)
 	return CommandResult::OK;
 }
 
+/**
+ * Sends a large range of the queue in portions, so its size is not
+ * limited by the client's output buffer.  The song ids are copied
+ * when the command starts, and each portion looks them up again: if
+ * the queue is modified meanwhile, every song of the original range
+ * is still sent exactly once (with its current position), and songs
+ * which have been deleted are skipped.  The client will be notified
+ * with an "idle playlist" event anyway.
+ */
+class PlaylistInfoCommand final : public StreamBackgroundCommand {
+	Client &client;
+
+	/**
+	 * The ids of all songs in the requested range.
+	 */
+	std::vector<unsigned> ids;
+
+	/**
+	 * The index of the next id in #ids to be sent.
+	 */
+	std::size_t next = 0;
+
+public:
+	/**
+	 * The number of songs printed in one portion.
+	 */
+	static constexpr unsigned PORTION = 256;
+
+	PlaylistInfoCommand(Client &_client, const char *_command,
+			    unsigned start, unsigned _end) noexcept
+		:StreamBackgroundCommand(_client, _command),
+		 client(_client) {
+		const Queue &queue = client.GetPlaylist().queue;
+		assert(start <= _end);
+		assert(_end <= queue.GetLength());
+
+		ids.reserve(_end - start);
+		for (unsigned i = start; i < _end; ++i)
+			ids.push_back(queue.PositionToId(i));
+	}
+
+protected:
+	bool Step(Response &r) override {
+		const std::size_t n = std::min(ids.size() - next,
+					       std::size_t(PORTION));
+		queue_print_ids(r, client.GetPlaylist().queue,
+				{ids.data() + next, n});
+		next += n;
+
+		return next < ids.size();
+	}
+};
+
+static CommandResult
+PrintPlaylistInfo(Client &client, Response &r, unsigned start, unsigned end)
+{
+	const auto &playlist = client.GetPlaylist();
+	end = std::min(end, playlist.queue.GetLength());
+
+	if (start < end && end - start > PlaylistInfoCommand::PORTION &&
+	    client.IsBackgroundAllowed()) {
+		auto cmd = std::make_unique<PlaylistInfoCommand>(client,
+								 r.GetCommand(),
+								 start, end);
+		cmd->Start();
+		client.SetBackgroundCommand(std::move(cmd));
+		return CommandResult::BACKGROUND;
+	}
+
+	playlist_print_info(r, playlist, start, end);
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_playlistinfo(Client &client, Request args, Response &r)
 {
 	RangeArg range = args.ParseOptional(0, RangeArg::All());
 
-	playlist_print_info(r, client.GetPlaylist(),
-			    range.start, range.end);
-	return CommandResult::OK;
+	return PrintPlaylistInfo(client, r, range.start, range.end);
 }
 
 CommandResult
@@ -253,8 +330,8 @@ handle_playlistid(Client &client, Request args, Response &r)
 		unsigned id = args.ParseUnsigned(0);
 		playlist_print_id(r, client.GetPlaylist(), id);
 	} else {
-		playlist_print_info(r, client.GetPlaylist(),
-				    0, std::numeric_limits<unsigned>::max());
+		return PrintPlaylistInfo(client, r,
+					 0, std::numeric_limits<unsigned>::max());
 	}
 
 	return CommandResult::OK;
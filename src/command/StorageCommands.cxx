@@ -216,6 +216,7 @@ handle_mount(Client &client, Request args, Response &r)
 
 		// TODO: call Instance::OnDatabaseModified()?
 		// TODO: trigger database update?
+		instance.database_response_cache.Clear();
 		instance.EmitIdle(IDLE_DATABASE);
 	}
 #endif
@@ -251,9 +252,11 @@ handle_unmount(Client &client, Request args, Response &r)
 		instance.update->CancelMount(local_uri);
 
 	if (auto *db = dynamic_cast<SimpleDatabase *>(instance.GetDatabase())) {
-		if (db->Unmount(local_uri))
+		if (db->Unmount(local_uri)) {
 			// TODO: call Instance::OnDatabaseModified()?
+			instance.database_response_cache.Clear();
 			instance.EmitIdle(IDLE_DATABASE);
+		}
 	}
 #endif
 
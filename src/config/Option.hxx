@@ -58,7 +58,10 @@ enum class ConfigOption {
 	REPLAYGAIN_LIMIT,
 	VOLUME_NORMALIZATION,
 	SAMPLERATE_CONVERTER,
+	DSD2PCM,
 	AUDIO_BUFFER_SIZE,
+	AUDIO_CHUNK_SIZE,
+	PREDECODE_TIME,
 	BUFFER_BEFORE_PLAY,
 	HTTP_PROXY_HOST,
 	HTTP_PROXY_PORT,
@@ -69,6 +72,7 @@ enum class ConfigOption {
 	MAX_PLAYLIST_LENGTH,
 	MAX_COMMAND_LIST_SIZE,
 	MAX_OUTPUT_BUFFER_SIZE,
+	CLIENT_THREADS,
 	FS_CHARSET,
 	ID3V1_ENCODING,
 	METADATA_TO_USE,
@@ -76,6 +80,7 @@ enum class ConfigOption {
 	GAPLESS_MP3_PLAYBACK,
 	AUTO_UPDATE,
 	AUTO_UPDATE_DEPTH,
+	UPDATE_THREADS,
 	DESPOTIFY_USER,
 	DESPOTIFY_PASSWORD,
 	DESPOTIFY_HIGH_BITRATE,
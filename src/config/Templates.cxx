@@ -54,7 +54,10 @@ const ConfigTemplate config_param_templates[] = {
 	{ "replaygain_limit" },
 	{ "volume_normalization" },
 	{ "samplerate_converter" },
+	{ "dsd2pcm" },
 	{ "audio_buffer_size" },
+	{ "audio_chunk_size" },
+	{ "predecode_time" },
 	{ "buffer_before_play", false, true },
 	{ "http_proxy_host", false, true },
 	{ "http_proxy_port", false, true },
@@ -65,6 +68,7 @@ const ConfigTemplate config_param_templates[] = {
 	{ "max_playlist_length" },
 	{ "max_command_list_size" },
 	{ "max_output_buffer_size" },
+	{ "client_threads" },
 	{ "filesystem_charset" },
 	{ "id3v1_encoding", false, true },
 	{ "metadata_to_use" },
@@ -72,6 +76,7 @@ const ConfigTemplate config_param_templates[] = {
 	{ "gapless_mp3_playback", false, true },
 	{ "auto_update" },
 	{ "auto_update_depth" },
+	{ "update_threads" },
 	{ "despotify_user", false, true },
 	{ "despotify_password", false, true },
 	{ "despotify_high_bitrate", false, true },
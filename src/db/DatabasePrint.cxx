@@ -28,12 +28,18 @@
 #include "LightDirectory.hxx"
 #include "PlaylistInfo.hxx"
 #include "Interface.hxx"
+#include "DatabaseError.hxx"
 #include "fs/Traits.hxx"
 #include "time/ChronoUtil.hxx"
 #include "util/RecursiveMap.hxx"
+#include "util/StringAPI.hxx"
 
+#include <algorithm>
+#include <cassert>
 #include <functional>
 
+#include <string.h>
+
 gcc_pure
 static const char *
 ApplyBaseFlag(const char *uri, bool base) noexcept
@@ -208,3 +214,169 @@ PrintUniqueTags(Response &r, Partition &partition,
 	PrintUniqueTags(r, tag_types,
 			db.CollectUniqueTags(selection, tag_types));
 }
+
+bool
+DatabaseTreePrinter::Open(Partition &partition, const char *uri)
+{
+	assert(stack.empty());
+
+	if (*uri == 0) {
+		stack.push_back({std::string(), LightDirectory::Root().mtime});
+		return true;
+	}
+
+	/* look up the directory in its parent to obtain its
+	   modification time; this also verifies that the URI refers
+	   to a directory */
+	const char *slash = strrchr(uri, '/');
+	const std::string parent = slash != nullptr
+		? std::string(uri, slash)
+		: std::string();
+
+	const Database &db = partition.GetDatabaseOrThrow();
+	db.Visit(DatabaseSelection(parent.c_str(), false),
+		 [this, uri](const LightDirectory &directory){
+			 if (stack.empty() &&
+			     StringIsEqual(directory.GetPath(), uri))
+				 stack.push_back({uri, directory.mtime});
+		 },
+		 VisitSong(), VisitPlaylist());
+
+	return !stack.empty();
+}
+
+namespace {
+/**
+ * Thrown by a visitor to abort DatabaseTreePrinter::PrintSubtree().
+ */
+struct SubtreeTooLarge {};
+}
+
+bool
+DatabaseTreePrinter::PrintSubtree(Response &r, const Database &db,
+				  const char *uri, unsigned max_items,
+				  unsigned &n) const
+{
+	/* print into a temporary buffer which gets discarded if the
+	   subtree turns out to be too large */
+	std::string buffer;
+	unsigned count = 0;
+
+	{
+		Response tmp(client, 0, buffer);
+
+		using namespace std::placeholders;
+		const auto d = std::bind(full ? PrintDirectoryFull : PrintDirectoryBrief,
+					 std::ref(tmp), false, _1);
+		const auto s = std::bind(full ? PrintSongFull : PrintSongBrief,
+					 std::ref(tmp), false, _1);
+		const auto p = std::bind(full ? PrintPlaylistFull : PrintPlaylistBrief,
+					 std::ref(tmp), false, _1, _2);
+
+		auto check = [&count, max_items](){
+			if (++count > max_items)
+				throw SubtreeTooLarge();
+		};
+
+		try {
+			db.Visit(DatabaseSelection(uri, true),
+				 [&d, &check, uri](const LightDirectory &directory){
+					 /* the directory itself has
+					    already been printed */
+					 if (StringIsEqual(directory.GetPath(), uri))
+						 return;
+
+					 check();
+					 d(directory);
+				 },
+				 [&s, &check](const LightSong &song){
+					 check();
+					 s(song);
+				 },
+				 [&p, &check](const PlaylistInfo &playlist,
+					      const LightDirectory &parent){
+					 check();
+					 p(playlist, parent);
+				 });
+		} catch (const SubtreeTooLarge &) {
+			return false;
+		}
+	}
+
+	r.Write(buffer.data(), buffer.size());
+	n += count;
+	return true;
+}
+
+void
+DatabaseTreePrinter::PrintDirectory(Response &r, const Database &db,
+				    const char *uri, unsigned &n)
+{
+	using namespace std::placeholders;
+	const auto s = std::bind(full ? PrintSongFull : PrintSongBrief,
+				 std::ref(r), false, _1);
+	const auto p = std::bind(full ? PrintPlaylistFull : PrintPlaylistBrief,
+				 std::ref(r), false, _1, _2);
+
+	/* the directory's own songs and playlists are printed right
+	   away; the child directories are printed later, each one
+	   followed by its contents, just like Directory::Walk() does
+	   it */
+	std::vector<Pending> children;
+
+	db.Visit(DatabaseSelection(uri, false),
+		 [&children](const LightDirectory &child){
+			 children.push_back({child.GetPath(), child.mtime});
+		 },
+		 [&s, &n](const LightSong &song){
+			 s(song);
+			 ++n;
+		 },
+		 [&p, &n](const PlaylistInfo &playlist,
+			  const LightDirectory &parent){
+			 p(playlist, parent);
+			 ++n;
+		 });
+
+	std::move(children.rbegin(), children.rend(),
+		  std::back_inserter(stack));
+}
+
+bool
+DatabaseTreePrinter::Print(Response &r, Partition &partition,
+			   unsigned max_items)
+{
+	const Database &db = partition.GetDatabaseOrThrow();
+
+	unsigned n = 0;
+
+	while (!stack.empty() && n < max_items) {
+		const Pending current = std::move(stack.back());
+		stack.pop_back();
+
+		const LightDirectory directory(current.uri.c_str(),
+					       current.mtime);
+		if (full)
+			PrintDirectoryFull(r, false, directory);
+		else
+			PrintDirectoryBrief(r, false, directory);
+		++n;
+
+		try {
+			/* looking up each directory is expensive, so
+			   first try to print the whole subtree at
+			   once; only if it is too large, it is split
+			   into its child directories */
+			if (!PrintSubtree(r, db, directory.GetPath(),
+					  max_items, n))
+				PrintDirectory(r, db, directory.GetPath(), n);
+		} catch (const DatabaseError &e) {
+			/* the directory has been deleted since it was
+			   added to the stack: skip it */
+			if (e.GetCode() != DatabaseErrorCode::NOT_FOUND)
+				throw;
+		}
+	}
+
+	return !stack.empty();
+}
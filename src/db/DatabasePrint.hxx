@@ -20,13 +20,18 @@
 #ifndef MPD_DB_PRINT_H
 #define MPD_DB_PRINT_H
 
+#include <chrono>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 template<typename T> struct ConstBuffer;
 enum TagType : uint8_t;
 class SongFilter;
 struct DatabaseSelection;
 struct Partition;
+class Client;
+class Database;
 class Response;
 
 /**
@@ -47,4 +52,75 @@ PrintUniqueTags(Response &r, Partition &partition,
 		ConstBuffer<TagType> tag_types,
 		const SongFilter *filter);
 
+/**
+ * Prints a recursive listing of a directory ("listall",
+ * "listallinfo") in portions, one directory at a time, so the
+ * response can be streamed to the client.  The database is unlocked
+ * between two directories; the output is the same as
+ * db_selection_print() with a recursive #DatabaseSelection unless
+ * the database gets modified meanwhile.
+ */
+class DatabaseTreePrinter {
+	struct Pending {
+		std::string uri;
+		std::chrono::system_clock::time_point mtime;
+	};
+
+	/**
+	 * Directories which remain to be printed; the next one is at
+	 * the back.
+	 */
+	std::vector<Pending> stack;
+
+	/**
+	 * Used to create temporary #Response objects.
+	 */
+	Client &client;
+
+	const bool full;
+
+public:
+	DatabaseTreePrinter(Client &_client, bool _full) noexcept
+		:client(_client), full(_full) {}
+
+	/**
+	 * Start the listing at the given URI.
+	 *
+	 * Throws on error.
+	 *
+	 * @return false if the URI does not refer to a directory
+	 */
+	bool Open(Partition &partition, const char *uri);
+
+	/**
+	 * Print the next directories, until at least the given number
+	 * of entries has been printed.
+	 *
+	 * Throws on error.
+	 *
+	 * @return true if there are more directories to be printed
+	 */
+	bool Print(Response &r, Partition &partition, unsigned max_items);
+
+private:
+	/**
+	 * Print the contents of the given directory recursively, but
+	 * only if it contains no more than the given number of
+	 * entries.
+	 *
+	 * @return false if the subtree is too large (nothing has
+	 * been printed)
+	 */
+	bool PrintSubtree(Response &r, const Database &db,
+			  const char *uri, unsigned max_items,
+			  unsigned &n) const;
+
+	/**
+	 * Print the songs and playlists of the given directory, and
+	 * push its child directories on the stack.
+	 */
+	void PrintDirectory(Response &r, const Database &db,
+			    const char *uri, unsigned &n);
+};
+
 #endif
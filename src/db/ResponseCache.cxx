@@ -0,0 +1,86 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ResponseCache.hxx"
+
+#include <cassert>
+
+std::string
+DatabaseResponseCache::MakeKey(TagMask tag_mask, const char *command,
+			       ConstBuffer<const char *> args)
+{
+	std::string key;
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		key.push_back(tag_mask.Test(TagType(i)) ? '1' : '0');
+
+	key.append(command);
+	for (const char *i : args) {
+		key.push_back('\0');
+		key.append(i);
+	}
+
+	return key;
+}
+
+const std::string *
+DatabaseResponseCache::Get(std::string_view key) noexcept
+{
+	auto i = map.find(key);
+	if (i == map.end())
+		return nullptr;
+
+	/* move to the front of the LRU list */
+	items.splice(items.begin(), items, i->second);
+	return &i->second->value;
+}
+
+void
+DatabaseResponseCache::Put(std::string &&key, std::string &&value)
+{
+	const size_t item_size = key.size() + value.size();
+	if (item_size > MAX_ITEM_SIZE || map.find(key) != map.end())
+		return;
+
+	while (size + item_size > MAX_SIZE)
+		EvictOldest();
+
+	items.emplace_front(std::move(key), std::move(value));
+	map.emplace(items.front().key, items.begin());
+	size += item_size;
+}
+
+void
+DatabaseResponseCache::Clear() noexcept
+{
+	map.clear();
+	items.clear();
+	size = 0;
+	++generation;
+}
+
+void
+DatabaseResponseCache::EvictOldest() noexcept
+{
+	assert(!items.empty());
+
+	const auto &item = items.back();
+	map.erase(item.key);
+	size -= item.key.size() + item.value.size();
+	items.pop_back();
+}
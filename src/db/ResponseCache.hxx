@@ -0,0 +1,128 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DB_RESPONSE_CACHE_HXX
+#define MPD_DB_RESPONSE_CACHE_HXX
+
+#include "tag/Mask.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * A cache for the serialized responses of expensive read-only
+ * database commands such as "list" and "count group".  The key is
+ * built from the command name and its arguments; the value is the
+ * exact response text, so a cache hit only needs to copy it to the
+ * client.
+ *
+ * The whole cache is flushed whenever the database is modified
+ * (see Clear() and Validate()).  This class is not thread-safe; it
+ * is only used by the main thread.
+ */
+class DatabaseResponseCache {
+	struct Item {
+		std::string key, value;
+
+		Item(std::string &&_key, std::string &&_value) noexcept
+			:key(std::move(_key)), value(std::move(_value)) {}
+	};
+
+	/**
+	 * All items, the most recently used one at the front.
+	 */
+	std::list<Item> items;
+
+	std::unordered_map<std::string_view, std::list<Item>::iterator> map;
+
+	/**
+	 * The sum of all key and value sizes.
+	 */
+	size_t size = 0;
+
+	/**
+	 * Incremented by Clear().  This allows detecting whether a
+	 * response which was generated asynchronously is stale.
+	 */
+	unsigned generation = 0;
+
+	/**
+	 * The SimpleDatabase::GetVersion() value the cached responses
+	 * were generated from.
+	 */
+	unsigned database_version = 0;
+
+public:
+	/**
+	 * The maximum total size of all cached responses.
+	 */
+	static constexpr size_t MAX_SIZE = 8 * 1024 * 1024;
+
+	/**
+	 * Responses larger than this are not cached, because they
+	 * would evict too many others.
+	 */
+	static constexpr size_t MAX_ITEM_SIZE = MAX_SIZE / 4;
+
+	/**
+	 * Build a cache key from the client's tag mask (which
+	 * determines the tags included in a response), a command
+	 * name and its arguments.
+	 */
+	static std::string MakeKey(TagMask tag_mask, const char *command,
+				   ConstBuffer<const char *> args);
+
+	unsigned GetGeneration() const noexcept {
+		return generation;
+	}
+
+	/**
+	 * Look up a cached response.
+	 *
+	 * @return the response text or nullptr if it is not cached;
+	 * the pointer is valid until the cache is modified
+	 */
+	const std::string *Get(std::string_view key) noexcept;
+
+	void Put(std::string &&key, std::string &&value);
+
+	void Clear() noexcept;
+
+	/**
+	 * Clear the cache if the database has been modified since
+	 * the cached responses were generated.
+	 *
+	 * @param version the current SimpleDatabase::GetVersion()
+	 * value
+	 */
+	void Validate(unsigned version) noexcept {
+		if (version != database_version) {
+			Clear();
+			database_version = version;
+		}
+	}
+
+private:
+	void EvictOldest() noexcept;
+};
+
+#endif
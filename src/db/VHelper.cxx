@@ -21,6 +21,7 @@
 #include "song/DetachedSong.hxx"
 #include "song/LightSong.hxx"
 #include "song/Filter.hxx"
+#include "tag/Tag.hxx"
 
 #include <algorithm>
 #include <cassert>
@@ -43,9 +44,21 @@ DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 		   result to the client, we need to copy it all into
 		   this std::vector, and then sort it */
 
+		if (!selection.window.IsAll()) {
+			/* but with a "window", only the top
+			   "window.end" songs need to be kept */
+			sort_limit = selection.window.end;
+
+			if (sort_limit == 0) {
+				/* nothing to do */
+				visit_song = nullptr;
+				return;
+			}
+		}
+
 		original_visit_song = std::move(visit_song);
 		visit_song = [this](const auto &song){
-			songs.emplace_back(song);
+			CollectSong(song);
 		};
 	} else if (selection.window != RangeArg::All()) {
 		original_visit_song = std::move(visit_song);
@@ -90,6 +103,75 @@ CompareTags(TagType type, bool descending, const Tag &a, const Tag &b) noexcept
 	}
 }
 
+bool
+CompareSortOrder(TagType sort, bool descending,
+		 const Tag &a_tag,
+		 std::chrono::system_clock::time_point a_mtime,
+		 const Tag &b_tag,
+		 std::chrono::system_clock::time_point b_mtime) noexcept
+{
+	if (sort == TagType(SORT_TAG_LAST_MODIFIED))
+		return descending
+			? a_mtime > b_mtime
+			: a_mtime < b_mtime;
+	else
+		return CompareTags(sort, descending, a_tag, b_tag);
+}
+
+bool
+DatabaseVisitorHelper::Compare(const SortItem &a,
+			       const SortItem &b) const noexcept
+{
+	const auto &a_tag = a.song.GetTag(), &b_tag = b.song.GetTag();
+	const auto a_mtime = a.song.GetLastModified();
+	const auto b_mtime = b.song.GetLastModified();
+
+	if (Compare(a_tag, a_mtime, b_tag, b_mtime))
+		return true;
+
+	if (Compare(b_tag, b_mtime, a_tag, a_mtime))
+		return false;
+
+	return a.position < b.position;
+}
+
+inline void
+DatabaseVisitorHelper::CollectSong(const LightSong &song)
+{
+	const unsigned position = counter++;
+
+	if (trimmed) {
+		/* this song comes after all songs collected so far,
+		   so it wins only if it is really "less" than the
+		   last one in the top list; this check avoids
+		   copying songs which will be discarded anyway */
+		const auto &last = songs[sort_limit - 1].song;
+		if (!Compare(song.tag, song.mtime,
+			     last.GetTag(), last.GetLastModified()))
+			return;
+	}
+
+	songs.push_back({DetachedSong(song), position});
+
+	if (sort_limit > 0 && songs.size() >= std::size_t(sort_limit) * 2)
+		TrimSongs();
+}
+
+void
+DatabaseVisitorHelper::TrimSongs() noexcept
+{
+	assert(sort_limit > 0);
+	assert(songs.size() > sort_limit);
+
+	const auto nth = std::next(songs.begin(), sort_limit - 1);
+	std::nth_element(songs.begin(), nth, songs.end(),
+			 [this](const SortItem &a, const SortItem &b){
+				 return Compare(a, b);
+			 });
+	songs.erase(std::next(nth), songs.end());
+	trimmed = true;
+}
+
 void
 DatabaseVisitorHelper::Commit()
 {
@@ -97,40 +179,30 @@ DatabaseVisitorHelper::Commit()
 	if (selection.sort == TAG_NUM_OF_ITEM_TYPES)
 		return;
 
-	assert(original_visit_song);
+	if (sort_limit > 0 && songs.size() > sort_limit)
+		TrimSongs();
+
+	if (selection.window.start >= songs.size())
+		return;
 
-	/* sort the song collection */
-	const auto sort = selection.sort;
-	const auto descending = selection.descending;
+	assert(original_visit_song);
 
-	if (sort == TagType(SORT_TAG_LAST_MODIFIED))
-		std::stable_sort(songs.begin(), songs.end(),
-				 [descending](const DetachedSong &a, const DetachedSong &b){
-					 return descending
-						 ? a.GetLastModified() > b.GetLastModified()
-						 : a.GetLastModified() < b.GetLastModified();
-				 });
-	else
-		std::stable_sort(songs.begin(), songs.end(),
-				 [sort, descending](const DetachedSong &a,
-						    const DetachedSong &b){
-					 return CompareTags(sort, descending,
-							    a.GetTag(),
-							    b.GetTag());
-				 });
+	/* sort the song collection; the position tie-breaker makes
+	   std::sort() behave like std::stable_sort() */
+	std::sort(songs.begin(), songs.end(),
+		  [this](const SortItem &a, const SortItem &b){
+			  return Compare(a, b);
+		  });
 
 	/* apply the "window" */
 	if (selection.window.end < songs.size())
 		songs.erase(std::next(songs.begin(), selection.window.end),
 			    songs.end());
 
-	if (selection.window.start >= songs.size())
-		return;
-
 	songs.erase(songs.begin(),
 		    std::next(songs.begin(), selection.window.start));
 
 	/* now pass all songs to the original visitor callback */
-	for (const auto &song : songs)
-		original_visit_song((LightSong)song);
+	for (const auto &i : songs)
+		original_visit_song((LightSong)i.song);
 }
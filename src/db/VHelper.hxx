@@ -22,10 +22,27 @@
 
 #include "Visitor.hxx"
 #include "Selection.hxx"
+#include "song/DetachedSong.hxx"
+#include "util/Compiler.h"
 
+#include <chrono>
 #include <vector>
 
-class DetachedSong;
+struct Tag;
+
+/**
+ * Compare two songs according to DatabaseSelection::sort (a #TagType
+ * or #SORT_TAG_LAST_MODIFIED).
+ *
+ * @return true if song "a" shall be sorted before song "b"
+ */
+gcc_pure
+bool
+CompareSortOrder(TagType sort, bool descending,
+		 const Tag &a_tag,
+		 std::chrono::system_clock::time_point a_mtime,
+		 const Tag &b_tag,
+		 std::chrono::system_clock::time_point b_mtime) noexcept;
 
 /**
  * This class helps implementing Database::Visit() by emulating
@@ -39,12 +56,27 @@ class DetachedSong;
 class DatabaseVisitorHelper {
 	const DatabaseSelection selection;
 
+	struct SortItem {
+		DetachedSong song;
+
+		/**
+		 * The position in the visit order; it is used to
+		 * break ties, which makes sorting stable even with
+		 * std::nth_element().
+		 */
+		unsigned position;
+	};
+
 	/**
 	 * If the plugin can't sort, then this container will collect
 	 * all songs, sort them and report them to the visitor in
 	 * Commit().
+	 *
+	 * If there is a "window", only the first "window.end" songs
+	 * are needed; the container is trimmed to that size whenever
+	 * it grows to twice that size.
 	 */
-	std::vector<DetachedSong> songs;
+	std::vector<SortItem> songs;
 
 	VisitSong original_visit_song;
 
@@ -53,6 +85,19 @@ class DatabaseVisitorHelper {
 	 */
 	unsigned counter = 0;
 
+	/**
+	 * The maximum number of songs needed for the "window";
+	 * 0 means there is no limit.
+	 */
+	unsigned sort_limit = 0;
+
+	/**
+	 * Has TrimSongs() been called?  Then songs[sort_limit-1] is
+	 * the last song of the current top list, and new songs which
+	 * sort after it can be ignored.
+	 */
+	bool trimmed = false;
+
 public:
 	/**
 	 * @param selection a #DatabaseSelection instance with only
@@ -65,6 +110,26 @@ public:
 	~DatabaseVisitorHelper() noexcept;
 
 	void Commit();
+
+private:
+	gcc_pure
+	bool Compare(const Tag &a_tag,
+		     std::chrono::system_clock::time_point a_mtime,
+		     const Tag &b_tag,
+		     std::chrono::system_clock::time_point b_mtime) const noexcept {
+		return CompareSortOrder(selection.sort, selection.descending,
+					a_tag, a_mtime, b_tag, b_mtime);
+	}
+
+	gcc_pure
+	bool Compare(const SortItem &a, const SortItem &b) const noexcept;
+
+	void CollectSong(const LightSong &song);
+
+	/**
+	 * Discard all songs which cannot be part of the "window".
+	 */
+	void TrimSongs() noexcept;
 };
 
 #endif
@@ -0,0 +1,629 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DatabaseBinary.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/Charset.hxx"
+#include "tag/Builder.hxx"
+#include "tag/ParseName.hxx"
+#include "tag/Settings.hxx"
+#include "time/ChronoUtil.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/RuntimeError.hxx"
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <string.h>
+
+static constexpr char BINARY_MAGIC[8] = {
+	'M', 'P', 'D', 'B', 'I', 'N', 'D', 'B',
+};
+
+/**
+ * Records are stored in host byte order; this value allows
+ * detecting a file written on a machine with a different one.
+ */
+static constexpr uint32_t BINARY_BYTE_ORDER = 0x01020304;
+
+static constexpr uint32_t BINARY_DB_FORMAT = 1;
+
+static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+/**
+ * Marks an unknown modification time.
+ */
+static constexpr int64_t NO_MTIME = -1;
+
+enum class BinaryDirectoryType : uint32_t {
+	REGULAR,
+	ARCHIVE,
+	CONTAINER,
+	PLAYLIST,
+};
+
+struct BinarySection {
+	uint64_t offset;
+
+	/**
+	 * The number of records (or bytes, for the string table).
+	 */
+	uint64_t count;
+};
+
+struct BinaryHeader {
+	char magic[sizeof(BINARY_MAGIC)];
+	uint32_t byte_order;
+	uint32_t format;
+
+	/**
+	 * A string table offset.
+	 */
+	uint32_t fs_charset;
+
+	uint32_t reserved;
+
+	BinarySection tag_names, directories, songs, tag_items, playlists;
+	BinarySection strings;
+};
+
+struct BinaryTagName {
+	uint32_t name;
+
+	/**
+	 * Was this tag enabled when the file was written?
+	 */
+	uint32_t enabled;
+};
+
+struct BinaryDirectory {
+	uint32_t name;
+
+	/**
+	 * The index of the parent directory, which is always smaller
+	 * than the index of this one; #NO_PARENT for the root.
+	 */
+	uint32_t parent;
+
+	uint32_t first_song, n_songs;
+	uint32_t first_playlist, n_playlists;
+
+	BinaryDirectoryType type;
+	uint32_t reserved;
+
+	int64_t mtime;
+};
+
+struct BinarySong {
+	uint32_t filename, target;
+	uint32_t first_tag_item, n_tag_items;
+	uint32_t start_ms, end_ms;
+
+	/**
+	 * Negative if unknown.
+	 */
+	int32_t duration_ms;
+
+	uint32_t sample_rate;
+	uint8_t sample_format, channels;
+	uint8_t has_playlist;
+	uint8_t reserved[5];
+
+	int64_t mtime;
+};
+
+struct BinaryTagItem {
+	/**
+	 * An index into the tag name table.
+	 */
+	uint32_t type;
+
+	uint32_t value;
+};
+
+struct BinaryPlaylist {
+	uint32_t name;
+	uint32_t reserved;
+	int64_t mtime;
+};
+
+static_assert(sizeof(BinaryHeader) % 8 == 0, "Bad header size");
+static_assert(sizeof(BinaryDirectory) % 8 == 0, "Bad record size");
+static_assert(sizeof(BinarySong) % 8 == 0, "Bad record size");
+static_assert(sizeof(BinaryTagItem) % 8 == 0, "Bad record size");
+static_assert(sizeof(BinaryPlaylist) % 8 == 0, "Bad record size");
+
+static constexpr uint64_t
+AlignSection(uint64_t offset) noexcept
+{
+	return (offset + 7) & ~uint64_t(7);
+}
+
+static int64_t
+ExportTime(std::chrono::system_clock::time_point t) noexcept
+{
+	return IsNegative(t)
+		? NO_MTIME
+		: int64_t(std::chrono::system_clock::to_time_t(t));
+}
+
+static std::chrono::system_clock::time_point
+ImportTime(int64_t t) noexcept
+{
+	return t < 0
+		? std::chrono::system_clock::time_point::min()
+		: std::chrono::system_clock::from_time_t(t);
+}
+
+gcc_const
+static BinaryDirectoryType
+ExportDeviceType(uint64_t device) noexcept
+{
+	switch (device) {
+	case DEVICE_INARCHIVE:
+		return BinaryDirectoryType::ARCHIVE;
+
+	case DEVICE_CONTAINER:
+		return BinaryDirectoryType::CONTAINER;
+
+	case DEVICE_PLAYLIST:
+		return BinaryDirectoryType::PLAYLIST;
+
+	default:
+		return BinaryDirectoryType::REGULAR;
+	}
+}
+
+gcc_const
+static uint64_t
+ImportDeviceType(BinaryDirectoryType type) noexcept
+{
+	switch (type) {
+	case BinaryDirectoryType::REGULAR:
+		break;
+
+	case BinaryDirectoryType::ARCHIVE:
+		return DEVICE_INARCHIVE;
+
+	case BinaryDirectoryType::CONTAINER:
+		return DEVICE_CONTAINER;
+
+	case BinaryDirectoryType::PLAYLIST:
+		return DEVICE_PLAYLIST;
+	}
+
+	return 0;
+}
+
+bool
+db_is_binary(ConstBuffer<void> src) noexcept
+{
+	return src.size >= sizeof(BINARY_MAGIC) &&
+		memcmp(src.data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+namespace {
+
+/**
+ * Collects NUL-terminated strings, storing each distinct value only
+ * once.  Offset 0 is always the empty string.
+ */
+class BinaryStringTable {
+	std::string data;
+	std::unordered_map<std::string, uint32_t> offsets;
+
+public:
+	BinaryStringTable() {
+		Add("");
+	}
+
+	uint32_t Add(const char *s) {
+		auto i = offsets.emplace(s, uint32_t(data.size()));
+		if (i.second) {
+			if (data.size() + strlen(s) >= UINT32_MAX)
+				throw std::runtime_error("Database string table too large");
+
+			data.append(s);
+			data.push_back('\0');
+		}
+
+		return i.first->second;
+	}
+
+	ConstBuffer<char> Get() const noexcept {
+		return {data.data(), data.size()};
+	}
+};
+
+class BinaryDatabaseWriter {
+	BinaryStringTable strings;
+
+	const uint32_t fs_charset;
+
+	std::vector<BinaryTagName> tag_names;
+	std::vector<BinaryDirectory> directories;
+	std::vector<BinarySong> songs;
+	std::vector<BinaryTagItem> tag_items;
+	std::vector<BinaryPlaylist> playlists;
+
+public:
+	BinaryDatabaseWriter()
+		:fs_charset(strings.Add(GetFSCharset())) {
+		/* the tag name table is indexed by TagType */
+		for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+			tag_names.push_back({strings.Add(tag_item_names[i]),
+					     IsTagEnabled(i)});
+	}
+
+	void AddDirectory(const Directory &directory, uint32_t parent);
+
+	void Write(BufferedOutputStream &os) const;
+
+private:
+	template<typename T>
+	static uint32_t CheckedIndex(const std::vector<T> &v) {
+		if (v.size() >= UINT32_MAX)
+			throw std::runtime_error("Database too large");
+		return v.size();
+	}
+
+	void AddSong(const Song &song);
+};
+
+}
+
+void
+BinaryDatabaseWriter::AddSong(const Song &song)
+{
+	BinarySong s{};
+	s.filename = strings.Add(song.filename.c_str());
+	s.target = strings.Add(song.target != nullptr ? song.target.c_str() : "");
+
+	s.first_tag_item = CheckedIndex(tag_items);
+	for (const auto &item : song.tag)
+		tag_items.push_back({uint32_t(item.type),
+				     strings.Add(item.value)});
+	s.n_tag_items = tag_items.size() - s.first_tag_item;
+
+	s.start_ms = song.start_time.ToMS();
+	s.end_ms = song.end_time.ToMS();
+	s.duration_ms = song.tag.duration.ToMS();
+
+	s.sample_rate = song.audio_format.sample_rate;
+	s.sample_format = uint8_t(song.audio_format.format);
+	s.channels = song.audio_format.channels;
+	s.has_playlist = song.tag.has_playlist;
+
+	s.mtime = ExportTime(song.mtime);
+
+	songs.push_back(s);
+}
+
+void
+BinaryDatabaseWriter::AddDirectory(const Directory &directory,
+				   uint32_t parent)
+{
+	const uint32_t index = CheckedIndex(directories);
+
+	BinaryDirectory d{};
+	d.name = directory.IsRoot() ? 0 : strings.Add(directory.GetName());
+	d.parent = parent;
+	d.type = ExportDeviceType(directory.device);
+	d.mtime = ExportTime(directory.mtime);
+
+	d.first_song = CheckedIndex(songs);
+	for (const auto &song : directory.songs)
+		AddSong(song);
+	d.n_songs = songs.size() - d.first_song;
+
+	d.first_playlist = CheckedIndex(playlists);
+	for (const auto &pi : directory.playlists)
+		playlists.push_back({strings.Add(pi.name.c_str()), 0,
+				     ExportTime(pi.mtime)});
+	d.n_playlists = playlists.size() - d.first_playlist;
+
+	directories.push_back(d);
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			AddDirectory(child, index);
+}
+
+template<typename T>
+static BinarySection
+MakeSection(uint64_t &position, const std::vector<T> &v) noexcept
+{
+	BinarySection section{AlignSection(position), v.size()};
+	position = section.offset + v.size() * sizeof(T);
+	return section;
+}
+
+static void
+WritePadded(BufferedOutputStream &os, uint64_t &position,
+	    const BinarySection &section,
+	    const void *data, size_t size)
+{
+	static constexpr uint8_t zero[8]{};
+	if (section.offset > position)
+		os.Write(zero, section.offset - position);
+
+	if (size > 0)
+		os.Write(data, size);
+
+	position = section.offset + size;
+}
+
+template<typename T>
+static void
+WriteSection(BufferedOutputStream &os, uint64_t &position,
+	     const BinarySection &section, const std::vector<T> &v)
+{
+	WritePadded(os, position, section, v.data(), v.size() * sizeof(T));
+}
+
+void
+BinaryDatabaseWriter::Write(BufferedOutputStream &os) const
+{
+	const auto string_data = strings.Get();
+
+	BinaryHeader header{};
+	memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	header.byte_order = BINARY_BYTE_ORDER;
+	header.format = BINARY_DB_FORMAT;
+	header.fs_charset = fs_charset;
+
+	uint64_t position = sizeof(header);
+	header.tag_names = MakeSection(position, tag_names);
+	header.directories = MakeSection(position, directories);
+	header.songs = MakeSection(position, songs);
+	header.tag_items = MakeSection(position, tag_items);
+	header.playlists = MakeSection(position, playlists);
+	header.strings = {AlignSection(position), string_data.size};
+
+	os.Write(&header, sizeof(header));
+	position = sizeof(header);
+
+	WriteSection(os, position, header.tag_names, tag_names);
+	WriteSection(os, position, header.directories, directories);
+	WriteSection(os, position, header.songs, songs);
+	WriteSection(os, position, header.tag_items, tag_items);
+	WriteSection(os, position, header.playlists, playlists);
+	WritePadded(os, position, header.strings,
+		    string_data.data, string_data.size);
+}
+
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root)
+{
+	BinaryDatabaseWriter writer;
+	writer.AddDirectory(root, NO_PARENT);
+	writer.Write(os);
+}
+
+namespace {
+
+class BinaryDatabaseReader {
+	const uint8_t *const base;
+	const size_t size;
+
+	const BinaryHeader &header;
+
+	ConstBuffer<char> strings;
+
+	/**
+	 * Maps indexes of the file's tag name table to #TagType.
+	 */
+	std::vector<TagType> tag_types;
+
+	ConstBuffer<BinaryDirectory> directories;
+	ConstBuffer<BinarySong> songs;
+	ConstBuffer<BinaryTagItem> tag_items;
+	ConstBuffer<BinaryPlaylist> playlists;
+
+public:
+	explicit BinaryDatabaseReader(ConstBuffer<void> src);
+
+	void Load(Directory &root) const;
+
+private:
+	template<typename T>
+	ConstBuffer<T> GetSection(const BinarySection &section) const {
+		if (section.offset % alignof(T) != 0 ||
+		    section.offset > size ||
+		    section.count > (size - section.offset) / sizeof(T))
+			throw std::runtime_error("Database corrupted");
+
+		return {(const T *)(base + section.offset), section.count};
+	}
+
+	template<typename T>
+	static ConstBuffer<T> GetRange(ConstBuffer<T> buffer,
+				       uint32_t first, uint32_t n) {
+		if (first > buffer.size || n > buffer.size - first)
+			throw std::runtime_error("Database corrupted");
+
+		return {buffer.data + first, n};
+	}
+
+	const char *GetString(uint32_t offset) const {
+		if (offset >= strings.size)
+			throw std::runtime_error("Database corrupted");
+
+		return strings.data + offset;
+	}
+
+	void LoadTagNames();
+	SongPtr LoadSong(const BinarySong &s, Directory &parent) const;
+	void LoadDirectory(const BinaryDirectory &d,
+			   Directory &directory) const;
+};
+
+}
+
+BinaryDatabaseReader::BinaryDatabaseReader(ConstBuffer<void> src)
+	:base((const uint8_t *)src.data), size(src.size),
+	 header(*(const BinaryHeader *)src.data)
+{
+	if (!db_is_binary(src) || size < sizeof(header) ||
+	    uintptr_t(base) % alignof(BinaryHeader) != 0)
+		throw std::runtime_error("Database corrupted");
+
+	if (header.byte_order != BINARY_BYTE_ORDER)
+		throw std::runtime_error("Database byte order mismatch, "
+					 "discarding database file");
+
+	if (header.format != BINARY_DB_FORMAT)
+		throw std::runtime_error("Database format mismatch, "
+					 "discarding database file");
+
+	strings = GetSection<char>(header.strings);
+	if (strings.empty() || strings.back() != 0)
+		throw std::runtime_error("Database corrupted");
+
+	const char *new_charset = GetString(header.fs_charset);
+	const char *const old_charset = GetFSCharset();
+	if (*old_charset != 0 && strcmp(new_charset, old_charset) != 0)
+		throw FormatRuntimeError("Existing database has charset "
+					 "\"%s\" instead of \"%s\"; "
+					 "discarding database file",
+					 new_charset, old_charset);
+
+	LoadTagNames();
+
+	directories = GetSection<BinaryDirectory>(header.directories);
+	if (directories.empty() || directories.front().parent != NO_PARENT)
+		throw std::runtime_error("Database corrupted");
+
+	songs = GetSection<BinarySong>(header.songs);
+	tag_items = GetSection<BinaryTagItem>(header.tag_items);
+	playlists = GetSection<BinaryPlaylist>(header.playlists);
+}
+
+void
+BinaryDatabaseReader::LoadTagNames()
+{
+	bool tags[TAG_NUM_OF_ITEM_TYPES]{};
+
+	for (const auto &i : GetSection<BinaryTagName>(header.tag_names)) {
+		const char *name = GetString(i.name);
+		TagType tag = tag_name_parse(name);
+		if (tag == TAG_NUM_OF_ITEM_TYPES)
+			throw FormatRuntimeError("Unrecognized tag '%s', "
+						 "discarding database file",
+						 name);
+
+		if (i.enabled)
+			tags[tag] = true;
+
+		tag_types.push_back(tag);
+	}
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsTagEnabled(i) && !tags[i])
+			throw std::runtime_error("Tag list mismatch, "
+						 "discarding database file");
+}
+
+SongPtr
+BinaryDatabaseReader::LoadSong(const BinarySong &s, Directory &parent) const
+{
+	auto song = std::make_unique<Song>(GetString(s.filename), parent);
+	song->SetTarget(GetString(s.target));
+	song->start_time = SongTime::FromMS(s.start_ms);
+	song->end_time = SongTime::FromMS(s.end_ms);
+	song->mtime = ImportTime(s.mtime);
+
+	AudioFormat audio_format(s.sample_rate, SampleFormat(s.sample_format),
+				 s.channels);
+	if (audio_format.IsValid())
+		song->audio_format = audio_format;
+
+	TagBuilder tag;
+	for (const auto &i : GetRange(tag_items, s.first_tag_item,
+				      s.n_tag_items)) {
+		if (i.type >= tag_types.size())
+			throw std::runtime_error("Database corrupted");
+
+		tag.AddItem(tag_types[i.type], GetString(i.value));
+	}
+
+	tag.SetDuration(SignedSongTime::FromMS(s.duration_ms));
+	tag.SetHasPlaylist(s.has_playlist);
+	song->tag = tag.Commit();
+
+	return song;
+}
+
+void
+BinaryDatabaseReader::LoadDirectory(const BinaryDirectory &d,
+				    Directory &directory) const
+{
+	for (const auto &s : GetRange(songs, d.first_song, d.n_songs))
+		directory.AddSong(LoadSong(s, directory));
+
+	for (const auto &p : GetRange(playlists, d.first_playlist,
+				      d.n_playlists))
+		directory.playlists.push_back(PlaylistInfo(GetString(p.name),
+							   ImportTime(p.mtime)));
+}
+
+void
+BinaryDatabaseReader::Load(Directory &root) const
+{
+	assert(holding_db_lock());
+
+	std::vector<Directory *> loaded;
+	loaded.reserve(directories.size);
+
+	for (const auto &d : directories) {
+		Directory *directory;
+
+		if (loaded.empty()) {
+			directory = &root;
+		} else {
+			const char *name = GetString(d.name);
+			if (d.parent >= loaded.size() || *name == 0 ||
+			    strchr(name, '/') != nullptr)
+				throw std::runtime_error("Database corrupted");
+
+			directory = loaded[d.parent]->CreateChild(name);
+			directory->device = ImportDeviceType(d.type);
+			directory->mtime = ImportTime(d.mtime);
+		}
+
+		LoadDirectory(d, *directory);
+		loaded.push_back(directory);
+	}
+}
+
+void
+db_load_binary(ConstBuffer<void> src, Directory &root)
+{
+	const BinaryDatabaseReader reader(src);
+
+	const ScopeDatabaseLock protect;
+	reader.Load(root);
+}
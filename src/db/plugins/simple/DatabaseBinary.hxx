@@ -0,0 +1,59 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DATABASE_BINARY_HXX
+#define MPD_DATABASE_BINARY_HXX
+
+#include "util/Compiler.h"
+
+template<typename T> struct ConstBuffer;
+struct Directory;
+class BufferedOutputStream;
+
+/**
+ * Does the given buffer look like a database file in the binary
+ * format?  This only checks the magic header.
+ */
+gcc_pure
+bool
+db_is_binary(ConstBuffer<void> src) noexcept;
+
+/**
+ * Write the database in the binary format: a header, a table of tag
+ * names, fixed-size directory/song/tag/playlist records and a
+ * deduplicated string table referenced by offset.  Directories are
+ * stored in pre-order, so each parent precedes its children, and the
+ * songs of each directory are contiguous.
+ *
+ * Throws on I/O error.
+ */
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root);
+
+/**
+ * Load a database in the binary format (e.g. from a #FileMapping).
+ * Unlike db_load_internal(), this does not parse any text; records
+ * are copied straight into #Directory and #Song objects.
+ *
+ * Throws #std::runtime_error on error.
+ */
+void
+db_load_binary(ConstBuffer<void> src, Directory &root);
+
+#endif
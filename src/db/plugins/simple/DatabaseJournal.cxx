@@ -0,0 +1,182 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DatabaseJournal.hxx"
+#include "DirectorySave.hxx"
+#include "Directory.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/StringLineReader.hxx"
+#include "util/DeleteDisposer.hxx"
+#include "util/StringAPI.hxx"
+#include "util/StringCompare.hxx"
+#include "util/RuntimeError.hxx"
+
+#include <cinttypes>
+
+#include <stdio.h>
+
+#define JOURNAL_HEADER "journal: 1"
+#define JOURNAL_BASE "base: "
+#define JOURNAL_RECORD "record:"
+#define JOURNAL_COMMIT "commit"
+
+void
+db_journal_prepare(Directory &directory) noexcept
+{
+	for (auto child = directory.children.begin(),
+		     end = directory.children.end();
+	     child != end;) {
+		if (!child->modified_below) {
+			++child;
+			continue;
+		}
+
+		db_journal_prepare(*child);
+
+		if (child->IsEmpty() && !child->IsMount()) {
+			child = directory.children.erase_and_dispose(child,
+								     DeleteDisposer());
+			directory.MarkModified();
+		} else
+			++child;
+	}
+
+	if (directory.modified)
+		directory.SortShallow();
+}
+
+void
+db_journal_save_header(BufferedOutputStream &os,
+		       uint64_t base_size, uint64_t base_mtime)
+{
+	os.Format("%s\n", JOURNAL_HEADER);
+	os.Format(JOURNAL_BASE "%" PRIu64 " %" PRIu64 "\n",
+		  base_size, base_mtime);
+}
+
+/**
+ * Write the records of all modified directories below the given
+ * one; parents are written before their children, so replaying
+ * them creates the children in the right order.
+ */
+static void
+db_journal_save_directory(BufferedOutputStream &os,
+			  const Directory &directory)
+{
+	if (directory.modified) {
+		os.Format(JOURNAL_RECORD " %s\n", directory.GetPath());
+		directory_save_shallow(os, directory);
+	}
+
+	for (const auto &child : directory.children)
+		if (child.modified_below && !child.IsMount())
+			db_journal_save_directory(os, child);
+}
+
+void
+db_journal_save(BufferedOutputStream &os, const Directory &root)
+{
+	if (root.modified_below)
+		db_journal_save_directory(os, root);
+
+	os.Format("%s\n", JOURNAL_COMMIT);
+}
+
+/**
+ * Look up a directory by its path, creating all missing
+ * directories on the way.
+ */
+static Directory &
+MakeDirectory(Directory &root, const char *path)
+{
+	if (*path == 0)
+		return root;
+
+	auto r = root.LookupDirectory(path);
+	Directory *directory = r.directory;
+	if (r.uri == nullptr)
+		return *directory;
+
+	const std::string rest(r.uri);
+	for (std::size_t start = 0; start < rest.size();) {
+		auto slash = rest.find('/', start);
+		if (slash == rest.npos)
+			slash = rest.size();
+
+		const std::string name = rest.substr(start, slash - start);
+		if (!name.empty())
+			directory = directory->MakeChild(name.c_str());
+
+		start = slash + 1;
+	}
+
+	return *directory;
+}
+
+bool
+db_journal_load(std::string &data, Directory &root,
+		uint64_t base_size, uint64_t base_mtime)
+{
+	/* ignore the incomplete batch at the end (if any) */
+	const auto commit = data.rfind("\n" JOURNAL_COMMIT "\n");
+	if (commit == data.npos)
+		data.clear();
+	else
+		data.resize(commit + sizeof(JOURNAL_COMMIT) + 1);
+
+	if (data.empty())
+		/* empty or without a single commit: nothing to do */
+		return true;
+
+	StringLineReader file(data);
+
+	const char *line = file.ReadLine();
+	if (line == nullptr || !StringIsEqual(line, JOURNAL_HEADER))
+		throw std::runtime_error("Malformed database journal");
+
+	line = file.ReadLine();
+	const char *p;
+	unsigned long long size, mtime;
+	if (line == nullptr ||
+	    (p = StringAfterPrefix(line, JOURNAL_BASE)) == nullptr ||
+	    sscanf(p, "%llu %llu", &size, &mtime) != 2)
+		throw std::runtime_error("Malformed database journal");
+
+	if (size != base_size || mtime != base_mtime)
+		return false;
+
+	while ((line = file.ReadLine()) != nullptr) {
+		if (StringIsEqual(line, JOURNAL_COMMIT))
+			continue;
+
+		p = StringAfterPrefix(line, JOURNAL_RECORD);
+		if (p == nullptr)
+			throw FormatRuntimeError("Malformed line in database journal: %s",
+						 line);
+
+		/* the root directory's record is "record:", because
+		   the trailing space has been stripped */
+		if (*p == ' ')
+			++p;
+
+		directory_load_shallow(file, MakeDirectory(root, p));
+	}
+
+	return true;
+}
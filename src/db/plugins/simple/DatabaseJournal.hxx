@@ -0,0 +1,81 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DATABASE_JOURNAL_HXX
+#define MPD_DATABASE_JOURNAL_HXX
+
+#include <cstdint>
+#include <string>
+
+struct Directory;
+class BufferedOutputStream;
+
+/*
+ * The database journal is a text file next to the database file.
+ * Instead of rewriting the whole database after each update, only
+ * the directories which have been modified (see
+ * Directory::modified) are appended to it, each as a
+ * directory_save_shallow() record.  A batch of records is
+ * terminated by a "commit" line; an incomplete batch (e.g. after a
+ * crash) is ignored when loading.
+ *
+ * The journal header identifies the database file it belongs to
+ * (by size and modification time), so a journal which was left
+ * behind by an older database file is not applied.
+ */
+
+/**
+ * Prepare the modified directories for saving: remove empty
+ * subdirectories and sort the entries.  This is what
+ * Directory::PruneEmpty() and Directory::Sort() do for the whole
+ * tree, but it visits only the modified parts.
+ *
+ * Caller must lock the #db_mutex.
+ */
+void
+db_journal_prepare(Directory &root) noexcept;
+
+void
+db_journal_save_header(BufferedOutputStream &os,
+		       uint64_t base_size, uint64_t base_mtime);
+
+/**
+ * Append a batch with all modified directories to the journal.
+ * This does not clear the "modified" flags.
+ */
+void
+db_journal_save(BufferedOutputStream &os, const Directory &root);
+
+/**
+ * Replay all committed batches of a journal.
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * Throws on error.
+ *
+ * @param data the whole contents of the journal file; it is
+ * modified by this function
+ * @return false if the journal does not belong to the given
+ * database file (and nothing was replayed)
+ */
+bool
+db_journal_load(std::string &data, Directory &root,
+		uint64_t base_size, uint64_t base_mtime);
+
+#endif
@@ -17,11 +17,12 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "config.h"
 #include "DatabaseSave.hxx"
 #include "db/DatabaseLock.hxx"
 #include "DirectorySave.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
-#include "fs/io/TextFile.hxx"
+#include "fs/io/LineReader.hxx"
 #include "tag/ParseName.hxx"
 #include "tag/Settings.hxx"
 #include "fs/Charset.hxx"
@@ -63,7 +64,8 @@ db_save_internal(BufferedOutputStream &os, const Directory &music_root)
 }
 
 void
-db_load_internal(TextFile &file, Directory &music_root)
+db_load_internal(LineReader &file, Directory &music_root,
+		 unsigned n_threads)
 {
 	char *line;
 	unsigned format = 0;
@@ -126,5 +128,8 @@ db_load_internal(TextFile &file, Directory &music_root)
 						 "discarding database file");
 
 	const ScopeDatabaseLock protect;
-	directory_load(file, music_root);
+	if (n_threads > 1)
+		directory_load_parallel(file, music_root, n_threads);
+	else
+		directory_load(file, music_root);
 }
@@ -22,15 +22,19 @@
 
 struct Directory;
 class BufferedOutputStream;
-class TextFile;
+class LineReader;
 
 void
 db_save_internal(BufferedOutputStream &os, const Directory &root);
 
 /**
  * Throws #std::runtime_error on error.
+ *
+ * @param n_threads if greater than 1, then the contents of top-level
+ * directories are parsed in parallel on this number of worker
+ * threads (see directory_load_parallel())
  */
 void
-db_load_internal(TextFile &file, Directory &root);
+db_load_internal(LineReader &file, Directory &root, unsigned n_threads=1);
 
 #endif
@@ -31,6 +31,7 @@
 #include "lib/icu/Collate.hxx"
 #include "fs/Traits.hxx"
 #include "util/Alloc.hxx"
+#include "util/StringAPI.hxx"
 #include "util/DeleteDisposer.hxx"
 
 #include <cassert>
@@ -61,6 +62,7 @@ Directory::Delete() noexcept
 	assert(holding_db_lock());
 	assert(parent != nullptr);
 
+	parent->MarkModified();
 	parent->children.erase_and_dispose(parent->children.iterator_to(*this),
 					   DeleteDisposer());
 }
@@ -86,6 +88,7 @@ Directory::CreateChild(const char *name_utf8) noexcept
 
 	auto *child = new Directory(std::move(path_utf8), this);
 	children.push_back(*child);
+	child->MarkModified();
 	return child;
 }
 
@@ -110,14 +113,37 @@ Directory::PruneEmpty() noexcept
 	     child != end;) {
 		child->PruneEmpty();
 
-		if (child->IsEmpty() && !child->IsMount())
+		if (child->IsEmpty() && !child->IsMount()) {
 			child = children.erase_and_dispose(child,
 							   DeleteDisposer());
-		else
+			MarkModified();
+		} else
 			++child;
 	}
 }
 
+void
+Directory::MarkModified() noexcept
+{
+	modified = true;
+
+	for (Directory *i = this; i != nullptr && !i->modified_below;
+	     i = i->parent)
+		i->modified_below = true;
+}
+
+void
+Directory::ClearModified() noexcept
+{
+	if (!modified_below)
+		return;
+
+	modified = modified_below = false;
+
+	for (auto &child : children)
+		child.ClearModified();
+}
+
 Directory::LookupResult
 Directory::LookupDirectory(const char *uri) noexcept
 {
@@ -171,6 +197,7 @@ Directory::AddSong(SongPtr song) noexcept
 	assert(&song->parent == this);
 
 	songs.push_back(*song.release());
+	MarkModified();
 }
 
 SongPtr
@@ -181,6 +208,7 @@ Directory::RemoveSong(Song *song) noexcept
 	assert(&song->parent == this);
 
 	songs.erase(songs.iterator_to(*song));
+	MarkModified();
 	return SongPtr(song);
 }
 
@@ -193,7 +221,7 @@ Directory::FindSong(const char *name_utf8) const noexcept
 	for (auto &song : songs) {
 		assert(&song.parent == this);
 
-		if (song.filename == name_utf8)
+		if (StringIsEqual(song.filename.c_str(), name_utf8))
 			return &song;
 	}
 
@@ -212,15 +240,24 @@ Directory::Sort() noexcept
 {
 	assert(holding_db_lock());
 
-	children.sort(directory_cmp);
-	song_list_sort(songs);
+	SortShallow();
 
 	for (auto &child : children)
 		child.Sort();
 }
 
+void
+Directory::SortShallow() noexcept
+{
+	assert(holding_db_lock());
+
+	children.sort(directory_cmp);
+	song_list_sort(songs);
+}
+
 void
 Directory::Walk(bool recursive, const SongFilter *filter,
+		bool protocol_cache,
 		const VisitDirectory& visit_directory, const VisitSong& visit_song,
 		const VisitPlaylist& visit_playlist) const
 {
@@ -240,7 +277,7 @@ Directory::Walk(bool recursive, const SongFilter *filter,
 
 	if (visit_song) {
 		for (auto &song : songs){
-			const LightSong song2 = song.Export();
+			const LightSong song2 = song.Export(protocol_cache);
 			if (filter == nullptr || filter->Match(song2))
 				visit_song(song2);
 		}
@@ -256,7 +293,7 @@ Directory::Walk(bool recursive, const SongFilter *filter,
 			visit_directory(child.Export());
 
 		if (recursive)
-			child.Walk(recursive, filter,
+			child.Walk(recursive, filter, protocol_cache,
 				   visit_directory, visit_song,
 				   visit_playlist);
 	}
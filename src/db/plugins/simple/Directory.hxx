@@ -97,6 +97,25 @@ struct Directory {
 
 	uint64_t inode = 0, device = 0;
 
+	/**
+	 * Has this directory (its attributes, songs, playlists or the
+	 * list of children) been modified since the database was
+	 * saved?  This is used to write only the modified directories
+	 * to the database journal.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	bool modified = false;
+
+	/**
+	 * Has this directory or one of its descendants been modified?
+	 * This allows finding all modified directories without
+	 * walking the whole tree.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	bool modified_below = false;
+
 	const std::string path;
 
 	/**
@@ -268,6 +287,22 @@ public:
 	 */
 	SongPtr RemoveSong(Song *song) noexcept;
 
+	/**
+	 * Set the #modified flag of this directory and the
+	 * #modified_below flag of all its ancestors.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void MarkModified() noexcept;
+
+	/**
+	 * Clear the #modified and #modified_below flags of this
+	 * directory and all modified descendants.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void ClearModified() noexcept;
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
@@ -280,10 +315,21 @@ public:
 	 */
 	void Sort() noexcept;
 
+	/**
+	 * Sort the entries of this directory, but not the entries of
+	 * its children.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void SortShallow() noexcept;
+
 	/**
 	 * Caller must lock #db_mutex.
+	 *
+	 * @param protocol_cache see Song::Export()
 	 */
 	void Walk(bool recursive, const SongFilter *match,
+		  bool protocol_cache,
 		  const VisitDirectory& visit_directory, const VisitSong& visit_song,
 		  const VisitPlaylist& visit_playlist) const;
 
@@ -23,13 +23,19 @@
 #include "SongSave.hxx"
 #include "song/DetachedSong.hxx"
 #include "PlaylistDatabase.hxx"
-#include "fs/io/TextFile.hxx"
+#include "fs/io/LineReader.hxx"
+#include "fs/io/StringLineReader.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
+#include "thread/WorkerPool.hxx"
 #include "time/ChronoUtil.hxx"
 #include "util/StringAPI.hxx"
 #include "util/StringCompare.hxx"
 #include "util/NumberParser.hxx"
 #include "util/RuntimeError.hxx"
+#include "util/DeleteDisposer.hxx"
+
+#include <cassert>
+#include <list>
 
 #include <string.h>
 
@@ -38,6 +44,7 @@
 #define DIRECTORY_MTIME "mtime: "
 #define DIRECTORY_BEGIN "begin: "
 #define DIRECTORY_END "end: "
+#define DIRECTORY_CHILD "child: "
 
 gcc_const
 static const char *
@@ -72,18 +79,23 @@ ParseTypeString(const char *type) noexcept
 		return 0;
 }
 
+static void
+directory_save_header(BufferedOutputStream &os, const Directory &directory)
+{
+	const char *type = DeviceToTypeString(directory.device);
+	if (type != nullptr)
+		os.Format(DIRECTORY_TYPE "%s\n", type);
+
+	if (!IsNegative(directory.mtime))
+		os.Format(DIRECTORY_MTIME "%lu\n",
+			  (unsigned long)std::chrono::system_clock::to_time_t(directory.mtime));
+}
+
 void
 directory_save(BufferedOutputStream &os, const Directory &directory)
 {
 	if (!directory.IsRoot()) {
-		const char *type = DeviceToTypeString(directory.device);
-		if (type != nullptr)
-			os.Format(DIRECTORY_TYPE "%s\n", type);
-
-		if (!IsNegative(directory.mtime))
-			os.Format(DIRECTORY_MTIME "%lu\n",
-				  (unsigned long)std::chrono::system_clock::to_time_t(directory.mtime));
-
+		directory_save_header(os, directory);
 		os.Format("%s%s\n", DIRECTORY_BEGIN, directory.GetPath());
 	}
 
@@ -104,8 +116,13 @@ directory_save(BufferedOutputStream &os, const Directory &directory)
 		os.Format(DIRECTORY_END "%s\n", directory.GetPath());
 }
 
+/**
+ * Parse a line of a directory header.  This works on both #Directory
+ * and #ParsedDirectory.
+ */
+template<typename D>
 static bool
-ParseLine(Directory &directory, const char *line)
+ParseLine(D &directory, const char *line)
 {
 	const char *p;
 	if ((p = StringAfterPrefix(line, DIRECTORY_MTIME))) {
@@ -121,7 +138,7 @@ ParseLine(Directory &directory, const char *line)
 }
 
 static Directory *
-directory_load_subdir(TextFile &file, Directory &parent, const char *name)
+directory_load_subdir(LineReader &file, Directory &parent, const char *name)
 {
 	if (parent.FindChild(name) != nullptr)
 		throw FormatRuntimeError("Duplicate subdirectory '%s'", name);
@@ -150,8 +167,28 @@ directory_load_subdir(TextFile &file, Directory &parent, const char *name)
 	return directory;
 }
 
+static void
+directory_load_song(LineReader &file, Directory &directory, const char *name)
+{
+	if (directory.FindSong(name) != nullptr)
+		throw FormatRuntimeError("Duplicate song '%s'", name);
+
+	std::string target;
+	auto audio_format = AudioFormat::Undefined();
+	auto detached_song = song_load(file, name,
+				       &target,
+				       &audio_format);
+
+	auto song = std::make_unique<Song>(std::move(detached_song),
+					   directory);
+	song->SetTarget(target);
+	song->audio_format = audio_format;
+
+	directory.AddSong(std::move(song));
+}
+
 void
-directory_load(TextFile &file, Directory &directory)
+directory_load(LineReader &file, Directory &directory)
 {
 	const char *line;
 
@@ -161,28 +198,332 @@ directory_load(TextFile &file, Directory &directory)
 		if ((p = StringAfterPrefix(line, DIRECTORY_DIR))) {
 			directory_load_subdir(file, directory, p);
 		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+			directory_load_song(file, directory, p);
+		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
 			const char *name = p;
+			playlist_metadata_load(file, directory.playlists, name);
+		} else {
+			throw FormatRuntimeError("Malformed line: %s", line);
+		}
+	}
+}
+
+void
+directory_save_shallow(BufferedOutputStream &os, const Directory &directory)
+{
+	if (!directory.IsRoot())
+		directory_save_header(os, directory);
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			os.Format(DIRECTORY_CHILD "%s\n", child.GetName());
+
+	for (const auto &song : directory.songs)
+		song_save(os, song);
+
+	playlist_vector_save(os, directory.playlists);
+
+	os.Format(DIRECTORY_END "%s\n", directory.GetPath());
+}
+
+void
+directory_load_shallow(LineReader &file, Directory &directory)
+{
+	if (!directory.IsRoot()) {
+		directory.mtime = std::chrono::system_clock::time_point::min();
+		directory.device = 0;
+	}
+
+	directory.songs.clear_and_dispose(DeleteDisposer());
+	directory.playlists.clear();
+	directory.MarkModified();
+
+	/* the listed children are moved to this list (in the listed
+	   order); the others are deleted afterwards */
+	Directory::List children;
+
+	try {
+		const char *line;
+		while ((line = file.ReadLine()) != nullptr &&
+		       !StringStartsWith(line, DIRECTORY_END) &&
+		       /* the root directory's "end: " line without
+			  the trailing space */
+		       !StringIsEqual(line, "end:")) {
+			if (ParseLine(directory, line))
+				continue;
+
+			const char *p;
+			if ((p = StringAfterPrefix(line, DIRECTORY_CHILD))) {
+				Directory *child = directory.FindChild(p);
+				if (child == nullptr)
+					child = directory.CreateChild(p);
+
+				children.splice(children.end(),
+						directory.children,
+						directory.children.iterator_to(*child));
+			} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+				directory_load_song(file, directory, p);
+			} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
+				playlist_metadata_load(file, directory.playlists, p);
+			} else {
+				throw FormatRuntimeError("Malformed line: %s", line);
+			}
+		}
+
+		if (line == nullptr)
+			throw std::runtime_error("Unexpected end of file");
+	} catch (...) {
+		directory.children.splice(directory.children.end(), children);
+		throw;
+	}
+
+	/* keep mount points, which are never listed */
+	directory.ForEachChildSafe([&](Directory &child){
+		if (child.IsMount())
+			children.splice(children.end(), directory.children,
+					directory.children.iterator_to(child));
+	});
+
+	directory.children.clear_and_dispose(DeleteDisposer());
+	directory.children.swap(children);
+}
+
+namespace {
+
+/**
+ * A song parsed by a worker thread of directory_load_parallel(),
+ * not yet attached to a #Directory.
+ */
+struct ParsedSong {
+	DetachedSong song;
+	std::string target;
+	AudioFormat audio_format;
+};
+
+/**
+ * A directory parsed by a worker thread of
+ * directory_load_parallel().  Unlike #Directory, this object is
+ * private to the worker and needs no locking.
+ */
+struct ParsedDirectory {
+	const std::string name;
+
+	std::chrono::system_clock::time_point mtime =
+		std::chrono::system_clock::time_point::min();
+
+	uint64_t device = 0;
+
+	std::list<ParsedDirectory> children;
+	std::list<ParsedSong> songs;
+	std::list<PlaylistInfo> playlists;
+
+	explicit ParsedDirectory(const char *_name) noexcept
+		:name(_name) {}
+};
+
+/**
+ * A top-level directory which is parsed by a worker thread.
+ */
+struct DirectoryChunk final : WorkerPool::Job {
+	ParsedDirectory directory;
+
+	/**
+	 * The lines following the "directory:" line, up to and
+	 * including the matching "end:" line.
+	 */
+	std::string text;
+
+	std::exception_ptr error;
+
+	explicit DirectoryChunk(const char *name) noexcept
+		:directory(name) {}
+
+	/* virtual methods from class WorkerPool::Job */
+	void RunJob() noexcept override;
+};
+
+}
+
+static void
+parsed_directory_load(LineReader &file, ParsedDirectory &directory);
+
+/**
+ * Parse the header and the contents of a directory, i.e. everything
+ * after its "directory:" line.
+ */
+static void
+parsed_directory_load_subdir(LineReader &file, ParsedDirectory &directory)
+{
+	while (true) {
+		const char *line = file.ReadLine();
+		if (line == nullptr)
+			throw std::runtime_error("Unexpected end of file");
+
+		if (StringStartsWith(line, DIRECTORY_BEGIN))
+			break;
+
+		if (!ParseLine(directory, line))
+			throw FormatRuntimeError("Malformed line: %s", line);
+	}
 
-			if (directory.FindSong(name) != nullptr)
-				throw FormatRuntimeError("Duplicate song '%s'", name);
+	parsed_directory_load(file, directory);
+}
 
+static void
+parsed_directory_load(LineReader &file, ParsedDirectory &directory)
+{
+	const char *line;
+
+	while ((line = file.ReadLine()) != nullptr &&
+	       !StringStartsWith(line, DIRECTORY_END)) {
+		const char *p;
+		if ((p = StringAfterPrefix(line, DIRECTORY_DIR))) {
+			directory.children.emplace_back(p);
+			parsed_directory_load_subdir(file,
+						     directory.children.back());
+		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
 			std::string target;
 			auto audio_format = AudioFormat::Undefined();
-			auto detached_song = song_load(file, name,
-						       &target,
-						       &audio_format);
+			auto song = song_load(file, p, &target, &audio_format);
+			directory.songs.push_back({std::move(song),
+						   std::move(target),
+						   audio_format});
+		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
+			directory.playlists.push_back(playlist_metadata_load(file,
+									     p));
+		} else {
+			throw FormatRuntimeError("Malformed line: %s", line);
+		}
+	}
+}
+
+/**
+ * Move a #ParsedDirectory into the database tree.
+ *
+ * Caller must lock the #db_mutex.
+ */
+static void
+directory_merge(Directory &parent, ParsedDirectory &&src)
+{
+	if (parent.FindChild(src.name.c_str()) != nullptr)
+		throw FormatRuntimeError("Duplicate subdirectory '%s'",
+					 src.name.c_str());
+
+	Directory *directory = parent.CreateChild(src.name.c_str());
+	directory->mtime = src.mtime;
+	directory->device = src.device;
+
+	for (auto &child : src.children)
+		directory_merge(*directory, std::move(child));
+
+	for (auto &i : src.songs) {
+		const char *name = i.song.GetURI();
+		if (directory->FindSong(name) != nullptr)
+			throw FormatRuntimeError("Duplicate song '%s'", name);
+
+		auto song = std::make_unique<Song>(std::move(i.song),
+						   *directory);
+		song->SetTarget(i.target);
+		song->audio_format = i.audio_format;
+
+		directory->AddSong(std::move(song));
+	}
+
+	for (auto &i : src.playlists)
+		directory->playlists.UpdateOrInsert(std::move(i));
+}
+
+void
+DirectoryChunk::RunJob() noexcept
+{
+	try {
+		StringLineReader reader(text);
+		parsed_directory_load_subdir(reader, directory);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	/* free memory early */
+	std::string().swap(text);
+}
 
-			auto song = std::make_unique<Song>(std::move(detached_song),
-							   directory);
-			song->target = std::move(target);
-			song->audio_format = audio_format;
+/**
+ * Copy the lines of a top-level directory (following its
+ * "directory:" line) up to and including its "end:" line, or up to
+ * the end of the file; like directory_load(), the parser accepts a
+ * missing "end:" line at the end of the file.
+ */
+static void
+ReadDirectoryChunk(LineReader &file, const std::string &name,
+		   std::string &dest)
+{
+	while (true) {
+		const char *line = file.ReadLine();
+		if (line == nullptr)
+			break;
+
+		dest.append(line);
+		dest.push_back('\n');
+
+		/* the path of a top-level directory equals its
+		   name; nested "end:" lines contain a slash */
+		const char *p = StringAfterPrefix(line, DIRECTORY_END);
+		if (p != nullptr && name == p)
+			break;
+	}
+}
+
+void
+directory_load_parallel(LineReader &file, Directory &root,
+			unsigned n_threads)
+{
+	assert(root.IsRoot());
+	assert(n_threads > 0);
 
-			directory.AddSong(std::move(song));
+	/* declared before the pool, because the pool's destructor
+	   must stop the worker threads before the chunks are
+	   freed */
+	std::list<DirectoryChunk> chunks;
+
+	WorkerPool pool("db_load", n_threads);
+
+	/* limit the number of chunks held in memory */
+	const std::size_t max_chunks = n_threads * 4;
+
+	const auto merge_front = [&chunks, &pool, &root](){
+		auto &chunk = chunks.front();
+		pool.Wait(chunk);
+
+		if (chunk.error)
+			std::rethrow_exception(chunk.error);
+
+		directory_merge(root, std::move(chunk.directory));
+		chunks.pop_front();
+	};
+
+	const char *line;
+
+	while ((line = file.ReadLine()) != nullptr &&
+	       !StringStartsWith(line, DIRECTORY_END)) {
+		const char *p;
+		if ((p = StringAfterPrefix(line, DIRECTORY_DIR))) {
+			chunks.emplace_back(p);
+			auto &chunk = chunks.back();
+			ReadDirectoryChunk(file, chunk.directory.name,
+					   chunk.text);
+			pool.Submit(chunk);
+
+			if (chunks.size() > max_chunks)
+				merge_front();
+		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+			directory_load_song(file, root, p);
 		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
-			const char *name = p;
-			playlist_metadata_load(file, directory.playlists, name);
+			playlist_metadata_load(file, root.playlists, p);
 		} else {
 			throw FormatRuntimeError("Malformed line: %s", line);
 		}
 	}
+
+	while (!chunks.empty())
+		merge_front();
 }
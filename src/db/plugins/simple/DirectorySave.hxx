@@ -21,7 +21,7 @@
 #define MPD_DIRECTORY_SAVE_HXX
 
 struct Directory;
-class TextFile;
+class LineReader;
 class BufferedOutputStream;
 
 void
@@ -31,6 +31,40 @@ directory_save(BufferedOutputStream &os, const Directory &directory);
  * Throws #std::runtime_error on error.
  */
 void
-directory_load(TextFile &file, Directory &directory);
+directory_load(LineReader &file, Directory &directory);
+
+/**
+ * Save only the given directory: its attributes, the names of its
+ * children, its songs and playlists.  This is a record of the
+ * database journal.
+ */
+void
+directory_save_shallow(BufferedOutputStream &os, const Directory &directory);
+
+/**
+ * Load a record written by directory_save_shallow() and replace
+ * the contents of the given directory with it.  Children which are
+ * not listed are deleted, and missing ones are created (empty).
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * Throws #std::runtime_error on error.
+ */
+void
+directory_load_shallow(LineReader &file, Directory &directory);
+
+/**
+ * Like directory_load(), but the subtrees of top-level directories
+ * are parsed by a pool of worker threads and then merged into the
+ * given root directory in file order.  The worker threads never
+ * access the #Directory tree, only the calling thread does.
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * Throws #std::runtime_error on error.
+ */
+void
+directory_load_parallel(LineReader &file, Directory &root,
+			unsigned n_threads);
 
 #endif
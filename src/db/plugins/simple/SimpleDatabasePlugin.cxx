@@ -31,18 +31,27 @@
 #include "Directory.hxx"
 #include "Song.hxx"
 #include "DatabaseSave.hxx"
+#include "DatabaseBinary.hxx"
+#include "DatabaseJournal.hxx"
 #include "db/DatabaseLock.hxx"
 #include "db/DatabaseError.hxx"
 #include "fs/io/TextFile.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
 #include "fs/io/FileOutputStream.hxx"
+#include "fs/io/FileMapping.hxx"
 #include "fs/FileInfo.hxx"
+#include "fs/Traits.hxx"
 #include "config/Block.hxx"
+#include "song/Filter.hxx"
+#include "tag/ParseName.hxx"
 #include "fs/FileSystem.hxx"
 #include "util/CharUtil.hxx"
 #include "util/Domain.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/RecursiveMap.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/SplitString.hxx"
+#include "util/StringAPI.hxx"
 #include "Log.hxx"
 
 #ifdef ENABLE_ZLIB
@@ -54,33 +63,120 @@
 
 static constexpr Domain simple_db_domain("simple_db");
 
+/**
+ * Parse the "format" setting.
+ *
+ * @return true for the binary format
+ */
+static bool
+ParseDatabaseFormat(const char *s)
+{
+	if (StringIsEqual(s, "text"))
+		return false;
+	else if (StringIsEqual(s, "binary"))
+		return true;
+	else
+		throw FormatRuntimeError("Unrecognized database format: \"%s\"",
+					 s);
+}
+
+/**
+ * Parse the "tag_index" and "trigram_index" settings: a
+ * comma-separated list of tag names.
+ */
+static TagMask
+ParseTagIndexMask(const char *s)
+{
+	TagMask mask = TagMask::None();
+	if (s == nullptr)
+		return mask;
+
+	for (const auto &i : SplitString(s, ',')) {
+		const char *name = i.c_str();
+		const auto type = tag_name_parse_i(name);
+		if (type == TAG_NUM_OF_ITEM_TYPES)
+			throw FormatRuntimeError("Unknown tag: \"%s\"", name);
+
+		mask.Set(type);
+	}
+
+	return mask;
+}
+
+/**
+ * Parse the "sort_index" setting: a comma-separated list of tag
+ * names and "Last-Modified".
+ */
+static std::vector<SortIndex>
+ParseSortIndexes(const char *s)
+{
+	std::vector<SortIndex> result;
+	if (s == nullptr)
+		return result;
+
+	for (const auto &i : SplitString(s, ',')) {
+		const char *name = i.c_str();
+
+		TagType type;
+		if (StringIsEqualIgnoreCase(name, "Last-Modified"))
+			type = TagType(SORT_TAG_LAST_MODIFIED);
+		else {
+			type = tag_name_parse_i(name);
+			if (type == TAG_NUM_OF_ITEM_TYPES)
+				throw FormatRuntimeError("Unknown sort tag: \"%s\"",
+							 name);
+		}
+
+		result.emplace_back(type);
+	}
+
+	return result;
+}
+
 inline SimpleDatabase::SimpleDatabase(const ConfigBlock &block)
 	:Database(simple_db_plugin),
 	 path(block.GetPath("path")),
 #ifdef ENABLE_ZLIB
 	 compress(block.GetBlockValue("compress", true)),
 #endif
-	 cache_path(block.GetPath("cache_directory"))
+	 binary(ParseDatabaseFormat(block.GetBlockValue("format", "text"))),
+	 protocol_cache(block.GetBlockValue("protocol_cache", false)),
+	 journal(block.GetBlockValue("journal", false)),
+	 load_threads(block.GetPositiveValue("load_threads", 1U)),
+	 cache_path(block.GetPath("cache_directory")),
+	 sort_indexes(ParseSortIndexes(block.GetBlockValue("sort_index"))),
+	 tag_index(ParseTagIndexMask(block.GetBlockValue("tag_index"))),
+	 trigram_index(ParseTagIndexMask(block.GetBlockValue("trigram_index")))
 {
 	if (path.IsNull())
 		throw std::runtime_error("No \"path\" parameter specified");
 
 	path_utf8 = path.ToUTF8();
+	journal_path = AllocatedPath::FromFS(PathTraitsFS::string(path.c_str()) +
+					     PATH_LITERAL(".journal"));
 }
 
 inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
 #ifndef ENABLE_ZLIB
 				      [[maybe_unused]]
 #endif
-				      bool _compress) noexcept
+				      bool _compress,
+				      bool _binary,
+				      bool _protocol_cache) noexcept
 	:Database(simple_db_plugin),
 	 path(std::move(_path)),
 	 path_utf8(path.ToUTF8()),
 #ifdef ENABLE_ZLIB
 	 compress(_compress),
 #endif
-	 cache_path(nullptr)
+	 binary(_binary),
+	 protocol_cache(_protocol_cache),
+	 cache_path(nullptr),
+	 tag_index(TagMask::None()),
+	 trigram_index(TagMask::None())
 {
+	journal_path = AllocatedPath::FromFS(PathTraitsFS::string(path.c_str()) +
+					     PATH_LITERAL(".journal"));
 }
 
 DatabasePtr
@@ -150,15 +246,90 @@ SimpleDatabase::Load()
 	assert(!path.IsNull());
 	assert(root != nullptr);
 
-	TextFile file(path);
+	bool loaded = false;
 
-	LogDebug(simple_db_domain, "reading DB");
+	{
+		const FileMapping mapping(path);
+		if (db_is_binary(mapping.Get())) {
+			LogDebug(simple_db_domain, "reading binary DB");
+
+			db_load_binary(mapping.Get(), *root);
+			loaded = true;
+		}
+	}
+
+	if (!loaded) {
+		TextFile file(path);
 
-	db_load_internal(file, *root);
+		LogDebug(simple_db_domain, "reading DB");
+
+		db_load_internal(file, *root, load_threads);
+	}
 
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
 		mtime = fi.GetModificationTime();
+
+	UpdateBase();
+	LoadJournal();
+
+	const ScopeDatabaseLock protect;
+	root->ClearModified();
+}
+
+void
+SimpleDatabase::LoadJournal()
+{
+	FileInfo fi;
+	if (!GetFileInfo(journal_path, fi) || !fi.IsRegular())
+		return;
+
+	std::string data;
+	if (fi.GetSize() > 0) {
+		const FileMapping mapping(journal_path);
+		const auto src = mapping.Get();
+		data.assign((const char *)src.data, src.size);
+	}
+
+	LogDebug(simple_db_domain, "reading DB journal");
+
+	const std::size_t journal_size = data.size();
+	bool applied;
+
+	{
+		const ScopeDatabaseLock protect;
+		applied = db_journal_load(data, *root, base_size, base_mtime);
+	}
+
+	if (!applied) {
+		LogWarning(simple_db_domain,
+			   "Ignoring stale database journal");
+		/* rewrite the database file (and delete the journal)
+		   on the next save */
+		base_size = 0;
+		return;
+	}
+
+	if (data.size() < journal_size) {
+		LogWarning(simple_db_domain,
+			   "Discarding incomplete database journal batch");
+		/* don't append after the garbage; rewrite the database
+		   file instead */
+		base_size = 0;
+	}
+
+	mtime = fi.GetModificationTime();
+}
+
+void
+SimpleDatabase::UpdateBase() noexcept
+{
+	FileInfo fi;
+	if (GetFileInfo(path, fi)) {
+		base_size = fi.GetSize();
+		base_mtime = std::chrono::system_clock::to_time_t(fi.GetModificationTime());
+	} else
+		base_size = base_mtime = 0;
 }
 
 void
@@ -180,10 +351,17 @@ SimpleDatabase::Open()
 
 		delete root;
 
+		/* Load() may have failed in LoadJournal() after
+		   having loaded the database file */
+		mtime = std::chrono::system_clock::time_point::min();
+		base_size = 0;
+
 		Check();
 
 		root = Directory::NewRoot();
 	}
+
+	RebuildIndexes();
 }
 
 void
@@ -193,9 +371,128 @@ SimpleDatabase::Close() noexcept
 	assert(prefixed_light_song == nullptr);
 	assert(borrowed_song_count == 0);
 
+	indexes_valid = false;
+	for (auto &i : sort_indexes)
+		i.Clear();
+	tag_index.Clear();
+	trigram_index.Clear();
+	index_songs.clear();
+	index_songs.shrink_to_fit();
+
 	delete root;
 }
 
+void
+SimpleDatabase::RebuildIndexes() noexcept
+{
+	if (!HasIndexes())
+		return;
+
+	try {
+		std::vector<const Song *> songs;
+
+		{
+			const ScopeDatabaseLock protect;
+			SortIndex::Collect(*root, songs);
+		}
+
+		/* building is done without holding the lock; this is
+		   safe because only the calling thread modifies the
+		   songs, and nobody uses the indexes until
+		   "indexes_valid" is set */
+		for (auto &i : sort_indexes)
+			i.Build(songs);
+
+		tag_index.Build(songs);
+		trigram_index.Build(songs);
+
+		songs.shrink_to_fit();
+		index_songs = std::move(songs);
+	} catch (...) {
+		LogError(std::current_exception(),
+			 "Failed to build the database indexes");
+		return;
+	}
+
+	const ScopeDatabaseLock protect;
+	indexes_valid = true;
+}
+
+const SortIndex *
+SimpleDatabase::FindSortIndex(TagType sort) const noexcept
+{
+	if (!CanUseIndexes())
+		return nullptr;
+
+	for (const auto &i : sort_indexes)
+		if (i.GetType() == sort)
+			return &i;
+
+	return nullptr;
+}
+
+bool
+SimpleDatabase::LookupCandidates(const SongFilter &filter,
+				 std::vector<unsigned> &candidates) const
+{
+	bool found = tag_index.Lookup(filter, candidates);
+
+	std::vector<unsigned> tmp;
+	if (trigram_index.Lookup(filter, tmp) &&
+	    (!found || tmp.size() < candidates.size())) {
+		candidates = std::move(tmp);
+		found = true;
+	}
+
+	return found;
+}
+
+void
+SimpleDatabase::VisitCandidates(const std::vector<unsigned> &candidates,
+				const Directory &directory,
+				const DatabaseSelection &selection,
+				const VisitSong &visit_song) const
+{
+	for (const unsigned position : candidates) {
+		const Song &song = *index_songs[position];
+		if (!song.IsInside(directory, selection.recursive))
+			continue;
+
+		const LightSong song2 = song.Export(protocol_cache);
+		if (selection.filter == nullptr ||
+		    selection.filter->Match(song2))
+			visit_song(song2);
+	}
+}
+
+void
+SimpleDatabase::BeginUpdate() noexcept
+{
+	const ScopeDatabaseLock protect;
+	indexes_valid = false;
+}
+
+void
+SimpleDatabase::EndUpdate(bool modified) noexcept
+{
+	if (modified) {
+		{
+			/* the indexes are collected in directory
+			   order, which must be the same order the
+			   plain walk (after Save()) sees */
+			const ScopeDatabaseLock protect;
+			root->PruneEmpty();
+			root->Sort();
+		}
+
+		RebuildIndexes();
+		++version;
+	} else if (HasIndexes()) {
+		const ScopeDatabaseLock protect;
+		indexes_valid = true;
+	}
+}
+
 const LightSong *
 SimpleDatabase::GetSong(const char *uri) const
 {
@@ -296,6 +593,47 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		return;
 	}
 
+	const SortIndex *sort_index = r.uri == nullptr && visit_song
+		? FindSortIndex(selection.sort)
+		: nullptr;
+
+	std::vector<unsigned> candidates;
+	if (r.uri == nullptr && visit_song &&
+	    !visit_directory && !visit_playlist &&
+	    selection.filter != nullptr && CanUseIndexes() &&
+	    LookupCandidates(*selection.filter, candidates) &&
+	    /* if there is a sort index and the filter is not very
+	       selective, scanning the sort index is cheaper than
+	       sorting all candidates */
+	    (sort_index == nullptr ||
+	     candidates.size() < index_songs.size() / 8)) {
+		DatabaseVisitorHelper helper(CheckSelection(selection),
+					     visit_song);
+		VisitCandidates(candidates, *r.directory, selection,
+				visit_song);
+		helper.Commit();
+		return;
+	}
+
+	if (sort_index != nullptr) {
+		/* the index implements "sort" and "window"; songs are
+		   visited after directories and playlists, just like
+		   DatabaseVisitorHelper does */
+
+		if (selection.recursive && visit_directory)
+			visit_directory(r.directory->Export());
+
+		if (visit_directory || visit_playlist)
+			r.directory->Walk(selection.recursive, selection.filter,
+					  protocol_cache,
+					  visit_directory, VisitSong(),
+					  visit_playlist);
+
+		sort_index->Visit(*r.directory, selection, protocol_cache,
+				  visit_song);
+		return;
+	}
+
 	DatabaseVisitorHelper helper(CheckSelection(selection), visit_song);
 
 	if (r.uri == nullptr) {
@@ -305,6 +643,7 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 			visit_directory(r.directory->Export());
 
 		r.directory->Walk(selection.recursive, selection.filter,
+				  protocol_cache,
 				  visit_directory, visit_song,
 				  visit_playlist);
 		helper.Commit();
@@ -315,7 +654,8 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		if (visit_song) {
 			Song *song = r.directory->FindSong(r.uri);
 			if (song != nullptr) {
-				const LightSong song2 = song->Export();
+				const LightSong song2 =
+					song->Export(protocol_cache);
 				if (selection.Match(song2))
 					visit_song(song2);
 
@@ -345,6 +685,68 @@ SimpleDatabase::GetStats(const DatabaseSelection &selection) const
 void
 SimpleDatabase::Save()
 {
+	if (journal && base_size > 0) {
+		try {
+			if (SaveJournal())
+				return;
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to write the database journal");
+		}
+	}
+
+	SaveFull();
+}
+
+bool
+SimpleDatabase::SaveJournal()
+{
+	FileInfo fi;
+	const bool exists = GetFileInfo(journal_path, fi);
+
+	/* compact the journal (i.e. rewrite the database file) when
+	   it becomes larger than the database file */
+	if (exists && fi.GetSize() > base_size)
+		return false;
+
+	{
+		const ScopeDatabaseLock protect;
+		db_journal_prepare(*root);
+	}
+
+	LogDebug(simple_db_domain, "writing DB journal");
+
+	{
+		FileOutputStream fos(journal_path,
+				     FileOutputStream::Mode::APPEND_OR_CREATE);
+		BufferedOutputStream bos(fos);
+
+		if (!exists || fi.GetSize() == 0)
+			db_journal_save_header(bos, base_size, base_mtime);
+
+		db_journal_save(bos, *root);
+		bos.Flush();
+		fos.Commit();
+	}
+
+	{
+		const ScopeDatabaseLock protect;
+		root->ClearModified();
+	}
+
+	if (GetFileInfo(journal_path, fi))
+		mtime = fi.GetModificationTime();
+
+	return true;
+}
+
+void
+SimpleDatabase::SaveFull()
+{
+	/* no journal until the new database file has been written
+	   successfully */
+	base_size = 0;
+
 	{
 		const ScopeDatabaseLock protect;
 
@@ -355,38 +757,63 @@ SimpleDatabase::Save()
 		root->Sort();
 	}
 
-	LogDebug(simple_db_domain, "writing DB");
-
 	FileOutputStream fos(path);
 
-	OutputStream *os = &fos;
+	if (binary) {
+		/* never compressed, because the loader maps the
+		   file into memory */
+		LogDebug(simple_db_domain, "writing binary DB");
+
+		BufferedOutputStream bos(fos);
+		db_save_binary(bos, *root);
+		bos.Flush();
+	} else {
+		LogDebug(simple_db_domain, "writing DB");
+
+		OutputStream *os = &fos;
 
 #ifdef ENABLE_ZLIB
-	std::unique_ptr<GzipOutputStream> gzip;
-	if (compress) {
-		gzip = std::make_unique<GzipOutputStream>(*os);
-		os = gzip.get();
-	}
+		std::unique_ptr<GzipOutputStream> gzip;
+		if (compress) {
+			gzip = std::make_unique<GzipOutputStream>(*os);
+			os = gzip.get();
+		}
 #endif
 
-	BufferedOutputStream bos(*os);
+		BufferedOutputStream bos(*os);
 
-	db_save_internal(bos, *root);
+		db_save_internal(bos, *root);
 
-	bos.Flush();
+		bos.Flush();
 
 #ifdef ENABLE_ZLIB
-	if (gzip != nullptr) {
-		gzip->Flush();
-		gzip.reset();
-	}
+		if (gzip != nullptr) {
+			gzip->Flush();
+			gzip.reset();
+		}
 #endif
+	}
 
 	fos.Commit();
 
+	if (PathExists(journal_path)) {
+		try {
+			RemoveFile(journal_path);
+		} catch (...) {
+			LogError(std::current_exception());
+		}
+	}
+
+	{
+		const ScopeDatabaseLock protect;
+		root->ClearModified();
+	}
+
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
 		mtime = fi.GetModificationTime();
+
+	UpdateBase();
 }
 
 void
@@ -412,6 +839,8 @@ SimpleDatabase::Mount(const char *uri, DatabasePtr db)
 
 	Directory *mnt = r.directory->CreateChild(r.uri);
 	mnt->mounted_database = std::move(db);
+	++n_mounts;
+	++version;
 }
 
 static constexpr bool
@@ -442,7 +871,8 @@ SimpleDatabase::Mount(const char *local_uri, const char *storage_uri)
 	constexpr bool compress = false;
 #endif
 	auto db = std::make_unique<SimpleDatabase>(cache_path / name_fs,
-						   compress);
+						   compress, binary,
+						   protocol_cache);
 	db->Open();
 
 	// TODO: update the new database instance?
@@ -467,6 +897,10 @@ SimpleDatabase::LockUmountSteal(const char *uri) noexcept
 	auto db = std::move(r.directory->mounted_database);
 	r.directory->Delete();
 
+	assert(n_mounts > 0);
+	--n_mounts;
+	++version;
+
 	return db;
 }
 
@@ -483,6 +917,6 @@ SimpleDatabase::Unmount(const char *uri) noexcept
 
 const DatabasePlugin simple_db_plugin = {
 	"simple",
-	DatabasePlugin::FLAG_REQUIRE_STORAGE,
+	DatabasePlugin::FLAG_REQUIRE_STORAGE|DatabasePlugin::FLAG_THREAD_SAFE,
 	SimpleDatabase::Create,
 };
@@ -20,6 +20,9 @@
 #ifndef MPD_SIMPLE_DATABASE_PLUGIN_HXX
 #define MPD_SIMPLE_DATABASE_PLUGIN_HXX
 
+#include "SortIndex.hxx"
+#include "TagIndex.hxx"
+#include "TrigramIndex.hxx"
 #include "db/Interface.hxx"
 #include "db/Ptr.hxx"
 #include "fs/AllocatedPath.hxx"
@@ -28,7 +31,9 @@
 #include "util/Compiler.h"
 #include "config.h"
 
+#include <atomic>
 #include <cassert>
+#include <vector>
 
 struct ConfigBlock;
 struct Directory;
@@ -36,6 +41,7 @@ struct DatabasePlugin;
 class EventLoop;
 class DatabaseListener;
 class PrefixedLightSong;
+class SongFilter;
 
 class SimpleDatabase : public Database {
 	AllocatedPath path;
@@ -45,13 +51,102 @@ class SimpleDatabase : public Database {
 	bool compress;
 #endif
 
+	/**
+	 * Write the database file in the binary format (see
+	 * DatabaseBinary.hxx) instead of the text format?  Loading
+	 * detects the format automatically, so toggling this setting
+	 * converts the file on the next save.
+	 */
+	bool binary;
+
+	/**
+	 * Let Song::Export() expose Song::protocol_cache while
+	 * visiting songs (the "protocol_cache" setting)?
+	 */
+	bool protocol_cache;
+
+	/**
+	 * Append modified directories to the journal file instead of
+	 * rewriting the whole database file after each update?
+	 */
+	bool journal = false;
+
+	/**
+	 * The number of threads parsing a database file in the text
+	 * format.
+	 */
+	unsigned load_threads = 1;
+
 	/**
 	 * The path where cache files for Mount() are located.
 	 */
 	AllocatedPath cache_path;
 
+	/**
+	 * The path of the journal file: #path with the suffix
+	 * ".journal".
+	 */
+	AllocatedPath journal_path = nullptr;
+
+	/**
+	 * The size and modification time (in seconds) of the
+	 * database file which is the base for the journal.  Zero if
+	 * there is none; then the next Save() rewrites the whole
+	 * database file.
+	 */
+	uint64_t base_size = 0, base_mtime = 0;
+
 	Directory *root;
 
+	/**
+	 * Indexes which implement DatabaseSelection::sort; configured
+	 * with the "sort_index" setting.
+	 */
+	std::vector<SortIndex> sort_indexes;
+
+	/**
+	 * An inverted index which speeds up filters with exact tag
+	 * matches; configured with the "tag_index" setting.
+	 */
+	TagIndex tag_index;
+
+	/**
+	 * An index which speeds up case-insensitive substring
+	 * filters; configured with the "trigram_index" setting.
+	 */
+	TrigramIndex trigram_index;
+
+	/**
+	 * All songs in the order of Directory::Walk().  #tag_index and
+	 * #trigram_index refer to songs by their position in this
+	 * list.
+	 */
+	std::vector<const Song *> index_songs;
+
+	/**
+	 * Are the indexes up to date?  This is false
+	 * while the update thread modifies the directory tree.
+	 *
+	 * Protected by #db_mutex.
+	 */
+	bool indexes_valid = false;
+
+	/**
+	 * The number of databases mounted with Mount().  The indexes
+	 * do not cover them.
+	 *
+	 * Protected by #db_mutex.
+	 */
+	unsigned n_mounts = 0;
+
+	/**
+	 * Incremented each time the directory tree is modified in a
+	 * way which is visible to clients: by an update which has
+	 * modified it, by Mount() and by Unmount().  See
+	 * GetVersion().
+	 */
+	std::atomic_uint version{0};
+
 	std::chrono::system_clock::time_point mtime;
 
 	/**
@@ -71,7 +166,8 @@ class SimpleDatabase : public Database {
 
 public:
 	SimpleDatabase(const ConfigBlock &block);
-	SimpleDatabase(AllocatedPath &&_path, bool _compress) noexcept;
+	SimpleDatabase(AllocatedPath &&_path, bool _compress,
+		       bool _binary, bool _protocol_cache) noexcept;
 
 	static DatabasePtr Create(EventLoop &main_event_loop,
 				  EventLoop &io_event_loop,
@@ -87,6 +183,30 @@ public:
 
 	void Save();
 
+	/**
+	 * Returns a number which changes whenever the directory tree
+	 * (without the contents of mounted databases) is modified.
+	 * This allows caches to detect stale data.
+	 */
+	unsigned GetVersion() const noexcept {
+		return version.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Called by the update thread before it modifies the
+	 * directory tree.  Disables all indexes pointing into it.
+	 */
+	void BeginUpdate() noexcept;
+
+	/**
+	 * Called by the update thread after it has finished
+	 * modifying the directory tree.  Removes empty directories,
+	 * sorts the tree and rebuilds the indexes.
+	 *
+	 * @param modified was the directory tree modified?
+	 */
+	void EndUpdate(bool modified) noexcept;
+
 	/**
 	 * Returns true if there is a valid database file on the disk.
 	 */
@@ -141,7 +261,93 @@ private:
 	 */
 	void Load();
 
+	/**
+	 * Replay the journal file (if one exists) on top of the
+	 * loaded database.
+	 *
+	 * Throws on error.
+	 */
+	void LoadJournal();
+
+	/**
+	 * Append all modified directories to the journal file.
+	 *
+	 * Throws on error.
+	 *
+	 * @return false if the whole database file needs to be
+	 * rewritten instead
+	 */
+	bool SaveJournal();
+
+	/**
+	 * Rewrite the whole database file and delete the journal.
+	 *
+	 * Throws on error.
+	 */
+	void SaveFull();
+
+	/**
+	 * Remember the size and modification time of the database
+	 * file as the journal base.
+	 */
+	void UpdateBase() noexcept;
+
 	DatabasePtr LockUmountSteal(const char *uri) noexcept;
+
+	/**
+	 * Rebuild all indexes from scratch.  Must be
+	 * called from the thread which modifies the directory tree.
+	 */
+	void RebuildIndexes() noexcept;
+
+	bool HasIndexes() const noexcept {
+		return !sort_indexes.empty() || tag_index.IsEnabled() ||
+			trigram_index.IsEnabled();
+	}
+
+	/**
+	 * May the indexes be used currently?
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	bool CanUseIndexes() const noexcept {
+		return indexes_valid && n_mounts == 0;
+	}
+
+	/**
+	 * Find a #SortIndex for the given DatabaseSelection::sort
+	 * value.  Returns nullptr if there is none or if it cannot be
+	 * used currently.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	gcc_pure
+	const SortIndex *FindSortIndex(TagType sort) const noexcept;
+
+	/**
+	 * Use #tag_index or #trigram_index to determine which songs
+	 * may match the given filter.
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @param candidates receives a sorted list of positions in
+	 * #index_songs
+	 * @return false if no index can be used for the filter
+	 */
+	bool LookupCandidates(const SongFilter &filter,
+			      std::vector<unsigned> &candidates) const;
+
+	/**
+	 * Pass all candidates which are inside the given directory
+	 * and match the filter of the #DatabaseSelection to the
+	 * visitor.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void VisitCandidates(const std::vector<unsigned> &candidates,
+			     const Directory &directory,
+			     const DatabaseSelection &selection,
+			     const VisitSong &visit_song) const;
 };
 
 extern const DatabasePlugin simple_db_plugin;
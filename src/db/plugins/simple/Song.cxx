@@ -19,43 +19,116 @@
 
 #include "Song.hxx"
 #include "Directory.hxx"
+#include "SongAllocator.hxx"
 #include "tag/Tag.hxx"
+#include "tag/Builder.hxx"
 #include "song/DetachedSong.hxx"
 #include "song/LightSong.hxx"
 #include "fs/Traits.hxx"
 
-Song::Song(DetachedSong &&other, Directory &_parent) noexcept
+#include <cassert>
+
+static AllocatedString<>
+DuplicateString(std::string_view s)
+{
+	return AllocatedString<>::Duplicate(s.data(), s.size());
+}
+
+Song::Song(std::string_view _filename, Directory &_parent)
+	:parent(_parent), filename(DuplicateString(_filename))
+{
+}
+
+Song::Song(DetachedSong &&other, Directory &_parent)
 	:tag(std::move(other.WritableTag())),
 	 parent(_parent),
 	 mtime(other.GetLastModified()),
 	 start_time(other.GetStartTime()),
 	 end_time(other.GetEndTime()),
-	 filename(other.GetURI())
+	 filename(AllocatedString<>::Duplicate(other.GetURI()))
 {
 }
 
+void *
+Song::operator new(std::size_t size)
+{
+	assert(size == sizeof(Song));
+	(void)size;
+
+	return song_allocator.Allocate();
+}
+
+void
+Song::operator delete(void *p) noexcept
+{
+	song_allocator.Free(p);
+}
+
+void
+Song::SetFilename(std::string_view _filename)
+{
+	filename = DuplicateString(_filename);
+}
+
+void
+Song::SetTarget(std::string_view _target)
+{
+	target = _target.empty()
+		? nullptr
+		: DuplicateString(_target);
+}
+
+void
+Song::ApplyScan(std::chrono::system_clock::time_point _mtime,
+		AudioFormat _audio_format,
+		TagBuilder &tag_builder) noexcept
+{
+	mtime = _mtime;
+	audio_format = _audio_format;
+	tag_builder.Commit(tag);
+	InvalidateProtocolCache();
+}
+
 std::string
 Song::GetURI() const noexcept
 {
 	if (parent.IsRoot())
-		return filename;
+		return filename.c_str();
 	else {
 		const char *path = parent.GetPath();
 		return PathTraitsUTF8::Build(path, filename.c_str());
 	}
 }
 
+bool
+Song::IsInside(const Directory &directory, bool recursive) const noexcept
+{
+	if (!recursive)
+		return &parent == &directory;
+
+	if (directory.IsRoot())
+		return true;
+
+	for (const Directory *i = &parent; i != nullptr; i = i->parent)
+		if (i == &directory)
+			return true;
+
+	return false;
+}
+
 LightSong
-Song::Export() const noexcept
+Song::Export(bool with_protocol_cache) const noexcept
 {
 	LightSong dest(filename.c_str(), tag);
 	if (!parent.IsRoot())
 		dest.directory = parent.GetPath();
-	if (!target.empty())
+	if (target != nullptr)
 		dest.real_uri = target.c_str();
 	dest.mtime = mtime;
 	dest.start_time = start_time;
 	dest.end_time = end_time;
 	dest.audio_format = audio_format;
+	if (with_protocol_cache)
+		dest.protocol_cache = &protocol_cache;
 	return dest;
 }
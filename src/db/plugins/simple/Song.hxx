@@ -24,12 +24,15 @@
 #include "Chrono.hxx"
 #include "tag/Tag.hxx"
 #include "pcm/AudioFormat.hxx"
+#include "util/AllocatedString.hxx"
 #include "util/Compiler.h"
 #include "config.h"
 
 #include <boost/intrusive/list.hpp>
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 struct StringView;
 struct LightSong;
@@ -37,10 +40,16 @@ struct Directory;
 class DetachedSong;
 class Storage;
 class ArchiveFile;
+class TagBuilder;
 
 /**
  * A song file inside the configured music directory.  Internal
  * #SimpleDatabase class.
+ *
+ * Since there may be hundreds of thousands of instances, this
+ * struct is kept small: strings are allocated with their exact size
+ * instead of using std::string, and the objects themselves are
+ * allocated in contiguous blocks by #SongAllocator.
  */
 struct Song {
 	static constexpr auto link_mode = boost::intrusive::normal_link;
@@ -89,24 +98,47 @@ struct Song {
 	AudioFormat audio_format = AudioFormat::Undefined();
 
 	/**
-	 * The file name.
+	 * The file name.  Never nullptr.
 	 */
-	std::string filename;
+	AllocatedString<> filename;
 
 	/**
-	 * If non-empty, then this object does not describe a file
+	 * If not nullptr, then this object does not describe a file
 	 * within the `music_directory`, but some sort of symbolic
 	 * link pointing to this value.  It can be an absolute URI
 	 * (i.e. with URI scheme) or a URI relative to this object
 	 * (which may begin with one or more "../").
 	 */
-	std::string target;
+	AllocatedString<> target = nullptr;
+
+	/**
+	 * The song_print_info() output for this song (excluding the
+	 * "file" line), filled on demand if the database has enabled
+	 * its "protocol_cache" setting (see Export()).  Must be
+	 * cleared with InvalidateProtocolCache() whenever one of the
+	 * attributes it was generated from is modified.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	mutable AllocatedString<> protocol_cache = nullptr;
+
+	Song(std::string_view _filename, Directory &_parent);
+
+	Song(DetachedSong &&other, Directory &_parent);
 
-	template<typename F>
-	Song(F &&_filename, Directory &_parent) noexcept
-		:parent(_parent), filename(std::forward<F>(_filename)) {}
+	static void *operator new(std::size_t size);
+	static void operator delete(void *p) noexcept;
 
-	Song(DetachedSong &&other, Directory &_parent) noexcept;
+	void SetFilename(std::string_view _filename);
+
+	void InvalidateProtocolCache() noexcept {
+		protocol_cache = nullptr;
+	}
+
+	/**
+	 * Set the #target attribute; an empty string clears it.
+	 */
+	void SetTarget(std::string_view _target);
 
 	/**
 	 * allocate a new song structure with a local file name and attempt to
@@ -122,12 +154,41 @@ struct Song {
 				Directory &parent);
 
 	/**
+	 * Scan the file and apply the result with ApplyScan().  The
+	 * file is scanned without holding #db_mutex; the caller must
+	 * not hold it.
+	 *
 	 * Throws on error.
 	 *
 	 * @return true on success, false if the file was not recognized
 	 */
 	bool UpdateFile(Storage &storage);
 
+	/**
+	 * Replace the attributes obtained from scanning the file
+	 * (see ScanFile()) and invalidate the #protocol_cache.
+	 *
+	 * Caller must lock #db_mutex.
+	 */
+	void ApplyScan(std::chrono::system_clock::time_point _mtime,
+		       AudioFormat _audio_format,
+		       TagBuilder &tag_builder) noexcept;
+
+	/**
+	 * Scan the specified file without touching any #Song object.
+	 * This is the expensive part of UpdateFile(), and it may be
+	 * called from any thread.
+	 *
+	 * Throws on error.
+	 *
+	 * @param uri_utf8 the song URI relative to the storage root
+	 * @return true on success, false if the file was not recognized
+	 */
+	static bool ScanFile(Storage &storage, const char *uri_utf8,
+			     TagBuilder &tag_builder,
+			     AudioFormat &audio_format,
+			     std::chrono::system_clock::time_point &mtime);
+
 #ifdef ENABLE_ARCHIVE
 	static SongPtr LoadFromArchive(ArchiveFile &archive,
 				       const char *name_utf8,
@@ -142,8 +203,23 @@ struct Song {
 	gcc_pure
 	std::string GetURI() const noexcept;
 
+	/**
+	 * @param with_protocol_cache expose #protocol_cache in the
+	 * returned object?  Only allowed if the caller holds #db_mutex
+	 * as long as the returned object is used.
+	 */
+	gcc_pure
+	LightSong Export(bool with_protocol_cache=false) const noexcept;
+
+	/**
+	 * Is this song inside the given directory?
+	 *
+	 * @param recursive if true, then songs in subdirectories of
+	 * the given directory match as well
+	 */
 	gcc_pure
-	LightSong Export() const noexcept;
+	bool IsInside(const Directory &directory,
+		      bool recursive) const noexcept;
 };
 
 typedef boost::intrusive::list<Song,
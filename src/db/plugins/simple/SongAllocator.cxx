@@ -0,0 +1,103 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SongAllocator.hxx"
+#include "Song.hxx"
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * The number of #Song objects in each block; with the current size
+ * of #Song, this is roughly 64 kB.
+ */
+static constexpr std::size_t SONGS_PER_BLOCK = 512;
+
+SongAllocator song_allocator(sizeof(Song), SONGS_PER_BLOCK);
+
+static constexpr std::size_t
+AlignSize(std::size_t size) noexcept
+{
+	constexpr std::size_t alignment = alignof(std::max_align_t);
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+SongAllocator::SongAllocator(std::size_t _item_size,
+			     std::size_t _items_per_block) noexcept
+	:item_size(AlignSize(_item_size)),
+	 items_per_block(_items_per_block),
+	 block_size(AlignSize(sizeof(Block)) + item_size * items_per_block)
+{
+}
+
+SongAllocator::~SongAllocator() noexcept
+{
+	while (blocks != nullptr) {
+		Block *block = blocks;
+		blocks = block->next;
+		std::free(block);
+	}
+}
+
+void
+SongAllocator::AddBlock()
+{
+	auto *block = (Block *)std::malloc(block_size);
+	if (block == nullptr)
+		throw std::bad_alloc();
+
+	block->next = blocks;
+	blocks = block;
+
+	/* put all objects of the new block on the free list; in
+	   reverse order, so they get allocated in ascending
+	   addresses */
+	auto *begin = (std::byte *)block + AlignSize(sizeof(Block));
+	for (std::size_t i = items_per_block; i-- > 0;) {
+		auto *item = (FreeItem *)(begin + i * item_size);
+		item->next = free_items;
+		free_items = item;
+	}
+}
+
+void *
+SongAllocator::Allocate()
+{
+	const std::lock_guard<Mutex> protect(mutex);
+
+	if (free_items == nullptr)
+		AddBlock();
+
+	FreeItem *item = free_items;
+	free_items = item->next;
+	return item;
+}
+
+void
+SongAllocator::Free(void *p) noexcept
+{
+	if (p == nullptr)
+		return;
+
+	auto *item = (FreeItem *)p;
+
+	const std::lock_guard<Mutex> protect(mutex);
+	item->next = free_items;
+	free_items = item;
+}
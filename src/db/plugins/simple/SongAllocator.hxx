@@ -0,0 +1,96 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SONG_ALLOCATOR_HXX
+#define MPD_SONG_ALLOCATOR_HXX
+
+#include "thread/Mutex.hxx"
+
+#include <cstddef>
+
+/**
+ * Allocates memory for #Song objects in large contiguous blocks
+ * instead of one heap allocation per song.  This avoids the
+ * per-allocation overhead of the general purpose allocator and
+ * keeps songs close to each other in memory.
+ *
+ * Freed objects are put on a free list and reused by the next
+ * allocation; blocks are only returned to the system by the
+ * destructor.
+ *
+ * This class is thread-safe.
+ */
+class SongAllocator {
+	/**
+	 * An unused object.
+	 */
+	struct FreeItem {
+		FreeItem *next;
+	};
+
+	/**
+	 * A block of objects.  The header is followed by the
+	 * objects.
+	 */
+	struct Block {
+		Block *next;
+	};
+
+	const std::size_t item_size;
+
+	const std::size_t items_per_block;
+
+	/**
+	 * The size of each #Block including its header.
+	 */
+	const std::size_t block_size;
+
+	Mutex mutex;
+
+	Block *blocks = nullptr;
+
+	FreeItem *free_items = nullptr;
+
+public:
+	/**
+	 * @param _item_size the size of one object
+	 * @param _items_per_block the number of objects in each block
+	 */
+	SongAllocator(std::size_t _item_size,
+		      std::size_t _items_per_block) noexcept;
+
+	~SongAllocator() noexcept;
+
+	SongAllocator(const SongAllocator &) = delete;
+	SongAllocator &operator=(const SongAllocator &) = delete;
+
+	/**
+	 * Throws std::bad_alloc on error.
+	 */
+	void *Allocate();
+
+	void Free(void *p) noexcept;
+
+private:
+	void AddBlock();
+};
+
+extern SongAllocator song_allocator;
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SortIndex.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/Selection.hxx"
+#include "db/VHelper.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+
+#include <algorithm>
+#include <cassert>
+
+void
+SortIndex::Collect(const Directory &directory,
+		   std::vector<const Song *> &dest)
+{
+	assert(!directory.IsMount());
+
+	for (const auto &song : directory.songs)
+		dest.push_back(&song);
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			Collect(child, dest);
+}
+
+inline bool
+SortIndex::Less(const Song &a, const Song &b) const noexcept
+{
+	return CompareSortOrder(type, false, a.tag, a.mtime, b.tag, b.mtime);
+}
+
+void
+SortIndex::Build(const std::vector<const Song *> &src)
+{
+	songs = src;
+	songs.shrink_to_fit();
+
+	std::stable_sort(songs.begin(), songs.end(),
+			 [this](const Song *a, const Song *b){
+				 return Less(*a, *b);
+			 });
+}
+
+template<typename F>
+inline void
+SortIndex::ForEach(bool descending, F &&f) const
+{
+	if (!descending) {
+		for (const Song *song : songs)
+			if (!f(*song))
+				return;
+		return;
+	}
+
+	/* walk backwards, one group of equal songs at a time, and
+	   visit each group in forward order */
+	const auto begin = songs.begin();
+	auto end = songs.end();
+	while (end != begin) {
+		const Song &last = **std::prev(end);
+
+		auto first = std::prev(end);
+		while (first != begin && !Less(**std::prev(first), last))
+			--first;
+
+		for (auto i = first; i != end; ++i)
+			if (!f(**i))
+				return;
+
+		end = first;
+	}
+}
+
+void
+SortIndex::Visit(const Directory &directory,
+		 const DatabaseSelection &selection,
+		 bool protocol_cache,
+		 const VisitSong &visit_song) const
+{
+	assert(selection.sort == type);
+
+	const auto window = selection.window;
+	if (window.start >= window.end)
+		return;
+
+	unsigned counter = 0;
+
+	ForEach(selection.descending, [&](const Song &song){
+		if (!song.IsInside(directory, selection.recursive))
+			return true;
+
+		const LightSong song2 = song.Export(protocol_cache);
+		if (selection.filter != nullptr &&
+		    !selection.filter->Match(song2))
+			return true;
+
+		if (window.Contains(counter))
+			visit_song(song2);
+
+		return ++counter < window.end;
+	});
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SORT_INDEX_HXX
+#define MPD_SORT_INDEX_HXX
+
+#include "db/Visitor.hxx"
+#include "tag/Type.h"
+
+#include <vector>
+
+struct Directory;
+struct Song;
+struct DatabaseSelection;
+
+/**
+ * All songs of a #Directory tree, sorted by one tag.  This allows
+ * SimpleDatabase::Visit() to implement "sort" and "window" by
+ * scanning the index instead of copying and sorting all matching
+ * songs.
+ *
+ * Songs which compare equal are kept in the order of
+ * Directory::Walk(), so the result is the same as the one generated
+ * by #DatabaseVisitorHelper.
+ */
+class SortIndex {
+	/**
+	 * A #TagType or #SORT_TAG_LAST_MODIFIED.
+	 */
+	const TagType type;
+
+	std::vector<const Song *> songs;
+
+public:
+	explicit SortIndex(TagType _type) noexcept
+		:type(_type) {}
+
+	TagType GetType() const noexcept {
+		return type;
+	}
+
+	/**
+	 * Collect all songs of the given tree (excluding mounted
+	 * databases) in the order of Directory::Walk().
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	static void Collect(const Directory &directory,
+			    std::vector<const Song *> &dest);
+
+	/**
+	 * Fill this index with the given songs (obtained by
+	 * Collect()) and sort them.  This does not need to lock the
+	 * #db_mutex, but the caller must ensure that the songs are
+	 * not modified meanwhile.
+	 */
+	void Build(const std::vector<const Song *> &src);
+
+	void Clear() noexcept {
+		songs.clear();
+		songs.shrink_to_fit();
+	}
+
+	/**
+	 * Pass the songs inside the given directory which match the
+	 * #DatabaseSelection to the visitor, in the requested order
+	 * and only those inside the "window".  The selection's "sort"
+	 * attribute must be equal to GetType().
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @param protocol_cache see Song::Export()
+	 */
+	void Visit(const Directory &directory,
+		   const DatabaseSelection &selection,
+		   bool protocol_cache,
+		   const VisitSong &visit_song) const;
+
+private:
+	bool Less(const Song &a, const Song &b) const noexcept;
+
+	/**
+	 * Invoke the function for each song in the given order, until
+	 * it returns false.  With "descending", songs which compare
+	 * equal are still visited in ascending (walk) order, just
+	 * like std::stable_sort() does.
+	 */
+	template<typename F>
+	void ForEach(bool descending, F &&f) const;
+};
+
+#endif
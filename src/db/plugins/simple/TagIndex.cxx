@@ -0,0 +1,138 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "TagIndex.hxx"
+#include "Song.hxx"
+#include "song/Filter.hxx"
+#include "song/TagSongFilter.hxx"
+#include "tag/Fallback.hxx"
+#include "tag/Settings.hxx"
+
+#include <algorithm>
+
+void
+TagIndex::Build(const std::vector<const Song *> &src)
+{
+	Clear();
+
+	if (!IsEnabled())
+		return;
+
+	for (unsigned position = 0; position < src.size(); ++position) {
+		for (const auto &item : src[position]->tag) {
+			if (!mask.Test(item.type))
+				continue;
+
+			auto &list = maps[item.type][item.value];
+
+			/* a song may have the same value more than
+			   once */
+			if (list.empty() || list.back() != position)
+				list.push_back(position);
+		}
+	}
+}
+
+void
+TagIndex::Clear() noexcept
+{
+	for (auto &map : maps)
+		Map().swap(map);
+}
+
+TagMask
+GetFilterTagMask(TagType type) noexcept
+{
+	if (type == TAG_NUM_OF_ITEM_TYPES)
+		/* "any" examines all tags which may appear in a
+		   song */
+		return global_tag_mask;
+
+	TagMask types = TagMask::None();
+	ApplyTagWithFallback(type, [&types](TagType t){
+		types.Set(t);
+		return false;
+	});
+
+	return types;
+}
+
+bool
+TagIndex::Lookup(TagType type, std::string_view value,
+		 std::vector<unsigned> &candidates) const
+{
+	const auto types = GetFilterTagMask(type);
+	if ((types & ~mask).TestAny())
+		return false;
+
+	std::size_t n_lists = 0;
+
+	for (unsigned t = 0; t < TAG_NUM_OF_ITEM_TYPES; ++t) {
+		if (!types.Test(TagType(t)))
+			continue;
+
+		const auto &map = maps[t];
+		auto i = map.find(value);
+		if (i != map.end()) {
+			candidates.insert(candidates.end(),
+					  i->second.begin(), i->second.end());
+			++n_lists;
+		}
+	}
+
+	if (n_lists > 1) {
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(),
+					     candidates.end()),
+				 candidates.end());
+	}
+
+	return true;
+}
+
+bool
+TagIndex::Lookup(const SongFilter &filter,
+		 std::vector<unsigned> &candidates) const
+{
+	if (!IsEnabled())
+		return false;
+
+	bool found = false;
+
+	for (const auto &i : filter.GetItems()) {
+		const auto *f = dynamic_cast<const TagSongFilter *>(i.get());
+		if (f == nullptr || f->IsNegated() || !f->IsExact() ||
+		    /* an empty value also matches songs which don't
+		       have this tag at all */
+		    f->GetValue().empty())
+			continue;
+
+		std::vector<unsigned> tmp;
+		if (!Lookup(f->GetTagType(), f->GetValue(), tmp))
+			continue;
+
+		/* use the most selective item */
+		if (!found || tmp.size() < candidates.size()) {
+			candidates = std::move(tmp);
+			found = true;
+		}
+	}
+
+	return found;
+}
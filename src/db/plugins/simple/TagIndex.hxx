@@ -0,0 +1,112 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_TAG_INDEX_HXX
+#define MPD_TAG_INDEX_HXX
+
+#include "tag/Mask.hxx"
+#include "util/Compiler.h"
+
+#include <array>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct Song;
+class SongFilter;
+
+/**
+ * Determine which tag types a #TagSongFilter for the given #TagType
+ * may examine, including fallback tags.  #TAG_NUM_OF_ITEM_TYPES
+ * ("any") returns all enabled tags.
+ */
+gcc_pure
+TagMask
+GetFilterTagMask(TagType type) noexcept;
+
+/**
+ * An inverted index which maps tag values to the songs which have
+ * them.  It allows SimpleDatabase::Visit() to evaluate filters with
+ * an exact tag match (e.g. "(Artist == \"X\")") without walking the
+ * whole directory tree.
+ *
+ * Songs are referred to by their position in the list passed to
+ * Build() (which is in the order of Directory::Walk()), so results
+ * can be passed to the visitor in the same order a walk would
+ * produce.
+ */
+class TagIndex {
+	/**
+	 * The tag types which are indexed.
+	 */
+	const TagMask mask;
+
+	/**
+	 * The keys point into the #TagItem instances owned by the
+	 * songs; the values are sorted song positions.
+	 */
+	using Map = std::unordered_map<std::string_view,
+				       std::vector<unsigned>>;
+
+	std::array<Map, TAG_NUM_OF_ITEM_TYPES> maps;
+
+public:
+	explicit TagIndex(TagMask _mask) noexcept
+		:mask(_mask) {}
+
+	bool IsEnabled() const noexcept {
+		return mask.TestAny();
+	}
+
+	/**
+	 * Fill this index with the given songs (obtained by
+	 * SortIndex::Collect()).  The list is not copied; callers
+	 * must keep it to resolve song positions.  This does not need to lock the
+	 * #db_mutex, but the caller must ensure that the songs are
+	 * not modified meanwhile.
+	 */
+	void Build(const std::vector<const Song *> &src);
+
+	void Clear() noexcept;
+
+	/**
+	 * Determine which songs may match the given filter.  The
+	 * result is a superset; the filter must still be applied to
+	 * each candidate.
+	 *
+	 * @param candidates receives a sorted list of positions
+	 * @return false if this index cannot be used for the filter
+	 */
+	bool Lookup(const SongFilter &filter,
+		    std::vector<unsigned> &candidates) const;
+
+private:
+	/**
+	 * Collect the candidates for an exact match of the given tag
+	 * type (or any tag type if it is #TAG_NUM_OF_ITEM_TYPES),
+	 * including fallback tags.
+	 *
+	 * @return false if not all of the required tag types are
+	 * indexed
+	 */
+	bool Lookup(TagType type, std::string_view value,
+		    std::vector<unsigned> &candidates) const;
+};
+
+#endif
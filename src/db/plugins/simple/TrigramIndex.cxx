@@ -0,0 +1,202 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "TrigramIndex.hxx"
+#include "TagIndex.hxx"
+#include "Song.hxx"
+#include "song/Filter.hxx"
+#include "song/TagSongFilter.hxx"
+#include "lib/icu/CaseFold.hxx"
+#include "util/AllocatedString.hxx"
+#include "util/CharUtil.hxx"
+
+#include <algorithm>
+#include <string>
+
+/**
+ * Fold the case of a string exactly like IcuCompare does, because
+ * the index must contain the trigrams of the strings which
+ * IcuCompare::IsIn() searches.
+ */
+static std::string
+FoldCase(const char *s) noexcept
+{
+#ifdef HAVE_ICU_CASE_FOLD
+	return IcuCaseFold(s).c_str();
+#else
+	/* IcuCompare uses strcasestr() or strncasecmp(), which fold
+	   only ASCII characters */
+	std::string result(s);
+	for (auto &ch : result)
+		ch = ToLowerASCII(ch);
+	return result;
+#endif
+}
+
+static constexpr uint_least32_t
+MakeTrigram(const char *p) noexcept
+{
+	return (uint_least32_t(uint8_t(p[0])) << 16) |
+		(uint_least32_t(uint8_t(p[1])) << 8) |
+		uint_least32_t(uint8_t(p[2]));
+}
+
+/**
+ * Append all trigrams of the given string to the vector (may contain
+ * duplicates).
+ */
+static void
+AddTrigrams(const std::string &s, std::vector<uint_least32_t> &dest)
+{
+	for (std::size_t i = 0; i + 3 <= s.length(); ++i)
+		dest.push_back(MakeTrigram(s.data() + i));
+}
+
+static void
+SortUnique(std::vector<uint_least32_t> &v) noexcept
+{
+	std::sort(v.begin(), v.end());
+	v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+void
+TrigramIndex::Build(const std::vector<const Song *> &src)
+{
+	Clear();
+
+	if (!IsEnabled())
+		return;
+
+	/* the tag pool shares identical items among songs, so
+	   folding each item only once saves a lot of ICU calls */
+	std::unordered_map<const TagItem *,
+			   std::vector<uint_least32_t>> item_cache;
+
+	std::vector<uint_least32_t> trigrams;
+
+	for (unsigned position = 0; position < src.size(); ++position) {
+		trigrams.clear();
+
+		for (const auto &item : src[position]->tag) {
+			if (!mask.Test(item.type))
+				continue;
+
+			auto i = item_cache.emplace(&item,
+						    std::vector<uint_least32_t>());
+			if (i.second) {
+				AddTrigrams(FoldCase(item.value),
+					    i.first->second);
+				SortUnique(i.first->second);
+			}
+
+			trigrams.insert(trigrams.end(),
+					i.first->second.begin(),
+					i.first->second.end());
+		}
+
+		SortUnique(trigrams);
+
+		for (const auto t : trigrams)
+			map[t].push_back(position);
+	}
+
+	for (auto &i : map)
+		i.second.shrink_to_fit();
+}
+
+bool
+TrigramIndex::Lookup(const char *needle,
+		     std::vector<unsigned> &candidates) const
+{
+	std::vector<uint_least32_t> trigrams;
+	AddTrigrams(FoldCase(needle), trigrams);
+	if (trigrams.empty())
+		/* too short */
+		return false;
+
+	SortUnique(trigrams);
+
+	/* collect the posting lists, and intersect them starting
+	   with the shortest one */
+	std::vector<const std::vector<unsigned> *> lists;
+	lists.reserve(trigrams.size());
+
+	for (const auto t : trigrams) {
+		auto i = map.find(t);
+		if (i == map.end()) {
+			/* no song contains this trigram */
+			candidates.clear();
+			return true;
+		}
+
+		lists.push_back(&i->second);
+	}
+
+	std::sort(lists.begin(), lists.end(), [](const auto *a, const auto *b){
+		return a->size() < b->size();
+	});
+
+	candidates = *lists.front();
+
+	std::vector<unsigned> tmp;
+	for (auto i = std::next(lists.begin());
+	     i != lists.end() && !candidates.empty(); ++i) {
+		tmp.clear();
+		std::set_intersection(candidates.begin(), candidates.end(),
+				      (*i)->begin(), (*i)->end(),
+				      std::back_inserter(tmp));
+		candidates.swap(tmp);
+	}
+
+	return true;
+}
+
+bool
+TrigramIndex::Lookup(const SongFilter &filter,
+		     std::vector<unsigned> &candidates) const
+{
+	if (!IsEnabled())
+		return false;
+
+	bool found = false;
+
+	for (const auto &i : filter.GetItems()) {
+		/* only case-insensitive filters are supported,
+		   because the index contains only folded strings */
+		const auto *f = dynamic_cast<const TagSongFilter *>(i.get());
+		if (f == nullptr || f->IsNegated() || f->IsRegex() ||
+		    !f->GetFoldCase())
+			continue;
+
+		if ((GetFilterTagMask(f->GetTagType()) & ~mask).TestAny())
+			continue;
+
+		std::vector<unsigned> tmp;
+		if (!Lookup(f->GetValue().c_str(), tmp))
+			continue;
+
+		/* use the most selective item */
+		if (!found || tmp.size() < candidates.size()) {
+			candidates = std::move(tmp);
+			found = true;
+		}
+	}
+
+	return found;
+}
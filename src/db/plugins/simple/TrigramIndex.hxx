@@ -0,0 +1,93 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_TRIGRAM_INDEX_HXX
+#define MPD_TRIGRAM_INDEX_HXX
+
+#include "tag/Mask.hxx"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct Song;
+class SongFilter;
+
+/**
+ * An index which maps each sequence of three bytes ("trigram") of
+ * the case-folded tag values to the songs containing it.  It allows
+ * SimpleDatabase::Visit() to evaluate case-insensitive substring
+ * filters (e.g. the "search" command) by examining only the songs
+ * which contain all trigrams of the search string.
+ *
+ * The trigrams of all indexed tags of a song are merged, so lookups
+ * yield a superset of the matching songs; the filter must still be
+ * applied to each candidate.
+ *
+ * Songs are referred to by their position in the list passed to
+ * Build(), just like #TagIndex does.
+ */
+class TrigramIndex {
+	/**
+	 * The tag types which are indexed.
+	 */
+	const TagMask mask;
+
+	/**
+	 * Maps a trigram to a sorted list of song positions.
+	 */
+	std::unordered_map<uint_least32_t, std::vector<unsigned>> map;
+
+public:
+	explicit TrigramIndex(TagMask _mask) noexcept
+		:mask(_mask) {}
+
+	bool IsEnabled() const noexcept {
+		return mask.TestAny();
+	}
+
+	/**
+	 * Fill this index with the given songs (obtained by
+	 * SortIndex::Collect()).  This does not need to lock the
+	 * #db_mutex, but the caller must ensure that the songs are
+	 * not modified meanwhile.
+	 */
+	void Build(const std::vector<const Song *> &src);
+
+	void Clear() noexcept {
+		decltype(map)().swap(map);
+	}
+
+	/**
+	 * Determine which songs may match the given filter.  The
+	 * result is a superset; the filter must still be applied to
+	 * each candidate.
+	 *
+	 * @param candidates receives a sorted list of positions
+	 * @return false if this index cannot be used for the filter
+	 */
+	bool Lookup(const SongFilter &filter,
+		    std::vector<unsigned> &candidates) const;
+
+private:
+	bool Lookup(const char *needle,
+		    std::vector<unsigned> &candidates) const;
+};
+
+#endif
@@ -92,6 +92,10 @@ UpdateWalk::UpdateArchiveTree(ArchiveFile &archive, Directory &directory,
 					    "deleting unrecognized file %s/%s",
 					    directory.GetPath(), name);
 				editor.LockDeleteSong(directory, song);
+			} else {
+				const ScopeDatabaseLock protect;
+				song->InvalidateProtocolCache();
+				directory.MarkModified();
 			}
 		}
 	}
@@ -31,7 +31,8 @@ UpdateConfig::UpdateConfig(const ConfigData &config)
 	follow_outside_symlinks =
 		config.GetBool(ConfigOption::FOLLOW_OUTSIDE_SYMLINKS,
 			       DEFAULT_FOLLOW_OUTSIDE_SYMLINKS);
-#else
-	(void)config;
 #endif
+
+	scan_threads = config.GetPositive(ConfigOption::UPDATE_THREADS,
+					  DEFAULT_SCAN_THREADS);
 }
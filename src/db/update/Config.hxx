@@ -31,6 +31,14 @@ struct UpdateConfig {
 	bool follow_outside_symlinks = DEFAULT_FOLLOW_OUTSIDE_SYMLINKS;
 #endif
 
+	static constexpr unsigned DEFAULT_SCAN_THREADS = 1;
+
+	/**
+	 * The number of threads which scan song tags in parallel.  If
+	 * this is 1, the update thread scans all files by itself.
+	 */
+	unsigned scan_threads = DEFAULT_SCAN_THREADS;
+
 	explicit UpdateConfig(const ConfigData &config);
 };
 
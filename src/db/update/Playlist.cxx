@@ -70,9 +70,9 @@ UpdateWalk::UpdatePlaylistFile(Directory &parent, const char *name,
 
 			auto db_song = std::make_unique<Song>(std::move(*song),
 							      *directory);
-			db_song->target = "../" + db_song->filename;
-			db_song->filename = StringFormat<64>("track%04u",
-							     ++track);
+			db_song->SetTarget("../" + std::string(db_song->filename.c_str()));
+			db_song->SetFilename(StringFormat<64>("track%04u",
+							      ++track).c_str());
 
 			{
 				const ScopeDatabaseLock protect;
@@ -101,8 +101,10 @@ UpdateWalk::UpdatePlaylistFile(Directory &directory,
 	PlaylistInfo pi(name, info.mtime);
 
 	const ScopeDatabaseLock protect;
-	if (directory.playlists.UpdateOrInsert(std::move(pi)))
+	if (directory.playlists.UpdateOrInsert(std::move(pi))) {
+		directory.MarkModified();
 		modified = true;
+	}
 
 	return true;
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ScanPool.hxx"
+#include "db/plugins/simple/Song.hxx"
+
+void
+ScanJob::RunJob() noexcept
+{
+	try {
+		found = Song::ScanFile(pool.storage, uri.c_str(),
+				       tag_builder, audio_format, mtime);
+	} catch (...) {
+		error = std::current_exception();
+	}
+}
+
+void
+ScanJob::FinishJob() noexcept
+{
+	const std::lock_guard<Mutex> protect(pool.mutex);
+	pool.finished.splice(pool.finished.end(), pool.pending, iterator);
+	pool.cond.notify_all();
+}
+
+ScanPool::ScanPool(Storage &_storage, unsigned n_threads)
+	:storage(_storage), max_queued(n_threads * 4),
+	 workers("update_scan", n_threads)
+{
+}
+
+void
+ScanPool::Submit(Directory &directory, const char *name,
+		 std::string &&uri, Song *song)
+{
+	std::unique_lock<Mutex> lock(mutex);
+	cond.wait(lock, [this]{ return pending.size() < max_queued; });
+
+	/* std::list guarantees that the job's address remains
+	   stable while it is moved to the "finished" list */
+	auto &job = pending.emplace_back(*this, directory, name,
+					 std::move(uri), song);
+	job.iterator = std::prev(pending.end());
+	lock.unlock();
+
+	workers.Submit(job);
+}
+
+std::list<ScanJob>
+ScanPool::TakeFinished() noexcept
+{
+	std::list<ScanJob> result;
+
+	const std::lock_guard<Mutex> protect(mutex);
+	result.swap(finished);
+	return result;
+}
+
+std::list<ScanJob>
+ScanPool::Drain() noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+	cond.wait(lock, [this]{ return pending.empty(); });
+
+	std::list<ScanJob> result;
+	result.swap(finished);
+	return result;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_UPDATE_SCAN_POOL_HXX
+#define MPD_UPDATE_SCAN_POOL_HXX
+
+#include "tag/Builder.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "thread/WorkerPool.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <chrono>
+#include <exception>
+#include <list>
+#include <string>
+
+struct Directory;
+struct Song;
+class Storage;
+class ScanPool;
+
+/**
+ * A request to scan the tags of one song file.  It is filled by a
+ * #ScanPool worker thread and applied to the database by the update
+ * thread.
+ */
+struct ScanJob final : WorkerPool::Job {
+	ScanPool &pool;
+
+	/**
+	 * This job's position in ScanPool::pending or
+	 * ScanPool::finished.
+	 */
+	std::list<ScanJob>::iterator iterator;
+
+	Directory &directory;
+
+	const std::string name;
+
+	/**
+	 * The URI of the file relative to the storage root.
+	 */
+	const std::string uri;
+
+	/**
+	 * The existing song which is being updated, or nullptr if
+	 * this is a new song.
+	 */
+	Song *const song;
+
+	TagBuilder tag_builder;
+	AudioFormat audio_format = AudioFormat::Undefined();
+	std::chrono::system_clock::time_point mtime;
+
+	/**
+	 * Was the file recognized by a decoder plugin?
+	 */
+	bool found = false;
+
+	std::exception_ptr error;
+
+	ScanJob(ScanPool &_pool, Directory &_directory, const char *_name,
+		std::string &&_uri, Song *_song) noexcept
+		:pool(_pool), directory(_directory), name(_name),
+		 uri(std::move(_uri)), song(_song) {}
+
+private:
+	/* virtual methods from WorkerPool::Job */
+	void RunJob() noexcept override;
+	void FinishJob() noexcept override;
+};
+
+/**
+ * Runs Song::ScanFile() on #WorkerPool threads on behalf of the
+ * update thread.  The worker threads never touch the database; the
+ * update thread collects the finished #ScanJob instances and applies
+ * them while holding the #db_mutex.
+ */
+class ScanPool {
+	friend struct ScanJob;
+
+	Storage &storage;
+
+	/**
+	 * Submit() blocks while this many jobs are pending.
+	 */
+	const std::size_t max_queued;
+
+	Mutex mutex;
+	Cond cond;
+
+	/**
+	 * Jobs which have been submitted, but have not finished yet.
+	 */
+	std::list<ScanJob> pending;
+
+	/**
+	 * Jobs which are waiting to be collected by the update
+	 * thread.
+	 */
+	std::list<ScanJob> finished;
+
+	/**
+	 * Declared last, so it is destroyed (and its threads are
+	 * stopped) before the job lists.
+	 */
+	WorkerPool workers;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	ScanPool(Storage &_storage, unsigned n_threads);
+
+	ScanPool(const ScanPool &) = delete;
+	ScanPool &operator=(const ScanPool &) = delete;
+
+	/**
+	 * Enqueue a new job.  Blocks while the queue is full.
+	 */
+	void Submit(Directory &directory, const char *name,
+		    std::string &&uri, Song *song);
+
+	/**
+	 * Return all jobs which have finished so far, without
+	 * waiting.
+	 */
+	std::list<ScanJob> TakeFinished() noexcept;
+
+	/**
+	 * Wait for all submitted jobs to finish and return them.
+	 */
+	std::list<ScanJob> Drain() noexcept;
+};
+
+#endif
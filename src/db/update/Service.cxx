@@ -20,6 +20,7 @@
 #include "Service.hxx"
 #include "Walk.hxx"
 #include "UpdateDomain.hxx"
+#include "tag/Pool.hxx"
 #include "db/DatabaseListener.hxx"
 #include "db/DatabaseLock.hxx"
 #include "db/plugins/simple/SimpleDatabasePlugin.hxx"
@@ -120,8 +121,10 @@ UpdateService::Task() noexcept
 
 	SetThreadIdlePriority();
 
+	next.db->BeginUpdate();
 	modified = walk->Walk(next.db->GetRoot(), next.path_utf8.c_str(),
 			      next.discard);
+	next.db->EndUpdate(modified);
 
 	if (modified || !next.db->FileExists()) {
 		try {
@@ -138,6 +141,12 @@ UpdateService::Task() noexcept
 	else
 		LogDebug(update_domain, "finished");
 
+	const auto pool_stats = tag_pool_get_stats();
+	FormatDebug(update_domain,
+		    "tag pool: %zu items in %zu buckets, longest chain %zu",
+		    pool_stats.n_items, pool_stats.n_buckets,
+		    pool_stats.max_chain);
+
 	defer.Schedule();
 }
 
@@ -25,10 +25,80 @@
 #include "db/plugins/simple/Song.hxx"
 #include "decoder/DecoderList.hxx"
 #include "storage/FileInfo.hxx"
+#include "fs/Traits.hxx"
 #include "Log.hxx"
 
 #include <unistd.h>
 
+bool
+UpdateWalk::SubmitScanJob(Directory &directory, const char *name,
+			  Song *song)
+{
+	if (!scan_pool)
+		return false;
+
+	std::string uri = directory.IsRoot()
+		? std::string(name)
+		: PathTraitsUTF8::Build(directory.GetPath(), name);
+
+	scan_pool->Submit(directory, name, std::move(uri), song);
+
+	/* apply what has been finished meanwhile, to keep the
+	   number of pending results small */
+	ApplyScanJobs(scan_pool->TakeFinished());
+	return true;
+}
+
+void
+UpdateWalk::ApplyScanJob(ScanJob &job) noexcept
+{
+	Directory &directory = job.directory;
+	const char *name = job.name.c_str();
+
+	if (job.error) {
+		FormatError(job.error, "error reading file %s/%s",
+			    directory.GetPath(), name);
+		return;
+	}
+
+	if (job.song == nullptr) {
+		if (!job.found) {
+			FormatDebug(update_domain,
+				    "ignoring unrecognized file %s/%s",
+				    directory.GetPath(), name);
+			return;
+		}
+
+		auto new_song = std::make_unique<Song>(name, directory);
+		new_song->mtime = job.mtime;
+		new_song->audio_format = job.audio_format;
+
+		{
+			const ScopeDatabaseLock protect;
+			job.tag_builder.Commit(new_song->tag);
+			directory.AddSong(std::move(new_song));
+		}
+
+		modified = true;
+		FormatDefault(update_domain, "added %s/%s",
+			      directory.GetPath(), name);
+	} else {
+		if (!job.found) {
+			FormatDebug(update_domain,
+				    "deleting unrecognized file %s/%s",
+				    directory.GetPath(), name);
+			editor.LockDeleteSong(directory, job.song);
+		} else {
+			const ScopeDatabaseLock protect;
+			job.song->ApplyScan(job.mtime, job.audio_format,
+					    job.tag_builder);
+			directory.MarkModified();
+		}
+
+		modified = true;
+	}
+}
+
 inline void
 UpdateWalk::UpdateSongFile2(Directory &directory,
 			    const char *name, const char *suffix,
@@ -62,6 +132,9 @@ try {
 		FormatDebug(update_domain, "reading %s/%s",
 			    directory.GetPath(), name);
 
+		if (SubmitScanJob(directory, name, nullptr))
+			return;
+
 		auto new_song = Song::LoadFile(storage, name, directory);
 		if (!new_song) {
 			FormatDebug(update_domain,
@@ -81,11 +154,18 @@ try {
 	} else if (info.mtime != song->mtime || walk_discard) {
 		FormatDefault(update_domain, "updating %s/%s",
 			      directory.GetPath(), name);
+
+		if (SubmitScanJob(directory, name, song))
+			return;
+
 		if (!song->UpdateFile(storage)) {
 			FormatDebug(update_domain,
 				    "deleting unrecognized file %s/%s",
 				    directory.GetPath(), name);
 			editor.LockDeleteSong(directory, song);
+		} else {
+			const ScopeDatabaseLock protect;
+			directory.MarkModified();
 		}
 
 		modified = true;
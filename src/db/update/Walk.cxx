@@ -53,6 +53,15 @@ UpdateWalk::UpdateWalk(const UpdateConfig &_config,
 	 storage(_storage),
 	 editor(_loop, _listener)
 {
+	if (config.scan_threads > 1) {
+		try {
+			scan_pool = std::make_unique<ScanPool>(storage,
+							       config.scan_threads);
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to start the tag scanner threads");
+		}
+	}
 }
 
 static void
@@ -117,6 +126,7 @@ UpdateWalk::PurgeDeletedFromDirectory(Directory &directory) noexcept
 						i->name.c_str())) {
 			const ScopeDatabaseLock protect;
 			i = directory.playlists.erase(i);
+			directory.MarkModified();
 		} else
 			++i;
 	}
@@ -362,7 +372,13 @@ UpdateWalk::UpdateDirectory(Directory &directory,
 		UpdateDirectoryChild(directory, child_exclude_list, name_utf8, info2);
 	}
 
-	directory.mtime = info.mtime;
+	FlushScanPool();
+
+	if (directory.mtime != info.mtime) {
+		const ScopeDatabaseLock protect;
+		directory.mtime = info.mtime;
+		directory.MarkModified();
+	}
 
 	return true;
 }
@@ -486,5 +502,7 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard) noexcept
 		UpdateDirectory(root, exclude_list, info);
 	}
 
+	FlushScanPool();
+
 	return modified;
 }
@@ -22,10 +22,12 @@
 
 #include "Config.hxx"
 #include "Editor.hxx"
+#include "ScanPool.hxx"
 #include "util/Compiler.h"
 #include "config.h"
 
 #include <atomic>
+#include <memory>
 
 struct StorageFileInfo;
 struct Directory;
@@ -56,6 +58,12 @@ class UpdateWalk final {
 
 	DatabaseEditor editor;
 
+	/**
+	 * Scans song tags on worker threads; nullptr if
+	 * UpdateConfig::scan_threads is 1.
+	 */
+	std::unique_ptr<ScanPool> scan_pool;
+
 public:
 	UpdateWalk(const UpdateConfig &_config,
 		   EventLoop &_loop, DatabaseListener &_listener,
@@ -84,6 +92,32 @@ private:
 
 	void PurgeDeletedFromDirectory(Directory &directory) noexcept;
 
+	/**
+	 * Apply the result of a #ScanJob to the database.
+	 */
+	void ApplyScanJob(ScanJob &job) noexcept;
+
+	void ApplyScanJobs(std::list<ScanJob> &&jobs) noexcept {
+		for (auto &job : jobs)
+			ApplyScanJob(job);
+	}
+
+	/**
+	 * Wait for all pending #ScanJob instances and apply them.
+	 */
+	void FlushScanPool() noexcept {
+		if (scan_pool)
+			ApplyScanJobs(scan_pool->Drain());
+	}
+
+	/**
+	 * Scan the file on a #ScanPool thread.
+	 *
+	 * @return false if there is no #ScanPool
+	 */
+	bool SubmitScanJob(Directory &directory, const char *name,
+			   Song *song);
+
 	void UpdateSongFile2(Directory &directory,
 			     const char *name, const char *suffix,
 			     const StorageFileInfo &info) noexcept;
@@ -109,6 +109,30 @@ LockNeedChunks(DecoderControl &dc) noexcept
 	return NeedChunks(dc, lock);
 }
 
+/**
+ * The pipe has reached DecoderControl::pipe_limit; wait until the
+ * player lifts the limit or sends a command.
+ */
+static DecoderCommand
+LockWaitPipeLimit(DecoderControl &dc) noexcept
+{
+	if (dc.pipe_limit.load(std::memory_order_relaxed).IsZero())
+		/* fast path: not pre-decoding (this is always the
+		   case if the "predecode_time" setting is disabled),
+		   no need to lock */
+		return DecoderCommand::NONE;
+
+	std::unique_lock<Mutex> lock(dc.mutex);
+	while (dc.IsPipeFull()) {
+		if (dc.command != DecoderCommand::NONE)
+			return dc.command;
+
+		dc.Wait(lock);
+	}
+
+	return DecoderCommand::NONE;
+}
+
 MusicChunk *
 DecoderBridge::GetChunk() noexcept
 {
@@ -117,6 +141,9 @@ DecoderBridge::GetChunk() noexcept
 	if (current_chunk != nullptr)
 		return current_chunk.get();
 
+	if (LockWaitPipeLimit(dc) != DecoderCommand::NONE)
+		return nullptr;
+
 	do {
 		current_chunk = dc.buffer->Allocate();
 		if (current_chunk != nullptr) {
@@ -19,6 +19,7 @@
 
 #include "Control.hxx"
 #include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
 #include "song/DetachedSong.hxx"
 
 #include <cassert>
@@ -76,6 +77,22 @@ DecoderControl::IsCurrentSong(const DetachedSong &_song) const noexcept
 	gcc_unreachable();
 }
 
+bool
+DecoderControl::IsPipeFull() const noexcept
+{
+	const SongTime limit = pipe_limit.load(std::memory_order_relaxed);
+	if (limit.IsZero() || state != DecoderState::DECODE)
+		return false;
+
+	const unsigned size = pipe->GetSize();
+
+	/* never occupy more than half of the buffer, or else the
+	   decoder of the current song may starve */
+	return size >= buffer->GetSize() / 2 ||
+		size * buffer->GetChunkCapacity() >=
+		out_audio_format.TimeToSize(limit);
+}
+
 void
 DecoderControl::Start(std::unique_lock<Mutex> &lock,
 		      std::unique_ptr<DetachedSong> _song,
@@ -110,6 +127,17 @@ DecoderControl::Stop(std::unique_lock<Mutex> &lock) noexcept
 		SynchronousCommandLocked(lock, DecoderCommand::STOP);
 }
 
+void
+DecoderControl::StopAndDiscard(std::unique_lock<Mutex> &lock) noexcept
+{
+	Stop(lock);
+
+	if (pipe != nullptr) {
+		pipe->Clear();
+		pipe.reset();
+	}
+}
+
 void
 DecoderControl::Seek(std::unique_lock<Mutex> &lock, SongTime t)
 {
@@ -31,6 +31,7 @@
 #include "ReplayGainConfig.hxx"
 #include "ReplayGainMode.hxx"
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <exception>
@@ -161,6 +162,19 @@ public:
 	 */
 	std::shared_ptr<MusicPipe> pipe;
 
+	/**
+	 * If positive, then the decoder pauses as soon as the #pipe
+	 * holds this much audio, until the caller resets it to zero.
+	 * This is used to decode only the beginning of a song in
+	 * advance.
+	 *
+	 * This attribute is protected by #mutex, but the decoder
+	 * thread may read it without locking to skip the limit check
+	 * quickly if it is zero; a non-zero value is only ever set
+	 * before the decoder is started.
+	 */
+	std::atomic<SongTime> pipe_limit{SongTime::zero()};
+
 	const ReplayGainConfig replay_gain_config;
 	ReplayGainMode replay_gain_mode = ReplayGainMode::OFF;
 
@@ -314,6 +328,14 @@ public:
 		return seekable && IsCurrentSong(_song);
 	}
 
+	/**
+	 * Has the #pipe reached the #pipe_limit?
+	 *
+	 * Caller must lock the object.
+	 */
+	gcc_pure
+	bool IsPipeFull() const noexcept;
+
 private:
 	/**
 	 * Wait for the command to be finished by the decoder thread.
@@ -397,6 +419,15 @@ public:
 	 */
 	void Stop(std::unique_lock<Mutex> &lock) noexcept;
 
+	/**
+	 * Stop the decoder (if it is running), return all chunks in
+	 * the #pipe to the #MusicBuffer and release the #pipe.  This
+	 * is used to discard the result of pre-decoding.
+	 *
+	 * Caller must lock the object.
+	 */
+	void StopAndDiscard(std::unique_lock<Mutex> &lock) noexcept;
+
 	/**
 	 * Throws #std::runtime_error on error.
 	 *
@@ -428,6 +459,18 @@ public:
 	 */
 	void CycleMixRamp() noexcept;
 
+	/**
+	 * Copy the MixRamp and ReplayGain information of the song
+	 * decoded by another #DecoderControl, so the next Start()
+	 * treats it as the previous song.
+	 *
+	 * Caller must lock the object.
+	 */
+	void InheritPreviousSong(const DecoderControl &other) noexcept {
+		mix_ramp = other.mix_ramp;
+		replay_gain_db = other.replay_gain_db;
+	}
+
 private:
 	void RunThread() noexcept;
 
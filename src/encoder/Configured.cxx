@@ -20,10 +20,13 @@
 #include "Configured.hxx"
 #include "EncoderList.hxx"
 #include "EncoderPlugin.hxx"
+#include "SharedEncoder.hxx"
 #include "config/Block.hxx"
 #include "util/StringAPI.hxx"
 #include "util/RuntimeError.hxx"
 
+#include <memory>
+
 static const EncoderPlugin &
 GetConfiguredEncoderPlugin(const ConfigBlock &block, bool shout_legacy)
 {
@@ -51,6 +54,13 @@ GetConfiguredEncoderPlugin(const ConfigBlock &block, bool shout_legacy)
 PreparedEncoder *
 CreateConfiguredEncoder(const ConfigBlock &block, bool shout_legacy)
 {
-	return encoder_init(GetConfiguredEncoderPlugin(block, shout_legacy),
-			    block);
+	const auto &plugin = GetConfiguredEncoderPlugin(block, shout_legacy);
+	std::unique_ptr<PreparedEncoder> prepared(encoder_init(plugin, block));
+
+	const char *shared = block.GetBlockValue("shared_encoder");
+	if (shared != nullptr)
+		return new SharedPreparedEncoder(shared, plugin,
+						 std::move(prepared));
+
+	return prepared.release();
 }
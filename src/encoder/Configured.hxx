@@ -26,7 +26,8 @@ class PreparedEncoder;
 /**
  * Create a #PreparedEncoder instance from the settings in the
  * #ConfigBlock.  Its "encoder" setting is used to choose the encoder
- * plugin.
+ * plugin.  If the "shared_encoder" setting is present, the encoder
+ * is wrapped in a #SharedPreparedEncoder.
  *
  * Throws an exception on error.
  *
@@ -0,0 +1,571 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SharedEncoder.hxx"
+#include "EncoderPlugin.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "thread/Mutex.hxx"
+#include "util/AllocatedArray.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/RuntimeError.hxx"
+
+#include <boost/intrusive/list.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+#include <string.h>
+
+/**
+ * Encoded pages which are older than this are discarded, even if an
+ * output has not read them yet; that output skips to the current
+ * position.
+ */
+static constexpr std::chrono::seconds max_lag_duration(60);
+
+class SharedEncoderGroup;
+
+/**
+ * The #Encoder implementation returned by
+ * SharedPreparedEncoder::Open().  It has its own input position, and
+ * reads the shared encoder's output from there.
+ */
+class SharedEncoder final
+	: public Encoder,
+	  public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
+
+	friend class SharedEncoderGroup;
+
+	SharedEncoderGroup &group;
+
+	/**
+	 * The number of PCM bytes passed to Write().
+	 */
+	uint64_t position;
+
+	/**
+	 * The number of tags passed to SendTag().
+	 */
+	unsigned tag_serial;
+
+	/**
+	 * The absolute index of the next page to be read, and the
+	 * number of bytes of it which have already been read.
+	 */
+	uint64_t next_page;
+	size_t page_offset;
+
+	/**
+	 * The stream header which Read() returns before the first
+	 * page.
+	 */
+	std::string header;
+	size_t header_offset;
+
+	/**
+	 * Set by SharedEncoderGroup::Trim() if pages were discarded
+	 * before this object has read them.
+	 */
+	bool lost;
+
+public:
+	/**
+	 * Caller must hold the mutex of the #SharedEncoderGroup
+	 * registry.
+	 */
+	SharedEncoder(SharedEncoderGroup &_group, bool implements_tag) noexcept;
+	~SharedEncoder() noexcept override;
+
+	/* virtual methods from class Encoder */
+	void End() override;
+	void Flush() override;
+	void PreTag() override;
+	void SendTag(const Tag &tag) override;
+	void Write(const void *data, size_t length) override;
+	size_t Read(void *dest, size_t length) override;
+
+private:
+	/**
+	 * Continue at the group's current position, like a new
+	 * subscriber.
+	 *
+	 * Caller must lock the group's mutex.
+	 */
+	void Resync() noexcept;
+
+	/**
+	 * Is this object at the group's current position, i.e. does
+	 * it control the encoder?
+	 *
+	 * Caller must lock the group's mutex.
+	 */
+	bool IsLeading() const noexcept;
+};
+
+/**
+ * One encoder instance shared by all #SharedEncoder objects with the
+ * same name and input audio format.
+ */
+class SharedEncoderGroup final
+	: public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
+
+	friend class SharedEncoder;
+
+	struct Page {
+		/**
+		 * The input position (in PCM bytes) at which the
+		 * encoder emitted this page.
+		 */
+		uint64_t position;
+
+		/**
+		 * The number of tags sent to the encoder before this
+		 * page.
+		 */
+		unsigned tag_serial;
+
+		AllocatedArray<uint8_t> data;
+
+		Page(uint64_t _position, unsigned _tag_serial,
+		     ConstBuffer<uint8_t> _data) noexcept
+			:position(_position), tag_serial(_tag_serial),
+			 data(_data) {}
+	};
+
+public:
+	const std::string name;
+
+	/**
+	 * The plugin of the #PreparedEncoder which created
+	 * #encoder.
+	 */
+	const EncoderPlugin &plugin;
+
+	/**
+	 * The MIME type of the #PreparedEncoder which created
+	 * #encoder (empty if it has none).
+	 */
+	const std::string mime_type;
+
+	/**
+	 * The audio format passed to SharedPreparedEncoder::Open().
+	 */
+	const AudioFormat in_audio_format;
+
+	/**
+	 * The audio format chosen by the encoder.
+	 */
+	AudioFormat out_audio_format;
+
+private:
+	/**
+	 * Protects everything below, including the #SharedEncoder
+	 * attributes.
+	 */
+	Mutex mutex;
+
+	const std::unique_ptr<Encoder> encoder;
+
+	boost::intrusive::list<SharedEncoder,
+			       boost::intrusive::constant_time_size<true>> subscribers;
+
+	/**
+	 * The number of PCM bytes passed to the encoder.
+	 */
+	uint64_t position = 0;
+
+	/**
+	 * The number of tags passed to the encoder.
+	 */
+	unsigned tag_serial = 0;
+
+	/**
+	 * Pages which are this many PCM bytes behind #position are
+	 * discarded.
+	 */
+	const uint64_t max_lag;
+
+	/**
+	 * Encoded data which has not yet been read by all
+	 * subscribers.
+	 */
+	std::deque<Page> pages;
+
+	/**
+	 * The absolute index of pages.front().
+	 */
+	uint64_t first_page = 0;
+
+	/**
+	 * The encoder output after Open() or after the most recent
+	 * SendTag().  A new subscriber reads this first.
+	 */
+	std::string header;
+
+	/**
+	 * Append encoder output to #header?  This is set by
+	 * SendTag() and cleared by the next Write().
+	 */
+	bool collecting_header = true;
+
+	/**
+	 * Has End() been called?  No more data may be written, and
+	 * SharedPreparedEncoder::Open() creates a new group.
+	 */
+	bool ended = false;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	SharedEncoderGroup(const char *_name, AudioFormat _audio_format,
+			   const EncoderPlugin &_plugin,
+			   PreparedEncoder &prepared);
+
+	~SharedEncoderGroup() noexcept {
+		assert(subscribers.empty());
+	}
+
+	bool IsEnded() const noexcept {
+		return ended;
+	}
+
+	bool ImplementsTag() const noexcept {
+		return encoder->ImplementsTag();
+	}
+
+	bool IsUnused() const noexcept {
+		return subscribers.empty();
+	}
+
+private:
+	/**
+	 * Move all pending encoder output to #pages.
+	 */
+	void Drain();
+
+	/**
+	 * Discard pages which are not needed anymore or which are
+	 * too old.
+	 */
+	void Trim() noexcept;
+};
+
+/**
+ * Protects #shared_encoder_groups.
+ */
+static Mutex shared_encoder_mutex;
+
+static boost::intrusive::list<SharedEncoderGroup> shared_encoder_groups;
+
+static constexpr const char *
+NullableString(const char *s) noexcept
+{
+	return s != nullptr ? s : "";
+}
+
+SharedEncoderGroup::SharedEncoderGroup(const char *_name,
+				       AudioFormat _audio_format,
+				       const EncoderPlugin &_plugin,
+				       PreparedEncoder &prepared)
+	:name(_name), plugin(_plugin),
+	 mime_type(NullableString(prepared.GetMimeType())),
+	 in_audio_format(_audio_format),
+	 out_audio_format(_audio_format),
+	 encoder(prepared.Open(out_audio_format)),
+	 max_lag(out_audio_format.TimeToSize(max_lag_duration))
+{
+	Drain();
+}
+
+void
+SharedEncoderGroup::Drain()
+{
+	while (true) {
+		uint8_t buffer[32768];
+		size_t nbytes = encoder->Read(buffer, sizeof(buffer));
+		if (nbytes == 0)
+			break;
+
+		if (collecting_header)
+			header.append((const char *)buffer, nbytes);
+
+		pages.emplace_back(position, tag_serial,
+				   ConstBuffer<uint8_t>(buffer, nbytes));
+	}
+
+	Trim();
+}
+
+void
+SharedEncoderGroup::Trim() noexcept
+{
+	while (!pages.empty()) {
+		const bool expired = pages.front().position + max_lag < position;
+
+		bool needed = false;
+		for (auto &s : subscribers) {
+			if (s.lost || s.next_page != first_page)
+				continue;
+
+			if (expired)
+				s.lost = true;
+			else
+				needed = true;
+		}
+
+		if (needed)
+			break;
+
+		pages.pop_front();
+		++first_page;
+	}
+}
+
+SharedEncoder::SharedEncoder(SharedEncoderGroup &_group,
+			     bool _implements_tag) noexcept
+	:Encoder(_implements_tag), group(_group)
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+	group.subscribers.push_back(*this);
+	Resync();
+}
+
+SharedEncoder::~SharedEncoder() noexcept
+{
+	const std::lock_guard<Mutex> lock(shared_encoder_mutex);
+
+	{
+		const std::lock_guard<Mutex> protect(group.mutex);
+		group.subscribers.erase(group.subscribers.iterator_to(*this));
+		group.Trim();
+	}
+
+	if (group.IsUnused()) {
+		shared_encoder_groups.erase(shared_encoder_groups.iterator_to(group));
+		delete &group;
+	}
+}
+
+inline bool
+SharedEncoder::IsLeading() const noexcept
+{
+	return !lost && position >= group.position &&
+		tag_serial == group.tag_serial;
+}
+
+void
+SharedEncoder::Resync() noexcept
+{
+	position = group.position;
+	tag_serial = group.tag_serial;
+	next_page = group.first_page + group.pages.size();
+	page_offset = 0;
+	header = group.header;
+	header_offset = 0;
+	lost = false;
+}
+
+void
+SharedEncoder::End()
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (!IsLeading())
+		return;
+
+	if (group.subscribers.size() == 1) {
+		/* we're alone; end the stream */
+		group.encoder->End();
+		group.ended = true;
+	} else
+		/* other outputs still need the encoder; just make
+		   everything available */
+		group.encoder->Flush();
+
+	group.Drain();
+}
+
+void
+SharedEncoder::Flush()
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (!IsLeading())
+		/* the leading output decides when to flush */
+		return;
+
+	group.encoder->Flush();
+	group.Drain();
+}
+
+void
+SharedEncoder::PreTag()
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (!IsLeading())
+		/* another output has already sent this tag */
+		return;
+
+	group.encoder->PreTag();
+	group.Drain();
+}
+
+void
+SharedEncoder::SendTag(const Tag &tag)
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (lost)
+		Resync();
+
+	if (tag_serial < group.tag_serial) {
+		/* another output has already sent this tag */
+		++tag_serial;
+		return;
+	}
+
+	if (position < group.position)
+		/* the leading output has not sent this tag at this
+		   position; ignore it */
+		return;
+
+	/* the first page after the tag begins a new stream; it is
+	   the header for new subscribers */
+	group.header.clear();
+	group.collecting_header = true;
+
+	group.encoder->SendTag(tag);
+	++group.tag_serial;
+	++tag_serial;
+
+	group.Drain();
+}
+
+void
+SharedEncoder::Write(const void *data, size_t length)
+{
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (lost)
+		Resync();
+
+	const uint64_t end = position + length;
+
+	if (end > group.position && !group.ended &&
+	    tag_serial == group.tag_serial) {
+		/* this output is ahead of all others: feed the part
+		   which has not been encoded yet into the encoder */
+
+		const size_t skip = position < group.position
+			? size_t(group.position - position)
+			: 0;
+
+		if (group.collecting_header) {
+			group.Drain();
+			group.collecting_header = false;
+		}
+
+		group.encoder->Write((const uint8_t *)data + skip,
+				     length - skip);
+		group.position = end;
+		group.Drain();
+	}
+
+	position = end;
+}
+
+size_t
+SharedEncoder::Read(void *_dest, size_t length)
+{
+	auto *dest = (uint8_t *)_dest;
+
+	const std::lock_guard<Mutex> protect(group.mutex);
+
+	if (lost)
+		Resync();
+
+	size_t nbytes = 0;
+
+	if (header_offset < header.size()) {
+		nbytes = std::min(length, header.size() - header_offset);
+		memcpy(dest, header.data() + header_offset, nbytes);
+		header_offset += nbytes;
+	}
+
+	while (nbytes < length &&
+	       next_page < group.first_page + group.pages.size()) {
+		const auto &page = group.pages[next_page - group.first_page];
+		if (page.position > position || page.tag_serial > tag_serial)
+			/* our input has not yet reached this page */
+			break;
+
+		const size_t n = std::min(length - nbytes,
+					  page.data.size() - page_offset);
+		memcpy(dest + nbytes, page.data.begin() + page_offset, n);
+		nbytes += n;
+		page_offset += n;
+
+		if (page_offset == page.data.size()) {
+			++next_page;
+			page_offset = 0;
+		}
+	}
+
+	group.Trim();
+	return nbytes;
+}
+
+Encoder *
+SharedPreparedEncoder::Open(AudioFormat &audio_format)
+{
+	const std::lock_guard<Mutex> lock(shared_encoder_mutex);
+
+	for (auto &group : shared_encoder_groups) {
+		if (group.name != name || group.IsEnded())
+			continue;
+
+		if (&group.plugin != &plugin)
+			throw FormatRuntimeError("Shared encoder \"%s\" is already used with encoder plugin \"%s\", not \"%s\"",
+						 name.c_str(),
+						 group.plugin.name,
+						 plugin.name);
+
+		if (group.mime_type != NullableString(prepared->GetMimeType()))
+			throw FormatRuntimeError("Shared encoder \"%s\" is already used with MIME type \"%s\"",
+						 name.c_str(),
+						 group.mime_type.c_str());
+
+		if (group.in_audio_format == audio_format) {
+			audio_format = group.out_audio_format;
+			return new SharedEncoder(group, group.ImplementsTag());
+		}
+	}
+
+	auto *group = new SharedEncoderGroup(name.c_str(), audio_format,
+					     plugin, *prepared);
+	shared_encoder_groups.push_back(*group);
+
+	audio_format = group->out_audio_format;
+	return new SharedEncoder(*group, group->ImplementsTag());
+}
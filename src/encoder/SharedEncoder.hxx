@@ -0,0 +1,64 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SHARED_ENCODER_HXX
+#define MPD_SHARED_ENCODER_HXX
+
+#include "EncoderInterface.hxx"
+
+#include <memory>
+#include <string>
+
+struct EncoderPlugin;
+
+/**
+ * A #PreparedEncoder which lets all audio outputs with the same
+ * "shared_encoder" name and the same input #AudioFormat use one
+ * #Encoder instance.  The output whose input is ahead of the others
+ * feeds the encoder; the encoded data is kept and returned to each
+ * of the other outputs as soon as its own input reaches the same
+ * position.
+ *
+ * The outputs are expected to receive the same PCM data; the
+ * encoder configuration of the output which opens the shared
+ * encoder first is used.  Opening a shared encoder with a different
+ * encoder plugin or MIME type than the one in use fails.
+ */
+class SharedPreparedEncoder final : public PreparedEncoder {
+	const std::string name;
+
+	const EncoderPlugin &plugin;
+
+	const std::unique_ptr<PreparedEncoder> prepared;
+
+public:
+	SharedPreparedEncoder(const char *_name, const EncoderPlugin &_plugin,
+			      std::unique_ptr<PreparedEncoder> _prepared) noexcept
+		:name(_name), plugin(_plugin),
+		 prepared(std::move(_prepared)) {}
+
+	/* virtual methods from class PreparedEncoder */
+	Encoder *Open(AudioFormat &audio_format) override;
+
+	const char *GetMimeType() const noexcept override {
+		return prepared->GetMimeType();
+	}
+};
+
+#endif
@@ -67,6 +67,7 @@ FullyBufferedSocket::Flush() noexcept
 	if (output.empty()) {
 		IdleMonitor::Cancel();
 		CancelWrite();
+		OnSocketDrained();
 	}
 
 	return true;
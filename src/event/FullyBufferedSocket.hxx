@@ -66,6 +66,13 @@ protected:
 	 */
 	bool Write(const void *data, size_t length) noexcept;
 
+	/**
+	 * All data in the output buffer has been sent.  This method
+	 * must not write to or destroy the socket; it may only
+	 * schedule more work.
+	 */
+	virtual void OnSocketDrained() noexcept {}
+
 	/* virtual methods from class SocketMonitor */
 	bool OnSocketReady(unsigned flags) noexcept override;
 
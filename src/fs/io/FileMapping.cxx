@@ -0,0 +1,88 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "FileMapping.hxx"
+#include "FileReader.hxx"
+#include "fs/Path.hxx"
+
+#ifdef _WIN32
+#include "util/HugeAllocator.hxx"
+#include <stdexcept>
+#else
+#include "system/Error.hxx"
+#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+
+FileMapping::FileMapping(Path path)
+{
+	FileReader reader(path);
+
+	size = reader.GetSize();
+	data = HugeAllocate(size).data;
+
+	try {
+		auto *p = (std::byte *)data;
+		size_t remaining = size;
+		while (remaining > 0) {
+			size_t nbytes = reader.Read(p, remaining);
+			if (nbytes == 0)
+				throw std::runtime_error("Unexpected end of file");
+
+			p += nbytes;
+			remaining -= nbytes;
+		}
+	} catch (...) {
+		HugeFree(data, size);
+		throw;
+	}
+}
+
+FileMapping::~FileMapping() noexcept
+{
+	HugeFree(data, size);
+}
+
+#else
+
+FileMapping::FileMapping(Path path)
+{
+	FileReader reader(path);
+
+	size = reader.GetSize();
+	if (size == 0) {
+		/* mmap() refuses zero-length mappings */
+		data = nullptr;
+		return;
+	}
+
+	data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+		    reader.GetFD().Get(), 0);
+	if (data == MAP_FAILED)
+		throw FormatErrno("Failed to map %s", path.ToUTF8().c_str());
+}
+
+FileMapping::~FileMapping() noexcept
+{
+	if (data != nullptr)
+		munmap(data, size);
+}
+
+#endif
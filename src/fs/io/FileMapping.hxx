@@ -0,0 +1,55 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_FILE_MAPPING_HXX
+#define MPD_FILE_MAPPING_HXX
+
+#include "util/ConstBuffer.hxx"
+
+#include <cstddef>
+
+class Path;
+
+/**
+ * A read-only view of a whole file.  On POSIX systems, the file is
+ * mapped into memory with mmap(), so pages are loaded lazily and
+ * shared with the kernel's page cache; elsewhere, it is read into a
+ * heap buffer.
+ */
+class FileMapping {
+	void *data;
+	size_t size;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	explicit FileMapping(Path path);
+
+	~FileMapping() noexcept;
+
+	FileMapping(const FileMapping &) = delete;
+	FileMapping &operator=(const FileMapping &) = delete;
+
+	ConstBuffer<void> Get() const noexcept {
+		return {data, size};
+	}
+};
+
+#endif
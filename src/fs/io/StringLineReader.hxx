@@ -0,0 +1,61 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_STRING_LINE_READER_HXX
+#define MPD_STRING_LINE_READER_HXX
+
+#include "LineReader.hxx"
+#include "util/StringStrip.hxx"
+
+#include <string>
+
+#include <string.h>
+
+/**
+ * Reads lines from a #std::string, replacing the newline characters
+ * with null bytes.  Like #TextFile, it strips trailing whitespace
+ * (including "\r") from each line.
+ */
+class StringLineReader final : public LineReader {
+	char *p;
+	char *const end;
+
+public:
+	explicit StringLineReader(std::string &s) noexcept
+		:p(s.data()), end(p + s.size()) {}
+
+	/* virtual methods from class LineReader */
+	char *ReadLine() override {
+		if (p == end)
+			return nullptr;
+
+		char *line = p;
+		char *line_end = (char *)memchr(p, '\n', end - p);
+		if (line_end != nullptr)
+			p = line_end + 1;
+		else
+			/* the std::string null terminator follows */
+			p = line_end = end;
+
+		*StripRight(line, line_end) = 0;
+		return line;
+	}
+};
+
+#endif
@@ -20,6 +20,7 @@
 #ifndef MPD_TEXT_FILE_HXX
 #define MPD_TEXT_FILE_HXX
 
+#include "LineReader.hxx"
 #include "config.h"
 
 #include <memory>
@@ -29,7 +30,7 @@ class FileReader;
 class AutoGunzipReader;
 class BufferedReader;
 
-class TextFile {
+class TextFile final : public LineReader {
 	const std::unique_ptr<FileReader> file_reader;
 
 #ifdef ENABLE_ZLIB
@@ -52,7 +53,7 @@ public:
 	 *
 	 * @return a pointer to the line, or nullptr on end-of-file
 	 */
-	char *ReadLine();
+	char *ReadLine() override;
 };
 
 #endif
@@ -67,6 +67,7 @@ IcuCollateFinish() noexcept
 	assert(collator != nullptr);
 
 	ucol_close(collator);
+	collator = nullptr;
 }
 
 #endif
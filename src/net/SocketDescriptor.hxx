@@ -39,6 +39,7 @@ class SocketAddress;
 class StaticSocketAddress;
 class IPv4Address;
 class IPv6Address;
+struct iovec;
 
 /**
  * An OO wrapper for a UNIX socket descriptor.
@@ -235,6 +236,13 @@ public:
 	ssize_t Read(void *buffer, size_t length) noexcept;
 	ssize_t Write(const void *buffer, size_t length) noexcept;
 
+#ifndef _WIN32
+	/**
+	 * Send several buffers with one sendmsg() call.
+	 */
+	ssize_t WriteV(const struct iovec *v, size_t n) noexcept;
+#endif
+
 #ifdef _WIN32
 	int WaitReadable(int timeout_ms) const noexcept;
 	int WaitWritable(int timeout_ms) const noexcept;
@@ -22,10 +22,13 @@
 #include "Client.hxx"
 #include "mixer/MixerControl.hxx"
 #include "config/Block.hxx"
+#include "util/RuntimeError.hxx"
 #include "Log.hxx"
 
 #include <cassert>
 
+#include <stdlib.h>
+
 /** after a failure, wait this duration before
     automatically reopening the device */
 static constexpr PeriodClock::Duration REOPEN_AFTER = std::chrono::seconds(10);
@@ -44,12 +47,66 @@ AudioOutputControl::~AudioOutputControl() noexcept
 	StopThread();
 }
 
+/**
+ * Parse a list of CPU numbers and ranges, e.g. "0,2-3".
+ *
+ * Throws on error.
+ */
+static CpuSet
+ParseCpuSet(const char *s)
+{
+	CpuSet cpus;
+
+	const char *p = s;
+	while (true) {
+		char *endptr;
+		unsigned long first = strtoul(p, &endptr, 10), last = first;
+		if (endptr == p)
+			throw FormatRuntimeError("Malformed CPU list: %s", s);
+
+		p = endptr;
+		if (*p == '-') {
+			++p;
+			last = strtoul(p, &endptr, 10);
+			if (endptr == p || last < first)
+				throw FormatRuntimeError("Malformed CPU list: %s", s);
+			p = endptr;
+		}
+
+		if (last >= cpus.size())
+			throw FormatRuntimeError("CPU number too large: %s", s);
+
+		for (unsigned long i = first; i <= last; ++i)
+			cpus.set(i);
+
+		if (*p == 0)
+			break;
+
+		if (*p != ',')
+			throw FormatRuntimeError("Malformed CPU list: %s", s);
+		++p;
+	}
+
+	return cpus;
+}
+
 void
 AudioOutputControl::Configure(const ConfigBlock &block)
 {
 	tags = block.GetBlockValue("tags", true);
 	always_on = block.GetBlockValue("always_on", false);
 	enabled = block.GetBlockValue("enabled", true);
+
+	lock_memory = block.GetBlockValue("lock_memory", false);
+
+	realtime_priority = block.GetBlockValue("realtime_priority", 40U);
+	if (realtime_priority > 99)
+		throw FormatRuntimeError("Invalid realtime_priority: %u",
+					 realtime_priority);
+
+	const char *p = block.GetBlockValue("cpu_affinity");
+	if (p != nullptr)
+		cpu_affinity = ParseCpuSet(p);
 }
 
 std::unique_ptr<FilteredAudioOutput>
@@ -23,6 +23,7 @@
 #include "Source.hxx"
 #include "pcm/AudioFormat.hxx"
 #include "thread/Thread.hxx"
+#include "thread/Util.hxx"
 #include "thread/Mutex.hxx"
 #include "thread/Cond.hxx"
 #include "system/PeriodClock.hxx"
@@ -160,6 +161,24 @@ class AudioOutputControl {
 	 */
 	bool always_on;
 
+	/**
+	 * Ask the player to lock the #MusicBuffer in RAM (setting
+	 * "lock_memory").
+	 */
+	bool lock_memory = false;
+
+	/**
+	 * The SCHED_FIFO priority of the output thread; 0 disables
+	 * real-time scheduling.
+	 */
+	unsigned realtime_priority = 40;
+
+	/**
+	 * The CPUs the output thread may run on; empty means no
+	 * restriction.
+	 */
+	CpuSet cpu_affinity;
+
 	/**
 	 * Has the user enabled this device?
 	 */
@@ -266,6 +285,10 @@ public:
 		return !output;
 	}
 
+	bool IsLockMemory() const noexcept {
+		return lock_memory;
+	}
+
 	/**
 	 * Caller must lock the mutex.
 	 */
@@ -387,3 +387,13 @@ MultipleOutputs::SongBorder() noexcept
 	   song */
 	elapsed_time = SignedSongTime::zero();
 }
+
+bool
+MultipleOutputs::IsLockMemory() const noexcept
+{
+	for (const auto &i : outputs)
+		if (i->IsLockMemory())
+			return true;
+
+	return false;
+}
@@ -209,6 +209,7 @@ private:
 	void Drain() noexcept override;
 	void Cancel() noexcept override;
 	void SongBorder() noexcept override;
+	bool IsLockMemory() const noexcept override;
 	SignedSongTime GetElapsedTime() const noexcept override {
 		return elapsed_time;
 	}
@@ -28,11 +28,12 @@ SharedPipeConsumer::Get() noexcept
 		if (!consumed)
 			return chunk;
 
-		if (chunk->next == nullptr)
+		const MusicChunk *next = chunk->next.load(std::memory_order_acquire);
+		if (next == nullptr)
 			return nullptr;
 
 		consumed = false;
-		return chunk = chunk->next.get();
+		return chunk = next;
 	} else {
 		/* get the first chunk from the pipe */
 		consumed = false;
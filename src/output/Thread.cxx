@@ -404,11 +404,23 @@ AudioOutputControl::Task() noexcept
 {
 	FormatThreadName("output:%s", GetName());
 
-	try {
-		SetThreadRealtime();
-	} catch (...) {
-		Log(LogLevel::INFO, std::current_exception(),
-		    "OutputThread could not get realtime scheduling, continuing anyway");
+	if (realtime_priority > 0) {
+		try {
+			SetThreadRealtime(realtime_priority);
+		} catch (...) {
+			Log(LogLevel::INFO, std::current_exception(),
+			    "OutputThread could not get realtime scheduling, continuing anyway");
+		}
+	}
+
+	if (cpu_affinity.any()) {
+		try {
+			SetThreadAffinity(cpu_affinity);
+		} catch (...) {
+			FormatError(std::current_exception(),
+				    "Failed to set the CPU affinity of %s",
+				    GetLogName());
+		}
 	}
 
 	SetThreadTimerSlack(std::chrono::microseconds(100));
@@ -21,17 +21,23 @@
 #include "HttpdInternal.hxx"
 #include "util/ASCII.hxx"
 #include "util/AllocatedString.hxx"
+#include "util/ConstBuffer.hxx"
 #include "Page.hxx"
 #include "IcyMetaDataServer.hxx"
 #include "net/SocketError.hxx"
 #include "net/UniqueSocketDescriptor.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
 #include <cassert>
 
 #include <string.h>
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
 HttpdClient::~HttpdClient() noexcept
 {
 	if (IsDefined())
@@ -58,6 +64,7 @@ HttpdClient::BeginResponse() noexcept
 
 	state = State::RESPONSE;
 	current_page = nullptr;
+	next_page = httpd.GetPageRing().GetHead();
 
 	if (!head_method)
 		httpd.SendHeader(*this);
@@ -189,62 +196,79 @@ HttpdClient::HttpdClient(HttpdOutput &_httpd, UniqueSocketDescriptor _fd,
 {
 }
 
-void
-HttpdClient::ClearQueue() noexcept
-{
-	assert(state == State::RESPONSE);
-
-	while (!pages.empty()) {
-#ifndef NDEBUG
-		auto &page = pages.front();
-		assert(queue_size >= page->GetSize());
-		queue_size -= page->GetSize();
-#endif
-
-		pages.pop();
-	}
-
-	assert(queue_size == 0);
-}
-
 void
 HttpdClient::CancelQueue() noexcept
 {
 	if (state != State::RESPONSE)
 		return;
 
-	ClearQueue();
+	next_page = httpd.GetPageRing().GetHead();
 
 	if (current_page == nullptr)
 		CancelWrite();
 }
 
-ssize_t
-HttpdClient::TryWritePage(const Page &page, size_t position) noexcept
-{
-	assert(position < page.GetSize());
+/**
+ * The maximum number of buffers passed to one sendmsg() call.
+ */
+static constexpr size_t MAX_SEGMENTS = 32;
 
-	return GetSocket().Write(page.GetData() + position,
-				 page.GetSize() - position);
-}
+/**
+ * An empty Icy-Metadata block, sent when the metadata has not
+ * changed.
+ */
+static constexpr uint8_t empty_metadata = 0;
 
-ssize_t
-HttpdClient::TryWritePageN(const Page &page,
-			   size_t position, ssize_t n) noexcept
+static ssize_t
+SendSegments(SocketDescriptor s,
+	     const ConstBuffer<uint8_t> *segments, size_t n) noexcept
 {
-	return n >= 0
-		? GetSocket().Write(page.GetData() + position, n)
-		: TryWritePage(page, position);
+	assert(n > 0);
+
+#ifdef _WIN32
+	(void)n;
+	return s.Write(segments[0].data, segments[0].size);
+#else
+	struct iovec v[MAX_SEGMENTS];
+	for (size_t i = 0; i < n; ++i) {
+		v[i].iov_base = const_cast<uint8_t *>(segments[i].data);
+		v[i].iov_len = segments[i].size;
+	}
+
+	return s.WriteV(v, n);
+#endif
 }
 
-ssize_t
-HttpdClient::GetBytesTillMetaData() const noexcept
+void
+HttpdClient::ConsumeData(size_t nbytes) noexcept
 {
-	if (metadata_requested &&
-	    current_page->GetSize() - current_position > metaint - metadata_fill)
-		return metaint - metadata_fill;
+	const auto &ring = httpd.GetPageRing();
+
+	if (metadata_requested)
+		metadata_fill += nbytes;
+
+	while (nbytes > 0) {
+		if (current_page == nullptr) {
+			const auto &page = ring.Get(next_page++);
+			if (nbytes < page->GetSize()) {
+				current_page = page;
+				current_position = nbytes;
+				return;
+			}
 
-	return -1;
+			nbytes -= page->GetSize();
+		} else {
+			const size_t remaining =
+				current_page->GetSize() - current_position;
+			if (nbytes < remaining) {
+				current_position += nbytes;
+				return;
+			}
+
+			nbytes -= remaining;
+			current_page.reset();
+		}
+	}
 }
 
 inline bool
@@ -254,128 +278,126 @@ HttpdClient::TryWrite() noexcept
 
 	assert(state == State::RESPONSE);
 
-	if (current_page == nullptr) {
-		if (pages.empty()) {
-			/* another thread has removed the event source
-			   while this thread was waiting for
-			   httpd.mutex */
-			CancelWrite();
-			return true;
-		}
+	const auto &ring = httpd.GetPageRing();
 
-		current_page = pages.front();
-		pages.pop();
-		current_position = 0;
-
-		assert(queue_size >= current_page->GetSize());
-		queue_size -= current_page->GetSize();
+	if (next_page < ring.GetTail()) {
+		/* the pages this client was waiting for have already
+		   been removed from the ring */
+		FormatDebug(httpd_output_domain,
+			    "client is too slow, flushing its queue");
+		next_page = ring.GetHead();
 	}
 
-	const ssize_t bytes_to_write = GetBytesTillMetaData();
-	if (bytes_to_write == 0) {
-		if (!metadata_sent) {
-			ssize_t nbytes = TryWritePage(*metadata,
-						      metadata_current_position);
-			if (nbytes < 0) {
-				auto e = GetSocketError();
-				if (IsSocketErrorAgain(e))
-					return true;
-
-				if (!IsSocketErrorClosed(e)) {
-					SocketErrorMessage msg(e);
-					FormatWarning(httpd_output_domain,
-						      "failed to write to client: %s",
-						      (const char *)msg);
-				}
-
-				Close();
-				return false;
-			}
+	/* collect all pending data (interleaved with Icy-Metadata
+	   blocks) to send it with one system call */
 
-			metadata_current_position += nbytes;
+	ConstBuffer<uint8_t> segments[MAX_SEGMENTS];
+	size_t n = 0;
 
-			if (metadata->GetSize() - metadata_current_position == 0) {
-				metadata_fill = 0;
-				metadata_current_position = 0;
-				metadata_sent = true;
-			}
-		} else {
-			char empty_data = 0;
-
-			ssize_t nbytes = GetSocket().Write(&empty_data, 1);
-			if (nbytes < 0) {
-				auto e = GetSocketError();
-				if (IsSocketErrorAgain(e))
-					return true;
-
-				if (!IsSocketErrorClosed(e)) {
-					SocketErrorMessage msg(e);
-					FormatWarning(httpd_output_domain,
-						      "failed to write to client: %s",
-						      (const char *)msg);
-				}
-
-				Close();
-				return false;
-			}
+	const Page *page = current_page.get();
+	size_t position = current_position;
+	auto sequence = next_page;
+	size_t till_metadata = metaint - metadata_fill;
+	size_t metadata_segment = MAX_SEGMENTS;
 
-			metadata_fill = 0;
-			metadata_current_position = 0;
+	while (n < MAX_SEGMENTS) {
+		if (page == nullptr || position == page->GetSize()) {
+			if (!ring.Contains(sequence))
+				break;
+
+			page = ring.Get(sequence++).get();
+			position = 0;
 		}
-	} else {
-		ssize_t nbytes =
-			TryWritePageN(*current_page, current_position,
-				      bytes_to_write);
-		if (nbytes < 0) {
-			auto e = GetSocketError();
-			if (IsSocketErrorAgain(e))
-				return true;
-
-			if (!IsSocketErrorClosed(e)) {
-				SocketErrorMessage msg(e);
-				FormatWarning(httpd_output_domain,
-					      "failed to write to client: %s",
-					      (const char *)msg);
-			}
 
-			Close();
-			return false;
+		if (metadata_requested && till_metadata == 0) {
+			if (!metadata_sent && metadata_segment == MAX_SEGMENTS) {
+				metadata_segment = n;
+				segments[n++] = {
+					metadata->GetData() + metadata_current_position,
+					metadata->GetSize() - metadata_current_position,
+				};
+			} else
+				segments[n++] = {&empty_metadata, 1};
+
+			till_metadata = metaint;
+			continue;
 		}
 
-		current_position += nbytes;
-		assert(current_position <= current_page->GetSize());
+		size_t length = page->GetSize() - position;
+		if (metadata_requested) {
+			if (length > till_metadata)
+				length = till_metadata;
+			till_metadata -= length;
+		}
 
-		if (metadata_requested)
-			metadata_fill += nbytes;
+		segments[n++] = {page->GetData() + position, length};
+		position += length;
+	}
 
-		if (current_position >= current_page->GetSize()) {
-			current_page.reset();
+	if (n == 0) {
+		/* all pages are sent (or another thread has removed
+		   the event source while this thread was waiting for
+		   httpd.mutex) */
+		CancelWrite();
+		return true;
+	}
+
+	const ssize_t nbytes = SendSegments(GetSocket(), segments, n);
+	if (nbytes < 0) {
+		auto e = GetSocketError();
+		if (IsSocketErrorAgain(e))
+			return true;
 
-			if (pages.empty())
-				/* all pages are sent: remove the
-				   event source */
-				CancelWrite();
+		if (!IsSocketErrorClosed(e)) {
+			SocketErrorMessage msg(e);
+			FormatWarning(httpd_output_domain,
+				      "failed to write to client: %s",
+				      (const char *)msg);
 		}
+
+		Close();
+		return false;
+	}
+
+	/* advance the read position over everything which was
+	   sent */
+
+	size_t rest = nbytes;
+	for (size_t i = 0; rest > 0; ++i) {
+		const auto &segment = segments[i];
+		const size_t length = std::min(rest, segment.size);
+		rest -= length;
+
+		if (i == metadata_segment) {
+			metadata_current_position += length;
+
+			if (metadata_current_position == metadata->GetSize()) {
+				metadata_fill = 0;
+				metadata_current_position = 0;
+				metadata_sent = true;
+			}
+		} else if (segment.data == &empty_metadata)
+			metadata_fill = 0;
+		else
+			ConsumeData(length);
 	}
 
+	if (current_page == nullptr && next_page == ring.GetHead())
+		/* all pages are sent: remove the event source */
+		CancelWrite();
+
 	return true;
 }
 
 void
-HttpdClient::PushPage(PagePtr page) noexcept
+HttpdClient::PushHeader(PagePtr page) noexcept
 {
 	if (state != State::RESPONSE)
 		/* the client is still writing the HTTP request */
 		return;
 
-	if (queue_size > 256 * 1024) {
-		FormatDebug(httpd_output_domain,
-			    "client is too slow, flushing its queue");
-		ClearQueue();
-	}
-
-	queue_size += page->GetSize();
-	pages.emplace(std::move(page));
+	current_page = std::move(page);
+	current_position = 0;
 
 	ScheduleWrite();
 }
@@ -28,8 +28,7 @@
 #include <boost/intrusive/list_hook.hpp>
 
 #include <cstddef>
-#include <list>
-#include <queue>
+#include <cstdint>
 
 class UniqueSocketDescriptor;
 class HttpdOutput;
@@ -57,17 +56,10 @@ class HttpdClient final
 	} state = State::REQUEST;
 
 	/**
-	 * A queue of #Page objects to be sent to the client.
-	 */
-	std::queue<PagePtr, std::list<PagePtr>> pages;
-
-	/**
-	 * The sum of all page sizes in #pages.
-	 */
-	size_t queue_size = 0;
-
-	/**
-	 * The #page which is currently being sent to the client.
+	 * A page which is sent before the pages from the
+	 * #PageRing: either the encoder header, or a ring page which
+	 * was only partially sent (this reference keeps it alive even
+	 * if it gets removed from the ring meanwhile).
 	 */
 	PagePtr current_page;
 
@@ -77,6 +69,12 @@ class HttpdClient final
 	 */
 	size_t current_position;
 
+	/**
+	 * The sequence number of the next #PageRing page to be sent
+	 * to this client.
+	 */
+	uint_least64_t next_page;
+
 	/**
 	 * Is this a HEAD request?
 	 */
@@ -154,7 +152,7 @@ public:
 	void LockClose() noexcept;
 
 	/**
-	 * Clears the page queue.
+	 * Skips all pages which have not been sent yet.
 	 */
 	void CancelQueue() noexcept;
 
@@ -173,19 +171,21 @@ public:
 	 */
 	bool SendResponse() noexcept;
 
-	gcc_pure
-	ssize_t GetBytesTillMetaData() const noexcept;
-
-	ssize_t TryWritePage(const Page &page, size_t position) noexcept;
-	ssize_t TryWritePageN(const Page &page,
-			      size_t position, ssize_t n) noexcept;
-
 	bool TryWrite() noexcept;
 
 	/**
-	 * Appends a page to the client's queue.
+	 * Sends this page before the pages from the #PageRing; this
+	 * is used for the encoder header.
+	 */
+	void PushHeader(PagePtr page) noexcept;
+
+	/**
+	 * New pages have been added to the #PageRing.
 	 */
-	void PushPage(PagePtr page) noexcept;
+	void NotifyPages() noexcept {
+		if (state == State::RESPONSE)
+			ScheduleWrite();
+	}
 
 	/**
 	 * Sends the passed metadata.
@@ -193,7 +193,10 @@ public:
 	void PushMetaData(PagePtr page) noexcept;
 
 private:
-	void ClearQueue() noexcept;
+	/**
+	 * Advance the read position after data has been sent.
+	 */
+	void ConsumeData(size_t nbytes) noexcept;
 
 protected:
 	/* virtual methods from class SocketMonitor */
@@ -26,6 +26,7 @@
 #define MPD_OUTPUT_HTTPD_INTERNAL_H
 
 #include "HttpdClient.hxx"
+#include "PageRing.hxx"
 #include "output/Interface.hxx"
 #include "output/Timer.hxx"
 #include "thread/Mutex.hxx"
@@ -40,6 +41,7 @@
 #include <queue>
 #include <list>
 #include <memory>
+#include <vector>
 
 struct ConfigBlock;
 class EventLoop;
@@ -72,6 +74,14 @@ class HttpdOutput final : AudioOutput, ServerSocket {
 	 */
 	size_t unflushed_input = 0;
 
+	/**
+	 * Is the encoder shared with other outputs (setting
+	 * "shared_encoder")?  Then all PCM data is passed to it even
+	 * if there are no clients, to keep this output's position
+	 * in sync with the others.
+	 */
+	const bool shared_encoder;
+
 public:
 	/**
 	 * The MIME type produced by the #encoder.
@@ -115,6 +125,47 @@ private:
 	 */
 	std::queue<PagePtr, std::list<PagePtr>> pages;
 
+	/**
+	 * The most recently broadcasted pages.  Clients read from
+	 * here with their own cursor.  Only accessed in the
+	 * IOThread, while holding #mutex.
+	 */
+	PageRing ring{256 * 1024};
+
+	/**
+	 * The bounds of #page_capacity.  ReadPage() never returns a
+	 * page larger than #MAX_PAGE_CAPACITY.
+	 */
+	static constexpr size_t MIN_PAGE_CAPACITY = 1024;
+	static constexpr size_t MAX_PAGE_CAPACITY = 32768;
+
+	/**
+	 * The allocated size of new pages, i.e. the payload size of
+	 * the previous page rounded up to a power of two.  ReadPage()
+	 * grows a page which fills up.  Only accessed by the
+	 * OutputThread.
+	 */
+	size_t page_capacity = MIN_PAGE_CAPACITY;
+
+	/**
+	 * Pages removed from #ring which were not referenced anymore;
+	 * ReadPage() reuses those matching #page_capacity instead of
+	 * allocating new ones.
+	 */
+	std::vector<PagePtr> free_pages;
+
+	/**
+	 * Protects #free_pages.  This is a separate mutex because
+	 * ReadPage() may be called while #mutex is locked.
+	 */
+	Mutex free_pages_mutex;
+
+	/**
+	 * A page which ReadPage() has obtained, but was unable to
+	 * fill.  Only accessed by the OutputThread.
+	 */
+	PagePtr spare_page;
+
 	DeferEvent defer_broadcast;
 
  public:
@@ -139,12 +190,6 @@ private:
 	boost::intrusive::list<HttpdClient,
 			       boost::intrusive::constant_time_size<true>> clients;
 
-	/**
-	 * A temporary buffer for the httpd_output_read_page()
-	 * function.
-	 */
-	char buffer[32768];
-
 	/**
 	 * The maximum and current number of clients connected
 	 * at the same time.
@@ -208,6 +253,21 @@ public:
 		return HasClients();
 	}
 
+	/**
+	 * Shall PCM data be passed to the encoder?
+	 */
+	gcc_pure
+	bool LockNeedsEncoder() const noexcept {
+		return shared_encoder || LockHasClients();
+	}
+
+	/**
+	 * Caller must lock the mutex.
+	 */
+	const PageRing &GetPageRing() const noexcept {
+		return ring;
+	}
+
 	/**
 	 * Caller must lock the mutex.
 	 */
@@ -269,6 +329,27 @@ public:
 	bool Pause() override;
 
 private:
+	/**
+	 * Obtain an empty page with #page_capacity from #free_pages
+	 * or allocate a new one.
+	 */
+	PagePtr GetFreePage() noexcept;
+
+	/**
+	 * Put a page removed from #ring back into #free_pages if
+	 * nobody else references it.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void RecyclePage(PagePtr &&page) noexcept;
+
+	/**
+	 * Remove all pages from #ring.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void ClearRing() noexcept;
+
 	/* DeferEvent callback */
 	void OnDeferredBroadcast() noexcept;
 
@@ -32,6 +32,7 @@
 #include "util/DeleteDisposer.hxx"
 #include "config/Net.hxx"
 
+#include <algorithm>
 #include <cassert>
 
 #include <string.h>
@@ -43,6 +44,7 @@ HttpdOutput::HttpdOutput(EventLoop &_loop, const ConfigBlock &block)
 	:AudioOutput(FLAG_ENABLE_DISABLE|FLAG_PAUSE),
 	 ServerSocket(_loop),
 	 prepared_encoder(CreateConfiguredEncoder(block)),
+	 shared_encoder(block.GetBlockValue("shared_encoder") != nullptr),
 	 defer_broadcast(_loop, BIND_THIS_METHOD(OnDeferredBroadcast))
 {
 	/* read configuration */
@@ -110,10 +112,15 @@ HttpdOutput::OnDeferredBroadcast() noexcept
 		PagePtr page = std::move(pages.front());
 		pages.pop();
 
-		for (auto &client : clients)
-			client.PushPage(page);
+		while (ring.IsFull(page->GetSize()))
+			RecyclePage(ring.Shift());
+
+		ring.Push(std::move(page));
 	}
 
+	for (auto &client : clients)
+		client.NotifyPages();
+
 	/* wake up the client that may be waiting for the queue to be
 	   flushed */
 	cond.notify_all();
@@ -133,6 +140,45 @@ HttpdOutput::OnAccept(UniqueSocketDescriptor fd,
 		AddClient(std::move(fd));
 }
 
+inline void
+HttpdOutput::RecyclePage(PagePtr &&page) noexcept
+{
+	static constexpr size_t MAX_FREE_PAGES = 16;
+
+	if (page.use_count() != 1)
+		return;
+
+	const std::lock_guard<Mutex> protect(free_pages_mutex);
+	if (free_pages.size() < MAX_FREE_PAGES)
+		free_pages.emplace_back(std::move(page));
+}
+
+void
+HttpdOutput::ClearRing() noexcept
+{
+	while (!ring.empty())
+		RecyclePage(ring.Shift());
+}
+
+inline PagePtr
+HttpdOutput::GetFreePage() noexcept
+{
+	{
+		const std::lock_guard<Mutex> protect(free_pages_mutex);
+		while (!free_pages.empty()) {
+			PagePtr page = std::move(free_pages.back());
+			free_pages.pop_back();
+
+			/* pages of a different size are freed, so the
+			   pool follows the encoder's output size */
+			if (page->GetCapacity() == page_capacity)
+				return page;
+		}
+	}
+
+	return std::make_shared<Page>(page_capacity);
+}
+
 PagePtr
 HttpdOutput::ReadPage()
 {
@@ -149,22 +195,46 @@ HttpdOutput::ReadPage()
 		unflushed_input = 0;
 	}
 
+	PagePtr page = std::move(spare_page);
+	if (page == nullptr)
+		page = GetFreePage();
+
+	/* read directly into the (possibly recycled) page buffer,
+	   growing it if the encoder has more data */
 	size_t size = 0;
-	do {
-		size_t nbytes = encoder->Read(buffer + size,
-					      sizeof(buffer) - size);
+	while (true) {
+		const size_t capacity = page->GetCapacity();
+		if (size == capacity) {
+			if (capacity >= MAX_PAGE_CAPACITY)
+				break;
+
+			page->Grow(std::min(capacity * 2,
+					    MAX_PAGE_CAPACITY),
+				   size);
+			continue;
+		}
+
+		size_t nbytes = encoder->Read(page->GetWriteBuffer() + size,
+					      capacity - size);
 		if (nbytes == 0)
 			break;
 
 		unflushed_input = 0;
 
 		size += nbytes;
-	} while (size < sizeof(buffer));
+	}
 
-	if (size == 0)
+	if (size == 0) {
+		spare_page = std::move(page);
 		return nullptr;
+	}
 
-	return std::make_shared<Page>(buffer, size);
+	page_capacity = MIN_PAGE_CAPACITY;
+	while (page_capacity < size)
+		page_capacity *= 2;
+
+	page->SetSize(size);
+	return page;
 }
 
 inline void
@@ -211,9 +281,13 @@ HttpdOutput::Close() noexcept
 			const std::lock_guard<Mutex> protect(mutex);
 			open = false;
 			clients.clear_and_dispose(DeleteDisposer());
+			ClearRing();
 		});
 
+	free_pages.clear();
+
 	header.reset();
+	spare_page.reset();
 
 	delete encoder;
 }
@@ -231,13 +305,13 @@ void
 HttpdOutput::SendHeader(HttpdClient &client) const noexcept
 {
 	if (header != nullptr)
-		client.PushPage(header);
+		client.PushHeader(header);
 }
 
 std::chrono::steady_clock::duration
 HttpdOutput::Delay() const noexcept
 {
-	if (!LockHasClients() && pause) {
+	if (!LockNeedsEncoder() && pause) {
 		/* if there's no client and this output is paused,
 		   then httpd_output_pause() will not do anything, it
 		   will not fill the buffer and it will not update the
@@ -305,7 +379,7 @@ HttpdOutput::Play(const void *chunk, size_t size)
 {
 	pause = false;
 
-	if (LockHasClients())
+	if (LockNeedsEncoder())
 		EncodeAndPlay(chunk, size);
 
 	if (!timer->IsStarted())
@@ -320,7 +394,7 @@ HttpdOutput::Pause()
 {
 	pause = true;
 
-	if (LockHasClients()) {
+	if (LockNeedsEncoder()) {
 		static const char silence[1020] = { 0 };
 		Play(silence, sizeof(silence));
 	}
@@ -390,6 +464,8 @@ HttpdOutput::CancelAllClients() noexcept
 		pages.pop();
 	}
 
+	ClearRing();
+
 	for (auto &client : clients)
 		client.CancelQueue();
 
@@ -22,6 +22,7 @@
 
 #include "util/AllocatedArray.hxx"
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -30,24 +31,60 @@
  * A dynamically allocated buffer.  It is used to pass
  * reference-counted buffers around (using std::shared_ptr), when
  * several instances hold references to one buffer.
+ *
+ * The allocated capacity may be larger than the payload size, which
+ * allows recycling the buffer for a new payload of a different size
+ * (see SetSize()).
  */
 class Page {
 	AllocatedArray<uint8_t> buffer;
 
+	size_t size;
+
 public:
-	explicit Page(size_t _size) noexcept:buffer(_size) {}
+	explicit Page(size_t _size) noexcept:buffer(_size), size(_size) {}
 	explicit Page(AllocatedArray<uint8_t> &&_buffer) noexcept
-		:buffer(std::move(_buffer)) {}
+		:buffer(std::move(_buffer)), size(buffer.size()) {}
 
 	Page(const void *data, size_t size) noexcept;
 
+	size_t GetCapacity() const noexcept {
+		return buffer.capacity();
+	}
+
 	size_t GetSize() const noexcept {
-		return buffer.size();
+		return size;
 	}
 
 	const uint8_t *GetData() const noexcept {
 		return &buffer.front();
 	}
+
+	/**
+	 * Returns a writable pointer to the buffer; only allowed
+	 * while nobody else holds a reference to this page.
+	 */
+	uint8_t *GetWriteBuffer() noexcept {
+		return &buffer.front();
+	}
+
+	/**
+	 * Enlarge the buffer, preserving the first #preserve bytes.
+	 * Only allowed while nobody else holds a reference to this
+	 * page.
+	 */
+	void Grow(size_t new_capacity, size_t preserve) noexcept {
+		buffer.GrowPreserve(new_capacity, preserve);
+	}
+
+	/**
+	 * Declare the payload size.  Must not be larger than the
+	 * capacity.
+	 */
+	void SetSize(size_t _size) noexcept {
+		assert(_size <= buffer.capacity());
+		size = _size;
+	}
 };
 
 typedef std::shared_ptr<Page> PagePtr;
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_OUTPUT_HTTPD_PAGE_RING_HXX
+#define MPD_OUTPUT_HTTPD_PAGE_RING_HXX
+
+#include "Page.hxx"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * A ring buffer of recently broadcasted #Page objects.  Every page
+ * gets a sequence number, and each client keeps its own read cursor
+ * into the ring instead of a private page queue.  The ring is limited
+ * only by the sum of all page sizes; old pages are removed by the
+ * producer when it is full, and a client whose cursor falls behind
+ * GetTail() has missed data.
+ */
+class PageRing {
+	/**
+	 * The pages from #tail to #head.
+	 */
+	std::deque<PagePtr> pages;
+
+	/**
+	 * The sequence number of the oldest page in the ring.
+	 */
+	uint_least64_t tail = 0;
+
+	/**
+	 * The sequence number which will be assigned to the next
+	 * page.
+	 */
+	uint_least64_t head = 0;
+
+	/**
+	 * The sum of all page sizes.
+	 */
+	size_t size = 0;
+
+	/**
+	 * The maximum value of #size.  A single page may exceed it.
+	 */
+	const size_t max_size;
+
+public:
+	explicit PageRing(size_t _max_size) noexcept
+		:max_size(_max_size) {}
+
+	PageRing(const PageRing &) = delete;
+	PageRing &operator=(const PageRing &) = delete;
+
+	bool empty() const noexcept {
+		return tail == head;
+	}
+
+	uint_least64_t GetTail() const noexcept {
+		return tail;
+	}
+
+	uint_least64_t GetHead() const noexcept {
+		return head;
+	}
+
+	/**
+	 * Is a page with the given sequence number still available?
+	 */
+	bool Contains(uint_least64_t sequence) const noexcept {
+		return sequence >= tail && sequence < head;
+	}
+
+	const PagePtr &Get(uint_least64_t sequence) const noexcept {
+		assert(Contains(sequence));
+
+		return pages[sequence - tail];
+	}
+
+	/**
+	 * Must the oldest page be removed before a page of the
+	 * given size can be added?
+	 */
+	bool IsFull(size_t add_size) const noexcept {
+		return !empty() && size + add_size > max_size;
+	}
+
+	/**
+	 * Remove the oldest page and return it.
+	 */
+	PagePtr Shift() noexcept {
+		assert(!empty());
+
+		PagePtr page = std::move(pages.front());
+		pages.pop_front();
+		++tail;
+
+		assert(size >= page->GetSize());
+		size -= page->GetSize();
+		return page;
+	}
+
+	/**
+	 * Append a page; the caller must make room first (see
+	 * IsFull()).
+	 */
+	void Push(PagePtr page) noexcept {
+		assert(!IsFull(page->GetSize()));
+
+		size += page->GetSize();
+		pages.emplace_back(std::move(page));
+		++head;
+	}
+};
+
+#endif
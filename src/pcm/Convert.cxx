@@ -19,20 +19,52 @@
 
 #include "Convert.hxx"
 #include "ConfiguredResampler.hxx"
+#include "config/Data.hxx"
+#include "config/Option.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/RuntimeError.hxx"
 
 #include <cassert>
 #include <stdexcept>
 
+#include <string.h>
+
+#ifdef ENABLE_DSD
+
+static Dsd2PcmEngine dsd2pcm_engine = Dsd2PcmEngine::BLOCK;
+
+static Dsd2PcmEngine
+ParseDsd2PcmEngine(const char *s)
+{
+	if (s == nullptr || strcmp(s, "block") == 0)
+		return Dsd2PcmEngine::BLOCK;
+	else if (strcmp(s, "classic") == 0)
+		return Dsd2PcmEngine::CLASSIC;
+	else
+		throw FormatRuntimeError("Unrecognized DSD to PCM converter: %s",
+					 s);
+}
+
+#endif
+
 void
 pcm_convert_global_init(const ConfigData &config)
 {
 	pcm_resampler_global_init(config);
+
+#ifdef ENABLE_DSD
+	dsd2pcm_engine = config.With(ConfigOption::DSD2PCM,
+				     ParseDsd2PcmEngine);
+#endif
 }
 
 PcmConvert::PcmConvert(const AudioFormat _src_format,
 		       const AudioFormat dest_format)
-	:src_format(_src_format)
+	:
+#ifdef ENABLE_DSD
+	 dsd(dsd2pcm_engine),
+#endif
+	 src_format(_src_format)
 {
 	assert(src_format.IsValid());
 	assert(dest_format.IsValid());
@@ -31,10 +31,12 @@ or implied, of Sebastian Gesemann.
  */
 
 #include "Dsd2Pcm.hxx"
+#include "Simd.hxx"
 #include "Traits.hxx"
 #include "util/BitReverse.hxx"
 #include "util/GenerateArray.hxx"
 
+#include <algorithm>
 #include <cassert>
 
 #include <stdlib.h>
@@ -175,6 +177,35 @@ GenerateCtableS24(size_t i) noexcept
 
 static constexpr auto ctables_s24 = GenerateArray<CTABLES>(GenerateCtableS24);
 
+/*
+ * Copies of the tables indexed with bit-reversed bytes; these are
+ * used by #BlockDsd2Pcm for the older half of the taps, where
+ * #Dsd2Pcm reverses the bytes in its FIFO.
+ */
+
+template<const auto &tables>
+struct GenerateReversedCtableValue {
+	size_t i;
+
+	constexpr auto operator()(size_t j) const noexcept {
+		return tables[i][BitReverseMultiplyModulus(j)];
+	}
+};
+
+template<const auto &tables>
+struct GenerateReversedCtable {
+	constexpr auto operator()(size_t i) const noexcept {
+		return GenerateArray<256>(GenerateReversedCtableValue<tables>{i});
+	}
+};
+
+static constexpr auto rctables =
+	GenerateArray<CTABLES>(GenerateReversedCtable<ctables>{});
+static constexpr auto rctables_s24 =
+	GenerateArray<CTABLES>(GenerateReversedCtable<ctables_s24>{});
+
+static_assert(BlockDsd2Pcm::HISTORY == CTABLES * 2 - 1);
+
 void
 Dsd2Pcm::Reset() noexcept
 {
@@ -328,3 +359,211 @@ MultiDsd2Pcm::TranslateStereoS24(size_t n_frames,
 	}
 	fifopos = ffp;
 }
+
+/**
+ * Calculate one output sample from #BlockDsd2Pcm's linear buffer.
+ * This is the same calculation (in the same order) as
+ * Dsd2Pcm::CalcOutputSample().
+ *
+ * @param p pointer to the oldest input byte this sample depends on
+ */
+static inline float
+CalcBlockSample(const uint8_t *p) noexcept
+{
+	double acc = 0;
+	for (size_t i = 0; i < CTABLES; ++i)
+		acc += double(ctables[i][p[BlockDsd2Pcm::HISTORY - i]] +
+			      rctables[i][p[i]]);
+	return float(acc);
+}
+
+static inline int32_t
+CalcBlockSampleS24(const uint8_t *p) noexcept
+{
+	int32_t acc = 0;
+	for (size_t i = 0; i < CTABLES; ++i)
+		acc += ctables_s24[i][p[BlockDsd2Pcm::HISTORY - i]] +
+			rctables_s24[i][p[i]];
+	return acc;
+}
+
+#ifdef HAVE_PCM_SIMD_X86
+#include <immintrin.h>
+
+/**
+ * Load 8 input bytes and zero-extend them to table indices.
+ */
+PCM_AVX2_TARGET
+static inline __m256i
+LoadIndices(const uint8_t *p) noexcept
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+PCM_AVX2_TARGET
+static size_t
+TranslateBlock_AVX2(const uint8_t *linear, size_t n,
+		    float *dest, size_t dest_stride) noexcept
+{
+	size_t t = 0;
+	for (; t + 8 <= n; t += 8) {
+		const uint8_t *p = linear + t;
+
+		/* accumulate in double precision, just like
+		   CalcBlockSample() */
+		__m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+		for (size_t i = 0; i < CTABLES; ++i) {
+			const __m256 a =
+				_mm256_i32gather_ps(ctables[i].data(),
+						    LoadIndices(p + BlockDsd2Pcm::HISTORY - i),
+						    sizeof(float));
+			const __m256 b =
+				_mm256_i32gather_ps(rctables[i].data(),
+						    LoadIndices(p + i),
+						    sizeof(float));
+			const __m256 sum = _mm256_add_ps(a, b);
+			lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(sum)));
+			hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(sum, 1)));
+		}
+
+		float result[8];
+		_mm_storeu_ps(result, _mm256_cvtpd_ps(lo));
+		_mm_storeu_ps(result + 4, _mm256_cvtpd_ps(hi));
+
+		for (const float i : result) {
+			*dest = i;
+			dest += dest_stride;
+		}
+	}
+
+	return t;
+}
+
+PCM_AVX2_TARGET
+static size_t
+TranslateBlockS24_AVX2(const uint8_t *linear, size_t n,
+		       int32_t *dest, size_t dest_stride) noexcept
+{
+	size_t t = 0;
+	for (; t + 8 <= n; t += 8) {
+		const uint8_t *p = linear + t;
+
+		__m256i acc = _mm256_setzero_si256();
+		for (size_t i = 0; i < CTABLES; ++i) {
+			const __m256i a =
+				_mm256_i32gather_epi32((const int *)ctables_s24[i].data(),
+						       LoadIndices(p + BlockDsd2Pcm::HISTORY - i),
+						       sizeof(int32_t));
+			const __m256i b =
+				_mm256_i32gather_epi32((const int *)rctables_s24[i].data(),
+						       LoadIndices(p + i),
+						       sizeof(int32_t));
+			acc = _mm256_add_epi32(acc, _mm256_add_epi32(a, b));
+		}
+
+		int32_t result[8];
+		_mm256_storeu_si256((__m256i *)result, acc);
+
+		for (const int32_t i : result) {
+			*dest = i;
+			dest += dest_stride;
+		}
+	}
+
+	return t;
+}
+
+#endif
+
+/**
+ * Calculate output samples from #BlockDsd2Pcm's linear buffer.
+ *
+ * @param linear the linear buffer; it contains
+ * #BlockDsd2Pcm::HISTORY bytes more than #n
+ * @param n the number of output samples
+ */
+static void
+TranslateBlock(const uint8_t *linear, size_t n,
+	       float *dest, size_t dest_stride) noexcept
+{
+	size_t t = 0;
+
+#ifdef HAVE_PCM_SIMD_X86
+	if (GetPcmSimd() >= PcmSimd::AVX2)
+		t = TranslateBlock_AVX2(linear, n, dest, dest_stride);
+#endif
+
+	for (dest += t * dest_stride; t < n; ++t, dest += dest_stride)
+		*dest = CalcBlockSample(linear + t);
+}
+
+static void
+TranslateBlock(const uint8_t *linear, size_t n,
+	       int32_t *dest, size_t dest_stride) noexcept
+{
+	size_t t = 0;
+
+#ifdef HAVE_PCM_SIMD_X86
+	if (GetPcmSimd() >= PcmSimd::AVX2)
+		t = TranslateBlockS24_AVX2(linear, n, dest, dest_stride);
+#endif
+
+	for (dest += t * dest_stride; t < n; ++t, dest += dest_stride)
+		*dest = CalcBlockSampleS24(linear + t);
+}
+
+void
+BlockDsd2Pcm::Reset() noexcept
+{
+	/* this is the state of a freshly reset #Dsd2Pcm FIFO (filled
+	   with 0x69): of the bytes at the older half of the filter
+	   taps, only the newest one gets bit-reversed before it is
+	   used, so the others must be stored reversed here to cancel
+	   out the reversed tables */
+	for (auto &h : history) {
+		std::fill_n(h.begin(), HISTORY - CTABLES, 0x96);
+		std::fill_n(h.begin() + HISTORY - CTABLES, CTABLES, 0x69);
+	}
+}
+
+template<typename T>
+inline void
+BlockDsd2Pcm::TranslateChannels(unsigned channels, size_t n_frames,
+				const uint8_t *src, T *dest) noexcept
+{
+	assert(channels <= history.max_size());
+
+	while (n_frames > 0) {
+		const size_t n = std::min(n_frames, BLOCK_SIZE);
+
+		for (unsigned c = 0; c < channels; ++c) {
+			auto &h = history[c];
+
+			std::copy(h.begin(), h.end(), linear);
+			for (size_t i = 0; i < n; ++i)
+				linear[HISTORY + i] = src[i * channels + c];
+
+			TranslateBlock(linear, n, dest + c, channels);
+
+			std::copy_n(linear + n, HISTORY, h.begin());
+		}
+
+		src += n * channels;
+		dest += n * channels;
+		n_frames -= n;
+	}
+}
+
+void
+BlockDsd2Pcm::Translate(unsigned channels, size_t n_frames,
+			const uint8_t *src, float *dest) noexcept
+{
+	TranslateChannels(channels, n_frames, src, dest);
+}
+
+void
+BlockDsd2Pcm::TranslateS24(unsigned channels, size_t n_frames,
+			   const uint8_t *src, int32_t *dest) noexcept
+{
+	TranslateChannels(channels, n_frames, src, dest);
+}
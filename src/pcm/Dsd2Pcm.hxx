@@ -120,5 +120,62 @@ private:
 				const uint8_t *src, int32_t *dest) noexcept;
 };
 
+/**
+ * A block-oriented implementation of #MultiDsd2Pcm with bit-identical
+ * output.  Instead of feeding each byte through a FIFO, it copies the
+ * input of one channel into a linear buffer (behind the bytes it
+ * remembers from the previous call), and then calculates many output
+ * samples from that buffer.  This eliminates the FIFO bookkeeping
+ * and the in-place bit reversal, and allows calculating 8 samples at
+ * once with AVX2.
+ */
+class BlockDsd2Pcm {
+public:
+	/**
+	 * The number of past input bytes (per channel) an output
+	 * sample depends on.
+	 */
+	static constexpr size_t HISTORY = 11;
+
+private:
+	/**
+	 * The number of frames processed in one pass.
+	 */
+	static constexpr size_t BLOCK_SIZE = 1024;
+
+	/**
+	 * The last #HISTORY input bytes of each channel (oldest
+	 * first).
+	 */
+	std::array<std::array<uint8_t, HISTORY>, MAX_CHANNELS> history;
+
+	/**
+	 * The #history of the current channel, followed by its input
+	 * for the current pass.
+	 */
+	uint8_t linear[HISTORY + BLOCK_SIZE];
+
+public:
+	BlockDsd2Pcm() noexcept {
+		Reset();
+	}
+
+	/**
+	 * resets the internal state for a fresh new stream
+	 */
+	void Reset() noexcept;
+
+	void Translate(unsigned channels, size_t n_frames,
+		       const uint8_t *src, float *dest) noexcept;
+
+	void TranslateS24(unsigned channels, size_t n_frames,
+			  const uint8_t *src, int32_t *dest) noexcept;
+
+private:
+	template<typename T>
+	void TranslateChannels(unsigned channels, size_t n_frames,
+			       const uint8_t *src, T *dest) noexcept;
+};
+
 #endif /* include guard DSD2PCM_H_INCLUDED */
 
@@ -0,0 +1,678 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "FormatSimd.hxx"
+#include "Simd.hxx"
+#include "FloatConvert.hxx"
+
+#ifdef HAVE_PCM_SIMD_X86
+#include <immintrin.h>
+
+#include <cstring>
+
+static constexpr float S16_TO_FLOAT =
+	IntegerToFloatSampleConvert<SampleFormat::S16>::factor;
+static constexpr float S24_TO_FLOAT =
+	IntegerToFloatSampleConvert<SampleFormat::S24_P32>::factor;
+static constexpr float S32_TO_FLOAT =
+	IntegerToFloatSampleConvert<SampleFormat::S32>::factor;
+
+static constexpr float FLOAT_TO_S16 =
+	FloatToIntegerSampleConvert<SampleFormat::S16>::factor;
+static constexpr float FLOAT_TO_S24 =
+	FloatToIntegerSampleConvert<SampleFormat::S24_P32>::factor;
+static constexpr float FLOAT_TO_S32 =
+	FloatToIntegerSampleConvert<SampleFormat::S32>::factor;
+
+/**
+ * Shift the signed 16 bit values in the lower half of the vector to
+ * the upper half of 32 bit values, i.e. multiply with 65536.
+ */
+PCM_SSE2_TARGET
+static inline __m128i
+Unpack16To32Lo(__m128i x) noexcept
+{
+	return _mm_unpacklo_epi16(_mm_setzero_si128(), x);
+}
+
+PCM_SSE2_TARGET
+static inline __m128i
+Unpack16To32Hi(__m128i x) noexcept
+{
+	return _mm_unpackhi_epi16(_mm_setzero_si128(), x);
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert16To24_SSE2(int32_t *dest, const int16_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_srai_epi32(Unpack16To32Lo(s), 8));
+		_mm_storeu_si128((__m128i *)(dest + i + 4),
+				 _mm_srai_epi32(Unpack16To32Hi(s), 8));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert16To32_SSE2(int32_t *dest, const int16_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), Unpack16To32Lo(s));
+		_mm_storeu_si128((__m128i *)(dest + i + 4), Unpack16To32Hi(s));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert24To32_SSE2(int32_t *dest, const int32_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_slli_epi32(s, 8));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert32To24_SSE2(int32_t *dest, const int32_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_srai_epi32(s, 8));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert16ToFloat_SSE2(float *dest, const int16_t *src, size_t n) noexcept
+{
+	const __m128 factor = _mm_set1_ps(S16_TO_FLOAT);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i lo = _mm_srai_epi32(Unpack16To32Lo(s), 16);
+		const __m128i hi = _mm_srai_epi32(Unpack16To32Hi(s), 16);
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), factor));
+		_mm_storeu_ps(dest + i + 4,
+			      _mm_mul_ps(_mm_cvtepi32_ps(hi), factor));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+ConvertS32ToFloat_SSE2(float *dest, const int32_t *src, size_t n,
+		       float _factor) noexcept
+{
+	const __m128 factor = _mm_set1_ps(_factor);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(s), factor));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert24ToFloat_SSE2(float *dest, const int32_t *src, size_t n) noexcept
+{
+	return ConvertS32ToFloat_SSE2(dest, src, n, S24_TO_FLOAT);
+}
+
+PCM_SSE2_TARGET
+static size_t
+Convert32ToFloat_SSE2(float *dest, const int32_t *src, size_t n) noexcept
+{
+	return ConvertS32ToFloat_SSE2(dest, src, n, S32_TO_FLOAT);
+}
+
+PCM_SSE2_TARGET
+static size_t
+ConvertFloatTo16_SSE2(int16_t *dest, const float *src, size_t n) noexcept
+{
+	const __m128 factor = _mm_set1_ps(FLOAT_TO_S16);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		/* truncate (like the C cast), then clamp while
+		   packing */
+		const __m128i lo =
+			_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i),
+						    factor));
+		const __m128i hi =
+			_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4),
+						    factor));
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_packs_epi32(lo, hi));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+ConvertFloatTo24_SSE2(int32_t *dest, const float *src, size_t n) noexcept
+{
+	const __m128 factor = _mm_set1_ps(FLOAT_TO_S24);
+
+	/* both limits are exact in single precision, so clamping
+	   before the truncation is equivalent to clamping after
+	   it */
+	const __m128 min = _mm_set1_ps(SampleTraits<SampleFormat::S24_P32>::MIN);
+	const __m128 max = _mm_set1_ps(SampleTraits<SampleFormat::S24_P32>::MAX);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), factor);
+		s = _mm_max_ps(_mm_min_ps(s, max), min);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_cvttps_epi32(s));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+ConvertFloatTo32_SSE2(int32_t *dest, const float *src, size_t n) noexcept
+{
+	const __m128 factor = _mm_set1_ps(FLOAT_TO_S32);
+	const __m128 limit = _mm_set1_ps(FLOAT_TO_S32);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), factor);
+
+		/* out-of-range values become INT32_MIN; this is
+		   correct for negative values, and flipping all bits
+		   turns it into INT32_MAX for positive ones */
+		const __m128i overflow = _mm_castps_si128(_mm_cmpge_ps(s, limit));
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_xor_si128(_mm_cvttps_epi32(s), overflow));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert16To24_AVX2(int32_t *dest, const int16_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_slli_epi32(_mm256_cvtepi16_epi32(s), 8));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert16To32_AVX2(int32_t *dest, const int16_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_slli_epi32(_mm256_cvtepi16_epi32(s), 16));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert24To32_AVX2(int32_t *dest, const int32_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_slli_epi32(s, 8));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert32To24_AVX2(int32_t *dest, const int32_t *src, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_srai_epi32(s, 8));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert16ToFloat_AVX2(float *dest, const int16_t *src, size_t n) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(S16_TO_FLOAT);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s));
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(f, factor));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+ConvertS32ToFloat_AVX2(float *dest, const int32_t *src, size_t n,
+		       float _factor) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(_factor);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_ps(dest + i,
+				 _mm256_mul_ps(_mm256_cvtepi32_ps(s), factor));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert24ToFloat_AVX2(float *dest, const int32_t *src, size_t n) noexcept
+{
+	return ConvertS32ToFloat_AVX2(dest, src, n, S24_TO_FLOAT);
+}
+
+PCM_AVX2_TARGET
+static size_t
+Convert32ToFloat_AVX2(float *dest, const int32_t *src, size_t n) noexcept
+{
+	return ConvertS32ToFloat_AVX2(dest, src, n, S32_TO_FLOAT);
+}
+
+PCM_AVX2_TARGET
+static size_t
+ConvertFloatTo16_AVX2(int16_t *dest, const float *src, size_t n) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(FLOAT_TO_S16);
+
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m256i lo =
+			_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i),
+							  factor));
+		const __m256i hi =
+			_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8),
+							  factor));
+
+		/* packing works on each 128 bit lane; restore the
+		   order afterwards */
+		const __m256i packed =
+			_mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+						 0xd8);
+		_mm256_storeu_si256((__m256i *)(dest + i), packed);
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+ConvertFloatTo24_AVX2(int32_t *dest, const float *src, size_t n) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(FLOAT_TO_S24);
+	const __m256 min = _mm256_set1_ps(SampleTraits<SampleFormat::S24_P32>::MIN);
+	const __m256 max = _mm256_set1_ps(SampleTraits<SampleFormat::S24_P32>::MAX);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), factor);
+		s = _mm256_max_ps(_mm256_min_ps(s, max), min);
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_cvttps_epi32(s));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+ConvertFloatTo32_AVX2(int32_t *dest, const float *src, size_t n) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(FLOAT_TO_S32);
+	const __m256 limit = _mm256_set1_ps(FLOAT_TO_S32);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), factor);
+		const __m256i overflow =
+			_mm256_castps_si256(_mm256_cmp_ps(s, limit, _CMP_GE_OQ));
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_xor_si256(_mm256_cvttps_epi32(s),
+						     overflow));
+	}
+
+	return i;
+}
+
+/*
+ * The 24 bit packing kernels need SSSE3's byte shuffle, and thus are
+ * only used with AVX2.
+ */
+
+PCM_AVX2_TARGET
+static size_t
+Pack24_AVX2(uint8_t *dest, const int32_t *src, size_t n) noexcept
+{
+	/* move the lower three bytes of each sample to the lower 12
+	   bytes of the vector */
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10,
+					      12, 13, 14, -1, -1, -1, -1);
+
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16, dest += 48) {
+		/* load everything before storing, because this may
+		   operate in-place */
+		const __m128i s0 = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i s1 = _mm_loadu_si128((const __m128i *)(src + i + 4));
+		const __m128i s2 = _mm_loadu_si128((const __m128i *)(src + i + 8));
+		const __m128i s3 = _mm_loadu_si128((const __m128i *)(src + i + 12));
+
+		/* each store writes 4 bytes of garbage which are
+		   overwritten by the next one */
+		_mm_storeu_si128((__m128i *)dest, _mm_shuffle_epi8(s0, shuffle));
+		_mm_storeu_si128((__m128i *)(dest + 12),
+				 _mm_shuffle_epi8(s1, shuffle));
+		_mm_storeu_si128((__m128i *)(dest + 24),
+				 _mm_shuffle_epi8(s2, shuffle));
+
+		/* .. except for the last one, which must not write
+		   past the end */
+		const __m128i d3 = _mm_shuffle_epi8(s3, shuffle);
+		_mm_storel_epi64((__m128i *)(dest + 36), d3);
+		const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(d3, 8));
+		memcpy(dest + 44, &tail, sizeof(tail));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+Unpack24_AVX2(int32_t *dest, const uint8_t *src, size_t n,
+	      bool big_endian) noexcept
+{
+	/* move each 24 bit sample to the upper three bytes of a 32
+	   bit integer, then shift it down, extending the sign */
+	const __m128i shuffle = big_endian
+		? _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3,
+				-1, 8, 7, 6, -1, 11, 10, 9)
+		: _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+				-1, 6, 7, 8, -1, 9, 10, 11);
+
+	/* the last vector is loaded 4 bytes early so it doesn't read
+	   past the end */
+	const __m128i shuffle3 = big_endian
+		? _mm_setr_epi8(-1, 6, 5, 4, -1, 9, 8, 7,
+				-1, 12, 11, 10, -1, 15, 14, 13)
+		: _mm_setr_epi8(-1, 4, 5, 6, -1, 7, 8, 9,
+				-1, 10, 11, 12, -1, 13, 14, 15);
+
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16, src += 48) {
+		const __m128i s0 = _mm_loadu_si128((const __m128i *)src);
+		const __m128i s1 = _mm_loadu_si128((const __m128i *)(src + 12));
+		const __m128i s2 = _mm_loadu_si128((const __m128i *)(src + 24));
+		const __m128i s3 = _mm_loadu_si128((const __m128i *)(src + 32));
+
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_srai_epi32(_mm_shuffle_epi8(s0, shuffle), 8));
+		_mm_storeu_si128((__m128i *)(dest + i + 4),
+				 _mm_srai_epi32(_mm_shuffle_epi8(s1, shuffle), 8));
+		_mm_storeu_si128((__m128i *)(dest + i + 8),
+				 _mm_srai_epi32(_mm_shuffle_epi8(s2, shuffle), 8));
+		_mm_storeu_si128((__m128i *)(dest + i + 12),
+				 _mm_srai_epi32(_mm_shuffle_epi8(s3, shuffle3), 8));
+	}
+
+	return i;
+}
+
+template<typename D, typename S>
+using Kernel = size_t (*)(D *dest, const S *src, size_t n) noexcept;
+
+template<typename D, typename S>
+static size_t
+Dispatch(PcmSimd simd, Kernel<D, S> sse2, Kernel<D, S> avx2,
+	 D *dest, const S *src, size_t n) noexcept
+{
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		return sse2(dest, src, n);
+
+	case PcmSimd::AVX2:
+		return avx2(dest, src, n);
+	}
+
+	return 0;
+}
+
+size_t
+PcmConvert16To24Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+		     size_t n) noexcept
+{
+	return Dispatch(simd, Convert16To24_SSE2, Convert16To24_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert16To32Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+		     size_t n) noexcept
+{
+	return Dispatch(simd, Convert16To32_SSE2, Convert16To32_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert24To32Simd(PcmSimd simd, int32_t *dest, const int32_t *src,
+		     size_t n) noexcept
+{
+	return Dispatch(simd, Convert24To32_SSE2, Convert24To32_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert32To24Simd(PcmSimd simd, int32_t *dest, const int32_t *src,
+		     size_t n) noexcept
+{
+	return Dispatch(simd, Convert32To24_SSE2, Convert32To24_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert16ToFloatSimd(PcmSimd simd, float *dest, const int16_t *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, Convert16ToFloat_SSE2, Convert16ToFloat_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert24ToFloatSimd(PcmSimd simd, float *dest, const int32_t *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, Convert24ToFloat_SSE2, Convert24ToFloat_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvert32ToFloatSimd(PcmSimd simd, float *dest, const int32_t *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, Convert32ToFloat_SSE2, Convert32ToFloat_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvertFloatTo16Simd(PcmSimd simd, int16_t *dest, const float *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, ConvertFloatTo16_SSE2, ConvertFloatTo16_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvertFloatTo24Simd(PcmSimd simd, int32_t *dest, const float *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, ConvertFloatTo24_SSE2, ConvertFloatTo24_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmConvertFloatTo32Simd(PcmSimd simd, int32_t *dest, const float *src,
+			size_t n) noexcept
+{
+	return Dispatch(simd, ConvertFloatTo32_SSE2, ConvertFloatTo32_AVX2,
+			dest, src, n);
+}
+
+size_t
+PcmPack24Simd(PcmSimd simd, uint8_t *dest, const int32_t *src,
+	      size_t n) noexcept
+{
+	return simd >= PcmSimd::AVX2
+		? Pack24_AVX2(dest, src, n)
+		: 0;
+}
+
+size_t
+PcmUnpack24Simd(PcmSimd simd, int32_t *dest, const uint8_t *src,
+		size_t n, bool big_endian) noexcept
+{
+	return simd >= PcmSimd::AVX2
+		? Unpack24_AVX2(dest, src, n, big_endian)
+		: 0;
+}
+
+#else
+
+size_t
+PcmConvert16To24Simd(PcmSimd, int32_t *, const int16_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert16To32Simd(PcmSimd, int32_t *, const int16_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert24To32Simd(PcmSimd, int32_t *, const int32_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert32To24Simd(PcmSimd, int32_t *, const int32_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert16ToFloatSimd(PcmSimd, float *, const int16_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert24ToFloatSimd(PcmSimd, float *, const int32_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvert32ToFloatSimd(PcmSimd, float *, const int32_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvertFloatTo16Simd(PcmSimd, int16_t *, const float *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvertFloatTo24Simd(PcmSimd, int32_t *, const float *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmConvertFloatTo32Simd(PcmSimd, int32_t *, const float *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmPack24Simd(PcmSimd, uint8_t *, const int32_t *, size_t) noexcept
+{
+	return 0;
+}
+
+size_t
+PcmUnpack24Simd(PcmSimd, int32_t *, const uint8_t *, size_t, bool) noexcept
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_FORMAT_SIMD_HXX
+#define MPD_PCM_FORMAT_SIMD_HXX
+
+#include <cstddef>
+#include <cstdint>
+
+enum class PcmSimd : uint8_t;
+
+/*
+ * Vectorized kernels for sample format conversion.  They produce
+ * exactly the same results as the generic code (for input within
+ * the range of the destination type).  Each function processes a
+ * prefix of the buffers and returns the number of samples it has
+ * processed; the caller handles the rest.
+ *
+ * Dithered conversions (to S16 from S24_P32 and S32) have no kernel,
+ * because the dither state carries from one sample to the next.
+ */
+
+size_t
+PcmConvert16To24Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+		     size_t n) noexcept;
+
+size_t
+PcmConvert16To32Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+		     size_t n) noexcept;
+
+size_t
+PcmConvert24To32Simd(PcmSimd simd, int32_t *dest, const int32_t *src,
+		     size_t n) noexcept;
+
+size_t
+PcmConvert32To24Simd(PcmSimd simd, int32_t *dest, const int32_t *src,
+		     size_t n) noexcept;
+
+size_t
+PcmConvert16ToFloatSimd(PcmSimd simd, float *dest, const int16_t *src,
+			size_t n) noexcept;
+
+size_t
+PcmConvert24ToFloatSimd(PcmSimd simd, float *dest, const int32_t *src,
+			size_t n) noexcept;
+
+size_t
+PcmConvert32ToFloatSimd(PcmSimd simd, float *dest, const int32_t *src,
+			size_t n) noexcept;
+
+size_t
+PcmConvertFloatTo16Simd(PcmSimd simd, int16_t *dest, const float *src,
+			size_t n) noexcept;
+
+size_t
+PcmConvertFloatTo24Simd(PcmSimd simd, int32_t *dest, const float *src,
+			size_t n) noexcept;
+
+size_t
+PcmConvertFloatTo32Simd(PcmSimd simd, int32_t *dest, const float *src,
+			size_t n) noexcept;
+
+/**
+ * Kernel for pcm_pack_24().  Like pcm_pack_24(), it may be used
+ * in-place.
+ */
+size_t
+PcmPack24Simd(PcmSimd simd, uint8_t *dest, const int32_t *src,
+	      size_t n) noexcept;
+
+/**
+ * Kernel for pcm_unpack_24() and pcm_unpack_24be().
+ */
+size_t
+PcmUnpack24Simd(PcmSimd simd, int32_t *dest, const uint8_t *src,
+		size_t n, bool big_endian) noexcept;
+
+#endif
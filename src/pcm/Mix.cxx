@@ -18,6 +18,8 @@
  */
 
 #include "Mix.hxx"
+#include "MixSimd.hxx"
+#include "Simd.hxx"
 #include "Volume.hxx"
 #include "Clamp.hxx"
 #include "Traits.hxx"
@@ -74,6 +76,13 @@ static void
 pcm_add_vol_float(float *buffer1, const float *buffer2,
 		  unsigned num_samples, float volume1, float volume2) noexcept
 {
+	const size_t n = PcmAddVolumeFloatSimd(GetPcmSimd(),
+					       buffer1, buffer2, num_samples,
+					       volume1, volume2);
+	buffer1 += n;
+	buffer2 += n;
+	num_samples -= n;
+
 	while (num_samples > 0) {
 		float sample1 = *buffer1;
 		float sample2 = *buffer2++;
@@ -178,6 +187,18 @@ static bool
 pcm_add(void *buffer1, const void *buffer2, size_t size,
 	SampleFormat format) noexcept
 {
+	const size_t sample_size = sample_format_size(format);
+	if (sample_size > 0) {
+		/* let the vectorized kernel do the bulk of the work;
+		   the generic code below handles the rest */
+		const size_t n = PcmAddSimd(GetPcmSimd(), format,
+					    buffer1, buffer2,
+					    size / sample_size);
+		buffer1 = (uint8_t *)buffer1 + n * sample_size;
+		buffer2 = (const uint8_t *)buffer2 + n * sample_size;
+		size -= n * sample_size;
+	}
+
 	switch (format) {
 	case SampleFormat::UNDEFINED:
 	case SampleFormat::DSD:
@@ -0,0 +1,373 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MixSimd.hxx"
+#include "Simd.hxx"
+#include "SampleFormat.hxx"
+
+#ifdef HAVE_PCM_SIMD_X86
+#include <immintrin.h>
+
+static constexpr int32_t S24_MIN = -0x800000;
+static constexpr int32_t S24_MAX = 0x7fffff;
+
+/**
+ * Select #a where #mask is set, #b elsewhere.
+ */
+PCM_SSE2_TARGET
+static inline __m128i
+Select(__m128i mask, __m128i a, __m128i b) noexcept
+{
+	return _mm_or_si128(_mm_and_si128(mask, a),
+			    _mm_andnot_si128(mask, b));
+}
+
+/**
+ * Add with 32 bit signed saturation.
+ */
+PCM_SSE2_TARGET
+static inline __m128i
+AddSaturate32(__m128i a, __m128i b) noexcept
+{
+	const __m128i sum = _mm_add_epi32(a, b);
+
+	/* overflow if both operands have the same sign and the sign
+	   of the sum differs */
+	const __m128i overflow =
+		_mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(a, b),
+						_mm_xor_si128(a, sum)), 31);
+
+	/* INT32_MAX for positive operands, INT32_MIN for negative
+	   ones */
+	const __m128i saturated =
+		_mm_xor_si128(_mm_srai_epi32(a, 31),
+			      _mm_set1_epi32(0x7fffffff));
+
+	return Select(overflow, saturated, sum);
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddS8_SSE2(int8_t *a, const int8_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		_mm_storeu_si128((__m128i *)(a + i), _mm_adds_epi8(va, vb));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddS16_SSE2(int16_t *a, const int16_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		_mm_storeu_si128((__m128i *)(a + i), _mm_adds_epi16(va, vb));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddS24_SSE2(int32_t *a, const int32_t *b, size_t n) noexcept
+{
+	const __m128i min = _mm_set1_epi32(S24_MIN);
+	const __m128i max = _mm_set1_epi32(S24_MAX);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+
+		/* 24 bit samples cannot overflow 32 bits */
+		__m128i sum = _mm_add_epi32(va, vb);
+		sum = Select(_mm_cmpgt_epi32(sum, max), max, sum);
+		sum = Select(_mm_cmplt_epi32(sum, min), min, sum);
+
+		_mm_storeu_si128((__m128i *)(a + i), sum);
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddS32_SSE2(int32_t *a, const int32_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		_mm_storeu_si128((__m128i *)(a + i), AddSaturate32(va, vb));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddFloat_SSE2(float *a, const float *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(a + i, _mm_add_ps(_mm_loadu_ps(a + i),
+						_mm_loadu_ps(b + i)));
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmAddVolumeFloat_SSE2(float *a, const float *b, size_t n,
+		       float volume1, float volume2) noexcept
+{
+	const __m128 v1 = _mm_set1_ps(volume1);
+	const __m128 v2 = _mm_set1_ps(volume2);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 va = _mm_mul_ps(_mm_loadu_ps(a + i), v1);
+		const __m128 vb = _mm_mul_ps(_mm_loadu_ps(b + i), v2);
+		_mm_storeu_ps(a + i, _mm_add_ps(va, vb));
+	}
+
+	return i;
+}
+
+/**
+ * Add with 32 bit signed saturation.
+ */
+PCM_AVX2_TARGET
+static inline __m256i
+AddSaturate32(__m256i a, __m256i b) noexcept
+{
+	const __m256i sum = _mm256_add_epi32(a, b);
+	const __m256i overflow =
+		_mm256_srai_epi32(_mm256_andnot_si256(_mm256_xor_si256(a, b),
+						      _mm256_xor_si256(a, sum)), 31);
+	const __m256i saturated =
+		_mm256_xor_si256(_mm256_srai_epi32(a, 31),
+				 _mm256_set1_epi32(0x7fffffff));
+
+	return _mm256_blendv_epi8(sum, saturated, overflow);
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddS8_AVX2(int8_t *a, const int8_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i),
+				    _mm256_adds_epi8(va, vb));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddS16_AVX2(int16_t *a, const int16_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i),
+				    _mm256_adds_epi16(va, vb));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddS24_AVX2(int32_t *a, const int32_t *b, size_t n) noexcept
+{
+	const __m256i min = _mm256_set1_epi32(S24_MIN);
+	const __m256i max = _mm256_set1_epi32(S24_MAX);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+
+		/* 24 bit samples cannot overflow 32 bits */
+		__m256i sum = _mm256_add_epi32(va, vb);
+		sum = _mm256_max_epi32(_mm256_min_epi32(sum, max), min);
+
+		_mm256_storeu_si256((__m256i *)(a + i), sum);
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddS32_AVX2(int32_t *a, const int32_t *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i),
+				    AddSaturate32(va, vb));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddFloat_AVX2(float *a, const float *b, size_t n) noexcept
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(a + i,
+				 _mm256_add_ps(_mm256_loadu_ps(a + i),
+					       _mm256_loadu_ps(b + i)));
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmAddVolumeFloat_AVX2(float *a, const float *b, size_t n,
+		       float volume1, float volume2) noexcept
+{
+	const __m256 v1 = _mm256_set1_ps(volume1);
+	const __m256 v2 = _mm256_set1_ps(volume2);
+
+	/* no FMA: the generic code rounds after each
+	   multiplication */
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 va = _mm256_mul_ps(_mm256_loadu_ps(a + i), v1);
+		const __m256 vb = _mm256_mul_ps(_mm256_loadu_ps(b + i), v2);
+		_mm256_storeu_ps(a + i, _mm256_add_ps(va, vb));
+	}
+
+	return i;
+}
+
+#endif
+
+size_t
+PcmAddSimd(PcmSimd simd, SampleFormat format,
+	   void *a, const void *b, size_t n) noexcept
+{
+#ifdef HAVE_PCM_SIMD_X86
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		switch (format) {
+		case SampleFormat::UNDEFINED:
+		case SampleFormat::DSD:
+			break;
+
+		case SampleFormat::S8:
+			return PcmAddS8_SSE2((int8_t *)a, (const int8_t *)b, n);
+
+		case SampleFormat::S16:
+			return PcmAddS16_SSE2((int16_t *)a, (const int16_t *)b, n);
+
+		case SampleFormat::S24_P32:
+			return PcmAddS24_SSE2((int32_t *)a, (const int32_t *)b, n);
+
+		case SampleFormat::S32:
+			return PcmAddS32_SSE2((int32_t *)a, (const int32_t *)b, n);
+
+		case SampleFormat::FLOAT:
+			return PcmAddFloat_SSE2((float *)a, (const float *)b, n);
+		}
+
+		break;
+
+	case PcmSimd::AVX2:
+		switch (format) {
+		case SampleFormat::UNDEFINED:
+		case SampleFormat::DSD:
+			break;
+
+		case SampleFormat::S8:
+			return PcmAddS8_AVX2((int8_t *)a, (const int8_t *)b, n);
+
+		case SampleFormat::S16:
+			return PcmAddS16_AVX2((int16_t *)a, (const int16_t *)b, n);
+
+		case SampleFormat::S24_P32:
+			return PcmAddS24_AVX2((int32_t *)a, (const int32_t *)b, n);
+
+		case SampleFormat::S32:
+			return PcmAddS32_AVX2((int32_t *)a, (const int32_t *)b, n);
+
+		case SampleFormat::FLOAT:
+			return PcmAddFloat_AVX2((float *)a, (const float *)b, n);
+		}
+
+		break;
+	}
+#else
+	(void)simd;
+	(void)format;
+	(void)a;
+	(void)b;
+	(void)n;
+#endif
+
+	return 0;
+}
+
+size_t
+PcmAddVolumeFloatSimd(PcmSimd simd, float *a, const float *b, size_t n,
+		      float volume1, float volume2) noexcept
+{
+#ifdef HAVE_PCM_SIMD_X86
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		return PcmAddVolumeFloat_SSE2(a, b, n, volume1, volume2);
+
+	case PcmSimd::AVX2:
+		return PcmAddVolumeFloat_AVX2(a, b, n, volume1, volume2);
+	}
+#else
+	(void)simd;
+	(void)a;
+	(void)b;
+	(void)n;
+	(void)volume1;
+	(void)volume2;
+#endif
+
+	return 0;
+}
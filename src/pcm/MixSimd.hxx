@@ -0,0 +1,53 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_MIX_SIMD_HXX
+#define MPD_PCM_MIX_SIMD_HXX
+
+#include <cstddef>
+#include <cstdint>
+
+enum class PcmSimd : uint8_t;
+enum class SampleFormat : uint8_t;
+
+/*
+ * Vectorized kernels for pcm_mix().  They produce exactly the same
+ * results as the generic code.  Each function processes a prefix of
+ * the buffers (a multiple of the vector width) and returns the number
+ * of samples it has processed; the caller handles the rest.
+ */
+
+/**
+ * Add the samples of #b to #a, clamping to the sample format's
+ * range (MixRamp mixing).
+ */
+size_t
+PcmAddSimd(PcmSimd simd, SampleFormat format,
+	   void *a, const void *b, size_t n) noexcept;
+
+/**
+ * Calculate a=a*volume1+b*volume2 (cross-fading of floating point
+ * samples).  Integer samples are dithered one by one, which cannot be
+ * vectorized.
+ */
+size_t
+PcmAddVolumeFloatSimd(PcmSimd simd, float *a, const float *b, size_t n,
+		      float volume1, float volume2) noexcept;
+
+#endif
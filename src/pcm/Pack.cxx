@@ -18,6 +18,8 @@
  */
 
 #include "Pack.hxx"
+#include "FormatSimd.hxx"
+#include "Simd.hxx"
 #include "util/ByteOrder.hxx"
 
 static void
@@ -39,6 +41,13 @@ pcm_pack_24(uint8_t *dest, const int32_t *src, const int32_t *src_end) noexcept
 	/* duplicate loop to help the compiler's optimizer (constant
 	   parameter to the pack_sample() inline function) */
 
+	if (!IsBigEndian()) {
+		const size_t n = PcmPack24Simd(GetPcmSimd(), dest, src,
+					       src_end - src);
+		src += n;
+		dest += n * 3;
+	}
+
 	while (src < src_end) {
 		pack_sample(dest, src++);
 		dest += 3;
@@ -90,6 +99,13 @@ void
 pcm_unpack_24(int32_t *dest,
 	      const uint8_t *src, const uint8_t *src_end) noexcept
 {
+	if (!IsBigEndian()) {
+		const size_t n = PcmUnpack24Simd(GetPcmSimd(), dest, src,
+						 (src_end - src) / 3, false);
+		dest += n;
+		src += n * 3;
+	}
+
 	while (src < src_end) {
 		*dest++ = ReadS24(src);
 		src += 3;
@@ -100,6 +116,13 @@ void
 pcm_unpack_24be(int32_t *dest,
 		const uint8_t *src, const uint8_t *src_end) noexcept
 {
+	if (!IsBigEndian()) {
+		const size_t n = PcmUnpack24Simd(GetPcmSimd(), dest, src,
+						 (src_end - src) / 3, true);
+		dest += n;
+		src += n * 3;
+	}
+
 	while (src < src_end) {
 		*dest++ = ReadS24BE(src);
 		src += 3;
@@ -35,7 +35,10 @@ PcmDsd::ToFloat(unsigned channels, ConstBuffer<uint8_t> src) noexcept
 
 	auto *dest = buffer.GetT<float>(num_samples);
 
-	dsd2pcm.Translate(channels, num_frames, src.data, dest);
+	if (engine == Dsd2PcmEngine::BLOCK)
+		block_dsd2pcm.Translate(channels, num_frames, src.data, dest);
+	else
+		dsd2pcm.Translate(channels, num_frames, src.data, dest);
 	return { dest, num_samples };
 }
 
@@ -51,6 +54,10 @@ PcmDsd::ToS24(unsigned channels, ConstBuffer<uint8_t> src) noexcept
 
 	auto *dest = buffer.GetT<int32_t>(num_samples);
 
-	dsd2pcm.TranslateS24(channels, num_frames, src.data, dest);
+	if (engine == Dsd2PcmEngine::BLOCK)
+		block_dsd2pcm.TranslateS24(channels, num_frames, src.data,
+					   dest);
+	else
+		dsd2pcm.TranslateS24(channels, num_frames, src.data, dest);
 	return { dest, num_samples };
 }
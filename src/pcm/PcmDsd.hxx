@@ -27,17 +27,39 @@
 
 template<typename T> struct ConstBuffer;
 
+/**
+ * Selects a dsd2pcm implementation.  They produce identical output.
+ */
+enum class Dsd2PcmEngine : uint8_t {
+	/**
+	 * #MultiDsd2Pcm: one byte at a time through a FIFO.
+	 */
+	CLASSIC,
+
+	/**
+	 * #BlockDsd2Pcm: vectorized, operating on blocks.
+	 */
+	BLOCK,
+};
+
 /**
  * Wrapper for the dsd2pcm library.
  */
 class PcmDsd {
 	PcmBuffer buffer;
 
+	const Dsd2PcmEngine engine;
+
 	MultiDsd2Pcm dsd2pcm;
+	BlockDsd2Pcm block_dsd2pcm;
 
 public:
+	explicit PcmDsd(Dsd2PcmEngine _engine=Dsd2PcmEngine::BLOCK) noexcept
+		:engine(_engine) {}
+
 	void Reset() noexcept {
 		dsd2pcm.Reset();
+		block_dsd2pcm.Reset();
 	}
 
 	ConstBuffer<float> ToFloat(unsigned channels,
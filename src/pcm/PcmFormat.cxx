@@ -18,6 +18,8 @@
  */
 
 #include "PcmFormat.hxx"
+#include "FormatSimd.hxx"
+#include "Simd.hxx"
 #include "Buffer.hxx"
 #include "Traits.hxx"
 #include "FloatConvert.hxx"
@@ -104,6 +106,33 @@ public:
 	}
 };
 
+/**
+ * Adapter for a kernel from FormatSimd.hxx, to be used as the
+ * "optimized" algorithm in #GlueOptimizedConvert.  The kernel is
+ * selected at runtime; the "portable" algorithm converts the samples
+ * it leaves over.
+ */
+template<typename Portable, auto kernel>
+struct SimdConvert {
+	using SrcTraits = typename Portable::SrcTraits;
+	using DstTraits = typename Portable::DstTraits;
+
+	static constexpr size_t BLOCK_SIZE = 16;
+
+	void Convert(typename DstTraits::pointer out,
+		     typename SrcTraits::const_pointer in,
+		     size_t n) const {
+		n -= n % BLOCK_SIZE;
+
+		const size_t done = kernel(GetPcmSimd(), out, in, n);
+		Portable().Convert(out + done, in + done, n - done);
+	}
+};
+
+template<typename Portable, auto kernel>
+using GlueSimdConvert =
+	GlueOptimizedConvert<SimdConvert<Portable, kernel>, Portable>;
+
 #ifdef __ARM_NEON__
 #include "Neon.hxx"
 
@@ -112,8 +141,26 @@ struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
 	: GlueOptimizedConvert<NeonFloatTo16,
 			       PortableFloatToInteger<SampleFormat::S16>> {};
 
+#else
+
+template<>
+struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
+	: GlueSimdConvert<PortableFloatToInteger<SampleFormat::S16>,
+			  PcmConvertFloatTo16Simd> {};
+
 #endif
 
+template<>
+struct FloatToInteger<SampleFormat::S24_P32,
+		      SampleTraits<SampleFormat::S24_P32>>
+	: GlueSimdConvert<PortableFloatToInteger<SampleFormat::S24_P32>,
+			  PcmConvertFloatTo24Simd> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S32, SampleTraits<SampleFormat::S32>>
+	: GlueSimdConvert<PortableFloatToInteger<SampleFormat::S32>,
+			  PcmConvertFloatTo32Simd> {};
+
 template<class C>
 static ConstBuffer<typename C::DstTraits::value_type>
 AllocateConvert(PcmBuffer &buffer, C convert,
@@ -194,8 +241,9 @@ struct Convert8To24
 						  SampleFormat::S24_P32>> {};
 
 struct Convert16To24
-	: PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S16,
-						  SampleFormat::S24_P32>> {};
+	: GlueSimdConvert<PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S16,
+								  SampleFormat::S24_P32>>,
+			  PcmConvert16To24Simd> {};
 
 static ConstBuffer<int32_t>
 pcm_allocate_8_to_24(PcmBuffer &buffer, ConstBuffer<int8_t> src)
@@ -210,8 +258,9 @@ pcm_allocate_16_to_24(PcmBuffer &buffer, ConstBuffer<int16_t> src)
 }
 
 struct Convert32To24
-	: PerSampleConvert<RightShiftSampleConvert<SampleFormat::S32,
-						   SampleFormat::S24_P32>> {};
+	: GlueSimdConvert<PerSampleConvert<RightShiftSampleConvert<SampleFormat::S32,
+								   SampleFormat::S24_P32>>,
+			  PcmConvert32To24Simd> {};
 
 static ConstBuffer<int32_t>
 pcm_allocate_32_to_24(PcmBuffer &buffer, ConstBuffer<int32_t> src)
@@ -262,12 +311,14 @@ struct Convert8To32
 						  SampleFormat::S32>> {};
 
 struct Convert16To32
-	: PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S16,
-						  SampleFormat::S32>> {};
+	: GlueSimdConvert<PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S16,
+								  SampleFormat::S32>>,
+			  PcmConvert16To32Simd> {};
 
 struct Convert24To32
-	: PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S24_P32,
-						  SampleFormat::S32>> {};
+	: GlueSimdConvert<PerSampleConvert<LeftShiftSampleConvert<SampleFormat::S24_P32,
+								  SampleFormat::S32>>,
+			  PcmConvert24To32Simd> {};
 
 static ConstBuffer<int32_t>
 pcm_allocate_8_to_32(PcmBuffer &buffer, ConstBuffer<int8_t> src)
@@ -329,13 +380,16 @@ struct Convert8ToFloat
 	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S8>> {};
 
 struct Convert16ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S16>> {};
+	: GlueSimdConvert<PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S16>>,
+			  PcmConvert16ToFloatSimd> {};
 
 struct Convert24ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S24_P32>> {};
+	: GlueSimdConvert<PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S24_P32>>,
+			  PcmConvert24ToFloatSimd> {};
 
 struct Convert32ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S32>> {};
+	: GlueSimdConvert<PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S32>>,
+			  PcmConvert32ToFloatSimd> {};
 
 static ConstBuffer<float>
 pcm_allocate_8_to_float(PcmBuffer &buffer, ConstBuffer<int8_t> src)
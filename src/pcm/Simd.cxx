@@ -0,0 +1,69 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Simd.hxx"
+
+#include <algorithm>
+
+PcmSimd
+DetectPcmSimd() noexcept
+{
+#ifdef HAVE_PCM_SIMD_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		return PcmSimd::AVX2;
+
+	if (__builtin_cpu_supports("sse2"))
+		return PcmSimd::SSE2;
+#endif
+
+	return PcmSimd::NONE;
+}
+
+static PcmSimd pcm_simd = DetectPcmSimd();
+
+PcmSimd
+GetPcmSimd() noexcept
+{
+	return pcm_simd;
+}
+
+void
+SetPcmSimd(PcmSimd simd) noexcept
+{
+	pcm_simd = std::min(simd, DetectPcmSimd());
+}
+
+const char *
+ToString(PcmSimd simd) noexcept
+{
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		return "sse2";
+
+	case PcmSimd::AVX2:
+		return "avx2";
+	}
+
+	return "none";
+}
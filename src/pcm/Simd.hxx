@@ -0,0 +1,77 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_SIMD_HXX
+#define MPD_PCM_SIMD_HXX
+
+#include "util/Compiler.h"
+
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+/**
+ * x86 kernels are built with GCC's "target" attribute, regardless of
+ * the compiler flags, and are selected at runtime.
+ */
+#define HAVE_PCM_SIMD_X86
+#define PCM_SSE2_TARGET __attribute__((target("sse2")))
+#define PCM_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+/**
+ * An instruction set extension which may be used by the PCM
+ * kernels.  The values are ordered: each one implies all smaller
+ * ones.
+ */
+enum class PcmSimd : uint8_t {
+	NONE,
+	SSE2,
+	AVX2,
+};
+
+/**
+ * Determine the best #PcmSimd supported by this CPU (and by this
+ * build).
+ */
+gcc_const
+PcmSimd
+DetectPcmSimd() noexcept;
+
+/**
+ * Returns the #PcmSimd which shall be used by the PCM kernels.  This
+ * is the result of DetectPcmSimd(), unless overridden with
+ * SetPcmSimd().
+ */
+gcc_pure
+PcmSimd
+GetPcmSimd() noexcept;
+
+/**
+ * Override the #PcmSimd to be used, e.g. for comparing the kernels
+ * in unit tests and benchmarks.  Values not supported by this CPU
+ * are reduced to what DetectPcmSimd() returns.
+ */
+void
+SetPcmSimd(PcmSimd simd) noexcept;
+
+gcc_const
+const char *
+ToString(PcmSimd simd) noexcept;
+
+#endif
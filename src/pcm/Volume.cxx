@@ -18,6 +18,8 @@
  */
 
 #include "Volume.hxx"
+#include "VolumeSimd.hxx"
+#include "Simd.hxx"
 #include "Silence.hxx"
 #include "Traits.hxx"
 #include "util/ConstBuffer.hxx"
@@ -123,6 +125,12 @@ static void
 PcmVolumeChange16to32(int32_t *dest, const int16_t *src, size_t n,
 		      int volume) noexcept
 {
+	const size_t done = PcmVolumeChange16to32Simd(GetPcmSimd(),
+						      dest, src, n, volume);
+	dest += done;
+	src += done;
+	n -= done;
+
 	transform_n(src, n, dest,
 		    [volume](auto x){
 			    return PcmVolumeConvert<SampleFormat::S16,
@@ -152,6 +160,12 @@ static void
 pcm_volume_change_float(float *dest, const float *src, size_t n,
 			float volume) noexcept
 {
+	const size_t done = PcmVolumeChangeFloatSimd(GetPcmSimd(),
+						     dest, src, n, volume);
+	dest += done;
+	src += done;
+	n -= done;
+
 	transform_n(src, n, dest,
 		    [volume](float x){ return x * volume; });
 }
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "VolumeSimd.hxx"
+#include "Simd.hxx"
+#include "Volume.hxx"
+
+#ifdef HAVE_PCM_SIMD_X86
+#include <immintrin.h>
+
+/**
+ * The S16 sample is multiplied with the volume, which leaves 16 +
+ * #PCM_VOLUME_BITS bits; shift to 24 bits.
+ */
+static constexpr int S16_TO_S24_SHIFT = 16 + PCM_VOLUME_BITS - 24;
+
+/**
+ * The kernels multiply with a 16 bit volume.
+ */
+static constexpr int MAX_VOLUME_16 = INT16_MAX;
+
+PCM_SSE2_TARGET
+static size_t
+PcmVolumeChange16to32_SSE2(int32_t *dest, const int16_t *src, size_t n,
+			   int volume) noexcept
+{
+	const __m128i v = _mm_set1_epi16(volume);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+
+		/* SSE2 has no 32 bit multiplication; combine the low
+		   and high halves of the 16x16 bit products */
+		const __m128i lo = _mm_mullo_epi16(s, v);
+		const __m128i hi = _mm_mulhi_epi16(s, v);
+
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi),
+						S16_TO_S24_SHIFT));
+		_mm_storeu_si128((__m128i *)(dest + i + 4),
+				 _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi),
+						S16_TO_S24_SHIFT));
+	}
+
+	return i;
+}
+
+PCM_SSE2_TARGET
+static size_t
+PcmVolumeChangeFloat_SSE2(float *dest, const float *src, size_t n,
+			  float volume) noexcept
+{
+	const __m128 v = _mm_set1_ps(volume);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), v));
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmVolumeChange16to32_AVX2(int32_t *dest, const int16_t *src, size_t n,
+			   int volume) noexcept
+{
+	const __m256i v = _mm256_set1_epi32(volume);
+
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m128i s0 = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i s1 = _mm_loadu_si128((const __m128i *)(src + i + 8));
+
+		const __m256i d0 = _mm256_mullo_epi32(_mm256_cvtepi16_epi32(s0), v);
+		const __m256i d1 = _mm256_mullo_epi32(_mm256_cvtepi16_epi32(s1), v);
+
+		_mm256_storeu_si256((__m256i *)(dest + i),
+				    _mm256_srai_epi32(d0, S16_TO_S24_SHIFT));
+		_mm256_storeu_si256((__m256i *)(dest + i + 8),
+				    _mm256_srai_epi32(d1, S16_TO_S24_SHIFT));
+	}
+
+	return i;
+}
+
+PCM_AVX2_TARGET
+static size_t
+PcmVolumeChangeFloat_AVX2(float *dest, const float *src, size_t n,
+			  float volume) noexcept
+{
+	const __m256 v = _mm256_set1_ps(volume);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(dest + i,
+				 _mm256_mul_ps(_mm256_loadu_ps(src + i), v));
+
+	return i;
+}
+
+#endif
+
+size_t
+PcmVolumeChange16to32Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+			  size_t n, int volume) noexcept
+{
+#ifdef HAVE_PCM_SIMD_X86
+	if (volume < 0 || volume > MAX_VOLUME_16)
+		/* this much amplification would clip anyway; leave
+		   it to the generic code */
+		return 0;
+
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		return PcmVolumeChange16to32_SSE2(dest, src, n, volume);
+
+	case PcmSimd::AVX2:
+		return PcmVolumeChange16to32_AVX2(dest, src, n, volume);
+	}
+#else
+	(void)simd;
+	(void)dest;
+	(void)src;
+	(void)n;
+	(void)volume;
+#endif
+
+	return 0;
+}
+
+size_t
+PcmVolumeChangeFloatSimd(PcmSimd simd, float *dest, const float *src,
+			 size_t n, float volume) noexcept
+{
+#ifdef HAVE_PCM_SIMD_X86
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::SSE2:
+		return PcmVolumeChangeFloat_SSE2(dest, src, n, volume);
+
+	case PcmSimd::AVX2:
+		return PcmVolumeChangeFloat_AVX2(dest, src, n, volume);
+	}
+#else
+	(void)simd;
+	(void)dest;
+	(void)src;
+	(void)n;
+	(void)volume;
+#endif
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_VOLUME_SIMD_HXX
+#define MPD_PCM_VOLUME_SIMD_HXX
+
+#include <cstddef>
+#include <cstdint>
+
+enum class PcmSimd : uint8_t;
+
+/*
+ * Vectorized kernels for #PcmVolume.  They produce exactly the same
+ * results as the generic code.  Each function processes a prefix of
+ * the buffers and returns the number of samples it has processed;
+ * the caller handles the rest.
+ *
+ * The dithered integer formats have no kernel, because the dither
+ * state carries from one sample to the next.
+ */
+
+/**
+ * Apply the volume to S16 samples, converting them to S24_P32.
+ */
+size_t
+PcmVolumeChange16to32Simd(PcmSimd simd, int32_t *dest, const int16_t *src,
+			  size_t n, int volume) noexcept;
+
+size_t
+PcmVolumeChangeFloatSimd(PcmSimd simd, float *dest, const float *src,
+			 size_t n, float volume) noexcept;
+
+#endif
@@ -29,11 +29,15 @@ PlayerControl::PlayerControl(PlayerListener &_listener,
 			     PlayerOutputs &_outputs,
 			     InputCacheManager *_input_cache,
 			     unsigned _buffer_chunks,
+			     size_t _chunk_size,
+			     SongTime _predecode_time,
 			     AudioFormat _configured_audio_format,
 			     const ReplayGainConfig &_replay_gain_config) noexcept
 	:listener(_listener), outputs(_outputs),
 	 input_cache(_input_cache),
 	 buffer_chunks(_buffer_chunks),
+	 chunk_size(_chunk_size),
+	 predecode_time(_predecode_time),
 	 configured_audio_format(_configured_audio_format),
 	 thread(BIND_THIS_METHOD(RunThread)),
 	 replay_gain_config(_replay_gain_config)
@@ -261,8 +265,11 @@ PlayerControl::SeekLocked(std::unique_lock<Mutex> &lock,
 	   "next_song" attribute with the CANCEL command */
 	/* optimization TODO: if the decoder happens to decode that
 	   song already, don't cancel that */
-	if (next_song != nullptr)
+	if (next_song != nullptr) {
+		cancel_seek_song = song.get();
 		SynchronousCommand(lock, PlayerCommand::CANCEL);
+		cancel_seek_song = nullptr;
+	}
 
 	assert(next_song == nullptr);
 
@@ -120,6 +120,19 @@ class PlayerControl final : public AudioOutputClient {
 
 	const unsigned buffer_chunks;
 
+	/**
+	 * The size of each #MusicChunk in bytes (the
+	 * "audio_chunk_size" setting).
+	 */
+	const size_t chunk_size;
+
+	/**
+	 * Pre-decode this much of the next song with a second
+	 * decoder (the "predecode_time" setting).  Zero disables the
+	 * second decoder.
+	 */
+	const SongTime predecode_time;
+
 	/**
 	 * The "audio_output_format" setting.
 	 */
@@ -163,6 +176,14 @@ class PlayerControl final : public AudioOutputClient {
 	 */
 	std::unique_ptr<DetachedSong> next_song;
 
+	/**
+	 * The song which SeekLocked() is going to seek to after its
+	 * #PlayerCommand::CANCEL; nullptr for all other CANCEL
+	 * commands.  The player keeps its pre-decoder running only if
+	 * it is decoding this song.
+	 */
+	const DetachedSong *cancel_seek_song = nullptr;
+
 	/**
 	 * A copy of the current #DetachedSong after its tags have
 	 * been updated by the decoder (for example, a radio stream
@@ -238,6 +259,8 @@ public:
 		      PlayerOutputs &_outputs,
 		      InputCacheManager *_input_cache,
 		      unsigned buffer_chunks,
+		      size_t chunk_size,
+		      SongTime predecode_time,
 		      AudioFormat _configured_audio_format,
 		      const ReplayGainConfig &_replay_gain_config) noexcept;
 	~PlayerControl() noexcept;
@@ -23,6 +23,8 @@
 #include "Chrono.hxx"
 #include "util/Compiler.h"
 
+#include <cstddef>
+
 struct AudioFormat;
 class SignedSongTime;
 
@@ -58,6 +60,8 @@ struct CrossFadeSettings {
 	 * @param af the audio format of the new song
 	 * @param old_format the audio format of the current song
 	 * @param max_chunks the maximum number of chunks
+	 * @param chunk_capacity the number of data bytes in each
+	 * chunk
 	 * @return the number of chunks for crossfading, or 0 if cross fading
 	 * should be disabled for this song change
 	 */
@@ -67,7 +71,8 @@ struct CrossFadeSettings {
 			   const char *mixramp_start,
 			   const char *mixramp_prev_end,
 			   AudioFormat af, AudioFormat old_format,
-			   unsigned max_chunks) const noexcept;
+			   unsigned max_chunks,
+			   size_t chunk_capacity) const noexcept;
 };
 
 #endif
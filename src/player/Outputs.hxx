@@ -102,6 +102,13 @@ public:
 	 */
 	virtual void SongBorder() noexcept = 0;
 
+	/**
+	 * Shall the #MusicBuffer be locked in RAM?  This is the case
+	 * if one of the outputs has the "lock_memory" setting.
+	 */
+	gcc_pure
+	virtual bool IsLockMemory() const noexcept = 0;
+
 	/**
 	 * Returns the "elapsed_time" stamp of the most recently finished
 	 * chunk.  A negative value is returned when no chunk has been
@@ -67,7 +67,19 @@ static constexpr auto buffer_before_play_duration = std::chrono::seconds(1);
 class Player {
 	PlayerControl &pc;
 
-	DecoderControl &dc;
+	/**
+	 * The decoder which feeds the current song (or the next song,
+	 * after the current one has been decoded completely).
+	 */
+	DecoderControl *dc;
+
+	/**
+	 * The second decoder slot, which decodes the beginning of the
+	 * queued song in advance while #dc is still busy with the
+	 * current song; nullptr if disabled.  It swaps roles with #dc
+	 * when playback reaches that song.
+	 */
+	DecoderControl *predecoder;
 
 	MusicBuffer &buffer;
 
@@ -197,8 +209,9 @@ class Player {
 
 public:
 	Player(PlayerControl &_pc, DecoderControl &_dc,
+	       DecoderControl *_predecoder,
 	       MusicBuffer &_buffer) noexcept
-		:pc(_pc), dc(_dc), buffer(_buffer),
+		:pc(_pc), dc(&_dc), predecoder(_predecoder), buffer(_buffer),
 		 decoder_wakeup_threshold(buffer.GetSize() * 3 / 4)
 	{
 	}
@@ -246,6 +259,38 @@ private:
 	 */
 	void StopDecoder(std::unique_lock<Mutex> &lock) noexcept;
 
+	/**
+	 * Start pre-decoding the queued song with the #predecoder.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void StartPredecoder(std::unique_lock<Mutex> &lock) noexcept;
+
+	/**
+	 * Stop the #predecoder and clear (and free) its music pipe.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void StopPredecoder(std::unique_lock<Mutex> &lock) noexcept;
+
+	/**
+	 * Has the #predecoder begun decoding the specified song?
+	 */
+	[[nodiscard]] gcc_pure
+	bool IsPredecoderAt(const DetachedSong &_song) const noexcept {
+		return predecoder != nullptr && predecoder->pipe != nullptr &&
+			predecoder->song->IsSame(_song);
+	}
+
+	/**
+	 * Make the #predecoder the active decoder and let it decode
+	 * the rest of the song.  The old decoder must be idle; it
+	 * becomes the new #predecoder.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void SwapPredecoder() noexcept;
+
 	/**
 	 * Is the decoder still busy on the same song as the player?
 	 *
@@ -256,7 +301,7 @@ private:
 	bool IsDecoderAtCurrentSong() const noexcept {
 		assert(pipe != nullptr);
 
-		return dc.pipe == pipe;
+		return dc->pipe == pipe;
 	}
 
 	/**
@@ -266,7 +311,7 @@ private:
 	 */
 	[[nodiscard]] gcc_pure
 	bool IsDecoderAtNextSong() const noexcept {
-		return dc.pipe != nullptr && !IsDecoderAtCurrentSong();
+		return dc->pipe != nullptr && !IsDecoderAtCurrentSong();
 	}
 
 	/**
@@ -373,27 +418,73 @@ Player::StartDecoder(std::unique_lock<Mutex> &lock,
 	assert(pc.next_song != nullptr);
 
 	/* copy ReplayGain parameters to the decoder */
-	dc.replay_gain_mode = pc.replay_gain_mode;
+	dc->replay_gain_mode = pc.replay_gain_mode;
 
 	SongTime start_time = pc.next_song->GetStartTime() + pc.seek_time;
 
-	dc.Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
+	dc->Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
 		 start_time, pc.next_song->GetEndTime(),
 		 buffer, std::move(_pipe));
 }
 
+void
+Player::StartPredecoder(std::unique_lock<Mutex> &lock) noexcept
+{
+	assert(predecoder != nullptr);
+	assert(predecoder->pipe == nullptr);
+	assert(queued);
+	assert(pc.next_song != nullptr);
+
+	predecoder->replay_gain_mode = pc.replay_gain_mode;
+	predecoder->InheritPreviousSong(*dc);
+	predecoder->pipe_limit = pc.predecode_time;
+
+	predecoder->Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
+			  pc.next_song->GetStartTime(),
+			  pc.next_song->GetEndTime(),
+			  buffer, std::make_shared<MusicPipe>());
+}
+
+void
+Player::StopPredecoder(std::unique_lock<Mutex> &lock) noexcept
+{
+	if (predecoder == nullptr)
+		return;
+
+	predecoder->StopAndDiscard(lock);
+}
+
+void
+Player::SwapPredecoder() noexcept
+{
+	assert(predecoder != nullptr);
+	assert(predecoder->pipe != nullptr);
+	assert(dc->IsIdle());
+
+	/* the old decoder's pipe (if any) is the one being played,
+	   don't clear it */
+	dc->pipe.reset();
+
+	std::swap(dc, predecoder);
+
+	/* decode the rest of the song */
+	dc->pipe_limit = SongTime::zero();
+	dc->Signal();
+	decoder_woken = false;
+}
+
 void
 Player::StopDecoder(std::unique_lock<Mutex> &lock) noexcept
 {
 	const PlayerControl::ScopeOccupied occupied(pc);
 
-	dc.Stop(lock);
+	dc->Stop(lock);
 
-	if (dc.pipe != nullptr) {
+	if (dc->pipe != nullptr) {
 		/* clear and free the decoder pipe */
 
-		dc.pipe->Clear();
-		dc.pipe.reset();
+		dc->pipe->Clear();
+		dc->pipe.reset();
 
 		/* just in case we've been cross-fading: cancel it
 		   now, because we just deleted the new song's decoder
@@ -406,7 +497,7 @@ bool
 Player::ForwardDecoderError() noexcept
 {
 	try {
-		dc.CheckRethrowError();
+		dc->CheckRethrowError();
 	} catch (...) {
 		pc.SetError(PlayerError::DECODER, std::current_exception());
 		return false;
@@ -512,7 +603,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 	if (!ForwardDecoderError()) {
 		/* the decoder failed */
 		return false;
-	} else if (!dc.IsStarting()) {
+	} else if (!dc->IsStarting()) {
 		/* the decoder is ready and ok */
 
 		if (output_open &&
@@ -521,17 +612,18 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 			   all chunks yet - wait for that */
 			return true;
 
-		pc.total_time = real_song_duration(*dc.song,
-						   dc.total_time);
-		pc.audio_format = dc.in_audio_format;
-		play_audio_format = dc.out_audio_format;
+		pc.total_time = real_song_duration(*dc->song,
+						   dc->total_time);
+		pc.audio_format = dc->in_audio_format;
+		play_audio_format = dc->out_audio_format;
 		decoder_starting = false;
 
 		const size_t buffer_before_play_size =
 			play_audio_format.TimeToSize(buffer_before_play_duration);
+		const size_t chunk_capacity = buffer.GetChunkCapacity();
 		buffer_before_play =
-			(buffer_before_play_size + sizeof(MusicChunk::data) - 1)
-			/ sizeof(MusicChunk::data);
+			(buffer_before_play_size + chunk_capacity - 1)
+			/ chunk_capacity;
 
 		idle_add(IDLE_PLAYER);
 
@@ -558,7 +650,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 			FormatError(player_domain,
 				    "problems opening audio device "
 				    "while playing \"%s\"",
-				    dc.song->GetURI());
+				    dc->song->GetURI());
 			return true;
 		}
 
@@ -566,7 +658,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 	} else {
 		/* the decoder is not yet ready; wait
 		   some more */
-		dc.WaitForDecoder(lock);
+		dc->WaitForDecoder(lock);
 
 		return true;
 	}
@@ -587,7 +679,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock, SongTime seek_time) noexcept
 	try {
 		const PlayerControl::ScopeOccupied occupied(pc);
 
-		dc.Seek(lock, song->GetStartTime() + seek_time);
+		dc->Seek(lock, song->GetStartTime() + seek_time);
 	} catch (...) {
 		/* decoder failure */
 		pc.SetError(PlayerError::DECODER, std::current_exception());
@@ -604,7 +696,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 	assert(pc.next_song != nullptr);
 
 	if (pc.seek_time > SongTime::zero() && // TODO: allow this only if the song duration is known
-	    dc.IsUnseekableCurrentSong(*pc.next_song)) {
+	    dc->IsUnseekableCurrentSong(*pc.next_song)) {
 		/* seeking into the current song; but we already know
 		   it's not seekable, so let's fail early */
 		/* note the seek_time>0 check: if seeking to the
@@ -625,7 +717,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 
 	idle_add(IDLE_PLAYER);
 
-	if (!dc.IsSeekableCurrentSong(*pc.next_song)) {
+	if (!dc->IsSeekableCurrentSong(*pc.next_song)) {
 		/* the decoder is already decoding the "next" song -
 		   stop it and start the previous song again */
 
@@ -635,8 +727,17 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 		   pipe */
 		pipe->Clear();
 
-		/* re-start the decoder */
-		StartDecoder(lock, pipe);
+		if (pc.seek_time.IsZero() && IsPredecoderAt(*pc.next_song)) {
+			/* the song has already been pre-decoded -
+			   continue with those chunks */
+			SwapPredecoder();
+			ReplacePipe(dc->pipe);
+		} else {
+			/* re-start the decoder */
+			StopPredecoder(lock);
+			StartDecoder(lock, pipe);
+		}
+
 		ActivateDecoder();
 
 		pc.seeking = true;
@@ -649,7 +750,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 		if (!IsDecoderAtCurrentSong()) {
 			/* the decoder is already decoding the "next" song,
 			   but it is the same song file; exchange the pipe */
-			ReplacePipe(dc.pipe);
+			ReplacePipe(dc->pipe);
 		}
 
 		pc.next_song.reset();
@@ -713,7 +814,7 @@ Player::ProcessCommand(std::unique_lock<Mutex> &lock) noexcept
 		queued = true;
 		pc.CommandFinished();
 
-		if (dc.IsIdle())
+		if (dc->IsIdle())
 			StartDecoder(lock, std::make_shared<MusicPipe>());
 
 		break;
@@ -751,6 +852,13 @@ Player::ProcessCommand(std::unique_lock<Mutex> &lock) noexcept
 			   stop it and reset the position */
 			StopDecoder(lock);
 
+		/* stop the pre-decoder, unless SeekLocked() is going
+		   to seek to the song it is decoding; SeekDecoder()
+		   continues with those chunks then */
+		if (pc.cancel_seek_song == nullptr ||
+		    !IsPredecoderAt(*pc.cancel_seek_song))
+			StopPredecoder(lock);
+
 		pc.next_song.reset();
 		queued = false;
 		pc.CommandFinished();
@@ -848,7 +956,7 @@ Player::PlayNextChunk() noexcept
 		unsigned cross_fade_position = pipe->GetSize();
 		assert(cross_fade_position <= cross_fade_chunks);
 
-		auto other_chunk = dc.pipe->Shift();
+		auto other_chunk = dc->pipe->Shift();
 		if (other_chunk != nullptr) {
 			chunk = pipe->Shift();
 			assert(chunk != nullptr);
@@ -884,14 +992,14 @@ Player::PlayNextChunk() noexcept
 
 			std::unique_lock<Mutex> lock(pc.mutex);
 
-			if (dc.IsIdle()) {
+			if (dc->IsIdle()) {
 				/* the decoder isn't running, abort
 				   cross fading */
 				xfade_state = CrossFadeState::DISABLED;
 			} else {
 				/* wait for the decoder */
-				dc.Signal();
-				dc.WaitForDecoder(lock);
+				dc->Signal();
+				dc->WaitForDecoder(lock);
 
 				return true;
 			}
@@ -937,14 +1045,22 @@ Player::PlayNextChunk() noexcept
 	/* this formula should prevent that the decoder gets woken up
 	   with each chunk; it is more efficient to make it decode a
 	   larger block at a time */
-	if (!dc.IsIdle() && dc.pipe->GetSize() <= decoder_wakeup_threshold) {
+	if (!dc->IsIdle() && dc->pipe->GetSize() <= decoder_wakeup_threshold) {
 		if (!decoder_woken) {
 			decoder_woken = true;
-			dc.Signal();
+			dc->Signal();
 		}
 	} else
 		decoder_woken = false;
 
+	/* the pre-decoder shares pc.mutex, so the lock above
+	   protects its state for IsPipeFull() as well */
+	if (predecoder != nullptr && predecoder->pipe != nullptr &&
+	    !predecoder->IsIdle() && !predecoder->IsPipeFull())
+		/* the pre-decoder may be waiting for buffer space,
+		   which we have just freed */
+		predecoder->Signal();
+
 	return true;
 }
 
@@ -956,7 +1072,7 @@ Player::SongBorder() noexcept
 
 		FormatDefault(player_domain, "played \"%s\"", song->GetURI());
 
-		ReplacePipe(dc.pipe);
+		ReplacePipe(dc->pipe);
 
 		pc.outputs.SongBorder();
 	}
@@ -1002,10 +1118,10 @@ Player::Run() noexcept
 			   prevent stuttering on slow machines */
 
 			if (pipe->GetSize() < buffer_before_play &&
-			    !dc.IsIdle() && !buffer.IsFull()) {
+			    !dc->IsIdle() && !buffer.IsFull()) {
 				/* not enough decoded buffer space yet */
 
-				dc.WaitForDecoder(lock);
+				dc->WaitForDecoder(lock);
 				continue;
 			} else {
 				/* buffering is complete */
@@ -1013,13 +1129,25 @@ Player::Run() noexcept
 			}
 		}
 
-		if (dc.IsIdle() && queued && IsDecoderAtCurrentSong()) {
+		if (dc->IsIdle() && queued && IsDecoderAtCurrentSong()) {
 			/* the decoder has finished the current song;
 			   make it decode the next song */
 
-			assert(dc.pipe == nullptr || dc.pipe == pipe);
+			assert(dc->pipe == nullptr || dc->pipe == pipe);
 
-			StartDecoder(lock, std::make_shared<MusicPipe>());
+			if (IsPredecoderAt(*pc.next_song))
+				SwapPredecoder();
+			else
+				StartDecoder(lock, std::make_shared<MusicPipe>());
+		} else if (predecoder != nullptr && queued &&
+			   IsDecoderAtCurrentSong() &&
+			   !IsPredecoderAt(*pc.next_song)) {
+			/* the decoder is still busy with the current
+			   song; meanwhile, begin decoding the next
+			   one with the second decoder */
+
+			StopPredecoder(lock);
+			StartPredecoder(lock);
 		}
 
 		if (/* no cross-fading if MPD is going to pause at the
@@ -1027,20 +1155,21 @@ Player::Run() noexcept
 		    !pc.border_pause &&
 		    IsDecoderAtNextSong() &&
 		    xfade_state == CrossFadeState::UNKNOWN &&
-		    !dc.IsStarting()) {
+		    !dc->IsStarting()) {
 			/* enable cross fading in this song?  if yes,
 			   calculate how many chunks will be required
 			   for it */
 			cross_fade_chunks =
-				pc.cross_fade.Calculate(dc.total_time,
-							dc.replay_gain_db,
-							dc.replay_gain_prev_db,
-							dc.GetMixRampStart(),
-							dc.GetMixRampPreviousEnd(),
-							dc.out_audio_format,
+				pc.cross_fade.Calculate(dc->total_time,
+							dc->replay_gain_db,
+							dc->replay_gain_prev_db,
+							dc->GetMixRampStart(),
+							dc->GetMixRampPreviousEnd(),
+							dc->out_audio_format,
 							play_audio_format,
 							buffer.GetSize() -
-							buffer_before_play);
+							buffer_before_play,
+							buffer.GetChunkCapacity());
 			if (cross_fade_chunks > 0)
 				xfade_state = CrossFadeState::ENABLED;
 			else
@@ -1067,14 +1196,14 @@ Player::Run() noexcept
 			   waiting for space in the MusicBuffer) and
 			   wait for it */
 			// TODO: eliminate this kludge
-			dc.Signal();
+			dc->Signal();
 
-			dc.WaitForDecoder(lock);
+			dc->WaitForDecoder(lock);
 		} else if (IsDecoderAtNextSong()) {
 			/* at the beginning of a new song */
 
 			SongBorder();
-		} else if (dc.IsIdle()) {
+		} else if (dc->IsIdle()) {
 			if (queued)
 				/* the decoder has just stopped,
 				   between the two IsIdle() checks,
@@ -1104,14 +1233,15 @@ Player::Run() noexcept
 			   waiting for space in the MusicBuffer) and
 			   wait for it */
 			// TODO: eliminate this kludge
-			dc.Signal();
+			dc->Signal();
 
-			dc.WaitForDecoder(lock);
+			dc->WaitForDecoder(lock);
 		}
 	}
 
 	CancelPendingSeek();
 	StopDecoder(lock);
+	StopPredecoder(lock);
 
 	pipe.reset();
 
@@ -1134,9 +1264,10 @@ Player::Run() noexcept
 
 static void
 do_play(PlayerControl &pc, DecoderControl &dc,
+	DecoderControl *predecoder,
 	MusicBuffer &buffer) noexcept
 {
-	Player player(pc, dc, buffer);
+	Player player(pc, dc, predecoder, buffer);
 	player.Run();
 }
 
@@ -1151,7 +1282,25 @@ try {
 			  replay_gain_config);
 	dc.StartThread();
 
-	MusicBuffer buffer(buffer_chunks);
+	std::unique_ptr<DecoderControl> predecoder;
+	if (predecode_time.IsPositive()) {
+		predecoder = std::make_unique<DecoderControl>(mutex, cond,
+							      input_cache,
+							      configured_audio_format,
+							      replay_gain_config);
+		predecoder->StartThread();
+	}
+
+	MusicBuffer buffer(buffer_chunks, chunk_size);
+
+	if (outputs.IsLockMemory()) {
+		try {
+			buffer.Lock();
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to lock the audio buffer in RAM");
+		}
+	}
 
 	std::unique_lock<Mutex> lock(mutex);
 
@@ -1163,7 +1312,7 @@ try {
 
 			{
 				const ScopeUnlock unlock(mutex);
-				do_play(*this, dc, buffer);
+				do_play(*this, dc, predecoder.get(), buffer);
 				listener.OnPlayerSync();
 			}
 
@@ -1211,6 +1360,8 @@ try {
 			{
 				const ScopeUnlock unlock(mutex);
 				dc.Quit();
+				if (predecoder)
+					predecoder->Quit();
 				outputs.Close();
 			}
 
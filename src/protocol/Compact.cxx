@@ -0,0 +1,127 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Compact.hxx"
+
+#include <algorithm>
+
+static constexpr std::size_t
+VarIntSize(uint64_t value) noexcept
+{
+	std::size_t size = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+}
+
+static uint8_t *
+WriteVarInt(uint8_t *p, uint64_t value) noexcept
+{
+	while (value >= 0x80) {
+		*p++ = uint8_t(value) | 0x80;
+		value >>= 7;
+	}
+
+	*p++ = uint8_t(value);
+	return p;
+}
+
+uint8_t *
+CompactRecord::BeginField(CompactField code, std::size_t length) noexcept
+{
+	const std::size_t field_size = 1 + VarIntSize(length) + length;
+	if (field_size > MAX_FIELDS_SIZE - size) {
+		++n_omitted;
+		return nullptr;
+	}
+
+	uint8_t *p = buffer + size;
+	*p++ = uint8_t(code);
+	p = WriteVarInt(p, length);
+	size += field_size;
+	return p;
+}
+
+bool
+CompactRecord::AddString(CompactField code, StringView value) noexcept
+{
+	uint8_t *p = BeginField(code, value.size);
+	if (p == nullptr)
+		return false;
+
+	std::copy_n(value.data, value.size, p);
+	return true;
+}
+
+bool
+CompactRecord::AddPath(CompactField code,
+		       StringView directory, StringView name) noexcept
+{
+	uint8_t *p = BeginField(code, directory.size + 1 + name.size);
+	if (p == nullptr)
+		return false;
+
+	p = std::copy_n(directory.data, directory.size, p);
+	*p++ = '/';
+	std::copy_n(name.data, name.size, p);
+	return true;
+}
+
+bool
+CompactRecord::AddNumber(CompactField code, uint64_t value) noexcept
+{
+	uint8_t *p = BeginField(code, VarIntSize(value));
+	if (p == nullptr)
+		return false;
+
+	WriteVarInt(p, value);
+	return true;
+}
+
+bool
+CompactRecord::AddNumbers(CompactField code, uint64_t a, uint64_t b) noexcept
+{
+	uint8_t *p = BeginField(code, VarIntSize(a) + VarIntSize(b));
+	if (p == nullptr)
+		return false;
+
+	WriteVarInt(WriteVarInt(p, a), b);
+	return true;
+}
+
+void
+CompactRecord::Finish() noexcept
+{
+	if (n_omitted == 0)
+		return;
+
+	static_assert(VarIntSize(UINT32_MAX) + 2 <= TRUNCATED_SIZE);
+
+	/* this always fits, because BeginField() has kept
+	   TRUNCATED_SIZE bytes free */
+	uint8_t *p = buffer + size;
+	*p++ = uint8_t(CompactField::TRUNCATED);
+	*p++ = uint8_t(VarIntSize(n_omitted));
+	p = WriteVarInt(p, n_omitted);
+	size = p - buffer;
+	n_omitted = 0;
+}
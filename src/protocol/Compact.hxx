@@ -0,0 +1,149 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PROTOCOL_COMPACT_HXX
+#define MPD_PROTOCOL_COMPACT_HXX
+
+#include "tag/Type.h"
+#include "util/ConstBuffer.hxx"
+#include "util/StringView.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Field codes of the compact protocol mode.  See the "Compact
+ * responses" section of doc/protocol.rst.
+ */
+enum class CompactField : uint8_t {
+	URI = 0x01,
+	LAST_MODIFIED = 0x02,
+	RANGE = 0x03,
+	FORMAT = 0x04,
+	DURATION = 0x05,
+	POS = 0x06,
+	ID = 0x07,
+	PRIO = 0x08,
+
+	/**
+	 * The number of fields which were omitted because they did
+	 * not fit into the record.  See CompactRecord::Finish().
+	 */
+	TRUNCATED = 0x09,
+
+	/**
+	 * The first tag code; add the #TagType to get the code of a
+	 * tag.
+	 */
+	TAG = 0x80,
+};
+
+static_assert(unsigned(CompactField::TAG) + TAG_NUM_OF_ITEM_TYPES <= 0x100,
+	      "Too many tag types for the compact protocol");
+
+/**
+ * Builds one record of the compact protocol mode.  A record is a
+ * sequence of fields; each field consists of a one-byte code (see
+ * #CompactField), the length of the value (unsigned LEB128) and the
+ * value.  Integer values are encoded as unsigned LEB128, too.
+ *
+ * Fields which do not fit into the record are omitted; Finish()
+ * appends a #CompactField::TRUNCATED field which counts them.
+ */
+class CompactRecord {
+public:
+	/**
+	 * The maximum size of a record; it must fit into one
+	 * "binary" chunk.
+	 */
+	static constexpr std::size_t MAX_SIZE = 8192;
+
+	/**
+	 * The space at the end of the buffer reserved for the
+	 * #CompactField::TRUNCATED field: code, length and a 32 bit
+	 * LEB128 number.
+	 */
+	static constexpr std::size_t TRUNCATED_SIZE = 1 + 1 + 5;
+
+	/**
+	 * The maximum total size of all other fields.
+	 */
+	static constexpr std::size_t MAX_FIELDS_SIZE =
+		MAX_SIZE - TRUNCATED_SIZE;
+
+private:
+	std::size_t size = 0;
+
+	/**
+	 * The number of fields which did not fit.
+	 */
+	uint32_t n_omitted = 0;
+
+	uint8_t buffer[MAX_SIZE];
+
+public:
+	bool empty() const noexcept {
+		return size == 0;
+	}
+
+	bool IsTruncated() const noexcept {
+		return n_omitted > 0;
+	}
+
+	ConstBuffer<void> GetData() const noexcept {
+		return {buffer, size};
+	}
+
+	/**
+	 * Append the #CompactField::TRUNCATED field if fields were
+	 * omitted.  Call this after the last field has been added.
+	 */
+	void Finish() noexcept;
+
+	bool AddString(CompactField code, StringView value) noexcept;
+
+	/**
+	 * Add a string value which is the concatenation of two
+	 * parts with a slash in between.
+	 */
+	bool AddPath(CompactField code,
+		     StringView directory, StringView name) noexcept;
+
+	bool AddNumber(CompactField code, uint64_t value) noexcept;
+
+	bool AddNumbers(CompactField code,
+			uint64_t a, uint64_t b) noexcept;
+
+	bool AddTag(TagType type, StringView value) noexcept {
+		return AddString(CompactField(unsigned(CompactField::TAG) +
+					      unsigned(type)),
+				 value);
+	}
+
+private:
+	/**
+	 * Write the field header and reserve space for the value.
+	 *
+	 * @return a pointer to the value or nullptr if the field
+	 * does not fit
+	 */
+	uint8_t *BeginField(CompactField code, std::size_t length) noexcept;
+};
+
+#endif
@@ -24,6 +24,8 @@
 #include "song/DetachedSong.hxx"
 #include "song/LightSong.hxx"
 #include "client/Response.hxx"
+#include "protocol/Compact.hxx"
+#include "util/ConstBuffer.hxx"
 
 /**
  * Send detailed information about a range of songs in the queue to a
@@ -37,6 +39,25 @@ static void
 queue_print_song_info(Response &r, const Queue &queue,
 		      unsigned position)
 {
+	if (r.IsCompact()) {
+		/* add the identifiers first, so they cannot be
+		   pushed out by large tags */
+		CompactRecord record;
+		record.AddNumber(CompactField::POS, position);
+		record.AddNumber(CompactField::ID,
+				 queue.PositionToId(position));
+
+		uint8_t priority = queue.GetPriorityAtPosition(position);
+		if (priority != 0)
+			record.AddNumber(CompactField::PRIO, priority);
+
+		song_compact_info(record, queue.Get(position),
+				  r.GetTagMask());
+		record.Finish();
+		r.WriteBinary(record.GetData());
+		return;
+	}
+
 	song_print_info(r, queue.Get(position));
 	r.Format("Pos: %u\nId: %u\n",
 		 position, queue.PositionToId(position));
@@ -57,6 +78,17 @@ queue_print_info(Response &r, const Queue &queue,
 		queue_print_song_info(r, queue, i);
 }
 
+void
+queue_print_ids(Response &r, const Queue &queue,
+		ConstBuffer<unsigned> ids)
+{
+	for (const unsigned id : ids) {
+		const int position = queue.IdToPosition(id);
+		if (position >= 0)
+			queue_print_song_info(r, queue, position);
+	}
+}
+
 void
 queue_print_uris(Response &r, const Queue &queue,
 		 unsigned start, unsigned end)
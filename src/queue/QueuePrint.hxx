@@ -28,6 +28,7 @@
 #include <cstdint>
 
 struct Queue;
+template<typename T> struct ConstBuffer;
 class SongFilter;
 class Response;
 
@@ -35,6 +36,14 @@ void
 queue_print_info(Response &r, const Queue &queue,
 		 unsigned start, unsigned end);
 
+/**
+ * Send detailed information about the songs with the given ids, in
+ * this order.  Ids which do not exist (anymore) are skipped.
+ */
+void
+queue_print_ids(Response &r, const Queue &queue,
+		ConstBuffer<unsigned> ids);
+
 void
 queue_print_uris(Response &r, const Queue &queue,
 		 unsigned start, unsigned end);
@@ -22,6 +22,7 @@
 
 #include "Chrono.hxx"
 #include "pcm/AudioFormat.hxx"
+#include "util/AllocatedString.hxx"
 #include "util/Compiler.h"
 
 #include <string>
@@ -85,6 +86,14 @@ struct LightSong {
 	 */
 	AudioFormat audio_format = AudioFormat::Undefined();
 
+	/**
+	 * If not nullptr, then this points to a cache slot owned by the
+	 * database which holds (or shall hold) the pre-serialized
+	 * output of song_print_info() with all tags.  It may only be
+	 * accessed while the database is locked.
+	 */
+	AllocatedString<> *protocol_cache = nullptr;
+
 	LightSong(const char *_uri, const Tag &_tag) noexcept
 		:uri(_uri), tag(_tag) {}
 
@@ -82,6 +82,15 @@ public:
 		return value;
 	}
 
+	/**
+	 * Does this filter compare the whole string, case-sensitive
+	 * and without a regular expression?  Then a (non-negated)
+	 * match means the string is equal to GetValue().
+	 */
+	bool IsExact() const noexcept {
+		return !fold_case && !substring && !IsRegex();
+	}
+
 	bool GetFoldCase() const noexcept {
 		return fold_case;
 	}
@@ -50,6 +50,14 @@ public:
 		return filter.GetFoldCase();
 	}
 
+	bool IsRegex() const noexcept {
+		return filter.IsRegex();
+	}
+
+	bool IsExact() const noexcept {
+		return filter.IsExact();
+	}
+
 	bool IsNegated() const noexcept {
 		return filter.IsNegated();
 	}
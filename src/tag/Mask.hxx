@@ -76,6 +76,14 @@ public:
 		return *this;
 	}
 
+	constexpr bool operator==(TagMask other) const noexcept {
+		return value == other.value;
+	}
+
+	constexpr bool operator!=(TagMask other) const noexcept {
+		return !(*this == other);
+	}
+
 	constexpr bool TestAny() const noexcept {
 		return value != 0;
 	}
@@ -19,27 +19,54 @@
 
 #include "Pool.hxx"
 #include "Item.hxx"
+#include "thread/Mutex.hxx"
 #include "util/Cast.hxx"
 #include "util/VarSize.hxx"
 #include "util/StringView.hxx"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <limits>
+#include <memory>
 
 #include <string.h>
 #include <stdlib.h>
 
-Mutex tag_pool_lock;
+/**
+ * The number of independently locked parts of the pool.  Must be a
+ * power of two.
+ */
+static constexpr unsigned NUM_STRIPES_BITS = 6;
+static constexpr std::size_t NUM_STRIPES = std::size_t(1) << NUM_STRIPES_BITS;
 
-static constexpr size_t NUM_SLOTS = 4093;
+/**
+ * The initial number of hash buckets in each stripe.  Must be a power
+ * of two.
+ */
+static constexpr std::size_t INITIAL_BUCKETS = 64;
+
+/**
+ * Grow the hash table of a stripe when the average chain is longer
+ * than this.
+ */
+static constexpr std::size_t MAX_LOAD_FACTOR = 2;
 
 struct TagPoolSlot {
 	TagPoolSlot *next;
-	uint8_t ref = 1;
+
+	/**
+	 * The reference counter.  It may be incremented without
+	 * holding the stripe lock (by somebody who already owns a
+	 * reference), but it drops to zero only while the lock is
+	 * held.
+	 */
+	std::atomic<uint8_t> ref{1};
+
 	TagItem item;
 
-	static constexpr unsigned MAX_REF = std::numeric_limits<decltype(ref)>::max();
+	static constexpr unsigned MAX_REF = std::numeric_limits<uint8_t>::max();
 
 	TagPoolSlot(TagPoolSlot *_next, TagType type,
 		    StringView value) noexcept
@@ -51,6 +78,40 @@ struct TagPoolSlot {
 
 	static TagPoolSlot *Create(TagPoolSlot *_next, TagType type,
 				   StringView value) noexcept;
+
+	/**
+	 * Try to obtain another reference.
+	 *
+	 * @return false if the reference counter is already at
+	 * #MAX_REF
+	 */
+	bool TryRef() noexcept {
+		uint8_t old = ref.load(std::memory_order_relaxed);
+		do {
+			assert(old > 0);
+			if (old >= MAX_REF)
+				return false;
+		} while (!ref.compare_exchange_weak(old, old + 1,
+						    std::memory_order_relaxed));
+		return true;
+	}
+
+	/**
+	 * Release a reference, unless it is the last one.
+	 *
+	 * @return false if this is the last reference, which must be
+	 * released with the stripe lock held
+	 */
+	bool TryUnrefShared() noexcept {
+		uint8_t old = ref.load(std::memory_order_relaxed);
+		do {
+			assert(old > 0);
+			if (old == 1)
+				return false;
+		} while (!ref.compare_exchange_weak(old, old - 1,
+						    std::memory_order_acq_rel));
+		return true;
+	}
 };
 
 TagPoolSlot *
@@ -64,9 +125,37 @@ TagPoolSlot::Create(TagPoolSlot *_next, TagType type,
 				       value);
 }
 
-static TagPoolSlot *slots[NUM_SLOTS];
+/**
+ * One part of the pool with its own lock and its own resizable hash
+ * table.  Aligned to a cache line to avoid false sharing between
+ * stripes.
+ */
+struct alignas(64) TagPoolStripe {
+	Mutex mutex;
+
+	std::unique_ptr<TagPoolSlot *[]> buckets;
+
+	std::size_t n_buckets = 0;
+
+	std::size_t n_items = 0;
+
+	TagPoolSlot **GetBucket(std::size_t hash) noexcept {
+		assert(n_buckets > 0);
 
-static inline unsigned
+		return &buckets[hash & (n_buckets - 1)];
+	}
+
+	TagItem *Get(std::size_t hash, TagType type,
+		     StringView value) noexcept;
+	void Remove(std::size_t hash, TagPoolSlot *slot) noexcept;
+
+private:
+	void Grow() noexcept;
+};
+
+static TagPoolStripe stripes[NUM_STRIPES];
+
+static inline std::size_t
 calc_hash(TagType type, StringView p) noexcept
 {
 	unsigned hash = 5381;
@@ -74,20 +163,31 @@ calc_hash(TagType type, StringView p) noexcept
 	for (auto ch : p)
 		hash = (hash << 5) + hash + ch;
 
-	return hash ^ type;
+	hash ^= type;
+
+	/* mix the bits, because both the stripe and the bucket are
+	   selected by masking */
+	return std::size_t(uint64_t(hash) * UINT64_C(0x9e3779b97f4a7c15) >> 16);
 }
 
-static inline unsigned
+static inline std::size_t
 calc_hash(TagType type, const char *p) noexcept
 {
-	unsigned hash = 5381;
-
 	assert(p != nullptr);
 
-	while (*p != 0)
-		hash = (hash << 5) + hash + *p++;
+	return calc_hash(type, StringView(p));
+}
 
-	return hash ^ type;
+/**
+ * Select the stripe for the given hash; the remaining (lower) bits
+ * select the bucket within the stripe.
+ */
+static inline TagPoolStripe &
+GetStripe(std::size_t &hash) noexcept
+{
+	auto &stripe = stripes[hash & (NUM_STRIPES - 1)];
+	hash >>= NUM_STRIPES_BITS;
+	return stripe;
 }
 
 static constexpr TagPoolSlot *
@@ -96,46 +196,97 @@ tag_item_to_slot(TagItem *item) noexcept
 	return &ContainerCast(*item, &TagPoolSlot::item);
 }
 
-static inline TagPoolSlot **
-tag_value_slot_p(TagType type, StringView value) noexcept
+void
+TagPoolStripe::Grow() noexcept
 {
-	return &slots[calc_hash(type, value) % NUM_SLOTS];
-}
+	const std::size_t new_n_buckets = n_buckets > 0
+		? n_buckets * 2
+		: INITIAL_BUCKETS;
 
-static inline TagPoolSlot **
-tag_value_slot_p(TagType type, const char *value) noexcept
-{
-	return &slots[calc_hash(type, value) % NUM_SLOTS];
+	std::unique_ptr<TagPoolSlot *[]> new_buckets(new TagPoolSlot *[new_n_buckets]);
+	std::fill_n(new_buckets.get(), new_n_buckets, nullptr);
+
+	for (std::size_t i = 0; i < n_buckets; ++i) {
+		for (auto slot = buckets[i]; slot != nullptr;) {
+			auto next = slot->next;
+
+			std::size_t hash = calc_hash(slot->item.type,
+						     slot->item.value);
+			GetStripe(hash);
+
+			auto &bucket = new_buckets[hash & (new_n_buckets - 1)];
+			slot->next = bucket;
+			bucket = slot;
+
+			slot = next;
+		}
+	}
+
+	buckets = std::move(new_buckets);
+	n_buckets = new_n_buckets;
 }
 
-TagItem *
-tag_pool_get_item(TagType type, StringView value) noexcept
+inline TagItem *
+TagPoolStripe::Get(std::size_t hash, TagType type, StringView value) noexcept
 {
-	auto slot_p = tag_value_slot_p(type, value);
-	for (auto slot = *slot_p; slot != nullptr; slot = slot->next) {
-		if (slot->item.type == type &&
-		    value.Equals(slot->item.value) &&
-		    slot->ref < TagPoolSlot::MAX_REF) {
-			assert(slot->ref > 0);
-			++slot->ref;
-			return &slot->item;
+	const std::lock_guard<Mutex> protect(mutex);
+
+	if (n_buckets > 0) {
+		for (auto slot = *GetBucket(hash); slot != nullptr;
+		     slot = slot->next) {
+			if (slot->item.type == type &&
+			    value.Equals(slot->item.value) &&
+			    slot->TryRef())
+				return &slot->item;
 		}
 	}
 
+	if (n_items >= n_buckets * MAX_LOAD_FACTOR)
+		Grow();
+
+	auto slot_p = GetBucket(hash);
 	auto slot = TagPoolSlot::Create(*slot_p, type, value);
 	*slot_p = slot;
+	++n_items;
 	return &slot->item;
 }
 
+inline void
+TagPoolStripe::Remove(std::size_t hash, TagPoolSlot *slot) noexcept
+{
+	const std::lock_guard<Mutex> protect(mutex);
+
+	/* somebody may have obtained a new reference in the
+	   meantime */
+	if (slot->ref.fetch_sub(1, std::memory_order_acq_rel) > 1)
+		return;
+
+	TagPoolSlot **slot_p;
+	for (slot_p = GetBucket(hash);
+	     *slot_p != slot;
+	     slot_p = &(*slot_p)->next) {
+		assert(*slot_p != nullptr);
+	}
+
+	*slot_p = slot->next;
+	--n_items;
+	DeleteVarSize(slot);
+}
+
+TagItem *
+tag_pool_get_item(TagType type, StringView value) noexcept
+{
+	std::size_t hash = calc_hash(type, value);
+	auto &stripe = GetStripe(hash);
+	return stripe.Get(hash, type, value);
+}
+
 TagItem *
 tag_pool_dup_item(TagItem *item) noexcept
 {
 	TagPoolSlot *slot = tag_item_to_slot(item);
 
-	assert(slot->ref > 0);
-
-	if (slot->ref < TagPoolSlot::MAX_REF) {
-		++slot->ref;
+	if (slot->TryRef()) {
 		return item;
 	} else {
 		/* the reference counter overflows above MAX_REF;
@@ -148,21 +299,35 @@ tag_pool_dup_item(TagItem *item) noexcept
 void
 tag_pool_put_item(TagItem *item) noexcept
 {
-	TagPoolSlot **slot_p, *slot;
+	TagPoolSlot *slot = tag_item_to_slot(item);
+	if (slot->TryUnrefShared())
+		return;
 
-	slot = tag_item_to_slot(item);
-	assert(slot->ref > 0);
-	--slot->ref;
+	std::size_t hash = calc_hash(item->type, item->value);
+	auto &stripe = GetStripe(hash);
+	stripe.Remove(hash, slot);
+}
 
-	if (slot->ref > 0)
-		return;
+TagPoolStats
+tag_pool_get_stats() noexcept
+{
+	TagPoolStats stats{};
 
-	for (slot_p = tag_value_slot_p(item->type, item->value);
-	     *slot_p != slot;
-	     slot_p = &(*slot_p)->next) {
-		assert(*slot_p != nullptr);
+	for (auto &stripe : stripes) {
+		const std::lock_guard<Mutex> protect(stripe.mutex);
+
+		stats.n_items += stripe.n_items;
+		stats.n_buckets += stripe.n_buckets;
+
+		for (std::size_t i = 0; i < stripe.n_buckets; ++i) {
+			std::size_t length = 0;
+			for (auto slot = stripe.buckets[i]; slot != nullptr;
+			     slot = slot->next)
+				++length;
+
+			stats.max_chain = std::max(stats.max_chain, length);
+		}
 	}
 
-	*slot_p = slot->next;
-	DeleteVarSize(slot);
+	return stats;
 }
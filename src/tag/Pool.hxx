@@ -21,13 +21,20 @@
 #define MPD_TAG_POOL_HXX
 
 #include "Type.h"
-#include "thread/Mutex.hxx"
+#include "util/Compiler.h"
 
-extern Mutex tag_pool_lock;
+#include <cstddef>
 
 struct TagItem;
 struct StringView;
 
+/*
+ * The tag pool interns all #TagItem values, so each distinct
+ * type/value pair is stored only once.  It is split into
+ * independently locked stripes, so it may be used by several threads
+ * at the same time; the caller does not need to lock anything.
+ */
+
 TagItem *
 tag_pool_get_item(TagType type, StringView value) noexcept;
 
@@ -37,4 +44,28 @@ tag_pool_dup_item(TagItem *item) noexcept;
 void
 tag_pool_put_item(TagItem *item) noexcept;
 
+struct TagPoolStats {
+	/**
+	 * The number of #TagItem instances in the pool.
+	 */
+	std::size_t n_items;
+
+	/**
+	 * The total number of hash buckets in all stripes.
+	 */
+	std::size_t n_buckets;
+
+	/**
+	 * The length of the longest hash chain.
+	 */
+	std::size_t max_chain;
+};
+
+/**
+ * Obtain statistics about the tag pool (for debugging and tuning).
+ */
+gcc_pure
+TagPoolStats
+tag_pool_get_stats() noexcept;
+
 #endif
@@ -97,11 +97,11 @@ SetThreadIdlePriority() noexcept
 }
 
 void
-SetThreadRealtime()
+SetThreadRealtime(unsigned priority)
 {
 #ifdef __linux__
 	struct sched_param sched_param;
-	sched_param.sched_priority = 40;
+	sched_param.sched_priority = priority;
 
 	int policy = SCHED_FIFO;
 #ifdef SCHED_RESET_ON_FORK
@@ -110,5 +110,25 @@ SetThreadRealtime()
 
 	if (linux_sched_setscheduler(0, policy, &sched_param) < 0)
 		throw MakeErrno("sched_setscheduler failed");
+#else
+	(void)priority;
 #endif	// __linux__
 }
+
+void
+SetThreadAffinity(const CpuSet &cpus)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (std::size_t i = 0; i < cpus.size() && i < CPU_SETSIZE; ++i)
+		if (cpus[i])
+			CPU_SET(i, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set) < 0)
+		throw MakeErrno("sched_setaffinity failed");
+#else
+	(void)cpus;
+#endif
+}
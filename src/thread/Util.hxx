@@ -30,6 +30,8 @@
 #ifndef THREAD_UTIL_HXX
 #define THREAD_UTIL_HXX
 
+#include <bitset>
+
 /**
  * Lower the current thread's priority to "idle" (very low).
  */
@@ -40,8 +42,24 @@ SetThreadIdlePriority() noexcept;
  * Raise the current thread's priority to "real-time" (very high).
  *
  * Throws std::system_error on error.
+ *
+ * @param priority the SCHED_FIFO priority (1-99)
+ */
+void
+SetThreadRealtime(unsigned priority=40);
+
+/**
+ * A set of CPU numbers for SetThreadAffinity().
+ */
+using CpuSet = std::bitset<1024>;
+
+/**
+ * Restrict the current thread to the given CPUs.  This is a no-op on
+ * operating systems other than Linux.
+ *
+ * Throws std::system_error on error.
  */
 void
-SetThreadRealtime();
+SetThreadAffinity(const CpuSet &cpus);
 
 #endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "WorkerPool.hxx"
+#include "Name.hxx"
+#include "util/BindMethod.hxx"
+
+#include <cassert>
+
+WorkerPool::WorkerPool(const char *_name, unsigned n_threads)
+	:name(_name)
+{
+	try {
+		for (unsigned i = 0; i < n_threads; ++i) {
+			threads.emplace_back(BIND_THIS_METHOD(Run));
+			threads.back().Start();
+		}
+	} catch (...) {
+		Stop();
+		throw;
+	}
+}
+
+void
+WorkerPool::Stop() noexcept
+{
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		quit = true;
+
+		/* queued jobs will never run; unblock Wait() */
+		queue.clear_and_dispose([](Job *job){
+			job->state = Job::State::NONE;
+		});
+
+		work_cond.notify_all();
+		done_cond.notify_all();
+	}
+
+	for (auto &thread : threads)
+		if (thread.IsDefined())
+			thread.Join();
+}
+
+void
+WorkerPool::Submit(Job &job) noexcept
+{
+	const std::lock_guard<Mutex> protect(mutex);
+
+	assert(job.state == Job::State::NONE);
+
+	job.state = Job::State::QUEUED;
+	queue.push_back(job);
+	work_cond.notify_one();
+}
+
+void
+WorkerPool::Cancel(Job &job) noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+
+	if (job.state == Job::State::QUEUED) {
+		queue.erase(queue.iterator_to(job));
+		job.state = Job::State::NONE;
+		return;
+	}
+
+	done_cond.wait(lock, [&job]{
+		return job.state != Job::State::RUNNING;
+	});
+}
+
+void
+WorkerPool::Wait(Job &job) noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+	done_cond.wait(lock, [&job]{
+		return job.state == Job::State::NONE;
+	});
+}
+
+void
+WorkerPool::Run() noexcept
+{
+	SetThreadName(name);
+
+	std::unique_lock<Mutex> lock(mutex);
+
+	while (!quit) {
+		if (queue.empty()) {
+			work_cond.wait(lock);
+			continue;
+		}
+
+		auto &job = queue.front();
+		queue.pop_front();
+		job.state = Job::State::RUNNING;
+
+		{
+			const ScopeUnlock unlock(mutex);
+			job.RunJob();
+		}
+
+		job.state = Job::State::NONE;
+		job.FinishJob();
+		done_cond.notify_all();
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_THREAD_WORKER_POOL_HXX
+#define MPD_THREAD_WORKER_POOL_HXX
+
+#include "Mutex.hxx"
+#include "Cond.hxx"
+#include "Thread.hxx"
+
+#include <boost/intrusive/list.hpp>
+
+#include <cstdint>
+#include <list>
+
+/**
+ * A fixed number of threads which execute #Job objects in the order
+ * they were submitted.
+ */
+class WorkerPool {
+public:
+	class Job
+		: public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
+		friend class WorkerPool;
+
+		enum class State : uint8_t {
+			NONE,
+			QUEUED,
+			RUNNING,
+		} state = State::NONE;
+
+	protected:
+		~Job() noexcept = default;
+
+		/**
+		 * Execute the job.  This runs in a worker thread.
+		 */
+		virtual void RunJob() noexcept = 0;
+
+		/**
+		 * The job has finished.  This is called in the
+		 * worker thread while the pool's mutex is locked, and
+		 * it is the last access of the #WorkerPool to this
+		 * object; afterwards, it may be deleted.
+		 */
+		virtual void FinishJob() noexcept {}
+	};
+
+private:
+	/**
+	 * The name of the worker threads.
+	 */
+	const char *const name;
+
+	Mutex mutex;
+	Cond work_cond, done_cond;
+
+	boost::intrusive::list<Job,
+			       boost::intrusive::constant_time_size<false>> queue;
+
+	bool quit = false;
+
+	std::list<Thread> threads;
+
+public:
+	/**
+	 * Throws on error.
+	 *
+	 * @param _name the name of the worker threads
+	 */
+	WorkerPool(const char *_name, unsigned n_threads);
+
+	~WorkerPool() noexcept {
+		Stop();
+	}
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	/**
+	 * Stop all threads.  Jobs which are currently running are
+	 * completed, but queued jobs are not started anymore.
+	 */
+	void Stop() noexcept;
+
+	void Submit(Job &job) noexcept;
+
+	/**
+	 * Remove a job from the queue.  If it is already running,
+	 * wait for it to finish.
+	 */
+	void Cancel(Job &job) noexcept;
+
+	/**
+	 * Wait for a submitted job to finish.
+	 */
+	void Wait(Job &job) noexcept;
+
+private:
+	void Run() noexcept;
+};
+
+#endif
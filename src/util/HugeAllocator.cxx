@@ -99,6 +99,12 @@ HugeDiscard(void *p, size_t size) noexcept
 #endif
 }
 
+bool
+HugeLock(void *p, size_t size) noexcept
+{
+	return mlock(p, AlignToPageSize(size)) == 0;
+}
+
 #elif defined(_WIN32)
 
 WritableBuffer<void>
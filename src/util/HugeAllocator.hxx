@@ -76,6 +76,17 @@ HugeForkCow(void *p, size_t size, bool enable) noexcept;
 void
 HugeDiscard(void *p, size_t size) noexcept;
 
+/**
+ * Lock the allocation in RAM, so accessing it never causes a page
+ * fault (mlock()).
+ *
+ * @param p an allocation returned by HugeAllocate()
+ * @param size the allocation's size as passed to HugeAllocate()
+ * @return false on error (with errno set)
+ */
+bool
+HugeLock(void *p, size_t size) noexcept;
+
 #elif defined(_WIN32)
 #include <windows.h>
 
@@ -99,12 +110,23 @@ HugeDiscard(void *p, size_t size) noexcept
 	VirtualAlloc(p, size, MEM_RESET, PAGE_NOACCESS);
 }
 
+/**
+ * @return false on error (see GetLastError())
+ */
+static inline bool
+HugeLock(void *p, size_t size) noexcept
+{
+	return VirtualLock(p, size);
+}
+
 #else
 
 /* not Linux: fall back to standard C calls */
 
 #include <cstdint>
 
+#include <sys/mman.h>
+
 static inline WritableBuffer<void>
 HugeAllocate(size_t size)
 {
@@ -128,6 +150,12 @@ HugeDiscard(void *, size_t) noexcept
 {
 }
 
+static inline bool
+HugeLock(void *p, size_t size) noexcept
+{
+	return mlock(p, size) == 0;
+}
+
 #endif
 
 /**
@@ -177,6 +205,14 @@ public:
 		HugeDiscard(v.data, v.size);
 	}
 
+	/**
+	 * @return false on error (see HugeLock())
+	 */
+	bool Lock() noexcept {
+		auto v = buffer.ToVoid();
+		return HugeLock(v.data, v.size);
+	}
+
 	constexpr bool operator==(std::nullptr_t) const noexcept {
 		return buffer == nullptr;
 	}
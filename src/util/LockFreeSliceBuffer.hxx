@@ -0,0 +1,289 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_LOCK_FREE_SLICE_BUFFER_HXX
+#define MPD_LOCK_FREE_SLICE_BUFFER_HXX
+
+#include "HugeAllocator.hxx"
+#include "Compiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+/**
+ * A thread-safe variant of #SliceBuffer.  The free list is a
+ * lock-free stack; its top, the number of allocated slices and an
+ * ABA counter are packed into one atomic 64 bit word.
+ *
+ * Like #SliceBuffer, this gives memory back to the kernel when the
+ * last slice is freed.  During that short phase, Allocate() waits.
+ *
+ * The slice size may be larger than sizeof(T), for objects which
+ * are followed by a variable amount of data.
+ */
+template<typename T>
+class LockFreeSliceBuffer {
+	union Slice {
+		/**
+		 * The index of the next free slice, or #NONE.
+		 */
+		std::atomic<uint32_t> next;
+
+		T value;
+	};
+
+	static constexpr unsigned INDEX_BITS = 22;
+	static constexpr uint64_t INDEX_MASK = (uint64_t(1) << INDEX_BITS) - 1;
+	static constexpr unsigned COUNT_SHIFT = INDEX_BITS;
+	static constexpr unsigned TAG_SHIFT = 2 * INDEX_BITS;
+	static constexpr uint64_t TAG_INCREMENT = uint64_t(1) << TAG_SHIFT;
+
+	/**
+	 * The "top" value of an empty free list.
+	 */
+	static constexpr uint32_t NONE = INDEX_MASK;
+
+	/**
+	 * The "count" value while the memory is being discarded.
+	 */
+	static constexpr uint32_t DISCARDING = INDEX_MASK;
+
+	HugeArray<std::byte> buffer;
+
+	/**
+	 * The size of each slice in bytes (at least sizeof(Slice)).
+	 */
+	const std::size_t slice_size;
+
+	/**
+	 * The number of slices.
+	 */
+	const unsigned capacity;
+
+	/**
+	 * Bits 0..21: the index of the first free slice (#NONE if
+	 * the free list is empty); bits 22..43: the number of
+	 * allocated slices; bits 44..63: a counter which is
+	 * incremented by each modification.
+	 *
+	 * Slices which are neither allocated nor in the free list
+	 * have never been used since the last DiscardMemory(); to
+	 * avoid page faults, they are not linked into the free list.
+	 * If the free list is empty, these are all slices starting at
+	 * "count".
+	 */
+	std::atomic<uint64_t> state{Pack(NONE, 0, 0)};
+
+	/**
+	 * Has Lock() been called?  Locked memory is never given back
+	 * to the kernel.
+	 */
+	bool locked = false;
+
+	static constexpr uint64_t Pack(uint32_t top, uint32_t count,
+				       uint64_t tag) noexcept {
+		return top | (uint64_t(count) << COUNT_SHIFT) | tag;
+	}
+
+	static constexpr uint32_t GetTop(uint64_t s) noexcept {
+		return s & INDEX_MASK;
+	}
+
+	static constexpr uint32_t GetCount(uint64_t s) noexcept {
+		return (s >> COUNT_SHIFT) & INDEX_MASK;
+	}
+
+	static constexpr uint64_t NextTag(uint64_t s) noexcept {
+		return (s & ~(TAG_INCREMENT - 1)) + TAG_INCREMENT;
+	}
+
+public:
+	/**
+	 * Throws std::length_error if the number of slices is too
+	 * large.
+	 *
+	 * @param _slice_size the size of each slice in bytes; must
+	 * not be smaller than sizeof(T)
+	 */
+	explicit LockFreeSliceBuffer(unsigned _count,
+				     std::size_t _slice_size=sizeof(T))
+		:buffer(CheckCount(_count) * AlignSliceSize(_slice_size)),
+		 slice_size(AlignSliceSize(_slice_size)),
+		 capacity(_count) {
+		assert(_slice_size >= sizeof(T));
+
+		buffer.ForkCow(false);
+	}
+
+	~LockFreeSliceBuffer() noexcept {
+		/* all slices must be freed explicitly, and this
+		   assertion checks for leaks */
+		assert(empty());
+	}
+
+	LockFreeSliceBuffer(const LockFreeSliceBuffer &other) = delete;
+	LockFreeSliceBuffer &operator=(const LockFreeSliceBuffer &other) = delete;
+
+	unsigned GetCapacity() const noexcept {
+		return capacity;
+	}
+
+	std::size_t GetSliceSize() const noexcept {
+		return slice_size;
+	}
+
+	/**
+	 * Lock the whole buffer in RAM (see HugeLock()).  Must be
+	 * called before the buffer is shared with other threads.
+	 *
+	 * @return false on error (with errno set)
+	 */
+	bool Lock() noexcept {
+		locked = buffer.Lock();
+		return locked;
+	}
+
+	bool empty() const noexcept {
+		const auto count = GetCount(state.load(std::memory_order_relaxed));
+		return count == 0 || count == DISCARDING;
+	}
+
+	bool IsFull() const noexcept {
+		return GetCount(state.load(std::memory_order_relaxed)) == capacity;
+	}
+
+	template<typename... Args>
+	T *Allocate(Args&&... args) {
+		uint64_t s = state.load(std::memory_order_acquire);
+
+		while (true) {
+			const uint32_t count = GetCount(s);
+			if (count == DISCARDING) {
+				/* Free() is currently giving the memory
+				   back to the kernel */
+				std::this_thread::yield();
+				s = state.load(std::memory_order_acquire);
+				continue;
+			}
+
+			const uint32_t top = GetTop(s);
+			uint32_t i, new_top;
+			if (top != NONE) {
+				/* pop the first free slice; if another
+				   thread has modified the list meanwhile,
+				   the value read here may be garbage,
+				   but then the tag has changed and the
+				   CAS fails */
+				i = top;
+				new_top = GetSlice(i).next.load(std::memory_order_relaxed);
+			} else if (count < capacity) {
+				/* use a slice which has never been used */
+				i = count;
+				new_top = NONE;
+			} else
+				/* out of (internal) memory, buffer is full */
+				return nullptr;
+
+			if (state.compare_exchange_weak(s,
+							Pack(new_top, count + 1,
+							     NextTag(s)),
+							std::memory_order_acquire,
+							std::memory_order_acquire)) {
+				/* construct the object */
+				T *value = &GetSlice(i).value;
+				return ::new((void *)value) T(std::forward<Args>(args)...);
+			}
+		}
+	}
+
+	void Free(T *value) noexcept {
+		Slice *slice = reinterpret_cast<Slice *>(value);
+		const std::size_t offset = (std::byte *)slice - &buffer.front();
+		assert(offset < buffer.size());
+		assert(offset % slice_size == 0);
+
+		const uint32_t i = offset / slice_size;
+
+		/* destruct the object */
+		value->~T();
+
+		uint64_t s = state.load(std::memory_order_relaxed);
+
+		while (true) {
+			const uint32_t count = GetCount(s);
+			assert(count > 0);
+			assert(count != DISCARDING);
+
+			if (count == 1) {
+				/* this is the last slice: give memory
+				   back to the kernel; Allocate() waits
+				   until this is finished */
+				if (!state.compare_exchange_weak(s,
+								 Pack(NONE, DISCARDING,
+								      NextTag(s)),
+								 std::memory_order_acquire,
+								 std::memory_order_relaxed))
+					continue;
+
+				if (!locked)
+					buffer.Discard();
+				state.store(Pack(NONE, 0, NextTag(s) + TAG_INCREMENT),
+					    std::memory_order_release);
+				return;
+			}
+
+			/* insert the slice in the "available" linked
+			   list */
+			slice->next.store(GetTop(s), std::memory_order_relaxed);
+
+			if (state.compare_exchange_weak(s,
+							Pack(i, count - 1,
+							     NextTag(s)),
+							std::memory_order_release,
+							std::memory_order_relaxed))
+				return;
+		}
+	}
+
+private:
+	Slice &GetSlice(uint32_t i) noexcept {
+		return *reinterpret_cast<Slice *>(&buffer[i * slice_size]);
+	}
+
+	static constexpr std::size_t AlignSliceSize(std::size_t size) noexcept {
+		return (std::max(size, sizeof(Slice)) + alignof(Slice) - 1)
+			/ alignof(Slice) * alignof(Slice);
+	}
+
+	static unsigned CheckCount(unsigned count) {
+		if (count >= NONE)
+			throw std::length_error("Too many slices");
+
+		return count;
+	}
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Unit tests for src/protocol/Compact.cxx
+ */
+
+#include "protocol/Compact.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+static std::string
+ToString(const CompactRecord &record)
+{
+	const auto data = ConstBuffer<char>::FromVoid(record.GetData());
+	return {data.data, data.size};
+}
+
+TEST(CompactRecord, String)
+{
+	CompactRecord record;
+	EXPECT_TRUE(record.empty());
+	EXPECT_TRUE(record.AddString(CompactField::URI, "a.flac"));
+	EXPECT_TRUE(record.AddPath(CompactField::URI, "d", "b.ogg"));
+	EXPECT_TRUE(record.AddTag(TAG_ARTIST, "X"));
+	EXPECT_FALSE(record.empty());
+
+	EXPECT_EQ(std::string("\x01\x06" "a.flac"
+			      "\x01\x07" "d/b.ogg"
+			      "\x80\x01" "X"),
+		  ToString(record));
+}
+
+TEST(CompactRecord, Number)
+{
+	CompactRecord record;
+	EXPECT_TRUE(record.AddNumber(CompactField::POS, 0));
+	EXPECT_TRUE(record.AddNumber(CompactField::ID, 300));
+	EXPECT_TRUE(record.AddNumbers(CompactField::RANGE, 127, 128));
+
+	EXPECT_EQ(std::string("\x06\x01\x00"
+			      "\x07\x02\xac\x02"
+			      "\x03\x03\x7f\x80\x01", 12),
+		  ToString(record));
+}
+
+TEST(CompactRecord, Overflow)
+{
+	const std::string big(CompactRecord::MAX_FIELDS_SIZE - 6, 'x');
+
+	CompactRecord record;
+	EXPECT_TRUE(record.AddString(CompactField::URI, big.c_str()));
+	EXPECT_FALSE(record.AddString(CompactField::FORMAT, "abc"));
+	EXPECT_TRUE(record.AddNumber(CompactField::POS, 1));
+	EXPECT_EQ(CompactRecord::MAX_FIELDS_SIZE, record.GetData().size);
+	EXPECT_FALSE(record.AddTag(TAG_TITLE, "T"));
+	EXPECT_TRUE(record.IsTruncated());
+
+	/* the omitted fields are counted in the last field, which
+	   still fits into the record */
+	record.Finish();
+	EXPECT_FALSE(record.IsTruncated());
+	const auto data = ToString(record);
+	EXPECT_LE(data.size(), CompactRecord::MAX_SIZE);
+	EXPECT_EQ(data.substr(CompactRecord::MAX_FIELDS_SIZE),
+		  std::string("\x09\x01\x02"));
+}
+
+TEST(CompactRecord, NotTruncated)
+{
+	CompactRecord record;
+	EXPECT_TRUE(record.AddString(CompactField::URI, "a.flac"));
+	record.Finish();
+	EXPECT_EQ(std::string("\x01\x06" "a.flac"), ToString(record));
+}
+
+TEST(CompactRecord, QueueIdentifiers)
+{
+	/* the identifiers of a queue entry are added first (see
+	   queue_print_song_info()), so an oversized tag cannot push
+	   them out */
+	const std::string comment(CompactRecord::MAX_SIZE, 'x');
+
+	CompactRecord record;
+	EXPECT_TRUE(record.AddNumber(CompactField::POS, 1));
+	EXPECT_TRUE(record.AddNumber(CompactField::ID, 2));
+	EXPECT_TRUE(record.AddString(CompactField::URI, "a.flac"));
+	EXPECT_FALSE(record.AddTag(TAG_COMMENT, comment.c_str()));
+	EXPECT_TRUE(record.AddTag(TAG_TITLE, "T"));
+	record.Finish();
+
+	EXPECT_EQ(std::string("\x06\x01\x01"
+			      "\x07\x01\x02"
+			      "\x01\x06" "a.flac")
+		  + char(0x80 + TAG_TITLE) + std::string("\x01" "T")
+		  + std::string("\x09\x01\x01"),
+		  ToString(record));
+}
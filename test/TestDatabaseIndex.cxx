@@ -0,0 +1,186 @@
+/*
+ * Unit tests for the indexes of src/db/plugins/simple/
+ */
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/Selection.hxx"
+#include "db/Visitor.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "config/Block.hxx"
+#include "lib/icu/Init.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+static std::string
+MakePath(const char *name)
+{
+	return testing::TempDir() + "TestDatabaseIndex." + name + "." +
+		std::to_string(getpid());
+}
+
+static std::unique_ptr<SimpleDatabase>
+MakeDatabase(const char *name, bool indexes)
+{
+	const auto path = MakePath(name);
+
+	ConfigBlock block;
+	block.AddBlockParam("path", path.c_str());
+	if (indexes) {
+		block.AddBlockParam("sort_index", "artist,title");
+		block.AddBlockParam("tag_index", "artist,album");
+		block.AddBlockParam("trigram_index", "title");
+	}
+
+	auto db = std::make_unique<SimpleDatabase>(block);
+	db->Open();
+	return db;
+}
+
+/**
+ * Add songs in an order which is not sorted.
+ */
+static void
+AddSongs(Directory &directory, const char *album)
+{
+	for (unsigned n = 9; n > 0; --n) {
+		const std::string filename =
+			std::to_string(n * 7 % 10) + ".flac";
+		const std::string artist = "Artist " + std::to_string(n % 3);
+		const std::string title =
+			"Title " + std::to_string(n) + album;
+
+		auto song = std::make_unique<Song>(filename, directory);
+		song->tag = MakeTag(TAG_ARTIST, artist.c_str(),
+				    TAG_ALBUM, album,
+				    TAG_TITLE, title.c_str());
+		directory.AddSong(std::move(song));
+	}
+
+	directory.MarkModified();
+}
+
+/**
+ * Fill and save the database like the update thread does: the new
+ * entries are not sorted, and an empty directory is left behind.
+ */
+static void
+Update(SimpleDatabase &db)
+{
+	db.BeginUpdate();
+
+	{
+		const ScopeDatabaseLock protect;
+		auto &root = db.GetRoot();
+
+		AddSongs(*root.MakeChild("z"), "z");
+		AddSongs(*root.MakeChild("b"), "b");
+		AddSongs(*root.MakeChild("m")->MakeChild("nested"), "nested");
+		AddSongs(*root.MakeChild("a"), "a");
+		root.MakeChild("empty")->MarkModified();
+	}
+
+	db.EndUpdate(true);
+	db.Save();
+}
+
+static std::vector<std::string>
+Visit(const SimpleDatabase &db, const DatabaseSelection &selection)
+{
+	std::vector<std::string> result;
+	db.Visit(selection, VisitDirectory(),
+		 [&result](const LightSong &song){
+			 result.emplace_back(song.GetURI());
+		 },
+		 VisitPlaylist());
+	return result;
+}
+
+class DatabaseIndexTest : public ::testing::Test {
+protected:
+	const ScopeIcuInit icu_init;
+
+	std::unique_ptr<SimpleDatabase> indexed, plain;
+
+	void SetUp() override {
+		indexed = MakeDatabase("indexed", true);
+		plain = MakeDatabase("plain", false);
+
+		Update(*indexed);
+		Update(*plain);
+	}
+
+	void TearDown() override {
+		indexed->Close();
+		plain->Close();
+
+		unlink(MakePath("indexed").c_str());
+		unlink(MakePath("plain").c_str());
+	}
+
+	/**
+	 * Compare the results of the indexed database with the ones
+	 * of the plain walk.
+	 */
+	void Compare(std::initializer_list<const char *> args,
+		     bool fold_case,
+		     TagType sort=TAG_NUM_OF_ITEM_TYPES,
+		     RangeArg window=RangeArg::All(),
+		     const char *base="") {
+		std::unique_ptr<SongFilter> filter;
+		if (args.size() > 0) {
+			filter = std::make_unique<SongFilter>();
+			filter->Parse({args.begin(), args.size()}, fold_case);
+			filter->Optimize();
+		}
+
+		DatabaseSelection selection(base, true, filter.get());
+		selection.sort = sort;
+		selection.window = window;
+
+		const auto expected = Visit(*plain, selection);
+		EXPECT_FALSE(expected.empty());
+		EXPECT_EQ(Visit(*indexed, selection), expected);
+	}
+};
+
+TEST_F(DatabaseIndexTest, Pruned)
+{
+	const ScopeDatabaseLock protect;
+	EXPECT_EQ(indexed->GetRoot().FindChild("empty"), nullptr);
+	EXPECT_EQ(plain->GetRoot().FindChild("empty"), nullptr);
+}
+
+TEST_F(DatabaseIndexTest, Find)
+{
+	Compare({"artist", "Artist 1"}, false);
+	Compare({"album", "nested"}, false);
+	Compare({"artist", "Artist 2"}, false, TAG_NUM_OF_ITEM_TYPES,
+		RangeArg::All(), "b");
+}
+
+TEST_F(DatabaseIndexTest, Search)
+{
+	Compare({"title", "itle 1"}, true);
+	Compare({"title", "TITLE 7A"}, true);
+}
+
+TEST_F(DatabaseIndexTest, SortWindow)
+{
+	Compare({}, false, TAG_ARTIST, {3, 11});
+	Compare({}, false, TAG_TITLE, {0, 5});
+	Compare({}, false, TAG_ARTIST);
+	Compare({"album", "z"}, false, TAG_TITLE, {1, 4});
+	Compare({}, false, TAG_ARTIST, {2, 6}, "m");
+}
@@ -0,0 +1,306 @@
+/*
+ * Unit tests for src/db/plugins/simple/DatabaseJournal.cxx
+ */
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/DatabaseJournal.hxx"
+#include "db/plugins/simple/DirectorySave.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "config/Block.hxx"
+#include "lib/icu/Init.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileSystem.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/StringLineReader.hxx"
+#include "fs/io/StringOutputStream.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+static void
+AddSong(Directory &directory, const char *name, const char *artist)
+{
+	auto song = std::make_unique<Song>(name, directory);
+	song->tag = MakeTag(TAG_ARTIST, artist);
+	directory.AddSong(std::move(song));
+}
+
+/**
+ * Serialize the whole tree in the database text format.
+ */
+static std::string
+Dump(const Directory &directory)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	directory_save(bos, directory);
+	bos.Flush();
+	return std::move(sos).GetValue();
+}
+
+static Directory *
+Load(std::string dump)
+{
+	auto *root = Directory::NewRoot();
+	StringLineReader reader(dump);
+	const ScopeDatabaseLock protect;
+	directory_load(reader, *root);
+	return root;
+}
+
+class DatabaseJournalTest : public ::testing::Test {
+protected:
+	static constexpr uint64_t BASE_SIZE = 1234, BASE_MTIME = 5678;
+
+	const ScopeIcuInit icu_init;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	std::string base;
+
+	void SetUp() override {
+		const ScopeDatabaseLock protect;
+
+		auto &a = *root->CreateChild("a");
+		AddSong(a, "1.flac", "A1");
+		AddSong(a, "2.flac", "A2");
+		AddSong(*a.CreateChild("nested"), "3.flac", "A3");
+
+		auto &b = *root->CreateChild("b");
+		AddSong(b, "4.flac", "B4");
+		b.playlists.UpdateOrInsert(PlaylistInfo("list.m3u"));
+
+		base = Dump(*root);
+	}
+
+	/**
+	 * Write a journal batch with all modified directories and
+	 * clear the "modified" flags, like SimpleDatabase::Save()
+	 * does.
+	 */
+	void SaveBatch(BufferedOutputStream &os) {
+		const ScopeDatabaseLock protect;
+		db_journal_prepare(*root);
+		db_journal_save(os, *root);
+		root->ClearModified();
+	}
+
+	/**
+	 * Modify the tree: add a song and a new nested directory
+	 * below "a" and delete "b".
+	 */
+	void ModifyFirst() {
+		const ScopeDatabaseLock protect;
+		auto &a = *root->FindChild("a");
+		AddSong(a, "0.flac", "A0");
+		a.MarkModified();
+
+		auto &c = *a.FindChild("nested")->CreateChild("deeper");
+		AddSong(c, "5.flac", "C5");
+		c.MarkModified();
+
+		root->FindChild("b")->Delete();
+	}
+
+	/**
+	 * Modify the tree again: remove a song from "a".
+	 */
+	void ModifySecond() {
+		const ScopeDatabaseLock protect;
+		auto &a = *root->FindChild("a");
+		a.RemoveSong(a.FindSong("2.flac"));
+		a.MarkModified();
+	}
+
+	std::string Replay(std::string journal,
+			   uint64_t base_size=BASE_SIZE,
+			   uint64_t base_mtime=BASE_MTIME,
+			   bool expected_result=true) {
+		std::unique_ptr<Directory> replayed(Load(base));
+		const ScopeDatabaseLock protect;
+		EXPECT_EQ(db_journal_load(journal, *replayed,
+					  base_size, base_mtime),
+			  expected_result);
+		return Dump(*replayed);
+	}
+};
+
+TEST_F(DatabaseJournalTest, Replay)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_journal_save_header(bos, BASE_SIZE, BASE_MTIME);
+
+	ModifyFirst();
+	SaveBatch(bos);
+	ModifySecond();
+	SaveBatch(bos);
+	bos.Flush();
+
+	const auto expected = Dump(*root);
+	EXPECT_NE(expected, base);
+	EXPECT_EQ(Replay(sos.GetValue()), expected);
+}
+
+TEST_F(DatabaseJournalTest, Stale)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_journal_save_header(bos, BASE_SIZE, BASE_MTIME);
+	ModifyFirst();
+	SaveBatch(bos);
+	bos.Flush();
+
+	/* a journal written for another database file must not be
+	   applied */
+	EXPECT_EQ(Replay(sos.GetValue(), BASE_SIZE + 1, BASE_MTIME, false),
+		  base);
+	EXPECT_EQ(Replay(sos.GetValue(), BASE_SIZE, BASE_MTIME + 1, false),
+		  base);
+}
+
+TEST_F(DatabaseJournalTest, IncompleteBatch)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_journal_save_header(bos, BASE_SIZE, BASE_MTIME);
+	ModifyFirst();
+	SaveBatch(bos);
+	bos.Flush();
+
+	const auto expected = Dump(*root);
+	const std::size_t committed = sos.GetValue().size();
+
+	ModifySecond();
+	SaveBatch(bos);
+	bos.Flush();
+
+	/* cut off the "commit" line of the second batch, and then
+	   some more, as if MPD had crashed while writing it */
+	std::string journal = sos.GetValue();
+	for (std::size_t size = journal.size() - 1; size > committed;
+	     size -= 7)
+		EXPECT_EQ(Replay(journal.substr(0, size)), expected);
+
+	/* the incomplete batch is removed from the buffer */
+	std::unique_ptr<Directory> replayed(Load(base));
+	std::string data = journal.substr(0, journal.size() - 1);
+	{
+		const ScopeDatabaseLock protect;
+		EXPECT_TRUE(db_journal_load(data, *replayed,
+					    BASE_SIZE, BASE_MTIME));
+	}
+	EXPECT_EQ(data.size(), committed);
+}
+
+TEST_F(DatabaseJournalTest, Empty)
+{
+	/* an empty journal or one without a single committed batch
+	   is a no-op */
+	EXPECT_EQ(Replay(std::string()), base);
+
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_journal_save_header(bos, BASE_SIZE, BASE_MTIME);
+	bos.Flush();
+	EXPECT_EQ(Replay(sos.GetValue()), base);
+}
+
+TEST_F(DatabaseJournalTest, Malformed)
+{
+	std::unique_ptr<Directory> replayed(Load(base));
+	const ScopeDatabaseLock protect;
+
+	std::string data("foo\ncommit\n");
+	EXPECT_ANY_THROW(db_journal_load(data, *replayed,
+					 BASE_SIZE, BASE_MTIME));
+
+	data = "journal: 1\nbase: 1234 5678\ngarbage\ncommit\n";
+	EXPECT_ANY_THROW(db_journal_load(data, *replayed,
+					 BASE_SIZE, BASE_MTIME));
+}
+
+/**
+ * Test SimpleDatabase::Save() with "journal": the journal is
+ * compacted into the database file when it becomes larger than
+ * the database file, and a reloaded database always equals the
+ * in-memory tree.
+ */
+TEST(DatabaseJournal, Compaction)
+{
+	const ScopeIcuInit icu_init;
+
+	const std::string file_name = "TestDatabaseJournal." +
+		std::to_string(getpid());
+	const auto db_path =
+		AllocatedPath::Build(testing::TempDir().c_str(),
+				     file_name.c_str());
+	const auto journal_path =
+		AllocatedPath::FromFS(db_path.c_str() +
+				      std::string(".journal"));
+
+	ConfigBlock block;
+	block.AddBlockParam("path", db_path.c_str());
+	block.AddBlockParam("journal", "yes");
+	block.AddBlockParam("compress", "no");
+
+	const auto Reload = [&block](){
+		SimpleDatabase db(block);
+		db.Open();
+		auto result = Dump(db.GetRoot());
+		db.Close();
+		return result;
+	};
+
+	SimpleDatabase db(block);
+	db.Open();
+
+	auto &root = db.GetRoot();
+
+	const auto Modify = [&root](const char *name, unsigned n_songs){
+		const ScopeDatabaseLock protect;
+		auto &directory = *root.MakeChild(name);
+		for (unsigned i = 0; i < n_songs; ++i)
+			AddSong(directory,
+				(std::to_string(i) + ".flac").c_str(),
+				name);
+		directory.MarkModified();
+	};
+
+	/* the first Save() writes the database file */
+	Modify("a", 32);
+	db.Save();
+	EXPECT_TRUE(PathExists(db_path));
+	EXPECT_FALSE(PathExists(journal_path));
+	EXPECT_EQ(Reload(), Dump(root));
+
+	/* small modifications are appended to the journal */
+	Modify("b", 1);
+	db.Save();
+	EXPECT_TRUE(PathExists(journal_path));
+	EXPECT_EQ(Reload(), Dump(root));
+
+	/* this batch makes the journal larger than the database
+	   file */
+	Modify("c", 64);
+	db.Save();
+	EXPECT_TRUE(PathExists(journal_path));
+	EXPECT_EQ(Reload(), Dump(root));
+
+	/* ... so the next Save() rewrites the database file and
+	   deletes the journal */
+	Modify("d", 1);
+	db.Save();
+	EXPECT_FALSE(PathExists(journal_path));
+	EXPECT_EQ(Reload(), Dump(root));
+
+	db.Close();
+	RemoveFile(db_path);
+}
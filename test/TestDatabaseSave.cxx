@@ -0,0 +1,506 @@
+/*
+ * Unit tests for src/db/plugins/simple/DatabaseSave.cxx and
+ * src/db/plugins/simple/DatabaseBinary.cxx
+ */
+
+#include "db/plugins/simple/DatabaseSave.hxx"
+#include "db/plugins/simple/DatabaseBinary.hxx"
+#include "db/plugins/simple/DirectorySave.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "tag/Builder.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/StringLineReader.hxx"
+#include "fs/io/StringOutputStream.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <string.h>
+#include <unistd.h>
+
+static std::chrono::system_clock::time_point
+MakeTime(std::time_t t) noexcept
+{
+	return std::chrono::system_clock::from_time_t(t);
+}
+
+static void
+AddSong(Directory &directory, const char *name, const char *artist,
+	const char *title, std::time_t mtime=0)
+{
+	auto song = std::make_unique<Song>(name, directory);
+
+	TagBuilder tag;
+	tag.AddItem(TAG_ARTIST, artist);
+	tag.AddItem(TAG_TITLE, title);
+	tag.AddItem(TAG_GENRE, "Rock");
+	tag.AddItem(TAG_GENRE, "Pop");
+	tag.SetDuration(SignedSongTime::FromMS(123456));
+	song->tag = tag.Commit();
+
+	if (mtime > 0)
+		song->mtime = MakeTime(mtime);
+	song->audio_format = AudioFormat(44100, SampleFormat::S16, 2);
+
+	directory.AddSong(std::move(song));
+}
+
+/**
+ * Build a tree which uses all features of the database formats.
+ *
+ * Caller must lock the #db_mutex.
+ */
+static void
+Populate(Directory &root, unsigned n_top_level=4)
+{
+	AddSong(root, "root.ogg", "Root Artist", "Root Title");
+	root.playlists.UpdateOrInsert(PlaylistInfo("root.m3u",
+						   MakeTime(1000)));
+
+	for (unsigned i = 0; i < n_top_level; ++i) {
+		const std::string name = "Dir " + std::to_string(i);
+		auto &dir = *root.CreateChild(name.c_str());
+		dir.mtime = MakeTime(100000 + i);
+
+		for (unsigned j = 0; j < 3; ++j) {
+			const std::string song_name =
+				std::to_string(j) + " \xc3\xa4.flac";
+			AddSong(dir, song_name.c_str(), name.c_str(),
+				song_name.c_str(), 200000 + j);
+		}
+
+		dir.playlists.UpdateOrInsert(PlaylistInfo("list.m3u"));
+
+		auto &nested = *dir.CreateChild("nested");
+		auto &deeper = *nested.CreateChild("deeper");
+		AddSong(deeper, "deep.mp3", "Deep", "Deeper");
+		deeper.CreateChild("empty");
+	}
+
+	auto &archive = *root.CreateChild("archive.zip");
+	archive.device = DEVICE_INARCHIVE;
+	AddSong(*archive.CreateChild("inside"), "a.mod", "Tracker",
+		"Module");
+
+	auto &container = *root.CreateChild("container.sid");
+	container.device = DEVICE_CONTAINER;
+	container.mtime = MakeTime(300000);
+
+	auto track = std::make_unique<Song>("tune_001.sid", container);
+	track->start_time = SongTime::FromMS(1000);
+	track->end_time = SongTime::FromMS(61000);
+	track->SetTarget("../container.sid");
+	container.AddSong(std::move(track));
+}
+
+/**
+ * Serialize the whole tree in the database text format.
+ */
+static std::string
+Dump(const Directory &directory)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	directory_save(bos, directory);
+	bos.Flush();
+	return std::move(sos).GetValue();
+}
+
+static std::string
+SaveText(const Directory &root)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_save_internal(bos, root);
+	bos.Flush();
+	return std::move(sos).GetValue();
+}
+
+static std::string
+LoadText(std::string text, unsigned n_threads=1)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+	StringLineReader reader(text);
+	db_load_internal(reader, *root, n_threads);
+
+	const ScopeDatabaseLock protect;
+	return Dump(*root);
+}
+
+/**
+ * A copy of a binary database file in a buffer with the alignment
+ * of a #FileMapping.
+ */
+class BinaryBuffer {
+	std::vector<uint64_t> buffer;
+	std::size_t size;
+
+public:
+	explicit BinaryBuffer(const std::string &src) noexcept
+		:buffer((src.size() + 7) / 8), size(src.size()) {
+		memcpy(buffer.data(), src.data(), size);
+	}
+
+	std::size_t GetSize() const noexcept {
+		return size;
+	}
+
+	uint8_t *data() noexcept {
+		return (uint8_t *)buffer.data();
+	}
+
+	template<typename T>
+	T &At(std::size_t offset) noexcept {
+		return *(T *)(data() + offset);
+	}
+
+	ConstBuffer<void> Get(std::size_t _size) const noexcept {
+		return {buffer.data(), _size};
+	}
+
+	ConstBuffer<void> Get() const noexcept {
+		return Get(size);
+	}
+};
+
+static std::string
+SaveBinary(const Directory &root)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_save_binary(bos, root);
+	bos.Flush();
+	return std::move(sos).GetValue();
+}
+
+static std::string
+LoadBinary(ConstBuffer<void> src)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+	db_load_binary(src, *root);
+
+	const ScopeDatabaseLock protect;
+	return Dump(*root);
+}
+
+class DatabaseSaveTest : public ::testing::Test {
+protected:
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	void SetUp() override {
+		const ScopeDatabaseLock protect;
+		Populate(*root);
+	}
+
+	std::string Dump() const {
+		const ScopeDatabaseLock protect;
+		return ::Dump(*root);
+	}
+};
+
+TEST_F(DatabaseSaveTest, Text)
+{
+	const auto text = SaveText(*root);
+	EXPECT_FALSE(db_is_binary({text.data(), text.size()}));
+	EXPECT_EQ(LoadText(text), Dump());
+}
+
+TEST_F(DatabaseSaveTest, Binary)
+{
+	const BinaryBuffer binary(SaveBinary(*root));
+	EXPECT_TRUE(db_is_binary(binary.Get()));
+	EXPECT_EQ(LoadBinary(binary.Get()), Dump());
+}
+
+/**
+ * Convert text → binary → text; nothing may get lost.
+ */
+TEST_F(DatabaseSaveTest, TextBinaryText)
+{
+	std::string text = SaveText(*root);
+
+	std::unique_ptr<Directory> loaded(Directory::NewRoot());
+	StringLineReader reader(text);
+	db_load_internal(reader, *loaded);
+
+	const BinaryBuffer binary(SaveBinary(*loaded));
+	std::unique_ptr<Directory> reloaded(Directory::NewRoot());
+	db_load_binary(binary.Get(), *reloaded);
+
+	EXPECT_EQ(SaveText(*reloaded), SaveText(*root));
+}
+
+TEST_F(DatabaseSaveTest, TextTruncated)
+{
+	const auto text = SaveText(*root);
+
+	/* a truncated text file is only detected if it ends inside
+	   a directory or a song */
+	for (std::size_t size = 0; size < text.size(); ++size) {
+		try {
+			LoadText(text.substr(0, size));
+		} catch (const std::runtime_error &) {
+		}
+	}
+}
+
+TEST_F(DatabaseSaveTest, BinaryTruncated)
+{
+	const BinaryBuffer binary(SaveBinary(*root));
+
+	for (std::size_t size = 0; size < binary.GetSize(); ++size)
+		EXPECT_THROW(LoadBinary(binary.Get(size)),
+			     std::runtime_error) << "size=" << size;
+}
+
+/**
+ * The layout of #BinaryHeader (see DatabaseBinary.cxx).
+ */
+static constexpr std::size_t HEADER_BYTE_ORDER = 8;
+static constexpr std::size_t HEADER_FORMAT = 12;
+static constexpr std::size_t HEADER_FS_CHARSET = 16;
+static constexpr std::size_t HEADER_SECTIONS = 24;
+static constexpr std::size_t N_SECTIONS = 6;
+static constexpr std::size_t HEADER_SIZE = HEADER_SECTIONS + N_SECTIONS * 16;
+
+TEST_F(DatabaseSaveTest, BinaryCorruptedHeader)
+{
+	const std::string original = SaveBinary(*root);
+
+	{
+		BinaryBuffer binary(original);
+		binary.data()[0] = 'X';
+		EXPECT_FALSE(db_is_binary(binary.Get()));
+		EXPECT_THROW(LoadBinary(binary.Get()), std::runtime_error);
+	}
+
+	{
+		BinaryBuffer binary(original);
+		binary.At<uint32_t>(HEADER_BYTE_ORDER) = 0x04030201;
+		EXPECT_THROW(LoadBinary(binary.Get()), std::runtime_error);
+	}
+
+	{
+		BinaryBuffer binary(original);
+		++binary.At<uint32_t>(HEADER_FORMAT);
+		EXPECT_THROW(LoadBinary(binary.Get()), std::runtime_error);
+	}
+
+	{
+		BinaryBuffer binary(original);
+		binary.At<uint32_t>(HEADER_FS_CHARSET) = 0xffffffff;
+		EXPECT_THROW(LoadBinary(binary.Get()), std::runtime_error);
+	}
+
+	/* flipping any bits of the header must never crash */
+	for (std::size_t i = 0; i < HEADER_SIZE; ++i) {
+		for (uint8_t mask : {0x01, 0x80, 0xff}) {
+			BinaryBuffer binary(original);
+			binary.data()[i] ^= mask;
+
+			try {
+				LoadBinary(binary.Get());
+			} catch (const std::runtime_error &) {
+			}
+		}
+	}
+}
+
+TEST_F(DatabaseSaveTest, BinaryCorruptedSections)
+{
+	const std::string original = SaveBinary(*root);
+
+	for (std::size_t i = 0; i < N_SECTIONS; ++i) {
+		const std::size_t offset = HEADER_SECTIONS + i * 16;
+		const std::size_t count = offset + 8;
+
+		/* beyond the end of the file */
+		for (uint64_t value : {uint64_t(original.size() + 8),
+				       uint64_t(1) << 40,
+				       ~uint64_t(0) - 7}) {
+			BinaryBuffer binary(original);
+			binary.At<uint64_t>(offset) = value;
+			EXPECT_THROW(LoadBinary(binary.Get()),
+				     std::runtime_error)
+				<< "section=" << i << " offset=" << value;
+		}
+
+		/* misaligned */
+		if (i != N_SECTIONS - 1) {
+			BinaryBuffer binary(original);
+			++binary.At<uint64_t>(offset);
+			EXPECT_THROW(LoadBinary(binary.Get()),
+				     std::runtime_error)
+				<< "section=" << i;
+		}
+
+		/* too many records */
+		for (uint64_t value : {uint64_t(original.size()),
+				       ~uint64_t(0) / 2, ~uint64_t(0)}) {
+			BinaryBuffer binary(original);
+			binary.At<uint64_t>(count) = value;
+			EXPECT_THROW(LoadBinary(binary.Get()),
+				     std::runtime_error)
+				<< "section=" << i << " count=" << value;
+		}
+	}
+}
+
+/**
+ * Overwrite the record sections (i.e. everything between the header
+ * and the string table) with garbage; this must never crash.
+ */
+TEST_F(DatabaseSaveTest, BinaryCorruptedRecords)
+{
+	const std::string original = SaveBinary(*root);
+	const BinaryBuffer reference(original);
+	const std::size_t strings_offset =
+		const_cast<BinaryBuffer &>(reference)
+		.At<uint64_t>(HEADER_SECTIONS + (N_SECTIONS - 1) * 16);
+
+	for (std::size_t i = HEADER_SIZE; i < strings_offset; i += 4) {
+		for (uint32_t value : {0x7fffffffU, 0xffffffffU, 1U}) {
+			BinaryBuffer binary(original);
+			binary.At<uint32_t>(i) = value;
+
+			try {
+				LoadBinary(binary.Get());
+			} catch (const std::runtime_error &) {
+			}
+		}
+	}
+}
+
+/**
+ * Attach an (empty) #SimpleDatabase as a mount point; it is never
+ * saved.
+ *
+ * Caller must lock the #db_mutex.
+ */
+static void
+AddMount(Directory &parent, const char *name)
+{
+	const std::string path = testing::TempDir() + "TestDatabaseSave." +
+		name + "." + std::to_string(getpid());
+
+	auto db = std::make_unique<SimpleDatabase>(AllocatedPath::FromFS(path.c_str()),
+						   false, false, false);
+
+	{
+		const ScopeDatabaseUnlock unlock;
+		db->Open();
+	}
+
+	parent.CreateChild(name)->mounted_database = std::move(db);
+}
+
+/**
+ * Load the text database with several worker threads
+ * (directory_load_parallel()); the result must equal the serial
+ * load.
+ */
+TEST(DatabaseSave, Parallel)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+
+	{
+		const ScopeDatabaseLock protect;
+
+		/* more top-level directories than chunks are held in
+		   memory at a time */
+		Populate(*root, 50);
+
+		AddMount(*root, "mnt");
+		AddMount(*root->FindChild("Dir 7"), "mnt");
+	}
+
+	const auto text = SaveText(*root);
+	const auto expected = LoadText(text, 1);
+
+	{
+		const ScopeDatabaseLock protect;
+		EXPECT_EQ(expected, Dump(*root));
+	}
+
+	for (unsigned n_threads : {2, 3, 8, 64})
+		EXPECT_EQ(LoadText(text, n_threads), expected)
+			<< "n_threads=" << n_threads;
+}
+
+TEST(DatabaseSave, ParallelMalformed)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+
+	{
+		const ScopeDatabaseLock protect;
+		Populate(*root, 20);
+	}
+
+	const auto text = SaveText(*root);
+
+	/* a malformed line inside a nested directory is found by a
+	   worker thread */
+	std::string malformed = text;
+	const auto deep = malformed.find("begin: Dir 13/nested/deeper\n");
+	ASSERT_NE(deep, malformed.npos);
+	malformed.insert(deep, "garbage\n");
+
+	EXPECT_THROW(LoadText(malformed, 1), std::runtime_error);
+	EXPECT_THROW(LoadText(malformed, 4), std::runtime_error);
+
+	/* a duplicate top-level directory */
+	std::string duplicate = text;
+	const auto dir = duplicate.find("directory: Dir 3\n");
+	const auto end = duplicate.find("end: Dir 3\n");
+	ASSERT_NE(dir, duplicate.npos);
+	ASSERT_NE(end, duplicate.npos);
+	duplicate.insert(dir, duplicate.substr(dir, end + 11 - dir));
+
+	EXPECT_THROW(LoadText(duplicate, 1), std::runtime_error);
+	EXPECT_THROW(LoadText(duplicate, 4), std::runtime_error);
+
+}
+
+/**
+ * Like LoadText(), but returns an empty string on error.
+ */
+static std::string
+TryLoadText(std::string text, unsigned n_threads)
+{
+	try {
+		return LoadText(std::move(text), n_threads);
+	} catch (const std::runtime_error &) {
+		return std::string();
+	}
+}
+
+/**
+ * A truncated file must be rejected (or accepted) by the parallel
+ * loader exactly like by the serial one.
+ */
+TEST(DatabaseSave, ParallelTruncated)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+
+	{
+		const ScopeDatabaseLock protect;
+		Populate(*root, 3);
+	}
+
+	const auto text = SaveText(*root);
+
+	for (std::size_t size = 0; size < text.size(); ++size) {
+		const auto truncated = text.substr(0, size);
+		EXPECT_EQ(TryLoadText(truncated, 4),
+			  TryLoadText(truncated, 1))
+			<< "size=" << size;
+	}
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static constexpr AudioFormat audio_format(44100, SampleFormat::S16, 2);
+
+static MusicChunkPtr
+AllocateWait(MusicBuffer &buffer) noexcept
+{
+	while (true) {
+		auto chunk = buffer.Allocate();
+		if (chunk)
+			return chunk;
+
+		std::this_thread::yield();
+	}
+}
+
+static void
+WriteSerial(MusicChunk &chunk, unsigned serial) noexcept
+{
+	auto w = chunk.Write(audio_format, SongTime::zero(), 0);
+	memcpy(w.data, &serial, sizeof(serial));
+	chunk.Expand(audio_format, sizeof(serial));
+}
+
+static unsigned
+ReadSerial(const MusicChunk &chunk) noexcept
+{
+	unsigned serial;
+	memcpy(&serial, chunk.GetData(), sizeof(serial));
+	return serial;
+}
+
+TEST(MusicBuffer, Full)
+{
+	constexpr unsigned N = 16;
+	MusicBuffer buffer(N);
+	EXPECT_EQ(buffer.GetSize(), N);
+
+	for (unsigned round = 0; round < 3; ++round) {
+		std::vector<MusicChunkPtr> chunks;
+		for (unsigned i = 0; i < N; ++i) {
+			EXPECT_FALSE(buffer.IsFull());
+			chunks.push_back(buffer.Allocate());
+			ASSERT_TRUE(chunks.back());
+		}
+
+		EXPECT_TRUE(buffer.IsFull());
+		EXPECT_FALSE(buffer.Allocate());
+
+		/* free one in the middle and get it back */
+		MusicChunk *const middle = chunks[N / 2].get();
+		chunks[N / 2].reset();
+		EXPECT_FALSE(buffer.IsFull());
+		chunks[N / 2] = buffer.Allocate();
+		EXPECT_EQ(chunks[N / 2].get(), middle);
+
+		chunks.clear();
+#ifndef NDEBUG
+		EXPECT_TRUE(buffer.IsEmptyUnsafe());
+#endif
+	}
+}
+
+TEST(MusicBuffer, ChunkSize)
+{
+	constexpr unsigned N = 4;
+	constexpr size_t CHUNK_SIZE = 16384;
+	MusicBuffer buffer(N, CHUNK_SIZE);
+
+	const size_t capacity = buffer.GetChunkCapacity();
+	EXPECT_GT(capacity, MusicChunk::GetCapacity(DEFAULT_CHUNK_SIZE));
+	EXPECT_LT(capacity, CHUNK_SIZE);
+
+	std::vector<MusicChunkPtr> chunks;
+	for (unsigned i = 0; i < N; ++i) {
+		auto chunk = buffer.Allocate();
+		ASSERT_TRUE(chunk);
+		EXPECT_EQ(chunk->capacity, capacity);
+
+		/* fill the whole chunk */
+		auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+		EXPECT_EQ(w.size, capacity / 4 * 4);
+		memset(w.data, 'a' + i, w.size);
+		EXPECT_TRUE(chunk->Expand(audio_format, w.size));
+
+		chunks.push_back(std::move(chunk));
+	}
+
+	EXPECT_TRUE(buffer.IsFull());
+
+	/* the chunks must not overlap */
+	for (unsigned i = 0; i < N; ++i) {
+		const auto &chunk = *chunks[i];
+		for (size_t j = 0; j < chunk.length; ++j)
+			ASSERT_EQ(chunk.GetData()[j], 'a' + i);
+	}
+}
+
+TEST(MusicBuffer, Threads)
+{
+	constexpr unsigned N = 64;
+	MusicBuffer buffer(N);
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < 4; ++t) {
+		threads.emplace_back([&buffer, t](){
+			std::vector<MusicChunkPtr> chunks;
+			for (unsigned i = 0; i < 20000; ++i) {
+				auto chunk = buffer.Allocate();
+				const bool full = !chunk;
+				if (!full) {
+					WriteSerial(*chunk, t);
+					chunks.push_back(std::move(chunk));
+				}
+
+				if (full || chunks.size() >= 8) {
+					for (const auto &c : chunks)
+						ASSERT_EQ(ReadSerial(*c), t);
+					chunks.clear();
+				}
+			}
+		});
+	}
+
+	for (auto &i : threads)
+		i.join();
+
+#ifndef NDEBUG
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+#endif
+}
+
+TEST(MusicPipe, Basic)
+{
+	MusicBuffer buffer(8);
+	MusicPipe pipe;
+
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Peek(), nullptr);
+	EXPECT_FALSE(pipe.Shift());
+
+	for (unsigned i = 0; i < 3; ++i) {
+		auto chunk = buffer.Allocate();
+		WriteSerial(*chunk, i);
+		pipe.Push(std::move(chunk));
+	}
+
+	EXPECT_EQ(pipe.GetSize(), 3u);
+	ASSERT_NE(pipe.Peek(), nullptr);
+	EXPECT_EQ(ReadSerial(*pipe.Peek()), 0u);
+
+	const MusicChunk *second = pipe.Peek()->next;
+	ASSERT_NE(second, nullptr);
+	EXPECT_EQ(ReadSerial(*second), 1u);
+#ifndef NDEBUG
+	EXPECT_TRUE(pipe.Contains(second));
+#endif
+
+	auto chunk = pipe.Shift();
+	ASSERT_TRUE(chunk);
+	EXPECT_EQ(ReadSerial(*chunk), 0u);
+	EXPECT_EQ(pipe.Peek(), second);
+	EXPECT_EQ(pipe.GetSize(), 2u);
+	chunk.reset();
+
+	pipe.Clear();
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.GetSize(), 0u);
+#ifndef NDEBUG
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+#endif
+
+	/* the pipe is usable again after it was drained */
+	chunk = buffer.Allocate();
+	WriteSerial(*chunk, 42);
+	pipe.Push(std::move(chunk));
+	chunk = pipe.Shift();
+	ASSERT_TRUE(chunk);
+	EXPECT_EQ(ReadSerial(*chunk), 42u);
+}
+
+TEST(MusicPipe, Threads)
+{
+	constexpr unsigned N = 200000;
+	MusicBuffer buffer(32);
+	MusicPipe pipe;
+
+	std::thread producer([&buffer, &pipe](){
+		for (unsigned i = 0; i < N; ++i) {
+			auto chunk = AllocateWait(buffer);
+			WriteSerial(*chunk, i);
+			pipe.Push(std::move(chunk));
+		}
+	});
+
+	/* the consumer often drains the pipe completely, which
+	   exercises the race between Push() and removing the last
+	   chunk */
+	unsigned expected = 0;
+	while (expected < N) {
+		auto chunk = pipe.Shift();
+		if (!chunk) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		ASSERT_EQ(ReadSerial(*chunk), expected);
+		++expected;
+	}
+
+	producer.join();
+
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.GetSize(), 0u);
+#ifndef NDEBUG
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+#endif
+}
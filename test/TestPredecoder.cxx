@@ -0,0 +1,394 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Unit tests for the pre-decoder support in src/decoder/Control.cxx
+ * and src/player/Thread.cxx.  The decoder thread is replaced with a
+ * fake one which produces silence, and the outputs with a fake one
+ * which never consumes anything.
+ */
+
+#include "decoder/Control.hxx"
+#include "player/Control.hxx"
+#include "player/Listener.hxx"
+#include "player/Outputs.hxx"
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "Idle.hxx"
+#include "song/DetachedSong.hxx"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr AudioFormat audio_format(44100, SampleFormat::S16, 2);
+
+/**
+ * The number of fake decoders working on each song URI.  Protected
+ * by #decoding_mutex.
+ */
+static std::map<std::string, unsigned> decoding;
+
+/**
+ * The number of times each song URI has been started.  Protected by
+ * #decoding_mutex.
+ */
+static std::map<std::string, unsigned> n_started;
+
+static std::mutex decoding_mutex;
+
+static bool
+IsDecoding(const char *uri) noexcept
+{
+	const std::lock_guard<std::mutex> lock(decoding_mutex);
+	return decoding[uri] > 0;
+}
+
+static unsigned
+GetStartCount(const char *uri) noexcept
+{
+	const std::lock_guard<std::mutex> lock(decoding_mutex);
+	return n_started[uri];
+}
+
+/**
+ * Wait until the given song is being decoded.
+ */
+static bool
+WaitDecoding(const char *uri) noexcept
+{
+	for (unsigned i = 0; i < 5000; ++i) {
+		if (IsDecoding(uri))
+			return true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return false;
+}
+
+/**
+ * Fill the #MusicPipe like DecoderBridge::GetChunk() does: until the
+ * pipe limit is reached or a command is received.
+ */
+static void
+FakeDecode(DecoderControl &dc, std::unique_lock<Mutex> &lock) noexcept
+{
+	dc.SetReady(audio_format, true, SignedSongTime::zero());
+
+	while (dc.command == DecoderCommand::NONE) {
+		if (dc.IsPipeFull()) {
+			dc.Wait(lock);
+			continue;
+		}
+
+		auto chunk = dc.buffer->Allocate();
+		if (!chunk) {
+			dc.Wait(lock);
+			continue;
+		}
+
+		auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+		memset(w.data, 0, w.size);
+		chunk->Expand(audio_format, w.size);
+
+		dc.pipe->Push(std::move(chunk));
+		dc.client_cond.notify_one();
+	}
+
+	dc.state = DecoderState::STOP;
+}
+
+void
+DecoderControl::RunThread() noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+
+	do {
+		switch (command) {
+		case DecoderCommand::START:
+			{
+				const std::string uri = song->GetURI();
+
+				{
+					const std::lock_guard<std::mutex> l(decoding_mutex);
+					++decoding[uri];
+					++n_started[uri];
+				}
+
+				state = DecoderState::START;
+				CommandFinishedLocked();
+				FakeDecode(*this, lock);
+
+				const std::lock_guard<std::mutex> l(decoding_mutex);
+				--decoding[uri];
+			}
+
+			break;
+
+		case DecoderCommand::SEEK:
+		case DecoderCommand::STOP:
+			CommandFinishedLocked();
+			break;
+
+		case DecoderCommand::NONE:
+			Wait(lock);
+			break;
+		}
+	} while (command != DecoderCommand::NONE || !quit);
+}
+
+static unsigned
+CountFreeChunks(MusicBuffer &buffer) noexcept
+{
+	std::vector<MusicChunkPtr> chunks;
+	while (auto chunk = buffer.Allocate())
+		chunks.emplace_back(std::move(chunk));
+	return chunks.size();
+}
+
+TEST(Predecoder, StopAndDiscard)
+{
+	Mutex mutex;
+	Cond cond;
+	const ReplayGainConfig replay_gain_config;
+	MusicBuffer buffer(64);
+
+	DecoderControl dc(mutex, cond, nullptr, AudioFormat::Undefined(),
+			  replay_gain_config);
+	dc.StartThread();
+
+	{
+		std::unique_lock<Mutex> lock(mutex);
+
+		/* much more than the buffer can hold: the decoder
+		   stops at half of the buffer */
+		dc.pipe_limit = SongTime::FromS(3600U);
+		dc.Start(lock, std::make_unique<DetachedSong>("foo.ogg"),
+			 SongTime::zero(), SongTime::zero(),
+			 buffer, std::make_shared<MusicPipe>());
+
+		while (!dc.IsPipeFull())
+			dc.WaitForDecoder(lock);
+
+		const auto pipe = dc.pipe;
+		EXPECT_EQ(pipe->GetSize(), buffer.GetSize() / 2);
+
+		/* the player cancels the queued song and then stops
+		   the stale pre-decoder */
+		dc.StopAndDiscard(lock);
+
+		EXPECT_TRUE(dc.IsIdle());
+		EXPECT_EQ(dc.pipe, nullptr);
+		EXPECT_TRUE(pipe->IsEmpty());
+	}
+
+	/* all chunks have been returned to the buffer */
+	EXPECT_EQ(CountFreeChunks(buffer), buffer.GetSize());
+
+	dc.Quit();
+}
+
+TEST(Predecoder, NoLimit)
+{
+	Mutex mutex;
+	Cond cond;
+	const ReplayGainConfig replay_gain_config;
+	MusicBuffer buffer(16);
+
+	DecoderControl dc(mutex, cond, nullptr, AudioFormat::Undefined(),
+			  replay_gain_config);
+	dc.StartThread();
+
+	{
+		std::unique_lock<Mutex> lock(mutex);
+
+		dc.Start(lock, std::make_unique<DetachedSong>("foo.ogg"),
+			 SongTime::zero(), SongTime::zero(),
+			 buffer, std::make_shared<MusicPipe>());
+
+		/* without a limit, the decoder fills the whole
+		   buffer */
+		while (dc.pipe->GetSize() < buffer.GetSize())
+			dc.WaitForDecoder(lock);
+
+		EXPECT_FALSE(dc.IsPipeFull());
+
+		dc.StopAndDiscard(lock);
+	}
+
+	EXPECT_EQ(CountFreeChunks(buffer), buffer.GetSize());
+
+	dc.Quit();
+}
+
+void
+idle_add(unsigned)
+{
+}
+
+class FakePlayerListener final : public PlayerListener {
+public:
+	void OnPlayerSync() noexcept override {}
+	void OnPlayerTagModified() noexcept override {}
+	void OnBorderPause() noexcept override {}
+};
+
+/**
+ * Keeps all chunks until cancelled; this makes the player wait in
+ * PlayNextChunk() as soon as the output pipe is full.  Only used by
+ * the player thread.
+ */
+class FakeOutputs final : public PlayerOutputs {
+	std::vector<MusicChunkPtr> chunks;
+
+public:
+	void EnableDisable() override {}
+	void Open(const AudioFormat) override {}
+
+	void Close() noexcept override {
+		chunks.clear();
+	}
+
+	void Release() noexcept override {
+		chunks.clear();
+	}
+
+	void Play(MusicChunkPtr chunk) override {
+		chunks.emplace_back(std::move(chunk));
+	}
+
+	unsigned CheckPipe() noexcept override {
+		return chunks.size();
+	}
+
+	void Pause() noexcept override {}
+
+	void Drain() noexcept override {
+		chunks.clear();
+	}
+
+	void Cancel() noexcept override {
+		chunks.clear();
+	}
+
+	void SongBorder() noexcept override {}
+
+	SignedSongTime GetElapsedTime() const noexcept override {
+		return SignedSongTime::Negative();
+	}
+
+	bool IsLockMemory() const noexcept override {
+		return false;
+	}
+};
+
+/**
+ * Test how the player thread stops its pre-decoder when the queued
+ * song is cancelled.  Song "a" is playing (its fake decoder never
+ * finishes), and song "b" is queued and being pre-decoded.
+ */
+class PlayerPredecoderTest : public ::testing::Test {
+protected:
+	FakePlayerListener listener;
+	FakeOutputs outputs;
+	const ReplayGainConfig replay_gain_config;
+
+	PlayerControl pc{listener, outputs, nullptr,
+			 256, DEFAULT_CHUNK_SIZE,
+			 SongTime::FromS(3600U),
+			 AudioFormat::Undefined(),
+			 replay_gain_config};
+
+	void SetUp() override {
+		{
+			const std::lock_guard<std::mutex> lock(decoding_mutex);
+			decoding.clear();
+			n_started.clear();
+		}
+
+		pc.Play(std::make_unique<DetachedSong>("a.ogg"));
+		pc.LockEnqueueSong(std::make_unique<DetachedSong>("b.ogg"));
+		ASSERT_TRUE(WaitDecoding("b.ogg"));
+		EXPECT_TRUE(IsDecoding("a.ogg"));
+	}
+
+	void TearDown() override {
+		pc.LockStop();
+		pc.Kill();
+
+		EXPECT_FALSE(IsDecoding("a.ogg"));
+		EXPECT_FALSE(IsDecoding("b.ogg"));
+	}
+};
+
+TEST_F(PlayerPredecoderTest, Cancel)
+{
+	/* this happens in "single" mode and when the last song is
+	   removed from the queue: the queued song is cancelled, and
+	   nothing else is queued */
+	pc.LockCancel();
+	EXPECT_FALSE(IsDecoding("b.ogg"));
+	EXPECT_TRUE(IsDecoding("a.ogg"));
+}
+
+TEST_F(PlayerPredecoderTest, Stop)
+{
+	/* this happens when the queue is cleared */
+	pc.LockStop();
+	EXPECT_FALSE(IsDecoding("b.ogg"));
+	EXPECT_FALSE(IsDecoding("a.ogg"));
+}
+
+TEST_F(PlayerPredecoderTest, Requeue)
+{
+	/* the queued song is replaced with another one */
+	pc.LockCancel();
+	EXPECT_FALSE(IsDecoding("b.ogg"));
+
+	pc.LockEnqueueSong(std::make_unique<DetachedSong>("c.ogg"));
+	EXPECT_TRUE(WaitDecoding("c.ogg"));
+	EXPECT_FALSE(IsDecoding("b.ogg"));
+}
+
+TEST_F(PlayerPredecoderTest, SeekPredecoded)
+{
+	/* SeekLocked() cancels "b" before seeking to it: the
+	   pre-decoder continues, and its chunks are used */
+	pc.LockSeek(std::make_unique<DetachedSong>("b.ogg"),
+		    SongTime::zero());
+	EXPECT_TRUE(IsDecoding("b.ogg"));
+	EXPECT_FALSE(IsDecoding("a.ogg"));
+	EXPECT_EQ(GetStartCount("b.ogg"), 1U);
+}
+
+TEST_F(PlayerPredecoderTest, SeekOther)
+{
+	pc.LockSeek(std::make_unique<DetachedSong>("c.ogg"),
+		    SongTime::zero());
+	EXPECT_FALSE(IsDecoding("b.ogg"));
+	EXPECT_TRUE(IsDecoding("c.ogg"));
+}
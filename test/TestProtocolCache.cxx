@@ -0,0 +1,111 @@
+/*
+ * Unit tests for Song::protocol_cache
+ */
+
+#include "MakeTag.hxx"
+#include "SongPrint.hxx"
+#include "client/Response.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Builder.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+class ProtocolCacheTest : public ::testing::Test {
+protected:
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	Song *song;
+
+	void SetUp() override {
+		const ScopeDatabaseLock protect;
+		auto &directory = *root->CreateChild("dir");
+
+		auto new_song = std::make_unique<Song>("1.flac", directory);
+		new_song->tag = MakeTag(TAG_ARTIST, "Artist",
+					TAG_TITLE, "Title");
+		new_song->mtime =
+			std::chrono::system_clock::from_time_t(1234567890);
+		new_song->audio_format =
+			AudioFormat(44100, SampleFormat::S16, 2);
+		new_song->start_time = SongTime::FromMS(10000);
+		song = new_song.get();
+		directory.AddSong(std::move(new_song));
+	}
+
+	std::string Print(bool with_protocol_cache,
+			  TagMask tag_mask=TagMask::All()) const {
+		const ScopeDatabaseLock protect;
+		std::string buffer;
+		Response r(buffer, tag_mask);
+		song_print_info(r, song->Export(with_protocol_cache));
+		return buffer;
+	}
+
+	/**
+	 * Rescan the song with a different tag, like
+	 * UpdateWalk::ApplyScanJob() and Song::UpdateFile() do.
+	 */
+	void Rescan(const char *title) {
+		TagBuilder tag_builder;
+		tag_builder.AddItem(TAG_ARTIST, "Artist");
+		tag_builder.AddItem(TAG_TITLE, title);
+
+		const ScopeDatabaseLock protect;
+		song->ApplyScan(std::chrono::system_clock::from_time_t(1234567891),
+				AudioFormat(48000, SampleFormat::S24_P32, 2),
+				tag_builder);
+	}
+};
+
+TEST_F(ProtocolCacheTest, Identical)
+{
+	const auto expected = Print(false);
+	EXPECT_NE(expected.find("Title: Title\n"), expected.npos);
+	EXPECT_EQ(song->protocol_cache, nullptr);
+
+	/* the first call fills the cache ... */
+	EXPECT_EQ(Print(true), expected);
+	EXPECT_NE(song->protocol_cache, nullptr);
+
+	/* ... and the second one uses it */
+	EXPECT_EQ(Print(true), expected);
+}
+
+TEST_F(ProtocolCacheTest, TagMask)
+{
+	/* a partial tag mask bypasses the cache */
+	auto tag_mask = TagMask::All();
+	tag_mask.Unset(TAG_TITLE);
+
+	const auto expected = Print(false, tag_mask);
+	EXPECT_EQ(expected.find("Title:"), expected.npos);
+	EXPECT_EQ(Print(true, tag_mask), expected);
+	EXPECT_EQ(song->protocol_cache, nullptr);
+
+	/* ... even if the cache has already been filled */
+	Print(true);
+	EXPECT_NE(song->protocol_cache, nullptr);
+	EXPECT_EQ(Print(true, tag_mask), expected);
+}
+
+TEST_F(ProtocolCacheTest, Rescan)
+{
+	Print(true);
+	EXPECT_NE(song->protocol_cache, nullptr);
+
+	Rescan("New Title");
+	EXPECT_EQ(song->protocol_cache, nullptr);
+
+	const auto expected = Print(false);
+	EXPECT_NE(expected.find("Title: New Title\n"), expected.npos);
+	EXPECT_NE(expected.find("Format: 48000:24:2\n"), expected.npos);
+	EXPECT_EQ(Print(true), expected);
+	EXPECT_EQ(Print(true), expected);
+}
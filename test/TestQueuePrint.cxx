@@ -0,0 +1,114 @@
+/*
+ * Unit tests for src/queue/QueuePrint.cxx
+ */
+
+#include "queue/QueuePrint.hxx"
+#include "queue/Queue.hxx"
+#include "client/Response.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Mask.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+static std::string
+PrintIds(const Queue &queue, const std::vector<unsigned> &ids)
+{
+	std::string buffer;
+	Response r(buffer, TagMask::All());
+	queue_print_ids(r, queue, {ids.data(), ids.size()});
+	return buffer;
+}
+
+static std::string
+PrintRange(const Queue &queue, unsigned start, unsigned end)
+{
+	std::string buffer;
+	Response r(buffer, TagMask::All());
+	queue_print_info(r, queue, start, end);
+	return buffer;
+}
+
+/**
+ * Count the "file" lines of the given URI.
+ */
+static unsigned
+CountFile(const std::string &response, const char *uri)
+{
+	const std::string line = std::string("file: ") + uri + "\n";
+
+	unsigned n = 0;
+	for (auto i = response.find(line); i != response.npos;
+	     i = response.find(line, i + 1))
+		++n;
+	return n;
+}
+
+class QueuePrintTest : public ::testing::Test {
+protected:
+	static constexpr unsigned N = 16;
+
+	Queue queue{32};
+
+	void SetUp() override {
+		for (unsigned i = 0; i < N; ++i)
+			queue.Append(DetachedSong(std::to_string(i) + ".ogg"),
+				     0);
+	}
+
+	std::vector<unsigned> GetIds(unsigned start, unsigned end) const {
+		std::vector<unsigned> ids;
+		for (unsigned i = start; i < end; ++i)
+			ids.push_back(queue.PositionToId(i));
+		return ids;
+	}
+};
+
+TEST_F(QueuePrintTest, Unmodified)
+{
+	/* printing by id equals printing by position */
+	EXPECT_EQ(PrintIds(queue, GetIds(0, N)), PrintRange(queue, 0, N));
+	EXPECT_EQ(PrintIds(queue, GetIds(3, 7)), PrintRange(queue, 3, 7));
+}
+
+/**
+ * Simulate a "playlistinfo" response which is sent in two portions
+ * while the queue gets modified between them, like
+ * PlaylistInfoCommand does it.
+ */
+TEST_F(QueuePrintTest, Modified)
+{
+	const auto ids = GetIds(0, N);
+	const std::vector<unsigned> first(ids.begin(), ids.begin() + N / 2);
+	const std::vector<unsigned> second(ids.begin() + N / 2, ids.end());
+
+	std::string response = PrintIds(queue, first);
+
+	/* delete one song from each half, move songs from the
+	   second half to the front, and insert a new song */
+	queue.DeletePosition(queue.IdToPosition(ids[2]));
+	queue.DeletePosition(queue.IdToPosition(ids[12]));
+	queue.MoveRange(N / 2, N / 2 + 3, 0);
+	queue.Append(DetachedSong("new.ogg"), 0);
+	queue.MovePostion(queue.GetLength() - 1, 0);
+
+	response += PrintIds(queue, second);
+
+	/* every song of the original range has been sent exactly
+	   once, except the one deleted before it was reached */
+	for (unsigned i = 0; i < N; ++i)
+		EXPECT_EQ(CountFile(response,
+				    (std::to_string(i) + ".ogg").c_str()),
+			  i == 12 ? 0U : 1U);
+
+	EXPECT_EQ(CountFile(response, "new.ogg"), 0U);
+
+	/* the moved songs are sent with their new position */
+	const int position = queue.IdToPosition(ids[N / 2]);
+	ASSERT_GE(position, 0);
+	EXPECT_NE(response.find(PrintRange(queue, position, position + 1)),
+		  response.npos);
+}
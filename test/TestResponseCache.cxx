@@ -0,0 +1,213 @@
+/*
+ * Unit tests for src/db/ResponseCache.cxx
+ */
+
+#include "db/ResponseCache.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/DatabaseLock.hxx"
+#include "config/Block.hxx"
+#include "lib/icu/Init.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+static std::string
+MakeKey(const char *command, std::initializer_list<const char *> args,
+	TagMask tag_mask=TagMask::All())
+{
+	return DatabaseResponseCache::MakeKey(tag_mask, command,
+					      {args.begin(), args.size()});
+}
+
+TEST(ResponseCache, Basic)
+{
+	DatabaseResponseCache cache;
+	const auto key = MakeKey("list", {"artist"});
+
+	EXPECT_EQ(cache.Get(key), nullptr);
+
+	cache.Put(std::string(key), "Artist: foo\n");
+	ASSERT_NE(cache.Get(key), nullptr);
+	EXPECT_EQ(*cache.Get(key), "Artist: foo\n");
+
+	/* an existing item is not replaced */
+	cache.Put(std::string(key), "Artist: bar\n");
+	EXPECT_EQ(*cache.Get(key), "Artist: foo\n");
+
+	const unsigned generation = cache.GetGeneration();
+	cache.Clear();
+	EXPECT_EQ(cache.Get(key), nullptr);
+	EXPECT_NE(cache.GetGeneration(), generation);
+}
+
+TEST(ResponseCache, Key)
+{
+	/* the argument boundaries are part of the key */
+	EXPECT_NE(MakeKey("list", {"album", "group", "artist"}),
+		  MakeKey("list", {"albumgroup", "artist"}));
+	EXPECT_NE(MakeKey("list", {"album"}), MakeKey("count", {"album"}));
+	EXPECT_EQ(MakeKey("list", {"album"}), MakeKey("list", {"album"}));
+
+	/* clients with different tag masks never share a response */
+	const auto all = MakeKey("list", {"album"});
+	const auto no_artist = MakeKey("list", {"album"},
+				       ~TagMask(TAG_ARTIST));
+	const auto no_album = MakeKey("list", {"album"},
+				      ~TagMask(TAG_ALBUM));
+	EXPECT_NE(all, no_artist);
+	EXPECT_NE(all, no_album);
+	EXPECT_NE(no_artist, no_album);
+	EXPECT_EQ(no_artist, MakeKey("list", {"album"},
+				     ~TagMask(TAG_ARTIST)));
+
+	DatabaseResponseCache cache;
+	cache.Put(std::string(all), "all");
+	cache.Put(std::string(no_artist), "no_artist");
+	EXPECT_EQ(*cache.Get(all), "all");
+	EXPECT_EQ(*cache.Get(no_artist), "no_artist");
+	EXPECT_EQ(cache.Get(no_album), nullptr);
+}
+
+TEST(ResponseCache, TooLarge)
+{
+	DatabaseResponseCache cache;
+	const auto key = MakeKey("list", {"title"});
+
+	cache.Put(std::string(key),
+		  std::string(DatabaseResponseCache::MAX_ITEM_SIZE, 'x'));
+	EXPECT_EQ(cache.Get(key), nullptr);
+}
+
+TEST(ResponseCache, LRU)
+{
+	DatabaseResponseCache cache;
+
+	/* each item occupies a bit less than an eighth of the
+	   cache */
+	constexpr std::size_t value_size =
+		DatabaseResponseCache::MAX_SIZE / 8 - 64;
+	const auto key = [](unsigned i){
+		return MakeKey("count", {"group", std::to_string(i).c_str()});
+	};
+
+	for (unsigned i = 0; i < 8; ++i)
+		cache.Put(key(i), std::string(value_size, 'a' + i));
+
+	for (unsigned i = 0; i < 8; ++i)
+		EXPECT_NE(cache.Get(key(i)), nullptr) << i;
+
+	/* use #0 and #1 again, so #2 becomes the oldest one */
+	EXPECT_NE(cache.Get(key(1)), nullptr);
+	EXPECT_NE(cache.Get(key(0)), nullptr);
+
+	cache.Put(key(8), std::string(value_size, 'i'));
+	EXPECT_EQ(cache.Get(key(2)), nullptr);
+	EXPECT_NE(cache.Get(key(8)), nullptr);
+	EXPECT_NE(cache.Get(key(0)), nullptr);
+	EXPECT_NE(cache.Get(key(1)), nullptr);
+
+	/* this one needs the space of two items: #3 and #4 are
+	   evicted */
+	cache.Put(key(9), std::string(2 * value_size, 'j'));
+	EXPECT_EQ(cache.Get(key(3)), nullptr);
+	EXPECT_EQ(cache.Get(key(4)), nullptr);
+	EXPECT_NE(cache.Get(key(5)), nullptr);
+
+	ASSERT_NE(cache.Get(key(9)), nullptr);
+	EXPECT_EQ(*cache.Get(key(9)), std::string(2 * value_size, 'j'));
+	ASSERT_NE(cache.Get(key(0)), nullptr);
+	EXPECT_EQ(*cache.Get(key(0)), std::string(value_size, 'a'));
+}
+
+static std::string
+MakePath(const char *name)
+{
+	return testing::TempDir() + "TestResponseCache." + name + "." +
+		std::to_string(getpid());
+}
+
+/**
+ * Check the invalidation with the SimpleDatabase::GetVersion() of a
+ * real database, like GetResponseCache() in DatabaseCommands.cxx
+ * does.
+ */
+class ResponseCacheDatabaseTest : public ::testing::Test {
+protected:
+	const ScopeIcuInit icu_init;
+
+	std::unique_ptr<SimpleDatabase> db;
+
+	DatabaseResponseCache cache;
+
+	const std::string key = MakeKey("list", {"album"});
+
+	void SetUp() override {
+		ConfigBlock block;
+		block.AddBlockParam("path", MakePath("db").c_str());
+
+		db = std::make_unique<SimpleDatabase>(block);
+		db->Open();
+
+		cache.Validate(db->GetVersion());
+		cache.Put(std::string(key), "Album: foo\n");
+	}
+
+	void TearDown() override {
+		db->Close();
+	}
+
+	/**
+	 * Does the cache still contain the response after
+	 * validating it against the database?
+	 */
+	bool IsCached() noexcept {
+		cache.Validate(db->GetVersion());
+		return cache.Get(key) != nullptr;
+	}
+};
+
+TEST_F(ResponseCacheDatabaseTest, Update)
+{
+	EXPECT_TRUE(IsCached());
+
+	/* an update which did not modify anything */
+	db->BeginUpdate();
+	db->EndUpdate(false);
+	EXPECT_TRUE(IsCached());
+
+	db->BeginUpdate();
+	{
+		const ScopeDatabaseLock protect;
+		db->GetRoot().MakeChild("new")->MarkModified();
+	}
+	db->EndUpdate(true);
+	EXPECT_FALSE(IsCached());
+}
+
+TEST_F(ResponseCacheDatabaseTest, MountUnmount)
+{
+	auto mounted = std::make_unique<SimpleDatabase>(AllocatedPath::FromFS(MakePath("mnt").c_str()),
+							false, false, false);
+	mounted->Open();
+
+	db->Mount("mnt", std::move(mounted));
+	EXPECT_FALSE(IsCached());
+
+	cache.Put(std::string(key), "Album: bar\n");
+	EXPECT_TRUE(IsCached());
+
+	/* unmounting something which is not mounted changes
+	   nothing */
+	EXPECT_FALSE(db->Unmount("foo"));
+	EXPECT_TRUE(IsCached());
+
+	EXPECT_TRUE(db->Unmount("mnt"));
+	EXPECT_FALSE(IsCached());
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "encoder/SharedEncoder.hxx"
+#include "encoder/EncoderPlugin.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "tag/Tag.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * An encoder which copies its input and marks tags and the stream
+ * header with letters.
+ */
+class FakeEncoder final : public Encoder {
+	std::string &log;
+	std::string buffer = "H";
+
+public:
+	explicit FakeEncoder(std::string &_log) noexcept
+		:Encoder(true), log(_log) {}
+
+	void End() override {
+		buffer += 'E';
+	}
+
+	void PreTag() override {
+		buffer += 'P';
+	}
+
+	void SendTag(const Tag &) override {
+		buffer += 'T';
+	}
+
+	void Write(const void *data, size_t length) override {
+		log.append((const char *)data, length);
+		buffer.append((const char *)data, length);
+	}
+
+	size_t Read(void *dest, size_t length) override {
+		length = std::min(length, buffer.size());
+		memcpy(dest, buffer.data(), length);
+		buffer.erase(0, length);
+		return length;
+	}
+};
+
+class FakePreparedEncoder final : public PreparedEncoder {
+	std::string &log;
+
+	const char *const mime_type;
+
+public:
+	FakePreparedEncoder(std::string &_log, const char *_mime_type) noexcept
+		:log(_log), mime_type(_mime_type) {}
+
+	Encoder *Open(AudioFormat &) override {
+		return new FakeEncoder(log);
+	}
+
+	const char *GetMimeType() const noexcept override {
+		return mime_type;
+	}
+};
+
+static constexpr EncoderPlugin fake_encoder_plugin = {
+	"fake",
+	nullptr,
+};
+
+static constexpr EncoderPlugin other_encoder_plugin = {
+	"other",
+	nullptr,
+};
+
+/**
+ * All data which was passed to the real encoder.
+ */
+static std::string encoder_input;
+
+static std::unique_ptr<SharedPreparedEncoder>
+MakeSharedEncoder(const char *name="test",
+		  const EncoderPlugin &plugin=fake_encoder_plugin,
+		  const char *mime_type="audio/x-fake")
+{
+	return std::make_unique<SharedPreparedEncoder>(name, plugin,
+						       std::make_unique<FakePreparedEncoder>(encoder_input, mime_type));
+}
+
+static std::unique_ptr<Encoder>
+Open(PreparedEncoder &prepared,
+     AudioFormat audio_format=AudioFormat(44100, SampleFormat::S16, 2))
+{
+	return std::unique_ptr<Encoder>(prepared.Open(audio_format));
+}
+
+static std::string
+ReadAll(Encoder &encoder)
+{
+	std::string result;
+	char buffer[7];
+	size_t nbytes;
+	while ((nbytes = encoder.Read(buffer, sizeof(buffer))) > 0)
+		result.append(buffer, nbytes);
+	return result;
+}
+
+static void
+Write(Encoder &encoder, const std::string &data)
+{
+	encoder.Write(data.data(), data.size());
+}
+
+TEST(SharedEncoder, Single)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder();
+	auto e = Open(*prepared);
+
+	EXPECT_EQ(ReadAll(*e), "H");
+	Write(*e, "abc");
+	EXPECT_EQ(ReadAll(*e), "abc");
+	Write(*e, "0123456789");
+	EXPECT_EQ(ReadAll(*e), "0123456789");
+	e->End();
+	EXPECT_EQ(ReadAll(*e), "E");
+	EXPECT_EQ(encoder_input, "abc0123456789");
+}
+
+TEST(SharedEncoder, EncodeOnce)
+{
+	encoder_input.clear();
+	auto prepared1 = MakeSharedEncoder();
+	auto prepared2 = MakeSharedEncoder();
+	auto a = Open(*prepared1);
+	auto b = Open(*prepared2);
+
+	EXPECT_EQ(ReadAll(*a), "H");
+	EXPECT_EQ(ReadAll(*b), "H");
+
+	Write(*a, "abcd");
+	EXPECT_EQ(ReadAll(*a), "abcd");
+
+	/* b has not reached this position yet */
+	EXPECT_EQ(ReadAll(*b), "");
+
+	/* pages are returned only after the input has reached the
+	   position where the encoder emitted them */
+	Write(*b, "ab");
+	EXPECT_EQ(ReadAll(*b), "");
+
+	/* b overtakes a */
+	Write(*b, "cdef");
+	EXPECT_EQ(ReadAll(*b), "abcdef");
+	EXPECT_EQ(ReadAll(*a), "");
+	Write(*a, "ef");
+	EXPECT_EQ(ReadAll(*a), "ef");
+
+	EXPECT_EQ(encoder_input, "abcdef");
+
+	/* with another output alive, End() only flushes */
+	a->End();
+	EXPECT_EQ(ReadAll(*a), "");
+}
+
+TEST(SharedEncoder, Tag)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder();
+	auto a = Open(*prepared);
+	auto b = Open(*prepared);
+	ReadAll(*a);
+	ReadAll(*b);
+
+	const Tag tag;
+
+	Write(*a, "ab");
+	a->PreTag();
+	a->SendTag(tag);
+	Write(*a, "cd");
+	EXPECT_EQ(ReadAll(*a), "abPTcd");
+
+	/* b sees the same stream; its own tag is not sent to the
+	   encoder again */
+	Write(*b, "ab");
+	b->PreTag();
+	std::string s = ReadAll(*b);
+	b->SendTag(tag);
+	s += ReadAll(*b);
+	Write(*b, "cd");
+	s += ReadAll(*b);
+	EXPECT_EQ(s, "abPTcd");
+
+	/* a new subscriber receives the header of the current
+	   stream */
+	auto c = Open(*prepared);
+	EXPECT_EQ(ReadAll(*c), "T");
+	Write(*a, "ef");
+	Write(*c, "ef");
+	EXPECT_EQ(ReadAll(*c), "ef");
+
+	EXPECT_EQ(encoder_input, "abcdef");
+}
+
+TEST(SharedEncoder, Separate)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder("foo");
+	auto prepared2 = MakeSharedEncoder("bar");
+	auto a = Open(*prepared);
+	auto b = Open(*prepared, AudioFormat(48000, SampleFormat::S16, 2));
+	auto c = Open(*prepared2);
+	ReadAll(*a);
+	ReadAll(*b);
+	ReadAll(*c);
+
+	Write(*a, "a");
+	Write(*b, "b");
+	Write(*c, "c");
+	EXPECT_EQ(ReadAll(*a), "a");
+	EXPECT_EQ(ReadAll(*b), "b");
+	EXPECT_EQ(ReadAll(*c), "c");
+	EXPECT_EQ(encoder_input, "abc");
+}
+
+TEST(SharedEncoder, Lag)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder();
+	const AudioFormat audio_format(8000, SampleFormat::S8, 1);
+	auto a = Open(*prepared, audio_format);
+	auto b = Open(*prepared, audio_format);
+	ReadAll(*a);
+	ReadAll(*b);
+
+	/* write more than 60 seconds while b is idle */
+	const std::string block(8000, 'x');
+	for (unsigned i = 0; i < 70; ++i) {
+		Write(*a, block);
+		EXPECT_EQ(ReadAll(*a), block);
+	}
+
+	/* b has lost the old pages; it continues at the current
+	   position */
+	EXPECT_EQ(ReadAll(*b), "H");
+	Write(*b, "y");
+	EXPECT_EQ(ReadAll(*b), "y");
+	Write(*a, "y");
+	EXPECT_EQ(ReadAll(*a), "y");
+
+	EXPECT_EQ(encoder_input.size(), 70 * block.size() + 1);
+}
+
+TEST(SharedEncoder, Reopen)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder();
+
+	{
+		auto a = Open(*prepared);
+		ReadAll(*a);
+		Write(*a, "abc");
+		a->End();
+		EXPECT_EQ(ReadAll(*a), "abcE");
+	}
+
+	/* the ended encoder is not reused */
+	auto a = Open(*prepared);
+	EXPECT_EQ(ReadAll(*a), "H");
+	Write(*a, "d");
+	EXPECT_EQ(ReadAll(*a), "d");
+	EXPECT_EQ(encoder_input, "abcd");
+}
+
+TEST(SharedEncoder, Mismatch)
+{
+	encoder_input.clear();
+	auto prepared = MakeSharedEncoder();
+	auto other_plugin = MakeSharedEncoder("test", other_encoder_plugin);
+	auto other_mime_type = MakeSharedEncoder("test", fake_encoder_plugin,
+						 "audio/x-other");
+	auto no_mime_type = MakeSharedEncoder("test", fake_encoder_plugin,
+					      nullptr);
+
+	auto a = Open(*prepared);
+
+	/* a different encoder configuration must not join the
+	   existing group, not even with another audio format */
+	EXPECT_ANY_THROW(Open(*other_plugin));
+	EXPECT_ANY_THROW(Open(*other_mime_type));
+	EXPECT_ANY_THROW(Open(*no_mime_type,
+			      AudioFormat(48000, SampleFormat::S16, 2)));
+
+	/* a matching one does */
+	auto prepared2 = MakeSharedEncoder();
+	auto b = Open(*prepared2);
+	ReadAll(*a);
+	ReadAll(*b);
+	Write(*a, "a");
+	Write(*b, "a");
+	EXPECT_EQ(ReadAll(*b), "a");
+	EXPECT_EQ(encoder_input, "a");
+
+	/* after the group is gone, another plugin may use the
+	   name */
+	a.reset();
+	b.reset();
+	auto c = Open(*other_plugin);
+	EXPECT_EQ(ReadAll(*c), "H");
+}
@@ -0,0 +1,25 @@
+/*
+ * Unit tests for src/fs/io/StringLineReader.hxx
+ */
+
+#include "fs/io/StringLineReader.hxx"
+
+#include <gtest/gtest.h>
+
+TEST(StringLineReader, Empty)
+{
+	std::string s;
+	StringLineReader reader(s);
+	EXPECT_EQ(reader.ReadLine(), nullptr);
+}
+
+TEST(StringLineReader, Lines)
+{
+	std::string s("foo\nbar \r\n\nbaz\t");
+	StringLineReader reader(s);
+	EXPECT_STREQ(reader.ReadLine(), "foo");
+	EXPECT_STREQ(reader.ReadLine(), "bar");
+	EXPECT_STREQ(reader.ReadLine(), "");
+	EXPECT_STREQ(reader.ReadLine(), "baz");
+	EXPECT_EQ(reader.ReadLine(), nullptr);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "tag/Pool.hxx"
+#include "tag/Item.hxx"
+#include "util/StringView.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <string.h>
+
+TEST(TagPool, Basic)
+{
+	TagItem *a = tag_pool_get_item(TAG_ARTIST, "foo");
+	EXPECT_EQ(a->type, TAG_ARTIST);
+	EXPECT_STREQ(a->value, "foo");
+
+	TagItem *b = tag_pool_get_item(TAG_ARTIST, "foo");
+	EXPECT_EQ(a, b);
+
+	TagItem *c = tag_pool_get_item(TAG_ALBUM, "foo");
+	EXPECT_NE(a, c);
+	EXPECT_EQ(c->type, TAG_ALBUM);
+
+	TagItem *d = tag_pool_dup_item(a);
+	EXPECT_EQ(a, d);
+
+	tag_pool_put_item(a);
+	tag_pool_put_item(b);
+	tag_pool_put_item(c);
+	tag_pool_put_item(d);
+
+	EXPECT_EQ(tag_pool_get_stats().n_items, 0u);
+}
+
+TEST(TagPool, RefOverflow)
+{
+	std::vector<TagItem *> items;
+	items.push_back(tag_pool_get_item(TAG_TITLE, "bar"));
+
+	for (unsigned i = 0; i < 1000; ++i)
+		items.push_back(tag_pool_dup_item(items.front()));
+
+	for (auto *i : items)
+		EXPECT_STREQ(i->value, "bar");
+
+	/* the reference counter is small, so more than one copy
+	   must have been allocated */
+	EXPECT_GT(tag_pool_get_stats().n_items, 1u);
+
+	for (auto *i : items)
+		tag_pool_put_item(i);
+
+	EXPECT_EQ(tag_pool_get_stats().n_items, 0u);
+}
+
+TEST(TagPool, Grow)
+{
+	constexpr unsigned N = 100000;
+
+	std::vector<TagItem *> items;
+	items.reserve(N);
+	for (unsigned i = 0; i < N; ++i)
+		items.push_back(tag_pool_get_item(TAG_TITLE,
+						  std::to_string(i).c_str()));
+
+	const auto stats = tag_pool_get_stats();
+	EXPECT_EQ(stats.n_items, N);
+	EXPECT_GE(stats.n_buckets * 2, N);
+
+	for (unsigned i = 0; i < N; ++i) {
+		TagItem *item = tag_pool_get_item(TAG_TITLE,
+						  std::to_string(i).c_str());
+		EXPECT_EQ(item, items[i]);
+		tag_pool_put_item(item);
+	}
+
+	for (auto *i : items)
+		tag_pool_put_item(i);
+
+	EXPECT_EQ(tag_pool_get_stats().n_items, 0u);
+}
+
+TEST(TagPool, Threads)
+{
+	constexpr unsigned N_THREADS = 8, N_VALUES = 2000;
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < N_THREADS; ++t) {
+		threads.emplace_back([](){
+			std::vector<TagItem *> items;
+			for (unsigned round = 0; round < 4; ++round) {
+				for (unsigned i = 0; i < N_VALUES; ++i) {
+					const auto value = std::to_string(i);
+					TagItem *item = tag_pool_get_item(TAG_GENRE,
+									  value.c_str());
+					if (strcmp(item->value, value.c_str()) != 0)
+						abort();
+					items.push_back(item);
+					items.push_back(tag_pool_dup_item(item));
+				}
+
+				for (auto *i : items)
+					tag_pool_put_item(i);
+				items.clear();
+			}
+		});
+	}
+
+	for (auto &i : threads)
+		i.join();
+
+	EXPECT_EQ(tag_pool_get_stats().n_items, 0u);
+}
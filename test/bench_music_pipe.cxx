@@ -0,0 +1,231 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput and latency of #MusicPipe
+ * and #MusicBuffer, compared with a mutex-protected implementation
+ * (the one MPD used before they became lock-free).
+ *
+ * Usage: bench_music_pipe [NUM_CHUNKS [BUFFER_CHUNKS]]
+ */
+
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "thread/Mutex.hxx"
+#include "util/SliceBuffer.hxx"
+#include "util/PrintException.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * The old #MusicBuffer: a #SliceBuffer protected by a #Mutex.
+ */
+class LockedBuffer {
+	Mutex mutex;
+	SliceBuffer<MusicChunk> buffer;
+
+public:
+	explicit LockedBuffer(unsigned n):buffer(n) {}
+
+	MusicChunk *Allocate() noexcept {
+		const std::lock_guard<Mutex> protect(mutex);
+		return buffer.Allocate(DEFAULT_CHUNK_SIZE);
+	}
+
+	void Return(MusicChunk *chunk) noexcept {
+		const std::lock_guard<Mutex> protect(mutex);
+		buffer.Free(chunk);
+	}
+};
+
+/**
+ * The old #MusicPipe: a linked list protected by a #Mutex.
+ */
+class LockedPipe {
+	Mutex mutex;
+	MusicChunk *head = nullptr, *tail = nullptr;
+
+public:
+	void Push(MusicChunk *chunk) noexcept {
+		chunk->next.store(nullptr, std::memory_order_relaxed);
+
+		const std::lock_guard<Mutex> protect(mutex);
+		if (tail != nullptr)
+			tail->next.store(chunk, std::memory_order_relaxed);
+		else
+			head = chunk;
+		tail = chunk;
+	}
+
+	MusicChunk *Shift() noexcept {
+		const std::lock_guard<Mutex> protect(mutex);
+		MusicChunk *chunk = head;
+		if (chunk != nullptr) {
+			head = chunk->next.load(std::memory_order_relaxed);
+			if (head == nullptr)
+				tail = nullptr;
+		}
+
+		return chunk;
+	}
+};
+
+struct LockedImplementation {
+	LockedBuffer buffer;
+	LockedPipe pipe;
+
+	explicit LockedImplementation(unsigned n):buffer(n) {}
+
+	MusicChunk *Allocate() noexcept {
+		return buffer.Allocate();
+	}
+
+	void Push(MusicChunk *chunk) noexcept {
+		pipe.Push(chunk);
+	}
+
+	MusicChunk *Shift() noexcept {
+		return pipe.Shift();
+	}
+
+	void Return(MusicChunk *chunk) noexcept {
+		buffer.Return(chunk);
+	}
+};
+
+struct LockFreeImplementation {
+	MusicBuffer buffer;
+	MusicPipe pipe;
+
+	explicit LockFreeImplementation(unsigned n):buffer(n) {}
+
+	MusicChunk *Allocate() noexcept {
+		return buffer.Allocate().release();
+	}
+
+	void Push(MusicChunk *chunk) noexcept {
+		pipe.Push(MusicChunkPtr(chunk, MusicChunkDeleter(buffer)));
+	}
+
+	MusicChunk *Shift() noexcept {
+		return pipe.Shift().release();
+	}
+
+	void Return(MusicChunk *chunk) noexcept {
+		buffer.Return(chunk);
+	}
+};
+
+}
+
+static constexpr AudioFormat audio_format(44100, SampleFormat::S16, 2);
+
+template<typename I>
+static void
+Run(const char *name, unsigned n_chunks, unsigned buffer_chunks)
+{
+	I i(buffer_chunks);
+
+	std::vector<Clock::duration> latencies;
+	latencies.reserve(n_chunks);
+
+	const auto start = Clock::now();
+
+	std::thread producer([&i, n_chunks](){
+		for (unsigned n = 0; n < n_chunks; ++n) {
+			MusicChunk *chunk;
+			while ((chunk = i.Allocate()) == nullptr)
+				std::this_thread::yield();
+
+			const auto now = Clock::now();
+			auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+			memcpy(w.data, &now, sizeof(now));
+			chunk->Expand(audio_format, sizeof(now));
+
+			i.Push(chunk);
+		}
+	});
+
+	for (unsigned n = 0; n < n_chunks;) {
+		MusicChunk *chunk = i.Shift();
+		if (chunk == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		Clock::time_point pushed;
+		memcpy(&pushed, chunk->GetData(), sizeof(pushed));
+		latencies.push_back(Clock::now() - pushed);
+
+		i.Return(chunk);
+		++n;
+	}
+
+	producer.join();
+
+	const auto duration = Clock::now() - start;
+	const double seconds = std::chrono::duration<double>(duration).count();
+
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&latencies](double p){
+		const std::size_t index = std::min<std::size_t>(p * latencies.size(),
+								latencies.size() - 1);
+		return (unsigned long)std::chrono::duration_cast<std::chrono::nanoseconds>(latencies[index]).count();
+	};
+
+	printf("%-10s %10.0f chunks/s  latency [ns]: p50=%lu p99=%lu p99.9=%lu max=%lu\n",
+	       name, n_chunks / seconds,
+	       percentile(0.5), percentile(0.99), percentile(0.999),
+	       percentile(1));
+}
+
+int
+main(int argc, char **argv)
+try {
+	const unsigned n_chunks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+	const unsigned buffer_chunks = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1024;
+
+	if (n_chunks == 0 || buffer_chunks == 0) {
+		fprintf(stderr, "Usage: bench_music_pipe [NUM_CHUNKS [BUFFER_CHUNKS]]\n");
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned round = 0; round < 3; ++round) {
+		Run<LockedImplementation>("mutex", n_chunks, buffer_chunks);
+		Run<LockFreeImplementation>("lock-free", n_chunks, buffer_chunks);
+	}
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
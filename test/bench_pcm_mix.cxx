@@ -0,0 +1,106 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of pcm_mix() with each
+ * vectorized kernel supported by this CPU.
+ *
+ * Usage: bench_pcm_mix [MEGABYTES]
+ */
+
+#include "pcm/Mix.hxx"
+#include "pcm/Dither.hxx"
+#include "pcm/Simd.hxx"
+#include "pcm/SampleFormat.hxx"
+
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Mix one #MusicChunk-sized block (stereo) per call, just like the
+ * player thread does.
+ */
+static constexpr size_t BLOCK_SIZE = 4096;
+
+static void
+Run(SampleFormat format, float portion1, PcmSimd simd, size_t n_bytes)
+{
+	SetPcmSimd(simd);
+
+	/* use bit patterns which are plausible floating point
+	   samples; denormals would spoil the measurement */
+	std::vector<float> a(BLOCK_SIZE / sizeof(float), 0.25f);
+	std::vector<float> b(BLOCK_SIZE / sizeof(float), -0.125f);
+
+	PcmDither dither;
+
+	const auto start = Clock::now();
+
+	for (size_t done = 0; done < n_bytes; done += BLOCK_SIZE)
+		if (!pcm_mix(dither, a.data(), b.data(), BLOCK_SIZE,
+			     format, portion1))
+			abort();
+
+	const auto duration = Clock::now() - start;
+	const double seconds = std::chrono::duration<double>(duration).count();
+
+	printf("%-8s %-9s %-5s %8.0f MB/s\n",
+	       sample_format_to_string(format),
+	       portion1 < 0 ? "add" : "crossfade",
+	       ToString(simd), n_bytes / seconds / 1e6);
+}
+
+int
+main(int argc, char **argv)
+{
+	const size_t n_bytes = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256)
+		* 1024 * 1024;
+
+	if (n_bytes == 0) {
+		fprintf(stderr, "Usage: bench_pcm_mix [MEGABYTES]\n");
+		return EXIT_FAILURE;
+	}
+
+	static constexpr SampleFormat formats[] = {
+		SampleFormat::S16,
+		SampleFormat::S24_P32,
+		SampleFormat::S32,
+		SampleFormat::FLOAT,
+	};
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	for (const float portion1 : {-1.0f, 0.5f}) {
+		for (const auto format : formats) {
+			for (const auto simd : {PcmSimd::NONE, PcmSimd::SSE2, PcmSimd::AVX2}) {
+				if (simd > detected)
+					break;
+
+				Run(format, portion1, simd, n_bytes);
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
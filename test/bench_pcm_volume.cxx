@@ -0,0 +1,118 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of #PcmVolume with each
+ * vectorized kernel supported by this CPU.
+ *
+ * Usage: bench_pcm_volume [MEGABYTES]
+ */
+
+#include "pcm/Volume.hxx"
+#include "pcm/Simd.hxx"
+#include "pcm/SampleFormat.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/PrintException.hxx"
+
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Process one #MusicChunk-sized block per call, just like an output
+ * thread does.
+ */
+static constexpr size_t BLOCK_SIZE = 4096;
+
+static void
+Run(SampleFormat format, bool allow_convert, PcmSimd simd, size_t n_bytes)
+{
+	SetPcmSimd(simd);
+
+	/* use bit patterns which are plausible floating point
+	   samples; denormals would spoil the measurement */
+	const std::vector<float> src(BLOCK_SIZE / sizeof(float), 0.25f);
+
+	PcmVolume pv;
+	const auto out_format = pv.Open(format, allow_convert);
+	pv.SetVolume(PCM_VOLUME_1 / 3);
+
+	const auto start = Clock::now();
+
+	for (size_t done = 0; done < n_bytes; done += BLOCK_SIZE)
+		if (pv.Apply({src.data(), BLOCK_SIZE}).IsNull())
+			abort();
+
+	const auto duration = Clock::now() - start;
+	const double seconds = std::chrono::duration<double>(duration).count();
+
+	pv.Close();
+
+	char name[32];
+	snprintf(name, sizeof(name), "%s->%s",
+		 sample_format_to_string(format),
+		 sample_format_to_string(out_format));
+
+	printf("%-8s %-5s %8.0f MB/s\n",
+	       name, ToString(simd), n_bytes / seconds / 1e6);
+}
+
+int
+main(int argc, char **argv)
+try {
+	const size_t n_bytes = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256)
+		* 1024 * 1024;
+
+	if (n_bytes == 0) {
+		fprintf(stderr, "Usage: bench_pcm_volume [MEGABYTES]\n");
+		return EXIT_FAILURE;
+	}
+
+	static constexpr struct {
+		SampleFormat format;
+		bool allow_convert;
+	} formats[] = {
+		{ SampleFormat::S8, false },
+		{ SampleFormat::S16, false },
+		{ SampleFormat::S16, true },
+		{ SampleFormat::S24_P32, false },
+		{ SampleFormat::S32, false },
+		{ SampleFormat::FLOAT, false },
+	};
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	for (const auto &i : formats) {
+		for (const auto simd : {PcmSimd::NONE, PcmSimd::SSE2, PcmSimd::AVX2}) {
+			if (simd > detected)
+				break;
+
+			Run(i.format, i.allow_convert, simd, n_bytes);
+		}
+	}
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures how fast song metadata is formatted into a
+ * #Response, like "listallinfo" does it.
+ *
+ * Usage: bench_response [SONGS]
+ */
+
+#include "SongPrint.hxx"
+#include "client/Response.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Builder.hxx"
+#include "tag/Tag.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * The response buffer is emptied after this many bytes, just like
+ * the client's output buffer gets flushed to the socket.
+ */
+static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+struct SyntheticSong {
+	std::string directory, uri;
+	Tag tag;
+};
+
+static SyntheticSong
+MakeSong(unsigned i)
+{
+	char buffer[64];
+
+	SyntheticSong song;
+
+	snprintf(buffer, sizeof(buffer), "Artist %u/Album %u", i / 1000, i / 10);
+	song.directory = buffer;
+
+	snprintf(buffer, sizeof(buffer), "%02u - Title %u.flac", i % 10 + 1, i);
+	song.uri = buffer;
+
+	TagBuilder tag;
+	tag.SetDuration(SignedSongTime::FromMS(180000 + i % 120000));
+
+	snprintf(buffer, sizeof(buffer), "Artist %u", i / 1000);
+	tag.AddItem(TAG_ARTIST, buffer);
+	tag.AddItem(TAG_ALBUM_ARTIST, buffer);
+
+	snprintf(buffer, sizeof(buffer), "Album %u", i / 10);
+	tag.AddItem(TAG_ALBUM, buffer);
+
+	snprintf(buffer, sizeof(buffer), "Title %u", i);
+	tag.AddItem(TAG_TITLE, buffer);
+
+	snprintf(buffer, sizeof(buffer), "%u", i % 10 + 1);
+	tag.AddItem(TAG_TRACK, buffer);
+
+	snprintf(buffer, sizeof(buffer), "%u", 1960 + i % 60);
+	tag.AddItem(TAG_DATE, buffer);
+
+	tag.AddItem(TAG_GENRE, "Rock");
+
+	song.tag = tag.Commit();
+	return song;
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_songs = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 100000;
+
+	if (n_songs == 0) {
+		fprintf(stderr, "Usage: bench_response [SONGS]\n");
+		return EXIT_FAILURE;
+	}
+
+	std::vector<SyntheticSong> songs;
+	songs.reserve(n_songs);
+	for (unsigned i = 0; i < n_songs; ++i)
+		songs.emplace_back(MakeSong(i));
+
+	const auto mtime = std::chrono::system_clock::from_time_t(1500000000);
+	const AudioFormat audio_format(44100, SampleFormat::S16, 2);
+
+	std::string buffer;
+	buffer.reserve(FLUSH_SIZE * 2);
+	Response r(buffer, TagMask::All());
+
+	size_t n_bytes = 0;
+
+	const auto start = Clock::now();
+
+	for (const auto &i : songs) {
+		LightSong song(i.uri.c_str(), i.tag);
+		song.directory = i.directory.c_str();
+		song.mtime = mtime;
+		song.audio_format = audio_format;
+
+		song_print_info(r, song);
+
+		if (buffer.size() >= FLUSH_SIZE) {
+			n_bytes += buffer.size();
+			buffer.clear();
+		}
+	}
+
+	n_bytes += buffer.size();
+
+	const auto duration = Clock::now() - start;
+	const double seconds = std::chrono::duration<double>(duration).count();
+
+	printf("%u songs, %zu bytes in %.3f s: %.0f songs/s, %.1f MB/s\n",
+	       n_songs, n_bytes, seconds,
+	       n_songs / seconds, n_bytes / seconds / 1e6);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2003-2020 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test_pcm_util.hxx"
+#include "pcm/Dsd2Pcm.hxx"
+#include "pcm/Simd.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <string.h>
+
+/**
+ * Feed the same random DSD data through #MultiDsd2Pcm and
+ * #BlockDsd2Pcm (in pieces of varying size) and compare the output;
+ * it must be bit-identical.
+ */
+template<typename T, typename F1, typename F2>
+static void
+TestBlockDsd2Pcm(unsigned channels, F1 &&translate1, F2 &&translate2)
+{
+	constexpr size_t N = 4099;
+	const auto src = TestDataBuffer<uint8_t, N * 8>();
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	for (const auto simd : {PcmSimd::NONE, PcmSimd::AVX2}) {
+		if (simd > detected)
+			break;
+
+		SetPcmSimd(simd);
+
+		auto multi = std::make_unique<MultiDsd2Pcm>();
+		auto block = std::make_unique<BlockDsd2Pcm>();
+
+		const size_t n_frames = src.size() / channels;
+		auto expected = std::make_unique<T[]>(n_frames * channels);
+		auto result = std::make_unique<T[]>(n_frames * channels);
+
+		/* odd sizes, and more than BlockDsd2Pcm::BLOCK_SIZE */
+		size_t position = 0;
+		for (const size_t size : {1, 7, 13, 2047, 64, 3}) {
+			const size_t n = std::min(size, n_frames - position);
+			const size_t offset = position * channels;
+
+			translate1(*multi, channels, n, src.begin() + offset,
+				   expected.get() + offset);
+			translate2(*block, channels, n, src.begin() + offset,
+				   result.get() + offset);
+
+			position += n;
+		}
+
+		const size_t n = position * channels;
+		EXPECT_EQ(0, memcmp(result.get(), expected.get(),
+				    n * sizeof(T)))
+			<< ToString(simd) << " channels=" << channels;
+
+		/* after Reset(), the output must be the same again */
+		multi->Reset();
+		block->Reset();
+		translate1(*multi, channels, 100, src.begin(), expected.get());
+		translate2(*block, channels, 100, src.begin(), result.get());
+		EXPECT_EQ(0, memcmp(result.get(), expected.get(),
+				    100 * channels * sizeof(T)))
+			<< ToString(simd) << " channels=" << channels;
+	}
+
+	SetPcmSimd(detected);
+}
+
+TEST(PcmTest, BlockDsd2Pcm)
+{
+	for (const unsigned channels : {1, 2, 3, 6, 8})
+		TestBlockDsd2Pcm<float>(channels,
+					[](MultiDsd2Pcm &d, unsigned c, size_t n,
+					   const uint8_t *src, float *dest){
+						d.Translate(c, n, src, dest);
+					},
+					[](BlockDsd2Pcm &d, unsigned c, size_t n,
+					   const uint8_t *src, float *dest){
+						d.Translate(c, n, src, dest);
+					});
+}
+
+TEST(PcmTest, BlockDsd2PcmS24)
+{
+	for (const unsigned channels : {1, 2, 3, 6, 8})
+		TestBlockDsd2Pcm<int32_t>(channels,
+					  [](MultiDsd2Pcm &d, unsigned c, size_t n,
+					     const uint8_t *src, int32_t *dest){
+						  d.TranslateS24(c, n, src, dest);
+					  },
+					  [](BlockDsd2Pcm &d, unsigned c, size_t n,
+					     const uint8_t *src, int32_t *dest){
+						  d.TranslateS24(c, n, src, dest);
+					  });
+}
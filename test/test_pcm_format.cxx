@@ -22,9 +22,12 @@
 #include "pcm/Dither.hxx"
 #include "pcm/Buffer.hxx"
 #include "pcm/SampleFormat.hxx"
+#include "pcm/Simd.hxx"
 
 #include <gtest/gtest.h>
 
+#include <string.h>
+
 TEST(PcmTest, Format8To16)
 {
 	constexpr size_t N = 509;
@@ -159,3 +162,102 @@ TEST(PcmTest, FormatFloat32)
 	for (size_t i = 4; i < N; ++i)
 		EXPECT_NEAR(src[i], d[i], error);
 }
+
+/**
+ * Floating point samples which exceed the valid range, to check
+ * clamping.
+ */
+struct RandomLoudFloat {
+	std::mt19937 gen;
+	std::uniform_real_distribution<float> dis{-1.5, 1.5};
+
+	float operator()() {
+		return dis(gen);
+	}
+};
+
+/**
+ * Compare the results of all vectorized kernels supported by this
+ * CPU with the generic code; they must be bit-exact.
+ */
+template<typename T, typename C, typename G>
+static void
+TestFormatSimd(SampleFormat src_format, C convert, G g)
+{
+	constexpr size_t N = 509;
+	const auto src = TestDataBuffer<T, N>(g);
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	/* odd offsets and lengths exercise unaligned buffers and the
+	   generic code handling the tail */
+	for (const unsigned offset : {0, 1, 3}) {
+		const ConstBuffer<void> s(src.begin() + offset,
+					  (N - offset) * sizeof(T));
+
+		SetPcmSimd(PcmSimd::NONE);
+		PcmBuffer expected_buffer;
+		const auto expected = convert(expected_buffer, src_format, s);
+		ASSERT_FALSE(expected.IsNull());
+
+		for (const auto simd : {PcmSimd::SSE2, PcmSimd::AVX2}) {
+			if (simd > detected)
+				break;
+
+			SetPcmSimd(simd);
+			PcmBuffer buffer;
+			const auto result = convert(buffer, src_format, s);
+
+			ASSERT_EQ(result.size, expected.size);
+			EXPECT_EQ(0, memcmp(result.data, expected.data,
+					    result.size * sizeof(*result.data)))
+				<< ToString(simd) << " offset=" << offset;
+		}
+	}
+
+	SetPcmSimd(detected);
+}
+
+static ConstBuffer<int16_t>
+ConvertTo16(PcmBuffer &buffer, SampleFormat src_format,
+	    ConstBuffer<void> src) noexcept
+{
+	PcmDither dither;
+	return pcm_convert_to_16(buffer, dither, src_format, src);
+}
+
+TEST(PcmTest, FormatSimdTo16)
+{
+	TestFormatSimd<float>(SampleFormat::FLOAT, ConvertTo16,
+			      RandomLoudFloat());
+}
+
+TEST(PcmTest, FormatSimdTo24)
+{
+	TestFormatSimd<int16_t>(SampleFormat::S16, pcm_convert_to_24,
+				RandomInt<int16_t>());
+	TestFormatSimd<int32_t>(SampleFormat::S32, pcm_convert_to_24,
+				RandomInt<int32_t>());
+	TestFormatSimd<float>(SampleFormat::FLOAT, pcm_convert_to_24,
+			      RandomLoudFloat());
+}
+
+TEST(PcmTest, FormatSimdTo32)
+{
+	TestFormatSimd<int16_t>(SampleFormat::S16, pcm_convert_to_32,
+				RandomInt<int16_t>());
+	TestFormatSimd<int32_t>(SampleFormat::S24_P32, pcm_convert_to_32,
+				RandomInt24());
+	TestFormatSimd<float>(SampleFormat::FLOAT, pcm_convert_to_32,
+			      RandomLoudFloat());
+}
+
+TEST(PcmTest, FormatSimdToFloat)
+{
+	TestFormatSimd<int16_t>(SampleFormat::S16, pcm_convert_to_float,
+				RandomInt<int16_t>());
+	TestFormatSimd<int32_t>(SampleFormat::S24_P32, pcm_convert_to_float,
+				RandomInt24());
+	TestFormatSimd<int32_t>(SampleFormat::S32, pcm_convert_to_float,
+				RandomInt<int32_t>());
+}
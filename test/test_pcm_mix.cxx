@@ -20,6 +20,7 @@
 #include "test_pcm_util.hxx"
 #include "pcm/Mix.hxx"
 #include "pcm/Dither.hxx"
+#include "pcm/Simd.hxx"
 
 #include <gtest/gtest.h>
 
@@ -81,3 +82,92 @@ TEST(PcmTest, Mix32)
 {
 	TestPcmMix<int32_t, SampleFormat::S32>();
 }
+
+/**
+ * A generator which, unlike #RandomInt, yields negative values, too.
+ */
+template<typename T>
+struct RandomSignedInt {
+	std::mt19937 engine;
+
+	T operator()() {
+		return T(engine());
+	}
+};
+
+/**
+ * Compare the results of all vectorized kernels supported by this
+ * CPU with the generic code; they must be bit-exact.
+ */
+template<typename T, SampleFormat format, typename G>
+static void
+TestPcmMixSimd(G g, float portion1)
+{
+	constexpr unsigned N = 509;
+	const auto src1 = TestDataBuffer<T, N>(g);
+	const auto src2 = TestDataBuffer<T, N>(g);
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	/* odd offsets and lengths exercise unaligned buffers and the
+	   generic code handling the tail */
+	for (const unsigned offset : {0, 1, 3}) {
+		const size_t size = (N - offset) * sizeof(T);
+
+		SetPcmSimd(PcmSimd::NONE);
+		PcmDither dither;
+		auto expected = src1;
+		ASSERT_TRUE(pcm_mix(dither, expected.begin() + offset,
+				    src2.begin() + offset, size,
+				    format, portion1));
+
+		for (const auto simd : {PcmSimd::SSE2, PcmSimd::AVX2}) {
+			if (simd > detected)
+				break;
+
+			SetPcmSimd(simd);
+			PcmDither dither2;
+			auto result = src1;
+			ASSERT_TRUE(pcm_mix(dither2, result.begin() + offset,
+					    src2.begin() + offset, size,
+					    format, portion1));
+
+			for (unsigned i = 0; i < N; ++i)
+				EXPECT_EQ(result[i], expected[i])
+					<< ToString(simd) << " offset="
+					<< offset << " i=" << i;
+		}
+	}
+
+	SetPcmSimd(detected);
+}
+
+TEST(PcmTest, MixSimd8)
+{
+	TestPcmMixSimd<int8_t, SampleFormat::S8>(RandomSignedInt<int8_t>(),
+						 -1);
+}
+
+TEST(PcmTest, MixSimd16)
+{
+	TestPcmMixSimd<int16_t, SampleFormat::S16>(RandomSignedInt<int16_t>(),
+						   -1);
+}
+
+TEST(PcmTest, MixSimd24)
+{
+	TestPcmMixSimd<int32_t, SampleFormat::S24_P32>(RandomInt24(), -1);
+}
+
+TEST(PcmTest, MixSimd32)
+{
+	TestPcmMixSimd<int32_t, SampleFormat::S32>(RandomSignedInt<int32_t>(),
+						   -1);
+}
+
+TEST(PcmTest, MixSimdFloat)
+{
+	TestPcmMixSimd<float, SampleFormat::FLOAT>(RandomFloat(), -1);
+	TestPcmMixSimd<float, SampleFormat::FLOAT>(RandomFloat(), 0.3);
+	TestPcmMixSimd<float, SampleFormat::FLOAT>(RandomFloat(), 0.8);
+}
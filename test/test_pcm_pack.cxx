@@ -19,10 +19,13 @@
 
 #include "test_pcm_util.hxx"
 #include "pcm/Pack.hxx"
+#include "pcm/Simd.hxx"
 #include "util/ByteOrder.hxx"
 
 #include <gtest/gtest.h>
 
+#include <string.h>
+
 TEST(PcmTest, Pack24)
 {
 	constexpr unsigned N = 509;
@@ -87,3 +90,71 @@ TEST(PcmTest, Unpack24BE)
 		EXPECT_EQ(s, dest[i]);
 	}
 }
+
+/**
+ * Compare the vectorized kernels supported by this CPU with the
+ * generic code.
+ */
+TEST(PcmTest, Pack24Simd)
+{
+	constexpr unsigned N = 509;
+	const auto src = TestDataBuffer<int32_t, N>(RandomInt24());
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	SetPcmSimd(PcmSimd::NONE);
+	uint8_t expected[N * 3];
+	pcm_pack_24(expected, src.begin(), src.end());
+
+	for (const auto simd : {PcmSimd::SSE2, PcmSimd::AVX2}) {
+		if (simd > detected)
+			break;
+
+		SetPcmSimd(simd);
+
+		uint8_t dest[N * 3];
+		pcm_pack_24(dest, src.begin(), src.end());
+		EXPECT_EQ(0, memcmp(dest, expected, sizeof(dest)))
+			<< ToString(simd);
+
+		/* in-place */
+		int32_t buffer[N];
+		std::copy(src.begin(), src.end(), buffer);
+		pcm_pack_24((uint8_t *)buffer, buffer, buffer + N);
+		EXPECT_EQ(0, memcmp(buffer, expected, sizeof(expected)))
+			<< ToString(simd);
+	}
+
+	SetPcmSimd(detected);
+}
+
+TEST(PcmTest, Unpack24Simd)
+{
+	constexpr unsigned N = 509;
+	const auto src = TestDataBuffer<uint8_t, N * 3>();
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	SetPcmSimd(PcmSimd::NONE);
+	int32_t expected[N], expected_be[N];
+	pcm_unpack_24(expected, src.begin(), src.end());
+	pcm_unpack_24be(expected_be, src.begin(), src.end());
+
+	for (const auto simd : {PcmSimd::SSE2, PcmSimd::AVX2}) {
+		if (simd > detected)
+			break;
+
+		SetPcmSimd(simd);
+
+		int32_t dest[N];
+		pcm_unpack_24(dest, src.begin(), src.end());
+		EXPECT_EQ(0, memcmp(dest, expected, sizeof(dest)))
+			<< ToString(simd);
+
+		pcm_unpack_24be(dest, src.begin(), src.end());
+		EXPECT_EQ(0, memcmp(dest, expected_be, sizeof(dest)))
+			<< ToString(simd);
+	}
+
+	SetPcmSimd(detected);
+}
@@ -19,6 +19,7 @@
 
 #include "pcm/Volume.hxx"
 #include "pcm/Traits.hxx"
+#include "pcm/Simd.hxx"
 #include "util/ConstBuffer.hxx"
 #include "test_pcm_util.hxx"
 
@@ -158,3 +159,67 @@ TEST(PcmTest, VolumeFloat)
 
 	pv.Close();
 }
+
+/**
+ * Compare the results of all vectorized kernels supported by this
+ * CPU with the generic code; they must be bit-exact.
+ */
+template<typename T, typename G>
+static void
+TestVolumeSimd(SampleFormat format, bool allow_convert, G g)
+{
+	constexpr size_t N = 509;
+	const auto _src = TestDataBuffer<T, N>(g);
+
+	const PcmSimd detected = DetectPcmSimd();
+
+	for (const unsigned volume : {1u, 333u, PCM_VOLUME_1 - 1,
+				      PCM_VOLUME_1, 3000u, 40000u}) {
+		/* odd offsets and lengths exercise unaligned buffers
+		   and the generic code handling the tail */
+		for (const unsigned offset : {0, 1, 3}) {
+			const ConstBuffer<void> src(_src.begin() + offset,
+						    (N - offset) * sizeof(T));
+
+			SetPcmSimd(PcmSimd::NONE);
+			PcmVolume expected_pv;
+			expected_pv.Open(format, allow_convert);
+			expected_pv.SetVolume(volume);
+			const auto expected = expected_pv.Apply(src);
+
+			for (const auto simd : {PcmSimd::SSE2, PcmSimd::AVX2}) {
+				if (simd > detected)
+					break;
+
+				SetPcmSimd(simd);
+				PcmVolume pv;
+				pv.Open(format, allow_convert);
+				pv.SetVolume(volume);
+				const auto dest = pv.Apply(src);
+
+				ASSERT_EQ(dest.size, expected.size);
+				EXPECT_EQ(0, memcmp(dest.data, expected.data,
+						    dest.size))
+					<< ToString(simd) << " volume="
+					<< volume << " offset=" << offset;
+
+				pv.Close();
+			}
+
+			expected_pv.Close();
+		}
+	}
+
+	SetPcmSimd(detected);
+}
+
+TEST(PcmTest, VolumeSimd16to32)
+{
+	TestVolumeSimd<int16_t>(SampleFormat::S16, true,
+				RandomInt<int16_t>());
+}
+
+TEST(PcmTest, VolumeSimdFloat)
+{
+	TestVolumeSimd<float>(SampleFormat::FLOAT, false, RandomFloat());
+}